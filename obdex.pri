@@ -0,0 +1,58 @@
+# obdex library sources, shared by obdex.pro (tests)
+# and obdex_bench.pro (benchmarks)
+
+HEADERS += \
+    $$PWD/obdex/duktape/duktape.h \
+    $$PWD/obdex/pugixml/pugiconfig.hpp \
+    $$PWD/obdex/pugixml/pugixml.hpp \
+    $$PWD/obdex/ObdexDataTypes.hpp \
+    $$PWD/obdex/ObdexLog.hpp \
+    $$PWD/obdex/ObdexUtil.hpp \
+    $$PWD/obdex/ObdexTemp.hpp \
+    $$PWD/obdex/ObdexErrors.hpp \
+    $$PWD/obdex/ObdexStats.hpp \
+    $$PWD/obdex/ObdexParseCache.hpp \
+    $$PWD/obdex/ObdexScriptAnalysis.hpp \
+    $$PWD/obdex/ObdexDefinitions.hpp \
+    $$PWD/obdex/ObdexCatalog.hpp \
+    $$PWD/obdex/ObdexLookupTable.hpp \
+    $$PWD/obdex/ObdexNativeScripts.hpp \
+    $$PWD/obdex/ObdexScriptEngine.hpp \
+    $$PWD/obdex/ObdexScriptBudget.hpp \
+    $$PWD/obdex/ObdexScriptHeap.hpp \
+    $$PWD/obdex/ObdexParser.hpp \
+    $$PWD/obdex/ObdexResponseCount.hpp \
+    $$PWD/obdex/ObdexRequestPlanner.hpp \
+    $$PWD/obdex/ObdexScheduler.hpp \
+    $$PWD/obdex/ObdexBusModel.hpp \
+    $$PWD/obdex/ObdexVirtualVehicle.hpp
+
+SOURCES += \
+    $$PWD/obdex/duktape/duktape.c \
+    $$PWD/obdex/pugixml/pugixml.cpp \
+    $$PWD/obdex/ObdexLog.cpp \
+    $$PWD/obdex/ObdexUtil.cpp \
+    $$PWD/obdex/ObdexErrors.cpp \
+    $$PWD/obdex/ObdexStats.cpp \
+    $$PWD/obdex/ObdexParseCache.cpp \
+    $$PWD/obdex/ObdexScriptAnalysis.cpp \
+    $$PWD/obdex/ObdexDefinitions.cpp \
+    $$PWD/obdex/ObdexLookupTable.cpp \
+    $$PWD/obdex/ObdexNativeScripts.cpp \
+    $$PWD/obdex/ObdexScriptEngine.cpp \
+    $$PWD/obdex/ObdexScriptBudget.cpp \
+    $$PWD/obdex/ObdexScriptHeap.cpp \
+    $$PWD/obdex/ObdexParser.cpp \
+    $$PWD/obdex/ObdexResponseCount.cpp \
+    $$PWD/obdex/ObdexRequestPlanner.cpp \
+    $$PWD/obdex/ObdexScheduler.cpp \
+    $$PWD/obdex/ObdexBusModel.cpp \
+    $$PWD/obdex/ObdexVirtualVehicle.cpp
+
+INCLUDEPATH += $$PWD
+
+# CONFIG += obdex_stats records per-stage parse
+# latency histograms (see ObdexStats.hpp)
+obdex_stats {
+    DEFINES += OBDEX_ENABLE_STATS
+}
@@ -2,35 +2,32 @@
  TARGET = obdex_test
  CONFIG -= qt
 
- HEADERS += \
-    obdex/duktape/duktape.h \
-    obdex/pugixml/pugiconfig.hpp \
-    obdex/pugixml/pugixml.hpp \
-    obdex/ObdexDataTypes.hpp \
-    obdex/ObdexLog.hpp \
-    obdex/ObdexUtil.hpp \
-    obdex/ObdexTemp.hpp \
-    obdex/ObdexErrors.hpp \
-    obdex/ObdexParser.hpp
-
-SOURCES += \
-    obdex/duktape/duktape.c \
-    obdex/pugixml/pugixml.cpp \
-    obdex/ObdexLog.cpp \
-    obdex/ObdexUtil.cpp \
-    obdex/ObdexErrors.cpp \
-    obdex/ObdexParser.cpp
+include(obdex.pri)
 
 # test
 HEADERS += \
-    obdex/test/ObdexTestHelpers.hpp
+    obdex/test/ObdexTestHelpers.hpp \
+    obdex/bench/ObdexDefinitionsGenerator.hpp \
+    obdex/codegen/ObdexScriptTranslator.hpp
 
 SOURCES += \
     obdex/test/ObdexTest.cpp \
     obdex/test/ObdexTestHelpers.cpp \
     obdex/test/ObdexTestUtil.cpp \
     obdex/test/ObdexTestBasic.cpp \
-    obdex/test/ObdexTestSpec.cpp
+    obdex/test/ObdexTestSpec.cpp \
+    obdex/test/ObdexTestRequests.cpp \
+    obdex/test/ObdexTestSynthetic.cpp \
+    obdex/test/ObdexTestStats.cpp \
+    obdex/test/ObdexTestLog.cpp \
+    obdex/test/ObdexTestScript.cpp \
+    obdex/bench/ObdexDefinitionsGenerator.cpp \
+    obdex/codegen/ObdexScriptTranslator.cpp
+
+# scripts translated from definitions/obd2.xml by
+# obdex_codegen (regenerate when obd2.xml changes)
+SOURCES += \
+    obdex/generated/ObdexNativeObd2.cpp
 
 # examples
 #SOURCES += \
@@ -0,0 +1,318 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexBusModel.hpp>
+#include <obdex/ObdexErrors.hpp>
+
+#include <algorithm>
+
+namespace obdex
+{
+    namespace
+    {
+        // ============================================================= //
+        // ============================================================= //
+
+        // getFrameTime
+        // * returns the time a frame with @byte_count
+        //   header, data and checksum bytes spends on the bus
+        Microseconds getFrameTime(BusTiming const &timing,
+                                  uint const byte_count,
+                                  Microseconds const inter_byte)
+        {
+            u64 bits = 0;
+
+            if(timing.protocol == PROTOCOL_ISO_15765)   {
+                // ISO 15765-4 frames always have eight data
+                // bytes (unused bytes are padded); worst case
+                // bit stuffing adds a bit for every four bits
+                // after the first in the stuffed part of the frame
+                u64 const data_bits = 64;
+                u64 const stuffed_bits =
+                        ((timing.iso15765_extended_id) ? 54 : 34) + data_bits;
+
+                bits = timing.frame_overhead_bits + data_bits + (stuffed_bits-1)/4;
+            }
+            else   {
+                bits = timing.frame_overhead_bits +
+                        u64(byte_count)*timing.bits_per_byte;
+            }
+
+            // round up to the next microsecond
+            Microseconds frame_time((bits*1000000 + timing.baudrate-1)/timing.baudrate);
+
+            if(byte_count > 1)   {
+                frame_time += inter_byte*(byte_count-1);
+            }
+
+            return frame_time;
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        // getPollTime
+        // * saves the wire time and the time spent waiting
+        //   between frames for a single request in @msg
+        void getPollTime(BusTiming const &timing,
+                         MessageData const &msg,
+                         Microseconds &wire_time,
+                         Microseconds &idle_time)
+        {
+            wire_time = Microseconds(0);
+            idle_time = Microseconds(0);
+
+            if(msg.list_req_data_bytes.empty())   {
+                return;
+            }
+
+            bool const is_iso15765 = (timing.protocol == PROTOCOL_ISO_15765);
+
+            // [request]
+            // header and checksum bytes are part of the
+            // identifier and CRC for ISO 15765
+            uint const req_frame_extra_bytes = (is_iso15765) ?
+                        0 : msg.req_header_bytes.size()+1;
+
+            for(auto const &req_data_bytes : msg.list_req_data_bytes)   {
+                wire_time += getFrameTime(timing,
+                                          req_frame_extra_bytes+req_data_bytes.size(),
+                                          timing.p4_inter_byte_req);
+            }
+
+            // [response]
+            // (length)
+            sint max_frame_data_bytes = 7;
+            if(timing.protocol == PROTOCOL_ISO_14230)   {
+                max_frame_data_bytes = 255;
+            }
+
+            uint data_length = 7;
+            if(msg.exp_data_byte_count >= 0)   {
+                data_length = msg.exp_data_prefix.size()+msg.exp_data_byte_count;
+            }
+
+            // (frames per responder)
+            // * ISO 15765 responses over seven bytes are sent as a
+            //   first frame with six bytes followed by consecutive
+            //   frames with seven bytes each
+            // * longer responses for other protocols are split in
+            //   a manufacturer specific way, so full frames are assumed
+            std::vector<uint> list_resp_frame_data_bytes;
+            if(is_iso15765 && data_length > 7)   {
+                list_resp_frame_data_bytes.push_back(6);
+                uint remaining = data_length-6;
+                while(remaining > 0)   {
+                    uint const frame_bytes = std::min(remaining,uint(7));
+                    list_resp_frame_data_bytes.push_back(frame_bytes);
+                    remaining -= frame_bytes;
+                }
+            }
+            else   {
+                uint remaining = data_length;
+                do {
+                    uint const frame_bytes = std::min(remaining,uint(max_frame_data_bytes));
+                    list_resp_frame_data_bytes.push_back(frame_bytes);
+                    remaining -= frame_bytes;
+                }
+                while(remaining > 0);
+            }
+
+            uint const frames_per_response = list_resp_frame_data_bytes.size();
+
+            // (responders)
+            uint responder_count = 1;
+            if(msg.exp_response_count > 0)   {
+                responder_count = std::max(
+                            uint(msg.exp_response_count)/frames_per_response,
+                            uint(1));
+            }
+
+            uint const resp_frame_extra_bytes = req_frame_extra_bytes;
+
+            Microseconds resp_time(0);
+            for(auto const frame_data_bytes : list_resp_frame_data_bytes)   {
+                resp_time += getFrameTime(timing,
+                                          resp_frame_extra_bytes+frame_data_bytes,
+                                          timing.p1_inter_byte_resp);
+            }
+            wire_time += resp_time*responder_count;
+
+            // (flow control)
+            // * an ISO 15765 receiver sends a flow control frame
+            //   after the first frame of a multi-frame message
+            if(is_iso15765)   {
+                Microseconds const fc_time = getFrameTime(timing,0,Microseconds(0));
+                if(msg.list_req_data_bytes.size() > 1)   {
+                    wire_time += fc_time;
+                }
+                if(frames_per_response > 1)   {
+                    wire_time += fc_time*responder_count;
+                }
+            }
+
+            // [idle]
+            uint const resp_frame_count = frames_per_response*responder_count;
+
+            idle_time += Milliseconds(msg.req_data_delay_ms);
+            idle_time += timing.p2_req_to_resp;
+            idle_time += timing.inter_frame*(resp_frame_count-1);
+            idle_time += timing.p3_resp_to_req;
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    BusTiming GetDefaultBusTiming(Protocol const protocol,
+                                  bool const j1850_vpw,
+                                  bool const iso15765_extended_id)
+    {
+        BusTiming timing;
+        timing.protocol = protocol;
+        timing.j1850_vpw = j1850_vpw;
+        timing.iso15765_extended_id = iso15765_extended_id;
+
+        if(protocol == PROTOCOL_SAE_J1850)
+        {
+            if(j1850_vpw)   {
+                // VPW bits vary in length; 10.4 kbps is the
+                // average rate. Each frame has a start of frame,
+                // end of data, end of frame and interframe
+                // separation of about ten bit times in total
+                timing.baudrate = 10400;
+                timing.frame_overhead_bits = 10;
+            }
+            else   {
+                // PWM frames add a start of frame, end of data,
+                // a single byte in-frame response and end of frame
+                // and interframe separation
+                timing.baudrate = 41600;
+                timing.frame_overhead_bits = 20;
+            }
+        }
+        else if(protocol == PROTOCOL_ISO_9141_2 ||
+                protocol == PROTOCOL_ISO_14230)
+        {
+            // K-line: one start and one stop bit for
+            // each byte, and the minimum P1-P4 times
+            timing.baudrate = 10400;
+            timing.bits_per_byte = 10;
+            timing.p1_inter_byte_resp = Milliseconds(0);
+            timing.p2_req_to_resp = Milliseconds(25);
+            timing.p3_resp_to_req = Milliseconds(55);
+            timing.p4_inter_byte_req = Milliseconds(5);
+
+            // responses from different nodes are
+            // separated by at least P2
+            timing.inter_frame = timing.p2_req_to_resp;
+        }
+        else if(protocol == PROTOCOL_ISO_15765)
+        {
+            // start of frame, identifier, control field, CRC,
+            // ack, end of frame and interframe space
+            timing.baudrate = 500000;
+            timing.frame_overhead_bits = (iso15765_extended_id) ? 67 : 47;
+        }
+        else   {
+            throw BuildParamFrameFailed("Unsupported protocol for bus timing");
+        }
+
+        timing.list_baudrates.push_back(timing.baudrate);
+
+        return timing;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    Microseconds EstimateWireTime(BusTiming const &timing,
+                                  ParameterFrame const &param_frame)
+    {
+        Microseconds wire_time(0);
+        for(auto const &msg : param_frame.list_message_data)   {
+            Microseconds msg_wire_time,msg_idle_time;
+            getPollTime(timing,msg,msg_wire_time,msg_idle_time);
+            wire_time += msg_wire_time;
+        }
+
+        return wire_time;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    Microseconds EstimatePollTime(BusTiming const &timing,
+                                  ParameterFrame const &param_frame)
+    {
+        Microseconds poll_time(0);
+        for(auto const &msg : param_frame.list_message_data)   {
+            Microseconds msg_wire_time,msg_idle_time;
+            getPollTime(timing,msg,msg_wire_time,msg_idle_time);
+            poll_time += msg_wire_time+msg_idle_time;
+        }
+
+        return poll_time;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    double EstimateMaxPollRate(BusTiming const &timing,
+                               std::vector<ParameterFrame> const &list_param_frames)
+    {
+        Microseconds cycle_time(0);
+        for(auto const &param_frame : list_param_frames)   {
+            cycle_time += EstimatePollTime(timing,param_frame);
+        }
+
+        if(cycle_time.count() == 0)   {
+            return 0.0;
+        }
+
+        return 1000000.0/cycle_time.count();
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    double EstimateBusLoad(BusTiming const &timing,
+                           std::vector<ParameterFrame> const &list_param_frames,
+                           std::vector<double> const &list_rates)
+    {
+        if(list_param_frames.size() != list_rates.size())   {
+            throw InvalidArgument(
+                        "EstimateBusLoad: Expected a rate "
+                        "for each parameter");
+        }
+
+        double load = 0.0;
+        for(uint i=0; i < list_param_frames.size(); i++)   {
+            Microseconds const poll_time =
+                    EstimatePollTime(timing,list_param_frames[i]);
+
+            load += poll_time.count()*list_rates[i]/1000000.0;
+        }
+
+        return load;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
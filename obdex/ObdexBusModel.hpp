@@ -0,0 +1,141 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_BUS_MODEL_HPP
+#define OBDEX_BUS_MODEL_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    // BusTiming
+    // * describes how long messages for a protocol take
+    //   on the bus; Parser::GetBusTiming fills this in
+    //   from the definitions file
+    // * the default timings are the minimums allowed by
+    //   each standard, so estimates made with them are
+    //   the best a vehicle could do
+    struct BusTiming
+    {
+        Protocol protocol;
+
+        // true for SAE J1850 VPW (otherwise PWM is assumed
+        // for PROTOCOL_SAE_J1850)
+        bool j1850_vpw;
+
+        // true for 29-bit ISO 15765 identifiers
+        bool iso15765_extended_id;
+
+        // bit rate used for estimates and all of the
+        // rates listed for the protocol
+        u32 baudrate;
+        std::vector<u32> list_baudrates;
+
+        // bits sent for each byte (start and stop bits
+        // make this 10 for ISO 9141-2 and ISO 14230)
+        u32 bits_per_byte;
+
+        // bits sent for each frame in addition to its bytes
+        // (start/end of frame, ack, interframe space etc)
+        // * for ISO 15765 this includes the identifier,
+        //   control field and CRC, and worst case bit
+        //   stuffing is added separately
+        u32 frame_overhead_bits;
+
+        // P1: time between bytes of a response
+        Microseconds p1_inter_byte_resp;
+
+        // P2: time between the end of a request and
+        // the start of the response
+        Microseconds p2_req_to_resp;
+
+        // P3: time between the end of the responses and
+        // the start of the next request
+        Microseconds p3_resp_to_req;
+
+        // P4: time between bytes of a request
+        Microseconds p4_inter_byte_req;
+
+        // time between consecutive response frames (ie.
+        // responses from different nodes on ISO 9141-2,
+        // STmin for ISO 15765 consecutive frames)
+        Microseconds inter_frame;
+
+        BusTiming() :
+            protocol(PROTOCOL_ISO_15765),
+            j1850_vpw(false),
+            iso15765_extended_id(false),
+            baudrate(0),
+            bits_per_byte(8),
+            frame_overhead_bits(0),
+            p1_inter_byte_resp(0),
+            p2_req_to_resp(0),
+            p3_resp_to_req(0),
+            p4_inter_byte_req(0),
+            inter_frame(0)
+        {}
+    };
+
+    // GetDefaultBusTiming
+    // * returns the default timing for @protocol with
+    //   the standard bit rate for the protocol
+    BusTiming GetDefaultBusTiming(Protocol const protocol,
+                                  bool const j1850_vpw=false,
+                                  bool const iso15765_extended_id=false);
+
+    // EstimateWireTime
+    // * returns the time the request and expected
+    //   response frames of every MessageData in
+    //   @param_frame spend on the bus, without the
+    //   idle time between them
+    // * @param_frame must be built (see BuildParameterFrame)
+    // * if the number of responses isn't known, a
+    //   single responder is assumed; if the length of
+    //   a response isn't known, a single full frame
+    //   is assumed
+    Microseconds EstimateWireTime(BusTiming const &timing,
+                                  ParameterFrame const &param_frame);
+
+    // EstimatePollTime
+    // * returns the time needed to poll @param_frame
+    //   once, which is its wire time plus the delays
+    //   the protocol requires around each request and
+    //   any MessageData.req_data_delay_ms
+    // * passive messages (with no request) are ignored
+    Microseconds EstimatePollTime(BusTiming const &timing,
+                                  ParameterFrame const &param_frame);
+
+    // EstimateMaxPollRate
+    // * returns the number of times per second every
+    //   parameter in @list_param_frames could be polled
+    //   if they were polled one after another with no
+    //   other traffic on the bus
+    double EstimateMaxPollRate(BusTiming const &timing,
+                               std::vector<ParameterFrame> const &list_param_frames);
+
+    // EstimateBusLoad
+    // * returns the fraction of bus time used to poll each
+    //   parameter in @list_param_frames at the matching
+    //   rate (in Hz) in @list_rates; a value over 1.0
+    //   means the rates can't be met
+    // * throws InvalidArgument unless there's a rate for
+    //   each parameter
+    double EstimateBusLoad(BusTiming const &timing,
+                           std::vector<ParameterFrame> const &list_param_frames,
+                           std::vector<double> const &list_rates);
+}
+
+#endif // OBDEX_BUS_MODEL_HPP
@@ -0,0 +1,147 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_CATALOG_HPP
+#define OBDEX_CATALOG_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    // CatalogRequest
+    // * a single request of a parameter, as it's listed in
+    //   the definitions file: the data bytes aren't split
+    //   into frames and don't have protocol bytes (ie. the
+    //   ISO 15765 PCI byte) added
+    // * the fields match those BuildParameterFrame sets in
+    //   MessageData; exp_data_byte_count is less than 0 if
+    //   the expected length is unknown
+    struct CatalogRequest
+    {
+        CatalogRequest() :
+            req_data_delay_ms(0),
+            exp_data_byte_count(-1)
+        {}
+
+        ByteList req_data_bytes;
+        u32 req_data_delay_ms;
+        ByteList exp_data_prefix;
+        sint exp_data_byte_count;
+    };
+
+    // CatalogParameter
+    // * a parameter in one of a spec's parameters groups;
+    //   it's the same for every protocol
+    // * list_requests is empty for parameters that are
+    //   only parsed passively
+    // * valid is false if the request attributes can't be
+    //   read; BuildParameterFrame throws for the parameter
+    struct CatalogParameter
+    {
+        CatalogParameter() :
+            spec_idx(0),
+            parse_mode(PARSE_SEPARATELY),
+            valid(true)
+        {}
+
+        std::string name;
+        std::string address;
+        u32 spec_idx;
+        ParseMode parse_mode;
+        std::vector<CatalogRequest> list_requests;
+        bool valid;
+    };
+
+    // CatalogAddress
+    // * the ParamIds of the parameters requested from an
+    //   address with a protocol are first_param_id up to
+    //   first_param_id+param_count, in the order
+    //   GetParameterNames lists them
+    struct CatalogAddress
+    {
+        CatalogAddress() :
+            first_param_id(0),
+            param_count(0)
+        {}
+
+        std::string name;
+        ParamId first_param_id;
+        u32 param_count;
+    };
+
+    // CatalogProtocol
+    // * the protocol options are set from the protocol's
+    //   name and option tags like BuildParameterFrame
+    //   sets them in ParameterFrame
+    // * supported is false for protocols the Parser can't
+    //   build frames for
+    struct CatalogProtocol
+    {
+        CatalogProtocol() :
+            parse_protocol(PROTOCOL_SAE_J1850),
+            supported(false),
+            iso14230_add_length_byte(false),
+            iso15765_extended_id(false),
+            iso15765_extended_addr(false)
+        {}
+
+        std::string name;
+        Protocol parse_protocol;
+        bool supported;
+        bool iso14230_add_length_byte;
+        bool iso15765_extended_id;
+        bool iso15765_extended_addr;
+        std::vector<std::string> list_baudrates;
+        std::vector<CatalogAddress> list_addresses;
+    };
+
+    struct CatalogSpec
+    {
+        std::string name;
+        std::vector<CatalogProtocol> list_protocols;
+    };
+
+    // CatalogParam
+    // * a ParamId: its parameter in Catalog.list_parameters
+    //   and its spec, protocol and address indices
+    // * function_key_idx is the parse function the
+    //   parameter uses for the protocol, or -1 if it has
+    //   no script for it (BuildParameterFrame throws)
+    struct CatalogParam
+    {
+        u32 parameter_idx;
+        u32 spec_idx;
+        u32 protocol_idx;
+        u32 address_idx;
+        sint function_key_idx;
+    };
+
+    // Catalog
+    // * everything in a definitions file that's needed to
+    //   request parameters, without building any frames
+    //   (see Parser::GetCatalog)
+    // * list_params is indexed by ParamId; parameters are
+    //   listed once in list_parameters however many
+    //   protocols they're requested with
+    struct Catalog
+    {
+        std::vector<CatalogSpec> list_specs;
+        std::vector<CatalogParameter> list_parameters;
+        std::vector<CatalogParam> list_params;
+    };
+}
+
+#endif // OBDEX_CATALOG_HPP
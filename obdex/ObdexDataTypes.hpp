@@ -54,6 +54,16 @@ namespace obdex
 
     using ByteList = std::vector<ubyte>;
 
+    // ParamId
+    // * a handle for a parameter in a spec, requested
+    //   from an address with a protocol; see
+    //   Parser::GetParamId
+    // * only valid for the Parser (or its clones) that
+    //   returned it
+    using ParamId = u32;
+
+    ParamId const k_invalid_param_id = ParamId(-1);
+
 
     struct LiteralData
     {
@@ -76,8 +86,16 @@ namespace obdex
         std::string property;
     };
 
+    // Data
+    // * param_name and src_name are the parameter and
+    //   address names of the ParameterFrame that was
+    //   parsed; they're empty for frames built from a
+    //   ParamId, use param_id instead
     struct Data
     {
+        Data() : param_id(k_invalid_param_id) {}
+
+        ParamId param_id;
         std::string param_name;
         std::string src_name;
         std::vector<LiteralData> list_literal_data;
@@ -122,6 +140,13 @@ namespace obdex
         // less than 0 means the expected length is unknown
         sint exp_data_byte_count;
 
+        // expected number of response frames (from all
+        // responders) for this request; interfaces like
+        // the ELM327 can stop waiting for a response once
+        // this many frames have been seen. A value less
+        // than 0 means the count is unknown
+        sint exp_response_count;
+
         // Raw Data
         // * each entry in the list contains bytes received for
         //   a single data frame in the format [header] [data]
@@ -142,7 +167,8 @@ namespace obdex
 
         MessageData() :
             req_data_delay_ms(0),
-            exp_data_byte_count(-1)
+            exp_data_byte_count(-1),
+            exp_response_count(-1)
         {}
     };
 
@@ -189,6 +215,10 @@ namespace obdex
         std::string             address;
         std::string             name;
 
+        // * set instead of the lookup strings when the
+        //   frame is built from a ParamId
+        ParamId                 param_id;
+
         // ISO 15765 Settings
         // * flag to calculate and add the PCI byte
         //   when generating MessageData.req_data_bytes
@@ -223,6 +253,7 @@ namespace obdex
 
 
         ParameterFrame() :
+            param_id(k_invalid_param_id),
             iso15765_add_pci_byte(true),
             iso15765_split_req_into_frames(true),
             iso14230_add_length_byte(false),
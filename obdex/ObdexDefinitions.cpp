@@ -0,0 +1,235 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexDefinitions.hpp>
+#include <obdex/ObdexErrors.hpp>
+#include <obdex/ObdexUtil.hpp>
+#include <obdex/pugixml/pugixml.hpp>
+
+#include <cstring>
+#include <unordered_map>
+
+namespace obdex
+{
+    namespace
+    {
+        void ReadElement(pugi::xml_node xn,
+                         DefinitionElement &element)
+        {
+            if(!xn)   {
+                return;
+            }
+
+            element.SetExists();
+            pugi::xml_attribute xa = xn.first_attribute();
+            for(; xa; xa=xa.next_attribute())   {
+                element.AddAttribute(xa.name(),xa.value());
+            }
+        }
+
+        // IndexParameters
+        // * fills in list_param_refs; ids are grouped by
+        //   spec, protocol and address, in file order
+        // * if a protocol lists an address more than
+        //   once, the first is used
+        void IndexParameters(Definitions &definitions)
+        {
+            for(u32 s=0; s < definitions.list_specs.size(); s++)
+            {
+                DefinitionSpec const &spec = definitions.list_specs[s];
+                for(u32 p=0; p < spec.list_protocols.size(); p++)
+                {
+                    DefinitionProtocol const &protocol = spec.list_protocols[p];
+                    for(u32 a=0; a < protocol.list_addresses.size(); a++)
+                    {
+                        std::string const &address = protocol.list_addresses[a].name;
+
+                        bool duplicate=false;
+                        for(u32 k=0; k < a; k++)   {
+                            duplicate = duplicate ||
+                                    protocol.list_addresses[k].name == address;
+                        }
+                        if(duplicate)   {
+                            continue;
+                        }
+
+                        for(u32 g=0; g < spec.list_param_groups.size(); g++)
+                        {
+                            DefinitionParameterGroup const &group = spec.list_param_groups[g];
+                            if(group.address != address)   {
+                                continue;
+                            }
+
+                            for(u32 i=0; i < group.list_parameters.size(); i++)   {
+                                DefinitionParamRef ref;
+                                ref.spec_idx = s;
+                                ref.protocol_idx = p;
+                                ref.address_idx = a;
+                                ref.group_idx = g;
+                                ref.param_idx = i;
+                                definitions.list_param_refs.push_back(ref);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    DefinitionElement::DefinitionElement() :
+        m_exists(false)
+    {}
+
+    bool DefinitionElement::HasAttribute(char const * name) const
+    {
+        for(auto const &attr : m_list_attrs)   {
+            if(std::strcmp(attr.first.c_str(),name) == 0)   {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string const & DefinitionElement::GetAttribute(char const * name) const
+    {
+        for(auto const &attr : m_list_attrs)   {
+            if(std::strcmp(attr.first.c_str(),name) == 0)   {
+                return attr.second;
+            }
+        }
+
+        static std::string const empty;
+        return empty;
+    }
+
+    void DefinitionElement::SetExists()
+    {
+        m_exists = true;
+    }
+
+    void DefinitionElement::AddAttribute(std::string name, std::string value)
+    {
+        m_list_attrs.emplace_back(std::move(name),std::move(value));
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void LoadDefinitions(std::string const &file_path,
+                         Definitions &definitions)
+    {
+        pugi::xml_document xml_doc;
+        auto xml_parse_result = xml_doc.load_file(file_path.c_str());
+
+        if(!xml_parse_result)
+        {
+            std::string err_desc;
+            err_desc += "Could not parse XML file: " + file_path;
+            err_desc += ": \n";
+            err_desc += xml_parse_result.description();
+            err_desc += ": \n offset char: ";
+            err_desc += ToString(s64(xml_parse_result.offset));
+
+            throw XMLParsingFailed(err_desc);
+        }
+
+        // the first parse function for each function key
+        std::unordered_map<std::string,sint> lkup_function_idx;
+
+        pugi::xml_node xn_spec = xml_doc.child("spec");
+        for(; xn_spec!=NULL; xn_spec=xn_spec.next_sibling("spec"))
+        {
+            definitions.list_specs.emplace_back();
+            DefinitionSpec &spec = definitions.list_specs.back();
+            spec.name = xn_spec.attribute("name").value();
+
+            pugi::xml_node xn_protocol = xn_spec.child("protocol");
+            for(; xn_protocol!=NULL; xn_protocol=xn_protocol.next_sibling("protocol"))
+            {
+                spec.list_protocols.emplace_back();
+                DefinitionProtocol &protocol = spec.list_protocols.back();
+                protocol.name = xn_protocol.attribute("name").value();
+
+                pugi::xml_node xn_option = xn_protocol.child("option");
+                for(; xn_option!=NULL; xn_option=xn_option.next_sibling("option"))   {
+                    protocol.list_options.emplace_back();
+                    ReadElement(xn_option,protocol.list_options.back());
+                }
+
+                pugi::xml_node xn_baudrate = xn_protocol.child("baudrate");
+                for(; xn_baudrate!=NULL; xn_baudrate=xn_baudrate.next_sibling("baudrate"))   {
+                    protocol.list_baudrates.push_back(xn_baudrate.attribute("value").value());
+                }
+
+                ReadElement(xn_protocol.child("timing"),protocol.timing);
+
+                pugi::xml_node xn_address = xn_protocol.child("address");
+                for(; xn_address!=NULL; xn_address=xn_address.next_sibling("address"))   {
+                    protocol.list_addresses.emplace_back();
+                    DefinitionAddress &address = protocol.list_addresses.back();
+                    address.name = xn_address.attribute("name").value();
+                    ReadElement(xn_address.child("request"),address.request);
+                    ReadElement(xn_address.child("response"),address.response);
+                }
+            }
+
+            pugi::xml_node xn_params = xn_spec.child("parameters");
+            for(; xn_params!=NULL; xn_params=xn_params.next_sibling("parameters"))
+            {
+                spec.list_param_groups.emplace_back();
+                DefinitionParameterGroup &group = spec.list_param_groups.back();
+                group.address = xn_params.attribute("address").value();
+
+                pugi::xml_node xn_param = xn_params.child("parameter");
+                for(; xn_param!=NULL; xn_param=xn_param.next_sibling("parameter"))
+                {
+                    group.list_parameters.emplace_back();
+                    DefinitionParameter &param = group.list_parameters.back();
+                    param.name = xn_param.attribute("name").value();
+                    ReadElement(xn_param,param.attributes);
+
+                    pugi::xml_node xn_script = xn_param.child("script");
+                    for(; xn_script!=NULL; xn_script=xn_script.next_sibling("script"))
+                    {
+                        DefinitionScript script;
+                        script.protocols = xn_script.attribute("protocols").value();
+
+                        // save unique key string and script for function
+                        std::string function_key =
+                                spec.name+":"+group.address+":"+
+                                param.name+":"+script.protocols;
+
+                        script.function_idx = sint(definitions.list_function_key.size());
+                        auto it = lkup_function_idx.emplace(function_key,script.function_idx);
+                        script.function_idx = it.first->second;
+
+                        definitions.list_function_key.push_back(std::move(function_key));
+                        definitions.list_script.push_back(xn_script.child_value());
+                        param.list_scripts.push_back(script);
+                    }
+                }
+            }
+        }
+
+        IndexParameters(definitions);
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
@@ -0,0 +1,157 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_DEFINITIONS_HPP
+#define OBDEX_DEFINITIONS_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    // DefinitionElement
+    // * the attributes of an element in a definitions file
+    class DefinitionElement
+    {
+    public:
+        DefinitionElement();
+
+        // Exists
+        // * false if the element isn't in the file
+        bool Exists() const
+        {
+            return m_exists;
+        }
+
+        bool HasAttribute(char const * name) const;
+
+        // GetAttribute
+        // * returns an empty string if there's no
+        //   attribute called @name
+        std::string const & GetAttribute(char const * name) const;
+
+        void SetExists();
+        void AddAttribute(std::string name, std::string value);
+
+    private:
+        bool m_exists;
+        std::vector<std::pair<std::string,std::string>> m_list_attrs;
+    };
+
+    // <address name="...">
+    //   <request ... />
+    //   <response ... />
+    // </address>
+    struct DefinitionAddress
+    {
+        std::string name;
+        DefinitionElement request;
+        DefinitionElement response;
+    };
+
+    // <protocol name="...">
+    //   <option name="..." value="..." />
+    //   <baudrate value="..." />
+    //   <timing ... />
+    //   <address ...> ... </address>
+    // </protocol>
+    struct DefinitionProtocol
+    {
+        std::string name;
+        std::vector<DefinitionElement> list_options;
+        std::vector<std::string> list_baudrates;
+        DefinitionElement timing;
+        std::vector<DefinitionAddress> list_addresses;
+    };
+
+    // <script protocols="..."> ... </script>
+    // * function_idx is the parse function for the
+    //   script (see Definitions.list_function_key)
+    struct DefinitionScript
+    {
+        std::string protocols;
+        sint function_idx;
+    };
+
+    // <parameter name="..." request="..." ...>
+    //   <script ...> ... </script>
+    // </parameter>
+    // * attributes holds all of the parameter's
+    //   attributes, including name
+    struct DefinitionParameter
+    {
+        std::string name;
+        DefinitionElement attributes;
+        std::vector<DefinitionScript> list_scripts;
+    };
+
+    // <parameters address="...">
+    struct DefinitionParameterGroup
+    {
+        std::string address;
+        std::vector<DefinitionParameter> list_parameters;
+    };
+
+    // <spec name="...">
+    struct DefinitionSpec
+    {
+        std::string name;
+        std::vector<DefinitionProtocol> list_protocols;
+        std::vector<DefinitionParameterGroup> list_param_groups;
+    };
+
+    // DefinitionParamRef
+    // * the position of a parameter and the protocol and
+    //   address it's requested with in the tables
+    // * indices are into list_specs, the spec's
+    //   list_protocols, the protocol's list_addresses,
+    //   the spec's list_param_groups and the group's
+    //   list_parameters
+    struct DefinitionParamRef
+    {
+        u32 spec_idx;
+        u32 protocol_idx;
+        u32 address_idx;
+        u32 group_idx;
+        u32 param_idx;
+    };
+
+    // Definitions
+    // * everything the Parser uses from a definitions
+    //   file, in the order it appears in the file
+    // * list_function_key and list_script have a parse
+    //   function for every script; the function key is
+    //   "spec:address:parameter:protocols"
+    // * list_param_refs has every parameter for every
+    //   protocol in its spec that has its address, and
+    //   is indexed by ParamId
+    struct Definitions
+    {
+        std::vector<DefinitionSpec> list_specs;
+        std::vector<std::string> list_function_key;
+        std::vector<std::string> list_script;
+        std::vector<DefinitionParamRef> list_param_refs;
+    };
+
+    // LoadDefinitions
+    // * reads the definitions file at @file_path into
+    //   @definitions; the xml document is only kept
+    //   while it's being read
+    // * throws XMLParsingFailed
+    void LoadDefinitions(std::string const &file_path,
+                         Definitions &definitions);
+}
+
+#endif // OBDEX_DEFINITIONS_HPP
@@ -92,4 +92,49 @@ namespace obdex
     {}
 
     // ============================================================= //
+
+    InvalidScriptEngine::InvalidScriptEngine(std::string msg) :
+        Exception(ErrorLevel::ERROR,std::move(msg))
+    {}
+
+    InvalidScriptEngine::~InvalidScriptEngine()
+    {}
+
+    // ============================================================= //
+
+    ScriptBudgetExceeded::ScriptBudgetExceeded(std::string msg) :
+        Exception(ErrorLevel::ERROR,std::move(msg))
+    {}
+
+    ScriptBudgetExceeded::~ScriptBudgetExceeded()
+    {}
+
+    // ============================================================= //
+
+    ScriptHeapLimitExceeded::ScriptHeapLimitExceeded(std::string msg) :
+        Exception(ErrorLevel::ERROR,std::move(msg))
+    {}
+
+    ScriptHeapLimitExceeded::~ScriptHeapLimitExceeded()
+    {}
+
+    // ============================================================= //
+
+    InvalidParamId::InvalidParamId(std::string msg) :
+        Exception(ErrorLevel::ERROR,std::move(msg))
+    {}
+
+    InvalidParamId::~InvalidParamId()
+    {}
+
+    // ============================================================= //
+
+    InvalidArgument::InvalidArgument(std::string msg) :
+        Exception(ErrorLevel::ERROR,std::move(msg))
+    {}
+
+    InvalidArgument::~InvalidArgument()
+    {}
+
+    // ============================================================= //
 }
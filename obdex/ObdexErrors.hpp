@@ -87,6 +87,51 @@ namespace obdex
     };
 
     // ============================================================= //
+
+    class InvalidScriptEngine : public Exception
+    {
+    public:
+        InvalidScriptEngine(std::string msg);
+        ~InvalidScriptEngine();
+    };
+
+    // ============================================================= //
+
+    class ScriptBudgetExceeded : public Exception
+    {
+    public:
+        ScriptBudgetExceeded(std::string msg);
+        ~ScriptBudgetExceeded();
+    };
+
+    // ============================================================= //
+
+    class ScriptHeapLimitExceeded : public Exception
+    {
+    public:
+        ScriptHeapLimitExceeded(std::string msg);
+        ~ScriptHeapLimitExceeded();
+    };
+
+    // ============================================================= //
+
+    class InvalidParamId : public Exception
+    {
+    public:
+        InvalidParamId(std::string msg);
+        ~InvalidParamId();
+    };
+
+    // ============================================================= //
+
+    class InvalidArgument : public Exception
+    {
+    public:
+        InvalidArgument(std::string msg);
+        ~InvalidArgument();
+    };
+
+    // ============================================================= //
 }
 
 #endif // OBDEX_ERRORS_HPP
@@ -16,6 +16,8 @@
 
 #include <obdex/ObdexLog.hpp>
 
+#include <algorithm>
+
 #ifdef __ANDROID__
 #include <android/log.h>
 #endif
@@ -33,10 +35,35 @@ namespace obdex
 
     // ============================================================= //
 
+    std::string LogFormatBlock::GetAt(std::chrono::system_clock::time_point const &)
+    {
+        return Get();
+    }
+
+    void LogFormatBlock::AppendTo(std::string &line,
+                                  std::chrono::system_clock::time_point const &time)
+    {
+        line.append(GetAt(time));
+    }
+
+    // ============================================================= //
+
+    namespace
+    {
+        // appends @val with at least @width digits
+        void AppendZeroPadded(std::string &line, u64 val, size_t width)
+        {
+            char buf[k_format_int_chars];
+            size_t const len = FormatUInt(buf,val);
+            if(len < width)   {
+                line.append(width-len,'0');
+            }
+            line.append(buf,len);
+        }
+    }
+
     LogFBRunTimeMs::LogFBRunTimeMs() :
-        m_time_str("00:00:00.000"),
-        m_start(std::chrono::system_clock::now()),
-        m_list_num_chars({{'0','1','2','3','4','5','6','7','8','9'}})
+        m_start(std::chrono::system_clock::now())
     {
         // empty
     }
@@ -48,48 +75,37 @@ namespace obdex
 
     std::string LogFBRunTimeMs::Get()
     {
-        // TODO: should we use steady_clock, not system clock?
-        auto now = std::chrono::system_clock::now();
-        std::chrono::system_clock::duration elapsed = now-m_start;
-
-        std::chrono::hours hours =
-                std::chrono::duration_cast<std::chrono::hours>(
-                    elapsed);
-        elapsed -= hours;
+        return GetAt(std::chrono::system_clock::now());
+    }
 
-        std::chrono::minutes mins =
-                std::chrono::duration_cast<std::chrono::minutes>(
-                    elapsed);
-        elapsed -= mins;
+    std::string LogFBRunTimeMs::GetAt(std::chrono::system_clock::time_point const &time)
+    {
+        std::string time_str;
+        AppendTo(time_str,time);
+        return time_str;
+    }
 
-        std::chrono::seconds secs =
-                std::chrono::duration_cast<std::chrono::seconds>(
-                    elapsed);
-        elapsed -= secs;
+    void LogFBRunTimeMs::AppendTo(std::string &line,
+                                  std::chrono::system_clock::time_point const &time)
+    {
+        // TODO: should we use steady_clock, not system clock?
+        std::chrono::system_clock::duration elapsed = time-m_start;
+        if(elapsed.count() < 0)   {
+            elapsed = std::chrono::system_clock::duration(0);
+        }
 
-        std::chrono::milliseconds ms =
+        u64 const ms_total =
                 std::chrono::duration_cast<std::chrono::milliseconds>(
-                    elapsed);
-
-        uint_fast8_t const hours_count = hours.count();
-        uint_fast8_t const mins_count = mins.count();
-        uint_fast8_t const secs_count = secs.count();
-        uint_fast16_t const ms_count = ms.count();
-
-        m_time_str[0] = m_list_num_chars[hours_count/10];
-        m_time_str[1] = m_list_num_chars[hours_count%10];
-
-        m_time_str[3] = m_list_num_chars[mins_count/10];
-        m_time_str[4] = m_list_num_chars[mins_count%10];
-
-        m_time_str[6] = m_list_num_chars[secs_count/10];
-        m_time_str[7] = m_list_num_chars[secs_count%10];
-
-        m_time_str[9] = m_list_num_chars[ms_count/100];
-        m_time_str[10] = m_list_num_chars[(ms_count%100)/10];
-        m_time_str[11] = m_list_num_chars[(ms_count%100)%10];
-
-        return m_time_str;
+                    elapsed).count();
+
+        // hours keep growing past two digits
+        AppendZeroPadded(line,ms_total/3600000,2);
+        line.push_back(':');
+        AppendZeroPadded(line,(ms_total/60000)%60,2);
+        line.push_back(':');
+        AppendZeroPadded(line,(ms_total/1000)%60,2);
+        line.push_back('.');
+        AppendZeroPadded(line,ms_total%1000,3);
     }
 
     LogFBCustomStr::LogFBCustomStr(std::string const &s) : m_s(s)
@@ -107,24 +123,178 @@ namespace obdex
         return m_s;
     }
 
+    void LogFBCustomStr::AppendTo(std::string &line,
+                                  std::chrono::system_clock::time_point const &)
+    {
+        line.append(m_s);
+    }
+
+    // ============================================================= //
+
+    namespace
+    {
+        std::atomic<u64> g_logger_count(0);
+
+        u8 const k_all_levels = 0x3F;
+
+        // AsyncRingRef
+        // * the ring a thread uses for a Logger's current
+        //   async session
+        struct AsyncRingRef
+        {
+            u64 logger_id;
+            u64 session;
+            std::shared_ptr<void> ring;
+        };
+
+        thread_local std::vector<AsyncRingRef> tl_list_async_rings;
+
+        // reused by Lines in async mode so that building
+        // a line doesn't allocate once it has grown
+        thread_local std::string tl_async_line;
+    }
+
+    struct Logger::AsyncRing
+    {
+        struct Entry
+        {
+            Level level;
+            std::chrono::system_clock::time_point time;
+            size_t length;
+            std::array<char,k_async_max_line_length> text;
+        };
+
+        explicit AsyncRing(size_t capacity) :
+            list_entries(capacity),
+            mask(capacity-1),
+            head(0),
+            tail(0)
+        {}
+
+        // Push
+        // * called by the producer; wait-free
+        bool Push(Level level,
+                  std::chrono::system_clock::time_point const &time,
+                  std::string const &line)
+        {
+            size_t const h = head.load(std::memory_order_relaxed);
+            if(h - tail.load(std::memory_order_acquire) > mask)   {
+                return false; // full
+            }
+
+            Entry &entry = list_entries[h & mask];
+            entry.level = level;
+            entry.time = time;
+            entry.length = std::min(line.size(),k_async_max_line_length);
+            line.copy(entry.text.data(),entry.length);
+
+            head.store(h+1,std::memory_order_release);
+            return true;
+        }
+
+        // Front, Pop
+        // * called by the consumer
+        Entry const * Front() const
+        {
+            size_t const t = tail.load(std::memory_order_relaxed);
+            if(t == head.load(std::memory_order_acquire))   {
+                return nullptr;
+            }
+            return &(list_entries[t & mask]);
+        }
+
+        void Pop()
+        {
+            tail.store(tail.load(std::memory_order_relaxed)+1,
+                       std::memory_order_release);
+        }
+
+        std::vector<Entry> list_entries;
+        size_t const mask;
+
+        // written by the producer and consumer respectively;
+        // kept on separate cache lines
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+    };
+
     // ============================================================= //
 
-    Logger::Logger()
+    size_t const Logger::k_async_max_line_length;
+
+    Logger::Line::Line(Logger * logger,
+                       Level level,
+                       bool line_valid,
+                       bool async) :
+        m_logger(logger),
+        m_level(level),
+        m_line_valid(line_valid),
+        m_async(async)
+    {
+        if(!m_line_valid) {
+            return;
+        }
+
+        if(m_async) {
+            // the prefix is added by the async thread
+            m_time = std::chrono::system_clock::now();
+            m_line.swap(tl_async_line);
+            m_line.clear();
+        }
+        else {
+            // create the prefix
+            auto const &list_fb = m_logger->m_list_fb[static_cast<size_t>(m_level)];
+            if(!list_fb.empty()) {
+                auto const now = std::chrono::system_clock::now();
+                for(auto & fb : list_fb) {
+                    fb->AppendTo(m_line,now);
+                }
+            }
+        }
+    }
+
+    Logger::Line::~Line()
     {
-        m_mutex.reset(new MutexSTL);
+        if(m_async) {
+            if(m_line_valid) {
+                m_logger->queueLine(m_level,m_time,m_line);
+                m_line.swap(tl_async_line);
+            }
+            m_logger->m_async_producers.fetch_sub(1);
+            return;
+        }
 
-        // default filter is all on
-        m_filter.set(static_cast<size_t>(Level::TRACE));
-        m_filter.set(static_cast<size_t>(Level::DEBUG));
-        m_filter.set(static_cast<size_t>(Level::INFO));
-        m_filter.set(static_cast<size_t>(Level::WARN));
-        m_filter.set(static_cast<size_t>(Level::ERROR));
-        m_filter.set(static_cast<size_t>(Level::FATAL));
+        if(m_line_valid) {
+            m_logger->writeLine(m_level,m_line);
+            m_logger->m_mutex->unlock();
+        }
     }
 
+    // ============================================================= //
+
+    Logger::Logger() :
+        m_mutex(new MutexSTL),
+        m_filter(k_all_levels), // default filter is all on
+        m_id(g_logger_count++),
+        m_async(false),
+        m_async_stop(false),
+        m_async_session(0),
+        m_async_dropped(0),
+        m_async_producers(0),
+        m_async_ring_capacity(0)
+    {}
+
     Logger::Logger(bool thread_safe,
                    std::shared_ptr<LogSink> const &sink,
-                   std::array<std::vector<LogFormatBlock*>,6> && list_fbs)
+                   std::array<std::vector<LogFormatBlock*>,6> && list_fbs) :
+        m_filter(k_all_levels), // default filter is all on
+        m_id(g_logger_count++),
+        m_async(false),
+        m_async_stop(false),
+        m_async_session(0),
+        m_async_dropped(0),
+        m_async_producers(0),
+        m_async_ring_capacity(0)
     {
         if(thread_safe) {
             m_mutex.reset(new MutexSTL);
@@ -144,14 +314,11 @@ namespace obdex
                                 list_fbs[level][fb_idx]));
             }
         }
+    }
 
-        // default filter is all on
-        m_filter.set(static_cast<size_t>(Level::TRACE));
-        m_filter.set(static_cast<size_t>(Level::DEBUG));
-        m_filter.set(static_cast<size_t>(Level::INFO));
-        m_filter.set(static_cast<size_t>(Level::WARN));
-        m_filter.set(static_cast<size_t>(Level::ERROR));
-        m_filter.set(static_cast<size_t>(Level::FATAL));
+    Logger::~Logger()
+    {
+        StopAsync();
     }
 
     bool Logger::AddSink(std::shared_ptr<LogSink> const &new_sink)
@@ -194,16 +361,12 @@ namespace obdex
 
     void Logger::SetLevel(Level level)
     {
-        m_mutex->lock();
-        m_filter.set(static_cast<size_t>(level));
-        m_mutex->unlock();
+        m_filter.fetch_or(u8(1 << static_cast<size_t>(level)));
     }
 
     void Logger::UnsetLevel(Level level)
     {
-        m_mutex->lock();
-        m_filter.reset(static_cast<size_t>(level));
-        m_mutex->unlock();
+        m_filter.fetch_and(u8(~(1 << static_cast<size_t>(level))));
     }
 
     void Logger::AddFormatBlock(std::unique_ptr<LogFormatBlock> fb,
@@ -215,90 +378,258 @@ namespace obdex
         m_mutex->unlock();
     }
 
-    // logging methods
-    Logger::Line Logger::Custom(Level level)
+    void Logger::StartAsync(size_t ring_capacity,
+                            Milliseconds poll_interval)
     {
-        m_mutex->lock();
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        if(m_async) {
+            return;
+        }
 
-        size_t const level_int = static_cast<size_t>(level);
+        size_t capacity=1;
+        while(capacity < ring_capacity) {
+            capacity <<= 1;
+        }
+        m_async_ring_capacity = capacity;
 
-        return Line(&m_list_sinks,
-                    &(m_list_fb[level_int]),
-                    m_mutex.get(),
-                    m_filter[level_int]);
+        // threads register a new ring for each session
+        m_async_session++;
+        m_async_stop = false;
+        m_async_thread = std::thread(&Logger::asyncThread,this,poll_interval);
+        m_async = true;
     }
 
+    void Logger::StopAsync()
+    {
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        if(!m_async) {
+            return;
+        }
 
-    Logger::Line Logger::Trace()
+        // wait for threads that saw m_async before it was
+        // cleared to queue their lines so that the final
+        // drain in asyncThread writes them
+        m_async = false;
+        while(m_async_producers.load() != 0) {
+            std::this_thread::yield();
+        }
+
+        {
+            std::lock_guard<std::mutex> wait_lock(m_async_wait_mutex);
+            m_async_stop = true;
+        }
+        m_async_wait_cv.notify_one();
+        m_async_thread.join();
+
+        std::lock_guard<std::mutex> rings_lock(m_async_rings_mutex);
+        m_list_async_rings.clear();
+    }
+
+    void Logger::Flush()
     {
-        m_mutex->lock();
+        drainAsyncRings();
+    }
 
-        size_t const level = static_cast<size_t>(Level::TRACE);
+    bool Logger::IsAsync() const
+    {
+        return m_async;
+    }
 
-        return Line(&m_list_sinks,
-                    &(m_list_fb[level]),
-                    m_mutex.get(),
-                    m_filter[level]);
+    u64 Logger::GetDroppedLineCount() const
+    {
+        return m_async_dropped;
     }
 
-    Logger::Line Logger::Debug()
+    // logging methods
+    Logger::Line Logger::Custom(Level level)
     {
+        if(!IsLevelEnabled(level)) {
+            return Line(this,level,false,false);
+        }
+
+        if(m_async.load(std::memory_order_acquire)) {
+            // the line is in flight until its Line is destroyed;
+            // m_async is checked again after counting it so
+            // StopAsync either waits for it or it isn't async
+            m_async_producers.fetch_add(1);
+            if(m_async.load()) {
+                return Line(this,level,true,true);
+            }
+            m_async_producers.fetch_sub(1);
+        }
+
         m_mutex->lock();
+        return Line(this,level,true,false);
+    }
 
-        size_t const level = static_cast<size_t>(Level::DEBUG);
 
-        return Line(&m_list_sinks,
-                    &(m_list_fb[level]),
-                    m_mutex.get(),
-                    m_filter[level]);
+    Logger::Line Logger::Trace()
+    {
+        return Custom(Level::TRACE);
+    }
+
+    Logger::Line Logger::Debug()
+    {
+        return Custom(Level::DEBUG);
     }
 
     Logger::Line Logger::Info()
     {
-        m_mutex->lock();
+        return Custom(Level::INFO);
+    }
 
-        size_t const level = static_cast<size_t>(Level::INFO);
+    Logger::Line Logger::Warn()
+    {
+        return Custom(Level::WARN);
+    }
 
-        return Line(&m_list_sinks,
-                    &(m_list_fb[level]),
-                    m_mutex.get(),
-                    m_filter[level]);
+    Logger::Line Logger::Error()
+    {
+        return Custom(Level::ERROR);
     }
 
-    Logger::Line Logger::Warn()
+    Logger::Line Logger::Fatal()
     {
-        m_mutex->lock();
+        return Custom(Level::FATAL);
+    }
 
-        size_t const level = static_cast<size_t>(Level::WARN);
+    void Logger::writeLine(Level,std::string const &line)
+    {
+        for(auto &sink : m_list_sinks) {
+            sink->log(line);
+        }
+    }
 
-        return Line(&m_list_sinks,
-                    &(m_list_fb[level]),
-                    m_mutex.get(),
-                    m_filter[level]);
+    void Logger::queueLine(Level level,
+                           std::chrono::system_clock::time_point const &time,
+                           std::string const &line)
+    {
+        std::shared_ptr<AsyncRing> ring = getAsyncRing();
+        if(!ring->Push(level,time,line)) {
+            m_async_dropped.fetch_add(1,std::memory_order_relaxed);
+        }
     }
 
-    Logger::Line Logger::Error()
+    std::shared_ptr<Logger::AsyncRing> Logger::getAsyncRing()
     {
-        m_mutex->lock();
+        u64 const session = m_async_session.load(std::memory_order_relaxed);
+
+        for(auto &ref : tl_list_async_rings) {
+            if(ref.logger_id == m_id) {
+                if(ref.session == session) {
+                    return std::static_pointer_cast<AsyncRing>(ref.ring);
+                }
+
+                // ring from a previous session
+                ref.session = session;
+                ref.ring.reset();
+                break;
+            }
+        }
 
-        size_t const level = static_cast<size_t>(Level::ERROR);
+        // first line from this thread for this session
+        std::shared_ptr<AsyncRing> ring =
+                std::make_shared<AsyncRing>(m_async_ring_capacity);
+        {
+            // StopAsync doesn't clear the list until this
+            // line is no longer in flight
+            std::lock_guard<std::mutex> lock(m_async_rings_mutex);
+            m_list_async_rings.push_back(ring);
+        }
+
+        for(auto &ref : tl_list_async_rings) {
+            if(ref.logger_id == m_id) {
+                ref.ring = ring;
+                return ring;
+            }
+        }
+
+        AsyncRingRef ref;
+        ref.logger_id = m_id;
+        ref.session = session;
+        ref.ring = ring;
+        tl_list_async_rings.push_back(ref);
 
-        return Line(&m_list_sinks,
-                    &(m_list_fb[level]),
-                    m_mutex.get(),
-                    m_filter[level]);
+        return ring;
     }
 
-    Logger::Line Logger::Fatal()
+    bool Logger::drainAsyncRings()
     {
+        std::lock_guard<std::mutex> drain_lock(m_async_drain_mutex);
+
+        std::vector<std::shared_ptr<AsyncRing>> list_rings;
+        {
+            std::lock_guard<std::mutex> lock(m_async_rings_mutex);
+            list_rings = m_list_async_rings;
+        }
+
+        bool wrote_lines=false;
         m_mutex->lock();
 
-        size_t const level = static_cast<size_t>(Level::FATAL);
+        for(;;) {
+            // write the oldest line first
+            AsyncRing * oldest_ring = nullptr;
+            AsyncRing::Entry const * oldest_entry = nullptr;
+            for(auto &ring : list_rings) {
+                AsyncRing::Entry const * entry = ring->Front();
+                if(entry && (!oldest_entry || entry->time < oldest_entry->time)) {
+                    oldest_ring = ring.get();
+                    oldest_entry = entry;
+                }
+            }
+
+            if(!oldest_entry) {
+                break;
+            }
+
+            Level const level = oldest_entry->level;
+            m_async_line.clear();
+            for(auto &fb : m_list_fb[static_cast<size_t>(level)]) {
+                fb->AppendTo(m_async_line,oldest_entry->time);
+            }
+            m_async_line.append(oldest_entry->text.data(),oldest_entry->length);
+
+            // the producer can reuse the entry once it's popped
+            oldest_ring->Pop();
+
+            writeLine(level,m_async_line);
+            wrote_lines = true;
+        }
+
+        m_mutex->unlock();
+
+        // forget rings of threads that have exited; these
+        // are only referenced by list_rings and the Logger
+        {
+            std::lock_guard<std::mutex> lock(m_async_rings_mutex);
+            for(auto &ring : list_rings) {
+                if(ring.use_count() == 2 && ring->Front() == nullptr) {
+                    auto it = std::find(m_list_async_rings.begin(),
+                                        m_list_async_rings.end(),
+                                        ring);
+                    if(it != m_list_async_rings.end()) {
+                        m_list_async_rings.erase(it);
+                    }
+                }
+            }
+        }
+
+        return wrote_lines;
+    }
+
+    void Logger::asyncThread(Milliseconds poll_interval)
+    {
+        while(!m_async_stop) {
+            if(!drainAsyncRings()) {
+                std::unique_lock<std::mutex> lock(m_async_wait_mutex);
+                m_async_wait_cv.wait_for(lock,poll_interval,[this]() {
+                    return m_async_stop.load();
+                });
+            }
+        }
 
-        return Line(&m_list_sinks,
-                    &(m_list_fb[level]),
-                    m_mutex.get(),
-                    m_filter[level]);
+        // lines logged while stopping
+        drainAsyncRings();
     }
 
     // ============================================================= //
@@ -18,13 +18,55 @@
 #define OBDEX_LOG_HPP
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
-#include <bitset>
+#include <thread>
 #include <iostream>
 #include <memory>
 #include <vector>
+#include <obdex/ObdexDataTypes.hpp>
 #include <obdex/ObdexUtil.hpp>
 
+// OBDEX_LOG_MIN_LEVEL
+// * lines below this level (0=TRACE ... 5=FATAL) are
+//   compiled out of OBDEX_LOG[...] macros, ie. define
+//   it as 3 to only keep warnings and errors
+#ifndef OBDEX_LOG_MIN_LEVEL
+#define OBDEX_LOG_MIN_LEVEL 0
+#endif
+
+// OBDEX_LOG
+// * logs a line like logger.Custom(level), but the line's
+//   arguments are only evaluated if the level is enabled
+//   (and no lock is taken otherwise):
+//
+//   OBDEX_LOG_WARN(obdexlog) << "bad frame: " << ToHexString(b);
+//
+// * the minimum level check is left out when nothing is
+//   compiled out (it'd always be true and warn with
+//   -Wtype-limits)
+#if OBDEX_LOG_MIN_LEVEL > 0
+#define OBDEX_LOG(logger,level) \
+    !((static_cast<int>(level) >= OBDEX_LOG_MIN_LEVEL) && \
+      (logger).IsLevelEnabled(level)) ? \
+        static_cast<void>(0) : \
+        obdex::LogVoidify() & (logger).Custom(level)
+#else
+#define OBDEX_LOG(logger,level) \
+    !(logger).IsLevelEnabled(level) ? \
+        static_cast<void>(0) : \
+        obdex::LogVoidify() & (logger).Custom(level)
+#endif
+
+#define OBDEX_LOG_TRACE(logger) OBDEX_LOG(logger,obdex::Logger::Level::TRACE)
+#define OBDEX_LOG_DEBUG(logger) OBDEX_LOG(logger,obdex::Logger::Level::DEBUG)
+#define OBDEX_LOG_INFO(logger)  OBDEX_LOG(logger,obdex::Logger::Level::INFO)
+#define OBDEX_LOG_WARN(logger)  OBDEX_LOG(logger,obdex::Logger::Level::WARN)
+#define OBDEX_LOG_ERROR(logger) OBDEX_LOG(logger,obdex::Logger::Level::ERROR)
+#define OBDEX_LOG_FATAL(logger) OBDEX_LOG(logger,obdex::Logger::Level::FATAL)
+
 namespace obdex
 {
     // ============================================================= //
@@ -78,6 +120,21 @@ namespace obdex
     public:
         virtual ~LogFormatBlock() = default;
         virtual std::string Get() = 0;
+
+        // GetAt
+        // * returns the block for a line logged at @time;
+        //   an async Logger formats lines some time after
+        //   they were logged
+        // * the default implementation ignores @time
+        virtual std::string GetAt(std::chrono::system_clock::time_point const &time);
+
+        // AppendTo
+        // * appends the block for a line logged at @time
+        //   to @line; the Logger uses this to build each
+        //   line's prefix without temporary strings
+        // * the default implementation appends GetAt(@time)
+        virtual void AppendTo(std::string &line,
+                              std::chrono::system_clock::time_point const &time);
     };
 
     // FBRunTimeMs
@@ -90,11 +147,12 @@ namespace obdex
         ~LogFBRunTimeMs();
 
         std::string Get();
+        std::string GetAt(std::chrono::system_clock::time_point const &time);
+        void AppendTo(std::string &line,
+                      std::chrono::system_clock::time_point const &time);
 
     private:
-        std::string m_time_str;
         std::chrono::system_clock::time_point const m_start;
-        std::array<char,10> const m_list_num_chars;
     };
 
     // FBCustomStr
@@ -106,6 +164,8 @@ namespace obdex
         ~LogFBCustomStr();
 
         std::string Get();
+        void AppendTo(std::string &line,
+                      std::chrono::system_clock::time_point const &time);
 
     private:
         std::string const m_s;
@@ -115,8 +175,26 @@ namespace obdex
 
     // Logger
     // * simple logging class with optional thread safety
+    // * lines are written to the sinks as they are logged
+    //   unless async mode is started (see StartAsync)
     class Logger
     {
+    public:
+        enum class Level : uint8_t
+        {
+            TRACE   = 0,
+            DEBUG   = 1,
+            INFO    = 2,
+            WARN    = 3,
+            ERROR   = 4,
+            FATAL   = 5
+        };
+
+        // longest line (without its prefix) that can
+        // be logged in async mode; longer lines are
+        // truncated
+        static size_t const k_async_max_line_length = 256;
+
     private:
         // Mutex
         // * abstract implementation of a mutex that
@@ -153,44 +231,34 @@ namespace obdex
             void unlock() {}
         };
 
+        // AsyncRing
+        // * single producer, single consumer queue of lines
+        //   logged by one thread in async mode
+        struct AsyncRing;
+
+    public:
         // Line
         // * class that wraps logging a line with RAII
         // * line is commited to log on destruction
+        // * in async mode the Logger's mutex isn't held;
+        //   the line is queued in the calling thread's
+        //   AsyncRing instead; lines from a disabled level
+        //   don't hold it either
         class Line
         {
         public:
-            Line(std::vector<std::shared_ptr<LogSink>> const * list_sinks,
-                 std::vector<std::unique_ptr<LogFormatBlock>> const * list_fb,
-                 Mutex * mutex,
-                 bool line_valid) :
-                m_list_sinks(list_sinks),
-                m_list_fb(list_fb),
-                m_mutex(mutex),
-                m_line_valid(line_valid)
-            {
-                if(m_line_valid) {
-                    // create the prefix
-                    for(auto & fb : (*m_list_fb)) {
-                        m_line.append(fb->Get());
-                    }
-                }
-            }
+            Line(Logger * logger,
+                 Level level,
+                 bool line_valid,
+                 bool async);
 
-            ~Line()
-            {
-                if(m_line_valid) {
-                    for(auto &sink : (*m_list_sinks)) {
-                        sink->log(m_line);
-                    }
-                }
-                m_mutex->unlock();
-            }
+            ~Line();
 
             template<typename T>
             Line & operator << (T const &msg)
             {
                 if(m_line_valid) {
-                    m_line.append(ToString(msg));
+                    AppendString(m_line,msg);
                 }
                 return *this;
             }
@@ -212,25 +280,16 @@ namespace obdex
             }
 
         private:
-            std::vector<std::shared_ptr<LogSink>> const * m_list_sinks;
-            std::vector<std::unique_ptr<LogFormatBlock>> const * m_list_fb;
-            Mutex * m_mutex;
+            Logger * m_logger;
+            Level const m_level;
             bool const m_line_valid;
+            bool const m_async;
+            std::chrono::system_clock::time_point m_time;
 
             std::string m_line;
         };
 
     public:
-        enum class Level : uint8_t
-        {
-            TRACE   = 0,
-            DEBUG   = 1,
-            INFO    = 2,
-            WARN    = 3,
-            ERROR   = 4,
-            FATAL   = 5
-        };
-
         // default constructor assumes thread safety is wanted
         Logger();
 
@@ -252,13 +311,67 @@ namespace obdex
                std::shared_ptr<LogSink> const &sink,
                std::array<std::vector<LogFormatBlock*>,6> && list_fbs);
 
+        ~Logger();
+
         bool AddSink(std::shared_ptr<LogSink> const &new_sink);
         bool RemoveSink(std::shared_ptr<LogSink> const &sink);
         void SetLevel(Level level);
         void UnsetLevel(Level level);
+
+        // IsLevelEnabled
+        // * returns false if lines at @level are filtered
+        //   out, either with UnsetLevel or at compile time
+        //   with OBDEX_LOG_MIN_LEVEL
+        // * doesn't lock; lines from a disabled level don't
+        //   lock either, but their arguments are still
+        //   evaluated unless the OBDEX_LOG macros are used
+        bool IsLevelEnabled(Level level) const
+        {
+            int const level_int = static_cast<int>(level);
+            return (level_int >= OBDEX_LOG_MIN_LEVEL) &&
+                   ((m_filter.load(std::memory_order_relaxed) >> level_int) & 1);
+        }
+
         void AddFormatBlock(std::unique_ptr<LogFormatBlock> fb,
                             Level level);
 
+        // StartAsync
+        // * starts a background thread that adds the prefix
+        //   to logged lines and writes them to the sinks
+        // * each logging thread gets its own lock-free ring
+        //   of @ring_capacity lines (rounded up to a power
+        //   of two); logging never waits, if the ring is
+        //   full the line is dropped and counted instead
+        // * the first line a thread logs in a session
+        //   allocates its ring and briefly locks to register
+        //   it; later lines don't lock or allocate
+        // * the background thread checks for new lines every
+        //   @poll_interval when there's nothing to write
+        // * lines from different threads are written in the
+        //   order they were logged
+        void StartAsync(size_t ring_capacity=256,
+                        Milliseconds poll_interval=Milliseconds(5));
+
+        // StopAsync
+        // * waits for lines that are being logged in async
+        //   mode, writes any queued lines and stops the
+        //   background thread; lines are written as they are
+        //   logged again afterwards
+        void StopAsync();
+
+        // Flush
+        // * in async mode, writes all lines queued before
+        //   the call to the sinks (ie. before exiting or
+        //   after a fatal error)
+        void Flush();
+
+        bool IsAsync() const;
+
+        // GetDroppedLineCount
+        // * returns the number of lines dropped because a
+        //   thread's ring was full in async mode
+        u64 GetDroppedLineCount() const;
+
         // logging methods
         Line Custom(Level level);
         Line Trace();
@@ -269,10 +382,52 @@ namespace obdex
         Line Fatal();
 
     private:
+        void writeLine(Level level,
+                       std::string const &line);
+
+        void queueLine(Level level,
+                       std::chrono::system_clock::time_point const &time,
+                       std::string const &line);
+
+        std::shared_ptr<AsyncRing> getAsyncRing();
+
+        // drainAsyncRings
+        // * writes queued lines to the sinks; returns
+        //   false if there weren't any
+        bool drainAsyncRings();
+
+        void asyncThread(Milliseconds poll_interval);
+
         std::unique_ptr<Mutex> m_mutex;
         std::vector<std::shared_ptr<LogSink>> m_list_sinks;
-        std::bitset<6> m_filter;
+        std::atomic<u8> m_filter;
         std::array<std::vector<std::unique_ptr<LogFormatBlock>>,6> m_list_fb;
+
+        // async
+        u64 const m_id;
+        std::atomic<bool> m_async;
+        std::atomic<bool> m_async_stop;
+        std::atomic<u64> m_async_session;
+        std::atomic<u64> m_async_dropped;
+        std::atomic<u32> m_async_producers; // async Lines in flight
+        size_t m_async_ring_capacity;
+        std::thread m_async_thread;
+        std::mutex m_async_mutex;           // start/stop
+        std::mutex m_async_drain_mutex;     // single consumer
+        std::mutex m_async_wait_mutex;      // m_async_wait_cv
+        std::condition_variable m_async_wait_cv;
+        std::mutex m_async_rings_mutex;     // m_list_async_rings
+        std::vector<std::shared_ptr<AsyncRing>> m_list_async_rings;
+        std::string m_async_line;
+    };
+
+    // LogVoidify
+    // * lets the OBDEX_LOG macros discard a Line in the
+    //   branch of a conditional expression; operator&
+    //   binds after all of the Line's operator<<
+    struct LogVoidify
+    {
+        void operator & (Logger::Line const &) {}
     };
 
     // ============================================================= //
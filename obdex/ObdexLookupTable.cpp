@@ -0,0 +1,180 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexLookupTable.hpp>
+
+#include <algorithm>
+
+namespace obdex
+{
+    ParseLookupTable::ParseLookupTable(std::vector<uint> const &list_byte_positions,
+                                       sint exp_data_length) :
+        m_list_byte_positions(list_byte_positions),
+        m_exp_data_length(exp_data_length),
+        m_min_data_length(0),
+        m_domain_size(1),
+        m_has_layout(false),
+        m_entry_count(0)
+    {
+        for(uint pos : m_list_byte_positions)   {
+            m_min_data_length = std::max(m_min_data_length,size_t(pos)+1);
+            m_domain_size *= 256;
+        }
+        m_list_state.resize(m_domain_size,ENTRY_EMPTY);
+    }
+
+    size_t ParseLookupTable::GetDomainSize() const
+    {
+        return m_domain_size;
+    }
+
+    std::vector<uint> const & ParseLookupTable::GetBytePositions() const
+    {
+        return m_list_byte_positions;
+    }
+
+    bool ParseLookupTable::GetIndex(ByteList const &data_bytes, size_t &idx) const
+    {
+        if(m_exp_data_length >= 0)   {
+            if(data_bytes.size() != size_t(m_exp_data_length))   {
+                return false;
+            }
+        }
+        else if(data_bytes.size() < m_min_data_length)   {
+            return false;
+        }
+
+        idx = 0;
+        for(uint pos : m_list_byte_positions)   {
+            idx = (idx << 8) | data_bytes[pos];
+        }
+        return true;
+    }
+
+    ByteList ParseLookupTable::GetDataBytes(size_t idx) const
+    {
+        size_t const length = (m_exp_data_length >= 0) ?
+                    size_t(m_exp_data_length) : m_min_data_length;
+
+        ByteList data_bytes(length,0);
+        for(size_t i=m_list_byte_positions.size(); i > 0; i--)   {
+            data_bytes[m_list_byte_positions[i-1]] = ubyte(idx & 0xFF);
+            idx >>= 8;
+        }
+        return data_bytes;
+    }
+
+    bool ParseLookupTable::Find(size_t idx, Data &data) const
+    {
+        if(m_list_state[idx] != ENTRY_TABLE)   {
+            return false;
+        }
+
+        size_t const num_count = m_list_num_layout.size();
+        for(size_t i=0; i < num_count; i++)   {
+            data.list_numerical_data.push_back(m_list_num_layout[i]);
+            data.list_numerical_data.back().value = m_list_num_values[idx*num_count+i];
+        }
+
+        size_t const lit_count = m_list_lit_layout.size();
+        for(size_t i=0; i < lit_count; i++)   {
+            data.list_literal_data.push_back(m_list_lit_layout[i]);
+            data.list_literal_data.back().value = (m_list_lit_values[idx*lit_count+i] != 0);
+        }
+
+        return true;
+    }
+
+    bool ParseLookupTable::IsEvaluated(size_t idx) const
+    {
+        return (m_list_state[idx] != ENTRY_EMPTY);
+    }
+
+    void ParseLookupTable::Insert(size_t idx, Data const &data)
+    {
+        if(m_list_state[idx] != ENTRY_EMPTY)   {
+            return;
+        }
+
+        // the first entry sets the layout for the table
+        if(!m_has_layout)   {
+            m_list_num_layout = data.list_numerical_data;
+            m_list_lit_layout = data.list_literal_data;
+            m_list_num_values.resize(m_domain_size*m_list_num_layout.size());
+            m_list_lit_values.resize(m_domain_size*m_list_lit_layout.size());
+            m_has_layout = true;
+        }
+
+        if(!matchesLayout(data))   {
+            m_list_state[idx] = ENTRY_SCRIPT;
+            return;
+        }
+
+        size_t const num_count = m_list_num_layout.size();
+        for(size_t i=0; i < num_count; i++)   {
+            m_list_num_values[idx*num_count+i] = data.list_numerical_data[i].value;
+        }
+
+        size_t const lit_count = m_list_lit_layout.size();
+        for(size_t i=0; i < lit_count; i++)   {
+            m_list_lit_values[idx*lit_count+i] = data.list_literal_data[i].value ? 1 : 0;
+        }
+
+        m_list_state[idx] = ENTRY_TABLE;
+        m_entry_count++;
+    }
+
+    size_t ParseLookupTable::GetEntryCount() const
+    {
+        return m_entry_count;
+    }
+
+    size_t ParseLookupTable::GetMemoryBytes() const
+    {
+        return (m_list_state.capacity() +
+                m_list_num_values.capacity()*sizeof(double) +
+                m_list_lit_values.capacity());
+    }
+
+    bool ParseLookupTable::matchesLayout(Data const &data) const
+    {
+        if(data.list_numerical_data.size() != m_list_num_layout.size() ||
+           data.list_literal_data.size() != m_list_lit_layout.size())   {
+            return false;
+        }
+
+        for(size_t i=0; i < m_list_num_layout.size(); i++)   {
+            NumericalData const &a = data.list_numerical_data[i];
+            NumericalData const &b = m_list_num_layout[i];
+            if(a.min != b.min || a.max != b.max ||
+               a.units != b.units || a.property != b.property)   {
+                return false;
+            }
+        }
+
+        for(size_t i=0; i < m_list_lit_layout.size(); i++)   {
+            LiteralData const &a = data.list_literal_data[i];
+            LiteralData const &b = m_list_lit_layout[i];
+            if(a.value_if_false != b.value_if_false ||
+               a.value_if_true != b.value_if_true ||
+               a.property != b.property)   {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
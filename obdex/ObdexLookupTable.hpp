@@ -0,0 +1,134 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_LOOKUP_TABLE_HPP
+#define OBDEX_LOOKUP_TABLE_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    // LookupTableStats
+    // * hits are responses decoded from a table, misses
+    //   are responses that ran the parse script
+    // * entries is the number of inputs evaluated into
+    //   tables so far and memory_bytes is their size
+    struct LookupTableStats
+    {
+        LookupTableStats() :
+            hits(0),
+            misses(0),
+            table_count(0),
+            entries(0),
+            memory_bytes(0)
+        {}
+
+        u64 hits;
+        u64 misses;
+        size_t table_count;
+        size_t entries;
+        size_t memory_bytes;
+    };
+
+    // ParseLookupTable
+    // * the results of a parse script for every possible
+    //   value of the data bytes it reads
+    // * only used for scripts whose results depend on
+    //   nothing but the data bytes (see AnalyzeScript);
+    //   the key for a response is made from the bytes at
+    //   list_byte_positions
+    // * entries are filled in as inputs are parsed for
+    //   the first time (or all at once by the Parser)
+    // * every input must give results with the same
+    //   properties, units, limits and literal strings;
+    //   only the values are kept for each input. Inputs
+    //   with a different layout are marked so that they
+    //   always run the script
+    class ParseLookupTable
+    {
+    public:
+        // @exp_data_length
+        // * if not negative, only responses with exactly
+        //   this many data bytes use the table; otherwise
+        //   responses need to have every byte position
+        ParseLookupTable(std::vector<uint> const &list_byte_positions,
+                         sint exp_data_length);
+
+        size_t GetDomainSize() const;
+
+        std::vector<uint> const & GetBytePositions() const;
+
+        // GetIndex
+        // * sets @idx to the table entry for @data_bytes and
+        //   returns true, or returns false if @data_bytes
+        //   can't use the table
+        bool GetIndex(ByteList const &data_bytes, size_t &idx) const;
+
+        // GetDataBytes
+        // * returns the data bytes for entry @idx; bytes
+        //   the script doesn't read are zero
+        ByteList GetDataBytes(size_t idx) const;
+
+        // Find
+        // * if entry @idx has been evaluated, appends its
+        //   numerical and literal data to @data and
+        //   returns true
+        bool Find(size_t idx, Data &data) const;
+
+        // IsEvaluated
+        // * returns true if entry @idx doesn't need to be
+        //   evaluated again (it's in the table, or its
+        //   layout didn't match and it uses the script)
+        bool IsEvaluated(size_t idx) const;
+
+        // Insert
+        // * saves the numerical and literal data in @data
+        //   as the results for entry @idx
+        void Insert(size_t idx, Data const &data);
+
+        size_t GetEntryCount() const;
+
+        size_t GetMemoryBytes() const;
+
+    private:
+        enum EntryState
+        {
+            ENTRY_EMPTY,
+            ENTRY_TABLE,
+            ENTRY_SCRIPT
+        };
+
+        bool matchesLayout(Data const &data) const;
+
+        std::vector<uint> const m_list_byte_positions;
+        sint const m_exp_data_length;
+        size_t m_min_data_length;
+        size_t m_domain_size;
+
+        // shared layout (values are ignored)
+        bool m_has_layout;
+        std::vector<NumericalData> m_list_num_layout;
+        std::vector<LiteralData> m_list_lit_layout;
+
+        // per entry values
+        std::vector<u8> m_list_state;
+        std::vector<double> m_list_num_values;
+        std::vector<u8> m_list_lit_values;
+        size_t m_entry_count;
+    };
+}
+
+#endif // OBDEX_LOOKUP_TABLE_HPP
@@ -0,0 +1,361 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexNativeScripts.hpp>
+
+#include <cmath>
+#include <mutex>
+
+namespace obdex
+{
+    namespace
+    {
+        struct NativeScriptRegistry
+        {
+            std::mutex mutex;
+            std::vector<NativeScript> list_scripts;
+        };
+
+        NativeScriptRegistry & GetRegistry()
+        {
+            static NativeScriptRegistry registry;
+            return registry;
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    NativeScriptInput::NativeScriptInput(ByteList const &data_bytes) :
+        m_data_bytes(&data_bytes),
+        m_list_msg_data(nullptr),
+        m_budget_counter(nullptr)
+    {}
+
+    NativeScriptInput::NativeScriptInput(std::vector<MessageData> const &list_msg_data) :
+        m_data_bytes(nullptr),
+        m_list_msg_data(&list_msg_data),
+        m_budget_counter(nullptr)
+    {}
+
+    size_t NativeScriptInput::GetRequestCount() const
+    {
+        return (m_list_msg_data) ? m_list_msg_data->size() : 1;
+    }
+
+    size_t NativeScriptInput::GetResponseCount(size_t req) const
+    {
+        if(req >= GetRequestCount())   {
+            throw native::Bail();
+        }
+        return (m_list_msg_data) ? (*m_list_msg_data)[req].list_data.size() : 1;
+    }
+
+    ByteList const * NativeScriptInput::GetData(size_t req, size_t resp) const
+    {
+        if(resp >= GetResponseCount(req))   {
+            throw native::Bail();
+        }
+        return (m_list_msg_data) ? &((*m_list_msg_data)[req].list_data[resp]) : m_data_bytes;
+    }
+
+    ByteList const * NativeScriptInput::GetHeader(size_t req, size_t idx) const
+    {
+        if(m_list_msg_data == nullptr ||
+           req >= m_list_msg_data->size() ||
+           idx >= (*m_list_msg_data)[req].list_headers.size())   {
+            throw native::Bail();
+        }
+        return &((*m_list_msg_data)[req].list_headers[idx]);
+    }
+
+    void NativeScriptInput::SetBudgetCounter(ScriptBudgetCounter * counter)
+    {
+        m_budget_counter = counter;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    u64 HashScript(std::string const &script)
+    {
+        u64 hash = 0xCBF29CE484222325ull;
+        for(char c : script)   {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    void RegisterNativeScripts(NativeScript const * list, size_t count)
+    {
+        NativeScriptRegistry &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.list_scripts.insert(registry.list_scripts.end(),list,list+count);
+    }
+
+    NativeParseFunction FindNativeScript(std::string const &function_key,
+                                         u64 script_hash)
+    {
+        NativeScriptRegistry &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        // scripts registered later take precedence
+        for(auto it = registry.list_scripts.rbegin();
+            it != registry.list_scripts.rend(); ++it)
+        {
+            if(it->script_hash == script_hash &&
+               function_key == it->function_key)   {
+                return it->function;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t GetRegisteredNativeScriptCount()
+    {
+        NativeScriptRegistry &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        return registry.list_scripts.size();
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    namespace native
+    {
+        size_t Index(double idx, size_t size)
+        {
+            if(!(idx >= 0) || idx >= double(size) || std::floor(idx) != idx)   {
+                throw Bail();
+            }
+            return size_t(idx);
+        }
+
+        double Byte(ByteList const * bytes, double pos)
+        {
+            return (*Obj(bytes))[Index(pos,bytes->size())];
+        }
+
+        double Bit(ByteList const * bytes, double pos, double bit)
+        {
+            s32 const byte_val = s32(Byte(bytes,pos));
+            s32 const mask = ToInt32(ShiftLeft(1,bit));
+            return ((byte_val & mask) > 0) ? 1 : 0;
+        }
+
+        double Length(ByteList const * bytes)
+        {
+            return double(Obj(bytes)->size());
+        }
+
+        size_t Req(NativeScriptInput const &input, double idx)
+        {
+            return Index(idx,input.GetRequestCount());
+        }
+
+        ByteList const * DataBytes(NativeScriptInput const &input,
+                                   size_t req, double idx)
+        {
+            return input.GetData(req,Index(idx,input.GetResponseCount(req)));
+        }
+
+        ByteList const * HeaderBytes(NativeScriptInput const &input,
+                                     size_t req, double idx)
+        {
+            if(!(idx >= 0) || std::floor(idx) != idx)   {
+                throw Bail();
+            }
+            return input.GetHeader(req,size_t(idx));
+        }
+
+        bool Truthy(double val)
+        {
+            return !(val == 0 || std::isnan(val));
+        }
+
+        s32 ToInt32(double val)
+        {
+            return s32(ToUint32(val));
+        }
+
+        u32 ToUint32(double val)
+        {
+            if(!std::isfinite(val))   {
+                return 0;
+            }
+            double m = std::fmod(std::trunc(val),4294967296.0);
+            if(m < 0)   {
+                m += 4294967296.0;
+            }
+            return u32(m);
+        }
+
+        double BitAnd(double a, double b)
+        {
+            return ToInt32(a) & ToInt32(b);
+        }
+
+        double BitOr(double a, double b)
+        {
+            return ToInt32(a) | ToInt32(b);
+        }
+
+        double BitXor(double a, double b)
+        {
+            return ToInt32(a) ^ ToInt32(b);
+        }
+
+        double BitNot(double a)
+        {
+            return ~ToInt32(a);
+        }
+
+        double ShiftLeft(double a, double b)
+        {
+            return s32(ToUint32(a) << (ToUint32(b) & 31));
+        }
+
+        double ShiftRight(double a, double b)
+        {
+            return ToInt32(a) >> (ToUint32(b) & 31);
+        }
+
+        double ShiftRightUnsigned(double a, double b)
+        {
+            return ToUint32(a) >> (ToUint32(b) & 31);
+        }
+
+        double JsAnd(double a, double b)
+        {
+            return Truthy(a) ? b : a;
+        }
+
+        double JsOr(double a, double b)
+        {
+            return Truthy(a) ? a : b;
+        }
+
+        double MathRound(double val)
+        {
+            // same as duktape: halfway cases round
+            // towards +Infinity and keep the sign of zero
+            if(!std::isfinite(val) || val == 0)   {
+                return val;
+            }
+            if(val >= -0.5 && val < 0.5)   {
+                return (val < 0) ? -0.0 : 0.0;
+            }
+            return std::floor(val+0.5);
+        }
+
+        std::string NumberToString(double val, double radix)
+        {
+            if(radix != std::floor(radix) || radix < 2 || radix > 36)   {
+                throw Bail();
+            }
+            if(std::isnan(val))   {
+                return "NaN";
+            }
+            if(std::isinf(val))   {
+                return (val < 0) ? "-Infinity" : "Infinity";
+            }
+            if(val == 0)   {
+                return "0";
+            }
+
+            // integers that don't need exponential notation
+            double const abs_val = std::fabs(val);
+            if(abs_val != std::floor(abs_val) || abs_val > 9007199254740992.0)   {
+                throw Bail();
+            }
+
+            static char const digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+            u64 const base = u64(radix);
+            u64 n = u64(abs_val);
+
+            std::string str;
+            while(n > 0)   {
+                str.push_back(digits[n%base]);
+                n /= base;
+            }
+            if(val < 0)   {
+                str.push_back('-');
+            }
+            return std::string(str.rbegin(),str.rend());
+        }
+
+        std::string ToUpperCase(std::string const &str)
+        {
+            std::string upper(str);
+            for(char &c : upper)   {
+                if(static_cast<unsigned char>(c) > 0x7F)   {
+                    throw Bail();
+                }
+                if(c >= 'a' && c <= 'z')   {
+                    c = char(c-'a'+'A');
+                }
+            }
+            return upper;
+        }
+
+        std::string ToLowerCase(std::string const &str)
+        {
+            std::string lower(str);
+            for(char &c : lower)   {
+                if(static_cast<unsigned char>(c) > 0x7F)   {
+                    throw Bail();
+                }
+                if(c >= 'A' && c <= 'Z')   {
+                    c = char(c-'A'+'a');
+                }
+            }
+            return lower;
+        }
+
+        NumericalData * Objects::NewNumerical()
+        {
+            m_list_num_objs.emplace_back();
+            return &(m_list_num_objs.back());
+        }
+
+        LiteralData * Objects::NewLiteral()
+        {
+            m_list_lit_objs.emplace_back();
+            return &(m_list_lit_objs.back());
+        }
+
+        void Objects::SaveNumerical(NumericalData * obj)
+        {
+            m_list_saved_num.push_back(Obj(obj));
+        }
+
+        void Objects::SaveLiteral(LiteralData * obj)
+        {
+            m_list_saved_lit.push_back(Obj(obj));
+        }
+
+        void Objects::SaveTo(Data &data) const
+        {
+            for(auto obj : m_list_saved_num)   {
+                data.list_numerical_data.push_back(*obj);
+            }
+            for(auto obj : m_list_saved_lit)   {
+                data.list_literal_data.push_back(*obj);
+            }
+        }
+    }
+}
@@ -0,0 +1,233 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_NATIVE_SCRIPTS_HPP
+#define OBDEX_NATIVE_SCRIPTS_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+#include <obdex/ObdexErrors.hpp>
+#include <obdex/ObdexScriptBudget.hpp>
+
+#include <deque>
+
+// Native scripts are C++ versions of definitions file scripts
+// written by obdex_codegen (see obdex/codegen). A generated file
+// registers its functions when it's linked in, and the Parser's
+// "native" engine (see Parser::SetScriptEngine) uses them instead
+// of the js versions for scripts with the same function key and
+// source. Anything a native script can't
+// reproduce exactly at runtime (ie. reading past the end of the
+// data or converting a fraction to a string) throws native::Bail,
+// and the Parser runs the js script instead.
+
+namespace obdex
+{
+    // NativeScriptInput
+    // * the response data a native script reads; the
+    //   same as what the js helpers (REQ, DATA, HEADER,
+    //   BYTE, ...) see for each parse mode
+    class NativeScriptInput
+    {
+    public:
+        // PARSE_SEPARATELY
+        // * one request with a single response and no headers
+        explicit NativeScriptInput(ByteList const &data_bytes);
+
+        // PARSE_COMBINED
+        explicit NativeScriptInput(std::vector<MessageData> const &list_msg_data);
+
+        size_t GetRequestCount() const;
+
+        // the functions below throw native::Bail
+        // for indices that are out of range
+        size_t GetResponseCount(size_t req) const;
+        ByteList const * GetData(size_t req, size_t resp) const;
+        ByteList const * GetHeader(size_t req, size_t idx) const;
+
+        // SetBudgetCounter
+        // * counts the steps of the script with @counter,
+        //   which must outlive the script run
+        void SetBudgetCounter(ScriptBudgetCounter * counter);
+
+        // Step
+        // * called by generated code for every loop iteration
+        // * throws ScriptBudgetExceeded once the budget of
+        //   the counter is exceeded
+        bool Step() const
+        {
+            if(m_budget_counter && !m_budget_counter->Step())   {
+                throw ScriptBudgetExceeded("Error: native script exceeded its budget");
+            }
+            return true;
+        }
+
+    private:
+        ByteList const * m_data_bytes;
+        std::vector<MessageData> const * m_list_msg_data;
+        ScriptBudgetCounter * m_budget_counter;
+    };
+
+    // NativeParseFunction
+    // * appends the results of a script for @input to
+    //   @data; nothing is appended if it throws
+    typedef void (*NativeParseFunction)(NativeScriptInput const &input,
+                                        Data &data);
+
+    // NativeScript
+    // * @function_key is the Parser's key for the script
+    //   ("spec:address:parameter:protocols") and @script_hash
+    //   is HashScript of its source, so a native script is
+    //   only used with the definitions it was generated from
+    struct NativeScript
+    {
+        char const * function_key;
+        u64 script_hash;
+        NativeParseFunction function;
+    };
+
+    // HashScript
+    // * 64-bit FNV-1a hash of a script's source
+    u64 HashScript(std::string const &script);
+
+    // RegisterNativeScripts
+    // * adds @count scripts from @list to the scripts used
+    //   by Parsers created afterwards; @list must stay valid
+    void RegisterNativeScripts(NativeScript const * list, size_t count);
+
+    // FindNativeScript
+    // * returns the registered function for a script
+    //   or nullptr if there isn't one
+    NativeParseFunction FindNativeScript(std::string const &function_key,
+                                         u64 script_hash);
+
+    size_t GetRegisteredNativeScriptCount();
+
+    // NativeScriptRegistration
+    // * registers scripts during static initialization
+    struct NativeScriptRegistration
+    {
+        NativeScriptRegistration(NativeScript const * list, size_t count)
+        {
+            RegisterNativeScripts(list,count);
+        }
+    };
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // native
+    // * helpers used by generated scripts to match the
+    //   behaviour of the js helpers and operators
+    namespace native
+    {
+        // Bail
+        // * thrown when a native script can't continue
+        //   with the same results as the js script
+        struct Bail {};
+
+        // Index
+        // * returns @idx as an index into a list of @size,
+        //   bailing unless it's an integer in range
+        size_t Index(double idx, size_t size);
+
+        // Byte, Bit, Length
+        // * same as DataBytesObj.BYTE, BIT and LENGTH
+        double Byte(ByteList const * bytes, double pos);
+        double Bit(ByteList const * bytes, double pos, double bit);
+        double Length(ByteList const * bytes);
+
+        // Req, DataBytes, HeaderBytes
+        // * same as REQ, MessageDataObj.DATA and HEADER;
+        //   requests are referred to by index
+        size_t Req(NativeScriptInput const &input, double idx);
+
+        ByteList const * DataBytes(NativeScriptInput const &input,
+                                   size_t req, double idx);
+
+        ByteList const * HeaderBytes(NativeScriptInput const &input,
+                                     size_t req, double idx);
+
+        bool Truthy(double val);
+
+        // ToInt32, ToUint32 and the bitwise operators
+        s32 ToInt32(double val);
+        u32 ToUint32(double val);
+        double BitAnd(double a, double b);
+        double BitOr(double a, double b);
+        double BitXor(double a, double b);
+        double BitNot(double a);
+        double ShiftLeft(double a, double b);
+        double ShiftRight(double a, double b);
+        double ShiftRightUnsigned(double a, double b);
+
+        // JsAnd, JsOr
+        // * && and || on numbers return one of the operands
+        double JsAnd(double a, double b);
+        double JsOr(double a, double b);
+
+        double MathRound(double val);
+
+        // NumberToString
+        // * Number.prototype.toString for integers, NaN and
+        //   Infinity; bails for anything else (ie. fractions
+        //   and exponential notation)
+        std::string NumberToString(double val, double radix);
+
+        // ToUpperCase, ToLowerCase
+        // * bail for strings that aren't ASCII
+        std::string ToUpperCase(std::string const &str);
+        std::string ToLowerCase(std::string const &str);
+
+        template<typename T>
+        T * Obj(T * obj)
+        {
+            if(obj == nullptr)   {
+                throw Bail();
+            }
+            return obj;
+        }
+
+        template<typename T>
+        T const & At(std::vector<T> const &list, double idx)
+        {
+            return list[Index(idx,list.size())];
+        }
+
+        // Objects
+        // * the NumericalDataObj and LiteralDataObj objects a
+        //   script creates and saves; saved objects can still
+        //   be changed until the script returns, like in js
+        class Objects
+        {
+        public:
+            NumericalData * NewNumerical();
+            LiteralData * NewLiteral();
+
+            void SaveNumerical(NumericalData * obj);
+            void SaveLiteral(LiteralData * obj);
+
+            void SaveTo(Data &data) const;
+
+        private:
+            std::deque<NumericalData> m_list_num_objs;
+            std::deque<LiteralData> m_list_lit_objs;
+            std::vector<NumericalData const *> m_list_saved_num;
+            std::vector<LiteralData const *> m_list_saved_lit;
+        };
+    }
+}
+
+#endif // OBDEX_NATIVE_SCRIPTS_HPP
@@ -0,0 +1,149 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexParseCache.hpp>
+
+namespace obdex
+{
+    ParseCache::ParseCache() :
+        m_capacity(0),
+        m_hits(0),
+        m_misses(0),
+        m_evictions(0),
+        m_size(0),
+        m_capacity_stat(0)
+    {
+        // empty
+    }
+
+    void ParseCache::SetCapacity(size_t capacity)
+    {
+        m_capacity = capacity;
+        m_capacity_stat = capacity;
+        evict(capacity);
+    }
+
+    void ParseCache::AppendKeyBytes(ByteList &key_bytes,
+                                    ByteList const &bytes)
+    {
+        AppendKeySize(key_bytes,bytes.size());
+        key_bytes.insert(key_bytes.end(),bytes.begin(),bytes.end());
+    }
+
+    void ParseCache::AppendKeySize(ByteList &key_bytes,
+                                   size_t size)
+    {
+        key_bytes.push_back(ubyte(size & 0xFF));
+        key_bytes.push_back(ubyte((size >> 8) & 0xFF));
+        key_bytes.push_back(ubyte((size >> 16) & 0xFF));
+        key_bytes.push_back(ubyte((size >> 24) & 0xFF));
+    }
+
+    u64 ParseCache::Hash(ByteList const &key_bytes)
+    {
+        u64 hash = 0xCBF29CE484222325ull;
+        for(ubyte byte : key_bytes)   {
+            hash ^= byte;
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    Data const * ParseCache::Find(u32 function_idx,
+                                  u64 hash,
+                                  ByteList const &key_bytes)
+    {
+        Key const key{function_idx,hash};
+        auto it = m_lkup_entries.find(key);
+        if(it == m_lkup_entries.end() ||
+           it->second->key_bytes != key_bytes)   {
+            m_misses.fetch_add(1,std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // move to the front
+        m_list_entries.splice(m_list_entries.begin(),
+                              m_list_entries,
+                              it->second);
+
+        m_hits.fetch_add(1,std::memory_order_relaxed);
+        return &(it->second->data);
+    }
+
+    void ParseCache::Insert(u32 function_idx,
+                            u64 hash,
+                            ByteList const &key_bytes,
+                            Data const &data)
+    {
+        if(m_capacity == 0)   {
+            return;
+        }
+
+        Key const key{function_idx,hash};
+        auto it = m_lkup_entries.find(key);
+        if(it != m_lkup_entries.end())   {
+            // replace the existing entry (ie. a hash
+            // collision with different key bytes)
+            it->second->key_bytes = key_bytes;
+            it->second->data = data;
+            m_list_entries.splice(m_list_entries.begin(),
+                                  m_list_entries,
+                                  it->second);
+            return;
+        }
+
+        evict(m_capacity-1);
+
+        m_list_entries.push_front(Entry{key,key_bytes,data});
+        m_lkup_entries.emplace(key,m_list_entries.begin());
+        m_size = m_list_entries.size();
+    }
+
+    void ParseCache::Clear()
+    {
+        m_list_entries.clear();
+        m_lkup_entries.clear();
+        m_size = 0;
+    }
+
+    ParseCacheStats ParseCache::GetStats() const
+    {
+        ParseCacheStats stats;
+        stats.hits = m_hits.load(std::memory_order_relaxed);
+        stats.misses = m_misses.load(std::memory_order_relaxed);
+        stats.evictions = m_evictions.load(std::memory_order_relaxed);
+        stats.size = m_size.load(std::memory_order_relaxed);
+        stats.capacity = m_capacity_stat.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void ParseCache::ResetStats()
+    {
+        m_hits = 0;
+        m_misses = 0;
+        m_evictions = 0;
+    }
+
+    void ParseCache::evict(size_t capacity)
+    {
+        while(m_list_entries.size() > capacity)   {
+            m_lkup_entries.erase(m_list_entries.back().key);
+            m_list_entries.pop_back();
+            m_evictions.fetch_add(1,std::memory_order_relaxed);
+        }
+        m_size = m_list_entries.size();
+    }
+}
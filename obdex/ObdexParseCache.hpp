@@ -0,0 +1,152 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_PARSE_CACHE_HPP
+#define OBDEX_PARSE_CACHE_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+namespace obdex
+{
+    // ParseCacheStats
+    // * hits and misses count lookups; evictions count
+    //   entries dropped to stay within the capacity
+    struct ParseCacheStats
+    {
+        ParseCacheStats() :
+            hits(0),
+            misses(0),
+            evictions(0),
+            size(0),
+            capacity(0)
+        {}
+
+        u64 hits;
+        u64 misses;
+        u64 evictions;
+        size_t size;
+        size_t capacity;
+    };
+
+    // ParseCache
+    // * least recently used cache of parsed Data keyed by
+    //   parse function index and the cleaned bytes that
+    //   were passed to the parse script
+    // * the key bytes are stored with each entry so a
+    //   hash collision is a miss rather than a wrong result
+    // * Find and Insert are called by the parsing thread;
+    //   GetStats may be called from any thread
+    class ParseCache
+    {
+    public:
+        ParseCache();
+
+        // SetCapacity
+        // * the maximum number of cached Data; zero
+        //   disables the cache and clears it
+        void SetCapacity(size_t capacity);
+
+        bool IsEnabled() const
+        {
+            return (m_capacity > 0);
+        }
+
+        // AppendKeyBytes, AppendKeySize
+        // * build up the key bytes for a lookup; each list
+        //   of bytes is prefixed with its size so different
+        //   splits of the same bytes have different keys
+        static void AppendKeyBytes(ByteList &key_bytes,
+                                   ByteList const &bytes);
+
+        static void AppendKeySize(ByteList &key_bytes,
+                                  size_t size);
+
+        // Hash
+        // * 64-bit FNV-1a hash of @key_bytes
+        static u64 Hash(ByteList const &key_bytes);
+
+        // Find
+        // * returns the cached Data for @function_idx and
+        //   @key_bytes or nullptr; the pointer is valid
+        //   until the next call to Insert or Clear
+        Data const * Find(u32 function_idx,
+                          u64 hash,
+                          ByteList const &key_bytes);
+
+        // Insert
+        // * adds or replaces the Data for @function_idx and
+        //   @key_bytes, evicting the least recently used
+        //   entry if the cache is full
+        void Insert(u32 function_idx,
+                    u64 hash,
+                    ByteList const &key_bytes,
+                    Data const &data);
+
+        void Clear();
+
+        ParseCacheStats GetStats() const;
+
+        void ResetStats();
+
+    private:
+        struct Key
+        {
+            bool operator == (Key const &other) const
+            {
+                return (function_idx == other.function_idx &&
+                        hash == other.hash);
+            }
+
+            u32 function_idx;
+            u64 hash;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(Key const &key) const
+            {
+                return size_t(key.hash ^ (u64(key.function_idx) * 0x9E3779B97F4A7C15ull));
+            }
+        };
+
+        struct Entry
+        {
+            Key key;
+            ByteList key_bytes;
+            Data data;
+        };
+
+        void evict(size_t capacity);
+
+        size_t m_capacity;
+
+        // most recently used entries are at the front
+        std::list<Entry> m_list_entries;
+        std::unordered_map<Key,std::list<Entry>::iterator,KeyHash> m_lkup_entries;
+
+        std::atomic<u64> m_hits;
+        std::atomic<u64> m_misses;
+        std::atomic<u64> m_evictions;
+        std::atomic<size_t> m_size;
+        std::atomic<size_t> m_capacity_stat;
+    };
+}
+
+#endif // OBDEX_PARSE_CACHE_HPP
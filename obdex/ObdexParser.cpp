@@ -17,252 +17,481 @@
 #include <obdex/ObdexParser.hpp>
 #include <obdex/ObdexErrors.hpp>
 #include <obdex/ObdexUtil.hpp>
-#include <obdex/ObdexJSGlobals.hpp>
+#include <obdex/ObdexScriptAnalysis.hpp>
+
+#include <algorithm>
+#include <cstdlib>
 
 namespace obdex
 {
     // ============================================================= //
     // ============================================================= //
 
-    Parser::Parser(std::string const &file_path) :
-        m_xml_file_path(file_path)
+    namespace
     {
-        // fill in lookup maps for hex str conversion
-        for(uint i=0; i < 256; i++)
+        std::shared_ptr<Definitions const>
+        LoadSharedDefinitions(std::string const &file_path)
         {
-            auto hex_byte_str_uppercase = StringToUpper(ToHexString(i));
-
-            // zero pad to two digits
-            if(hex_byte_str_uppercase.size() < 2)
-            {
-                PrependString(hex_byte_str_uppercase,"0");
-            }
-
-            m_lkup_ubyte_hex_str.push_back(hex_byte_str_uppercase);
-            m_lkup_hex_str_ubyte.emplace(hex_byte_str_uppercase,u8(i));
-            m_lkup_hex_str_ubyte.emplace(StringToLower(hex_byte_str_uppercase),u8(i));
+            std::shared_ptr<Definitions> definitions(new Definitions);
+            LoadDefinitions(file_path,*definitions);
+            return definitions;
         }
 
-        // read in xml file
-        auto xml_parse_result = m_xml_doc.load_file(file_path.c_str());
-
-        if(!xml_parse_result)
+        // hex lookup tables
+        // * shared by every Parser and filled in at compile time
+        // * k_ubyte_hex_str has the two uppercase digits for
+        //   each byte, null terminated
+        // * k_hex_digit_value has the value of each hex digit
+        //   character (either case), or -1
+        #define OBDEX_HEX_STR_ROW(h) \
+            {h,'0',0},{h,'1',0},{h,'2',0},{h,'3',0}, \
+            {h,'4',0},{h,'5',0},{h,'6',0},{h,'7',0}, \
+            {h,'8',0},{h,'9',0},{h,'A',0},{h,'B',0}, \
+            {h,'C',0},{h,'D',0},{h,'E',0},{h,'F',0}
+
+        constexpr char k_ubyte_hex_str[256][3] = {
+            OBDEX_HEX_STR_ROW('0'),OBDEX_HEX_STR_ROW('1'),
+            OBDEX_HEX_STR_ROW('2'),OBDEX_HEX_STR_ROW('3'),
+            OBDEX_HEX_STR_ROW('4'),OBDEX_HEX_STR_ROW('5'),
+            OBDEX_HEX_STR_ROW('6'),OBDEX_HEX_STR_ROW('7'),
+            OBDEX_HEX_STR_ROW('8'),OBDEX_HEX_STR_ROW('9'),
+            OBDEX_HEX_STR_ROW('A'),OBDEX_HEX_STR_ROW('B'),
+            OBDEX_HEX_STR_ROW('C'),OBDEX_HEX_STR_ROW('D'),
+            OBDEX_HEX_STR_ROW('E'),OBDEX_HEX_STR_ROW('F')
+        };
+
+        #undef OBDEX_HEX_STR_ROW
+
+        constexpr s8 HexDigitValue(uint c)
         {
-            std::string err_desc;
-            err_desc += "Could not parse XML file: " + file_path;
-            err_desc += ": \n";
-            err_desc += xml_parse_result.description();
-            err_desc += ": \n offset char: ";
-            err_desc += ToString(s64(xml_parse_result.offset));
-
-            throw XMLParsingFailed(err_desc);
+            return (c >= '0' && c <= '9') ? s8(c-'0') :
+                   (c >= 'A' && c <= 'F') ? s8(c-'A'+10) :
+                   (c >= 'a' && c <= 'f') ? s8(c-'a'+10) : s8(-1);
         }
 
+        #define OBDEX_HEX_VALUE_ROW(r) \
+            HexDigitValue(r+0x0),HexDigitValue(r+0x1), \
+            HexDigitValue(r+0x2),HexDigitValue(r+0x3), \
+            HexDigitValue(r+0x4),HexDigitValue(r+0x5), \
+            HexDigitValue(r+0x6),HexDigitValue(r+0x7), \
+            HexDigitValue(r+0x8),HexDigitValue(r+0x9), \
+            HexDigitValue(r+0xA),HexDigitValue(r+0xB), \
+            HexDigitValue(r+0xC),HexDigitValue(r+0xD), \
+            HexDigitValue(r+0xE),HexDigitValue(r+0xF)
+
+        constexpr s8 k_hex_digit_value[256] = {
+            OBDEX_HEX_VALUE_ROW(0x00),OBDEX_HEX_VALUE_ROW(0x10),
+            OBDEX_HEX_VALUE_ROW(0x20),OBDEX_HEX_VALUE_ROW(0x30),
+            OBDEX_HEX_VALUE_ROW(0x40),OBDEX_HEX_VALUE_ROW(0x50),
+            OBDEX_HEX_VALUE_ROW(0x60),OBDEX_HEX_VALUE_ROW(0x70),
+            OBDEX_HEX_VALUE_ROW(0x80),OBDEX_HEX_VALUE_ROW(0x90),
+            OBDEX_HEX_VALUE_ROW(0xA0),OBDEX_HEX_VALUE_ROW(0xB0),
+            OBDEX_HEX_VALUE_ROW(0xC0),OBDEX_HEX_VALUE_ROW(0xD0),
+            OBDEX_HEX_VALUE_ROW(0xE0),OBDEX_HEX_VALUE_ROW(0xF0)
+        };
+
+        #undef OBDEX_HEX_VALUE_ROW
+
+        static_assert(k_hex_digit_value['f'] == 15 &&
+                      k_hex_digit_value['G'] == -1,
+                      "bad hex digit table");
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    Parser::Parser(std::string const &file_path) :
+        Parser(file_path,LoadSharedDefinitions(file_path))
+    {
         // setup js context
         jsInit();
     }
 
+    Parser::Parser(std::string const &file_path,
+                   std::shared_ptr<Definitions const> definitions) :
+        m_xml_file_path(file_path),
+        m_definitions(std::move(definitions)),
+        m_script_heap_limit(0),
+#ifdef OBDEX_ENABLE_STATS
+        m_stats(new ParseStatsRecorder),
+#endif
+        m_reject_counters(new FrameRejectCounters),
+        m_parse_cache(new ParseCache),
+        m_lookup_table_max_domain(0),
+        m_lookup_hits(0),
+        m_lookup_misses(0)
+    {}
+
     Parser::~Parser()
     {}
 
+    Parser::Parser(Parser &&other) = default;
+
+    Parser & Parser::operator = (Parser &&other) = default;
+
+    Parser Parser::Clone() const
+    {
+        Parser parser(m_xml_file_path,m_definitions);
+
+        // scripts were already checked for lookup tables
+        parser.m_js_list_lookup_info = m_js_list_lookup_info;
+        parser.m_lookup_table_max_domain = m_lookup_table_max_domain;
+        for(auto const &table : m_list_lookup_tables)   {
+            parser.m_list_lookup_tables.emplace_back(
+                        table ? new ParseLookupTable(*table) : nullptr);
+        }
+
+        parser.m_script_budget = m_script_budget;
+        parser.m_script_heap_limit = m_script_heap_limit;
+        parser.m_js_list_engine_idx = m_js_list_engine_idx;
+        for(auto const &engine : m_list_script_engines)   {
+            parser.AddScriptEngine(engine->Clone());
+        }
+
+        parser.m_reject_counters->SetWarningInterval(
+                    m_reject_counters->GetWarningInterval());
+        parser.m_parse_cache->SetCapacity(
+                    m_parse_cache->GetStats().capacity);
+
+        return parser;
+    }
+
     // ============================================================= //
     // ============================================================= //
 
     void Parser::BuildParameterFrame(ParameterFrame &param_frame) const
     {
-        bool xn_spec_found       = false;
-        bool xn_protocol_found   = false;
-        bool xn_address_found    = false;
-        bool xn_params_found     = false;
-        bool xn_parameter_found  = false;
+        DefinitionParamRef ref;
+        std::string error;
+        if(!findParamRef(param_frame.spec,
+                         param_frame.protocol,
+                         param_frame.address,
+                         param_frame.name,
+                         ref,error))   {
+            throw BuildParamFrameFailed(error);
+        }
 
-        pugi::xml_node xn_spec = m_xml_doc.child("spec");
-        for(; xn_spec!=NULL; xn_spec=xn_spec.next_sibling("spec"))
-        {
-            std::string const spec(xn_spec.attribute("name").value());
-            if(spec == param_frame.spec)
-            {   // found spec
-                xn_spec_found = true;
-                pugi::xml_node xn_protocol = xn_spec.child("protocol");
-                for(; xn_protocol!=NULL; xn_protocol=xn_protocol.next_sibling("protocol"))
-                {
-                    std::string const protocol(xn_protocol.attribute("name").value());
-                    if(protocol == param_frame.protocol)
-                    {   // found protocol
-                        xn_protocol_found = true;
-
-                        std::vector<std::string> list_opt_names;
-                        std::vector<u8> list_opt_values;
-                        pugi::xml_node xn_option = xn_protocol.child("option");
-                        for(; xn_option!=NULL; xn_option=xn_option.next_sibling("option"))
-                        {
-                            std::string const opt_name(xn_option.attribute("name").value());
-                            std::string const opt_value(xn_option.attribute("value").value());
+        DefinitionSpec const &spec = m_definitions->list_specs[ref.spec_idx];
+        DefinitionProtocol const &protocol = spec.list_protocols[ref.protocol_idx];
 
-                            if(!opt_name.empty())
-                            {
-                                list_opt_names.push_back(opt_name);
-                                list_opt_values.push_back(0);
+        buildFrame(param_frame,
+                   protocol,
+                   protocol.list_addresses[ref.address_idx],
+                   spec.list_param_groups[ref.group_idx].list_parameters[ref.param_idx]);
 
-                                if(opt_value == "true")
-                                {
-                                    list_opt_values.back() = 1;
-                                }
-                            }
-                        }
+        param_frame.param_id = getParamId(ref);
+    }
 
-                        // set actual protocol used to clean up raw message data
-                        sint opt_idx;
-                        if(StringContains(protocol,"SAE J1850"))
-                        {
-                            param_frame.parse_protocol = PROTOCOL_SAE_J1850;
-                        }
-                        else if(protocol == "ISO 9141-2")   {
-                            param_frame.parse_protocol = PROTOCOL_ISO_9141_2;
-                        }
-                        else if(protocol == "ISO 14230")   {
-                            param_frame.parse_protocol = PROTOCOL_ISO_14230;
+    void Parser::BuildParameterFrame(ParamId param_id,
+                                     ParameterFrame &param_frame) const
+    {
+        DefinitionParamRef const &ref = getParamRef(param_id);
+        DefinitionSpec const &spec = m_definitions->list_specs[ref.spec_idx];
+        DefinitionProtocol const &protocol = spec.list_protocols[ref.protocol_idx];
 
-                            // check for options
-                            opt_idx = StringListIndexOf(list_opt_names,"Length Byte");
-                            if(opt_idx > -1) {
-                                param_frame.iso14230_add_length_byte = bool(list_opt_values[opt_idx]);
-                            }
-                        }
-                        else if(StringContains(protocol,"ISO 15765"))   {
-                            param_frame.parse_protocol = PROTOCOL_ISO_15765;
+        buildFrame(param_frame,
+                   protocol,
+                   protocol.list_addresses[ref.address_idx],
+                   spec.list_param_groups[ref.group_idx].list_parameters[ref.param_idx]);
 
-                            if(StringContains(protocol,"Extended Id"))   {
-                                param_frame.iso15765_extended_id = true;
-                            }
+        param_frame.param_id = param_id;
+    }
 
-                            // check for options
-                            opt_idx = StringListIndexOf(list_opt_names,"Extended Address");
-                            if(opt_idx > -1)   {
-                                param_frame.iso15765_extended_addr = bool(list_opt_values[opt_idx]);
-                            }
-                        }
-                        else   {
-                            throw BuildParamFrameFailed("Unsupported Protocol:"+protocol);
-                        }
+    bool Parser::setProtocolOptions(ParameterFrame &param_frame,
+                                    DefinitionProtocol const &protocol)
+    {
+        std::vector<std::string> list_opt_names;
+        std::vector<u8> list_opt_values;
+        for(auto const &option : protocol.list_options)
+        {
+            std::string const &opt_name = option.GetAttribute("name");
+            std::string const &opt_value = option.GetAttribute("value");
 
-                        // use address information to build the request header
-                        pugi::xml_node xn_address = xn_protocol.child("address");
-                        for(; xn_address!=NULL; xn_address=xn_address.next_sibling("address"))
-                        {
-                            std::string const address(xn_address.attribute("name").value());
-                            if(address == param_frame.address)
-                            {   // found address
-                                xn_address_found = true;
-
-                                // [build headers]
-                                if(param_frame.parse_protocol < 0xA00)   {
-                                    buildHeader_Legacy(param_frame,xn_address);
-                                }
-                                else if(param_frame.parse_protocol == PROTOCOL_ISO_14230)   {
-                                    buildHeader_ISO_14230(param_frame,xn_address);
-                                }
-                                else if(param_frame.parse_protocol == PROTOCOL_ISO_15765)   {
-                                    buildHeader_ISO_15765(param_frame,xn_address);
-                                }
-                            }
-                        }
-                    }
-                }
-                if(!xn_address_found)   {
-                    break;
-                }
+            if(!opt_name.empty())
+            {
+                list_opt_names.push_back(opt_name);
+                list_opt_values.push_back(0);
 
-                pugi::xml_node xn_params = xn_spec.child("parameters");
-                for(; xn_params!=NULL; xn_params=xn_params.next_sibling("parameters"))
+                if(opt_value == "true")
                 {
-                    std::string const params_addr(xn_params.attribute("address").value());
-                    if(params_addr == param_frame.address)
-                    {   // found parameters group
-                        xn_params_found = true;
-
-                        // use parameter information to build request data
-                        pugi::xml_node xn_parameter = xn_params.child("parameter");
-                        for(; xn_parameter!=NULL; xn_parameter=xn_parameter.next_sibling("parameter"))
-                        {
-                            std::string const name(xn_parameter.attribute("name").value());
-                            if(name == param_frame.name)
-                            {   // found parameter
-                                xn_parameter_found = true;
-
-                                // [build request data]
-                                buildData(param_frame,xn_parameter);
-
-                                // [save parse script]
-                                // set parse mode
-                                std::string parse_mode(xn_parameter.attribute("parse").value());
-                                if(parse_mode == "combined")   {
-                                    param_frame.parse_mode = PARSE_COMBINED;
-                                }
-                                else   {
-                                    param_frame.parse_mode = PARSE_SEPARATELY;
-                                }
-
-                                // save reference to parse function
-                                pugi::xml_node xn_script = xn_parameter.child("script");
-                                std::string protocols(xn_script.attribute("protocols").value());
-                                if(!protocols.empty())   {
-                                    bool found_protocol=false;
-                                    for(; xn_script!=NULL; xn_script = xn_script.next_sibling("script"))   {
-                                        // get the script for the specified protocol
-                                        protocols = std::string(xn_script.attribute("protocols").value());
-                                        if(StringContains(protocols,param_frame.protocol))   {
-                                            found_protocol = true;
-                                            break;
-                                        }
-                                    }
-                                    if(!found_protocol)   {
-                                        throw BuildParamFrameFailed(
-                                                    "Protocol specified not found in parse script");
-                                    }
-                                }
-
-                                std::string js_function_key =
-                                        param_frame.spec+":"+
-                                        param_frame.address+":"+
-                                        param_frame.name+":"+
-                                        protocols;
-
-                                param_frame.function_key_idx =
-                                        StringListIndexOf(m_js_list_function_key,js_function_key);
-
-                                if(param_frame.function_key_idx == -1)   {
-                                    throw BuildParamFrameFailed(
-                                                "No parse function found for message: "+
-                                                param_frame.name);
-                                }
-                            }
-                        }
-                    }
+                    list_opt_values.back() = 1;
                 }
             }
         }
 
-        if(!xn_spec_found)   {
-            throw BuildParamFrameFailed("could not find spec " + param_frame.spec);
+        // set actual protocol used to clean up raw message data
+        sint opt_idx;
+        if(StringContains(protocol.name,"SAE J1850"))
+        {
+            param_frame.parse_protocol = PROTOCOL_SAE_J1850;
+        }
+        else if(protocol.name == "ISO 9141-2")   {
+            param_frame.parse_protocol = PROTOCOL_ISO_9141_2;
+        }
+        else if(protocol.name == "ISO 14230")   {
+            param_frame.parse_protocol = PROTOCOL_ISO_14230;
+
+            // check for options
+            opt_idx = StringListIndexOf(list_opt_names,"Length Byte");
+            if(opt_idx > -1) {
+                param_frame.iso14230_add_length_byte = bool(list_opt_values[opt_idx]);
+            }
+        }
+        else if(StringContains(protocol.name,"ISO 15765"))   {
+            param_frame.parse_protocol = PROTOCOL_ISO_15765;
+
+            if(StringContains(protocol.name,"Extended Id"))   {
+                param_frame.iso15765_extended_id = true;
+            }
+
+            // check for options
+            opt_idx = StringListIndexOf(list_opt_names,"Extended Address");
+            if(opt_idx > -1)   {
+                param_frame.iso15765_extended_addr = bool(list_opt_values[opt_idx]);
+            }
+        }
+        else   {
+            return false;
+        }
+        return true;
+
+    }
+
+    void Parser::buildFrame(ParameterFrame &param_frame,
+                            DefinitionProtocol const &protocol,
+                            DefinitionAddress const &address,
+                            DefinitionParameter const &param) const
+    {
+        if(!setProtocolOptions(param_frame,protocol))   {
+            throw BuildParamFrameFailed("Unsupported Protocol:"+protocol.name);
+        }
+
+        // use address information to build the request header
+        if(param_frame.parse_protocol < 0xA00)   {
+            buildHeader_Legacy(param_frame,address);
+        }
+        else if(param_frame.parse_protocol == PROTOCOL_ISO_14230)   {
+            buildHeader_ISO_14230(param_frame,address);
         }
-        else if(!xn_protocol_found)   {
-            throw BuildParamFrameFailed("Error: could not find protocol " + param_frame.protocol);
+        else if(param_frame.parse_protocol == PROTOCOL_ISO_15765)   {
+            buildHeader_ISO_15765(param_frame,address);
         }
-        else if(!xn_address_found)    {
-            throw BuildParamFrameFailed("Error: could not find address " + param_frame.address);
+
+        // number of nodes expected to answer a request
+        // at this address (less than 0 if unknown)
+        sint const responder_count =
+                getResponderCount(param_frame,address);
+
+        // [build request data]
+        buildData(param_frame,param);
+
+        // [build expected response count]
+        buildExpResponseCount(param_frame,responder_count);
+
+        // [save parse script]
+        // set parse mode
+        if(param.attributes.GetAttribute("parse") == "combined")   {
+            param_frame.parse_mode = PARSE_COMBINED;
         }
-        else if(!xn_params_found)   {
-            throw BuildParamFrameFailed("Error: could not find param group");
+        else   {
+            param_frame.parse_mode = PARSE_SEPARATELY;
         }
-        else if(!xn_parameter_found)   {
-            throw BuildParamFrameFailed("Error: could not find parameter " + param_frame.name);
+
+        // save reference to parse function
+        param_frame.function_key_idx =
+                getParseFunction(param,protocol.name);
+
+        if(param_frame.function_key_idx == -1)   {
+            throw BuildParamFrameFailed(
+                        "No parse function found for message: "+
+                        param.name);
         }
     }
 
     // ============================================================= //
     // ============================================================= //
 
+    ParamId Parser::GetParamId(std::string const &spec,
+                               std::string const &protocol,
+                               std::string const &address,
+                               std::string const &param_name) const
+    {
+        DefinitionParamRef ref;
+        std::string error;
+        if(!findParamRef(spec,protocol,address,param_name,ref,error))   {
+            return k_invalid_param_id;
+        }
+        return getParamId(ref);
+    }
+
+    std::vector<ParamId>
+    Parser::GetParamIds(std::string const &spec_name,
+                        std::string const &protocol_name,
+                        std::string const &address_name) const
+    {
+        std::vector<ParamId> list_param_ids;
+        auto const &list_refs = m_definitions->list_param_refs;
+        for(size_t i=0; i < list_refs.size(); i++)
+        {
+            DefinitionParamRef const &ref = list_refs[i];
+            DefinitionSpec const &spec = m_definitions->list_specs[ref.spec_idx];
+            DefinitionProtocol const &protocol = spec.list_protocols[ref.protocol_idx];
+            if(spec.name == spec_name &&
+               protocol.name == protocol_name &&
+               protocol.list_addresses[ref.address_idx].name == address_name)   {
+                list_param_ids.push_back(ParamId(i));
+            }
+        }
+        return list_param_ids;
+    }
+
+    size_t Parser::GetParamIdCount() const
+    {
+        return m_definitions->list_param_refs.size();
+    }
+
+    std::string const & Parser::GetParamSpec(ParamId param_id) const
+    {
+        DefinitionParamRef const &ref = getParamRef(param_id);
+        return m_definitions->list_specs[ref.spec_idx].name;
+    }
+
+    std::string const & Parser::GetParamProtocol(ParamId param_id) const
+    {
+        DefinitionParamRef const &ref = getParamRef(param_id);
+        return m_definitions->list_specs[ref.spec_idx].
+                list_protocols[ref.protocol_idx].name;
+    }
+
+    std::string const & Parser::GetParamAddress(ParamId param_id) const
+    {
+        DefinitionParamRef const &ref = getParamRef(param_id);
+        return m_definitions->list_specs[ref.spec_idx].
+                list_protocols[ref.protocol_idx].
+                list_addresses[ref.address_idx].name;
+    }
+
+    std::string const & Parser::GetParamName(ParamId param_id) const
+    {
+        DefinitionParamRef const &ref = getParamRef(param_id);
+        return m_definitions->list_specs[ref.spec_idx].
+                list_param_groups[ref.group_idx].
+                list_parameters[ref.param_idx].name;
+    }
+
+    bool Parser::findParamRef(std::string const &spec_name,
+                              std::string const &protocol_name,
+                              std::string const &address_name,
+                              std::string const &param_name,
+                              DefinitionParamRef &ref,
+                              std::string &error) const
+    {
+        auto const &list_specs = m_definitions->list_specs;
+
+        ref.spec_idx = 0;
+        while(ref.spec_idx < list_specs.size() &&
+              list_specs[ref.spec_idx].name != spec_name)   {
+            ref.spec_idx++;
+        }
+        if(ref.spec_idx == list_specs.size())   {
+            error = "could not find spec " + spec_name;
+            return false;
+        }
+        DefinitionSpec const &spec = list_specs[ref.spec_idx];
+
+        ref.protocol_idx = 0;
+        while(ref.protocol_idx < spec.list_protocols.size() &&
+              spec.list_protocols[ref.protocol_idx].name != protocol_name)   {
+            ref.protocol_idx++;
+        }
+        if(ref.protocol_idx == spec.list_protocols.size())   {
+            error = "Error: could not find protocol " + protocol_name;
+            return false;
+        }
+        DefinitionProtocol const &protocol = spec.list_protocols[ref.protocol_idx];
+
+        ref.address_idx = 0;
+        while(ref.address_idx < protocol.list_addresses.size() &&
+              protocol.list_addresses[ref.address_idx].name != address_name)   {
+            ref.address_idx++;
+        }
+        if(ref.address_idx == protocol.list_addresses.size())   {
+            error = "Error: could not find address " + address_name;
+            return false;
+        }
+
+        bool group_found=false;
+        for(u32 g=0; g < spec.list_param_groups.size(); g++)
+        {
+            DefinitionParameterGroup const &group = spec.list_param_groups[g];
+            if(group.address != address_name)   {
+                continue;
+            }
+            group_found = true;
+
+            for(u32 i=0; i < group.list_parameters.size(); i++)   {
+                if(group.list_parameters[i].name == param_name)   {
+                    ref.group_idx = g;
+                    ref.param_idx = i;
+                    return true;
+                }
+            }
+        }
+
+        if(!group_found)   {
+            error = "Error: could not find param group";
+        }
+        else   {
+            error = "Error: could not find parameter " + param_name;
+        }
+        return false;
+    }
+
+    ParamId Parser::getParamId(DefinitionParamRef const &ref) const
+    {
+        // list_param_refs is sorted by its indices
+        auto const &list_refs = m_definitions->list_param_refs;
+        auto it = std::lower_bound(
+                    list_refs.begin(),list_refs.end(),ref,
+                    [](DefinitionParamRef const &a, DefinitionParamRef const &b) {
+                        if(a.spec_idx != b.spec_idx)   {
+                            return a.spec_idx < b.spec_idx;
+                        }
+                        if(a.protocol_idx != b.protocol_idx)   {
+                            return a.protocol_idx < b.protocol_idx;
+                        }
+                        if(a.address_idx != b.address_idx)   {
+                            return a.address_idx < b.address_idx;
+                        }
+                        if(a.group_idx != b.group_idx)   {
+                            return a.group_idx < b.group_idx;
+                        }
+                        return a.param_idx < b.param_idx;
+                    });
+        return ParamId(it-list_refs.begin());
+    }
+
+    DefinitionParamRef const & Parser::getParamRef(ParamId param_id) const
+    {
+        if(param_id >= m_definitions->list_param_refs.size())   {
+            std::string msg = "Invalid parameter id ";
+            AppendUInt(msg,param_id);
+            throw InvalidParamId(msg);
+        }
+        return m_definitions->list_param_refs[param_id];
+    }
+
+    std::string const & Parser::getFrameProtocol(ParameterFrame const &frame) const
+    {
+        if(frame.param_id < m_definitions->list_param_refs.size())   {
+            return GetParamProtocol(frame.param_id);
+        }
+        return frame.protocol;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
     void Parser::ParseParameterFrame(ParameterFrame &msg_frame,
                                      std::vector<obdex::Data> &list_data)
     {
@@ -272,6 +501,24 @@ namespace obdex
                         "index in message frame");
         }
 
+        OBDEX_STATS_FRAME(*m_stats,msg_frame.function_key_idx,getFrameProtocol(msg_frame));
+
+        // clean
+        CleanParameterFrame(msg_frame);
+
+        // parse
+        parseResponse(msg_frame,list_data);
+
+        OBDEX_STATS_FRAME_OK();
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void Parser::CleanParameterFrame(ParameterFrame &msg_frame)
+    {
+        OBDEX_STATS_FRAME(*m_stats,msg_frame.function_key_idx,getFrameProtocol(msg_frame));
+
         bool format_ok=true;
 
         // clean message data based on protocol type
@@ -313,8 +560,24 @@ namespace obdex
                         "using spec'd format");
         }
 
-        // parse
+        OBDEX_STATS_FRAME_OK();
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void Parser::ParseCleanedParameterFrame(ParameterFrame const &msg_frame,
+                                            std::vector<obdex::Data> &list_data)
+    {
+        if(msg_frame.function_key_idx == -1)   {
+            throw ParseParamFrameFailed(
+                        "Invalid parse function "
+                        "index in message frame");
+        }
+
+        OBDEX_STATS_FRAME(*m_stats,msg_frame.function_key_idx,getFrameProtocol(msg_frame));
         parseResponse(msg_frame,list_data);
+        OBDEX_STATS_FRAME_OK();
     }
 
     // ============================================================= //
@@ -327,24 +590,17 @@ namespace obdex
     {
         bool found_address = false;
         std::vector<std::string> param_list;
-        pugi::xml_node node_spec = m_xml_doc.child("spec");
-
-        for(; node_spec!=NULL; node_spec = node_spec.next_sibling("spec"))
+        for(auto const &spec : m_definitions->list_specs)
         {
-            std::string filespec_name(node_spec.attribute("name").value());
-            if(filespec_name == spec_name)
+            if(spec.name == spec_name)
             {
-                pugi::xml_node node_protocol = node_spec.child("protocol");
-                for(; node_protocol!=NULL; node_protocol = node_protocol.next_sibling("protocol"))
+                for(auto const &protocol : spec.list_protocols)
                 {
-                    std::string fileprotocol_name(node_protocol.attribute("name").value());
-                    if(fileprotocol_name == protocol_name)
+                    if(protocol.name == protocol_name)
                     {
-                        pugi::xml_node node_address = node_protocol.child("address");
-                        for(; node_address!=NULL; node_address = node_address.next_sibling("address"))
+                        for(auto const &address : protocol.list_addresses)
                         {
-                            std::string fileaddress_name(node_address.attribute("name").value());
-                            if(fileaddress_name == address_name)
+                            if(address.name == address_name)
                             {
                                 found_address = true;
                             }
@@ -355,17 +611,13 @@ namespace obdex
                 if(!found_address)
                 {   break;   }
 
-                pugi::xml_node node_params = node_spec.child("parameters");
-                for(; node_params!=NULL; node_params = node_protocol.next_sibling("parameters"))
+                for(auto const &group : spec.list_param_groups)
                 {
-                    std::string file_params_name(node_params.attribute("address").value());
-                    if(file_params_name == address_name)
+                    if(group.address == address_name)
                     {
-                        pugi::xml_node node_parameter = node_params.child("parameter");
-                        for(; node_parameter!=NULL; node_parameter = node_parameter.next_sibling("parameter"))
+                        for(auto const &param : group.list_parameters)
                         {
-                            std::string file_parameter_name(node_parameter.attribute("name").value());
-                            param_list.push_back(file_parameter_name);
+                            param_list.push_back(param.name);
                         }
                     }
                 }
@@ -378,104 +630,416 @@ namespace obdex
     // ============================================================= //
     // ============================================================= //
 
+    Catalog Parser::GetCatalog() const
+    {
+        Catalog catalog;
+        auto const &list_specs = m_definitions->list_specs;
+
+        // [parameters]
+        // * list_group_first_idx[s][g] is the index of the first
+        //   parameter of group g in spec s in list_parameters
+        std::vector<std::vector<u32>> list_group_first_idx(list_specs.size());
+        for(u32 s=0; s < list_specs.size(); s++)
+        {
+            for(auto const &group : list_specs[s].list_param_groups)
+            {
+                list_group_first_idx[s].push_back(catalog.list_parameters.size());
+                for(auto const &param : group.list_parameters)
+                {
+                    catalog.list_parameters.emplace_back();
+                    CatalogParameter &cat_param = catalog.list_parameters.back();
+                    cat_param.name = param.name;
+                    cat_param.address = group.address;
+                    cat_param.spec_idx = s;
+                    if(param.attributes.GetAttribute("parse") == "combined")   {
+                        cat_param.parse_mode = PARSE_COMBINED;
+                    }
+
+                    ParameterFrame param_frame;
+                    param_frame.list_message_data.resize(1);
+                    try {
+                        if(!buildRequests(param_frame,param))   {
+                            continue;
+                        }
+                    }
+                    catch(BuildParamFrameFailed &e)   {
+                        cat_param.valid = false;
+                        continue;
+                    }
+
+                    for(auto &msg : param_frame.list_message_data)   {
+                        cat_param.list_requests.emplace_back();
+                        CatalogRequest &request = cat_param.list_requests.back();
+                        request.req_data_bytes = std::move(msg.list_req_data_bytes[0]);
+                        request.req_data_delay_ms = msg.req_data_delay_ms;
+                        request.exp_data_prefix = std::move(msg.exp_data_prefix);
+                        request.exp_data_byte_count = msg.exp_data_byte_count;
+                    }
+                }
+            }
+        }
+
+        // [specs, protocols and addresses]
+        // * list_address_idx[a] is the catalog index of the
+        //   protocol's address a; repeated addresses use
+        //   the first one, like list_param_refs
+        std::vector<std::vector<std::vector<u32>>> list_address_idx(list_specs.size());
+        for(u32 s=0; s < list_specs.size(); s++)
+        {
+            catalog.list_specs.emplace_back();
+            CatalogSpec &cat_spec = catalog.list_specs.back();
+            cat_spec.name = list_specs[s].name;
+
+            for(auto const &protocol : list_specs[s].list_protocols)
+            {
+                cat_spec.list_protocols.emplace_back();
+                CatalogProtocol &cat_protocol = cat_spec.list_protocols.back();
+                cat_protocol.name = protocol.name;
+                cat_protocol.list_baudrates = protocol.list_baudrates;
+
+                ParameterFrame param_frame;
+                cat_protocol.supported = setProtocolOptions(param_frame,protocol);
+                cat_protocol.parse_protocol = param_frame.parse_protocol;
+                cat_protocol.iso14230_add_length_byte = param_frame.iso14230_add_length_byte;
+                cat_protocol.iso15765_extended_id = param_frame.iso15765_extended_id;
+                cat_protocol.iso15765_extended_addr = param_frame.iso15765_extended_addr;
+
+                list_address_idx[s].emplace_back();
+                for(auto const &address : protocol.list_addresses)
+                {
+                    u32 idx=0;
+                    while(idx < cat_protocol.list_addresses.size() &&
+                          cat_protocol.list_addresses[idx].name != address.name)   {
+                        idx++;
+                    }
+                    if(idx == cat_protocol.list_addresses.size())   {
+                        cat_protocol.list_addresses.emplace_back();
+                        cat_protocol.list_addresses.back().name = address.name;
+                    }
+                    list_address_idx[s].back().push_back(idx);
+                }
+            }
+        }
+
+        // [param ids]
+        auto const &list_refs = m_definitions->list_param_refs;
+        catalog.list_params.reserve(list_refs.size());
+        for(size_t i=0; i < list_refs.size(); i++)
+        {
+            DefinitionParamRef const &ref = list_refs[i];
+            DefinitionProtocol const &protocol =
+                    list_specs[ref.spec_idx].list_protocols[ref.protocol_idx];
+            DefinitionParameter const &param =
+                    list_specs[ref.spec_idx].list_param_groups[ref.group_idx].
+                    list_parameters[ref.param_idx];
+
+            CatalogParam cat_param;
+            cat_param.parameter_idx =
+                    list_group_first_idx[ref.spec_idx][ref.group_idx]+ref.param_idx;
+            cat_param.spec_idx = ref.spec_idx;
+            cat_param.protocol_idx = ref.protocol_idx;
+            cat_param.address_idx =
+                    list_address_idx[ref.spec_idx][ref.protocol_idx][ref.address_idx];
+            cat_param.function_key_idx = findParseFunction(param,protocol.name);
+            catalog.list_params.push_back(cat_param);
+
+            CatalogAddress &cat_address =
+                    catalog.list_specs[ref.spec_idx].
+                    list_protocols[ref.protocol_idx].
+                    list_addresses[cat_param.address_idx];
+            if(cat_address.param_count == 0)   {
+                cat_address.first_param_id = ParamId(i);
+            }
+            cat_address.param_count++;
+        }
+
+        return catalog;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    BusTiming Parser::GetBusTiming(std::string const &spec_name,
+                                   std::string const &protocol_name) const
+    {
+        for(auto const &spec : m_definitions->list_specs)
+        {
+            if(spec.name != spec_name)   {
+                continue;
+            }
+
+            for(auto const &def_protocol : spec.list_protocols)
+            {
+                std::string const &protocol = def_protocol.name;
+                if(protocol != protocol_name)   {
+                    continue;
+                }
+
+                BusTiming timing;
+                if(StringContains(protocol,"SAE J1850"))   {
+                    timing = GetDefaultBusTiming(PROTOCOL_SAE_J1850,
+                                                 StringContains(protocol,"VPW"));
+                }
+                else if(protocol == "ISO 9141-2")   {
+                    timing = GetDefaultBusTiming(PROTOCOL_ISO_9141_2);
+                }
+                else if(protocol == "ISO 14230")   {
+                    timing = GetDefaultBusTiming(PROTOCOL_ISO_14230);
+                }
+                else if(StringContains(protocol,"ISO 15765"))   {
+                    timing = GetDefaultBusTiming(PROTOCOL_ISO_15765,false,
+                                                 StringContains(protocol,"Extended Id"));
+                }
+                else   {
+                    throw BuildParamFrameFailed("Unsupported Protocol:"+protocol);
+                }
+
+                // <baudrate value="..." />
+                std::vector<u32> list_baudrates;
+                for(auto const &value : def_protocol.list_baudrates)
+                {
+                    bool ok = false;
+                    u32 const baudrate = StringToUInt(value,ok);
+                    if(!ok || baudrate == 0)   {
+                        throw XMLParsingFailed(
+                                    "Invalid baudrate for protocol "+protocol+
+                                    ": "+value);
+                    }
+                    list_baudrates.push_back(baudrate);
+                }
+                if(!list_baudrates.empty())   {
+                    timing.list_baudrates = list_baudrates;
+                    timing.baudrate = *std::max_element(list_baudrates.begin(),
+                                                        list_baudrates.end());
+                }
+
+                // <timing p1="..." p2="..." p3="..." p4="..." inter_frame="..." />
+                // * times are in milliseconds
+                DefinitionElement const &timing_attrs = def_protocol.timing;
+                if(timing_attrs.Exists())
+                {
+                    std::vector<std::string> const list_attr_names {
+                        "p1","p2","p3","p4","inter_frame"
+                    };
+                    std::vector<Microseconds*> const list_attr_values {
+                        &timing.p1_inter_byte_resp,
+                        &timing.p2_req_to_resp,
+                        &timing.p3_resp_to_req,
+                        &timing.p4_inter_byte_req,
+                        &timing.inter_frame
+                    };
+
+                    for(uint i=0; i < list_attr_names.size(); i++)
+                    {
+                        char const * attr_name = list_attr_names[i].c_str();
+                        if(!timing_attrs.HasAttribute(attr_name))   {
+                            continue;
+                        }
+
+                        std::string const &value = timing_attrs.GetAttribute(attr_name);
+                        char* endptr;
+                        double const time_ms = strtod(value.c_str(),&endptr);
+                        if(endptr == value.c_str() || *endptr != '\0' || time_ms < 0)   {
+                            throw XMLParsingFailed(
+                                        "Invalid timing for protocol "+protocol+
+                                        ": "+list_attr_names[i]);
+                        }
+                        *(list_attr_values[i]) = Microseconds(u64(time_ms*1000.0 + 0.5));
+                    }
+                }
+
+                return timing;
+            }
+        }
+
+        throw BuildParamFrameFailed("Error: could not find protocol " + protocol_name);
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
     void Parser::jsInit()
     {
-        // create js heap and default context
-        m_js_ctx = duk_create_heap_default();
-        if(!m_js_ctx)   {
-            throw JSContextSetupFailed();
-        }
-
-        // push the global object onto the context's stack
-        duk_push_global_object(m_js_ctx);
-        m_js_idx_global_object = duk_normalize_index(m_js_ctx,-1);
-
-        // register properties to the global object
-        duk_eval_string(m_js_ctx,globals_js);
-        duk_pop(m_js_ctx);
-
-        // add important properties to the stack and
-        // and save their location
-        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
-                            "__private_get_lit_data");
-
-        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
-                            "__private_get_num_data");
-
-        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
-                            "__private__clear_all_data");
-
-        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
-                            "__private__add_list_databytes");
-
-        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
-                            "__private__add_msg_data");
-
-        m_js_idx_f_add_msg_data     = duk_normalize_index(m_js_ctx,-1);
-        m_js_idx_f_add_databytes    = duk_normalize_index(m_js_ctx,-2);
-        m_js_idx_f_clear_data       = duk_normalize_index(m_js_ctx,-3);
-        m_js_idx_f_get_num_data     = duk_normalize_index(m_js_ctx,-4);
-        m_js_idx_f_get_lit_data     = duk_normalize_index(m_js_ctx,-5);
-
-        // evaluate and save all parse functions
-        pugi::xml_node xn_spec = m_xml_doc.child("spec");
-        for(; xn_spec!=NULL; xn_spec=xn_spec.next_sibling("spec"))
-        {   // for each spec
-            std::string spec(xn_spec.attribute("name").value());
-            pugi::xml_node xn_params = xn_spec.child("parameters");
-            for(; xn_params!=NULL; xn_params=xn_params.next_sibling("parameters"))
-            {   // for each set of parameters
-                std::string address(xn_params.attribute("address").value());
-                pugi::xml_node xn_param = xn_params.child("parameter");
-                for(; xn_param!=NULL; xn_param=xn_param.next_sibling("parameter"))
-                {   // for each parameter
-                    std::string param(xn_param.attribute("name").value());
-                    pugi::xml_node xn_script = xn_param.child("script");
-                    for(; xn_script!=NULL; xn_script=xn_script.next_sibling("script"))
-                    {   // for each script
-                        std::string protocols(xn_script.attribute("protocols").value());
-                        std::string script(xn_script.child_value());
-
-                        // add parse function name and scope
-                        std::string idx = ToString(m_js_list_function_key.size());
-                        std::string fname = "f"+idx;
-                        PrependString(script,"function "+fname+"() {");
-                        script.append("}");
-
-                        // register parse function to global js object
-                        duk_eval_string(m_js_ctx,script.c_str());
-                        duk_pop(m_js_ctx);
-
-                        // add parse function to top of stack
-                        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
-                                            fname.c_str());
-
-                        // save unique key string and stack index for function
-                        std::string js_function_key = spec+":"+address+":"+param+":"+protocols;
-                        m_js_list_function_key.push_back(js_function_key);
-                        m_js_list_function_idx.push_back(duk_normalize_index(m_js_ctx,-1));
+        // check if each script can use a lookup table; parse
+        // functions are in the same order as the scripts
+        size_t js_f_idx=0;
+        for(auto const &spec : m_definitions->list_specs)   {
+            for(auto const &group : spec.list_param_groups)   {
+                for(auto const &param : group.list_parameters)   {
+                    for(size_t i=0; i < param.list_scripts.size(); i++)   {
+                        m_js_list_lookup_info.push_back(
+                                    buildLookupTableInfo(m_definitions->list_script[js_f_idx],param));
+                        m_list_lookup_tables.emplace_back();
+                        js_f_idx++;
                     }
                 }
             }
         }
+
+        // compile all parse functions with the built in
+        // engines; duktape must be first since it's used
+        // for any script another engine can't run
+        m_js_list_engine_idx.resize(m_definitions->list_function_key.size(),0);
+        AddScriptEngine(std::unique_ptr<ScriptEngine>(new DuktapeScriptEngine));
+        AddScriptEngine(std::unique_ptr<ScriptEngine>(new NativeScriptEngine));
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void Parser::AddScriptEngine(std::unique_ptr<ScriptEngine> engine)
+    {
+        engine->SetBudget(m_script_budget);
+        engine->SetHeapLimit(m_script_heap_limit);
+        std::vector<bool> list_compiled = compileScripts(*engine);
+
+        // replace an existing engine with the same name
+        for(size_t i=0; i < m_list_script_engines.size(); i++)   {
+            if(m_list_script_engines[i]->GetName() == engine->GetName())   {
+                m_list_script_engines[i] = std::move(engine);
+                m_list_engine_compiled[i] = std::move(list_compiled);
+                return;
+            }
+        }
+
+        m_list_script_engines.push_back(std::move(engine));
+        m_list_engine_compiled.push_back(std::move(list_compiled));
+    }
+
+    void Parser::SetScriptEngine(std::string const &engine_name)
+    {
+        size_t const engine_idx = getScriptEngineIndex(engine_name);
+        for(auto &idx : m_js_list_engine_idx)   {
+            idx = engine_idx;
+        }
+    }
+
+    void Parser::SetParameterScriptEngine(std::string const &spec,
+                                          std::string const &address,
+                                          std::string const &param_name,
+                                          std::string const &engine_name)
+    {
+        size_t const engine_idx = getScriptEngineIndex(engine_name);
+
+        // function keys are spec:address:param:protocols
+        std::string const prefix = spec+":"+address+":"+param_name+":";
+        bool found=false;
+        for(size_t i=0; i < m_definitions->list_function_key.size(); i++)   {
+            if(m_definitions->list_function_key[i].compare(0,prefix.size(),prefix) == 0)   {
+                m_js_list_engine_idx[i] = engine_idx;
+                found = true;
+            }
+        }
+
+        if(!found)   {
+            throw InvalidScriptEngine("Error: could not find parameter "+prefix);
+        }
+    }
+
+    size_t Parser::GetCompiledScriptCount(std::string const &engine_name) const
+    {
+        std::vector<bool> const &list_compiled =
+                m_list_engine_compiled[getScriptEngineIndex(engine_name)];
+
+        return size_t(std::count(list_compiled.begin(),list_compiled.end(),true));
+    }
+
+    void Parser::SetScriptBudget(ScriptBudget const &budget)
+    {
+        bool const recompile =
+                (budget.IsEnabled() != m_script_budget.IsEnabled());
+
+        m_script_budget = budget;
+        for(size_t i=0; i < m_list_script_engines.size(); i++)   {
+            m_list_script_engines[i]->SetBudget(m_script_budget);
+            if(recompile)   {
+                m_list_engine_compiled[i] =
+                        compileScripts(*(m_list_script_engines[i]));
+            }
+        }
+    }
+
+    ScriptBudget Parser::GetScriptBudget() const
+    {
+        return m_script_budget;
+    }
+
+    std::vector<ScriptBudgetStats> Parser::GetScriptBudgetStats() const
+    {
+        std::vector<ScriptBudgetStats> list_stats;
+        for(size_t i=0; i < m_js_list_budget_stats.size(); i++)   {
+            if(m_js_list_budget_stats[i].runs > 0)   {
+                list_stats.push_back(m_js_list_budget_stats[i]);
+                list_stats.back().function_key = m_definitions->list_function_key[i];
+            }
+        }
+        return list_stats;
+    }
+
+    void Parser::ResetScriptBudgetStats()
+    {
+        m_js_list_budget_stats.clear();
+    }
+
+    void Parser::SetScriptHeapLimit(size_t max_bytes)
+    {
+        m_script_heap_limit = max_bytes;
+        for(auto &engine : m_list_script_engines)   {
+            engine->SetHeapLimit(m_script_heap_limit);
+        }
+    }
+
+    ScriptHeapStats Parser::GetScriptHeapStats() const
+    {
+        ScriptHeapStats total;
+        total.limit = m_script_heap_limit;
+        for(auto const &engine : m_list_script_engines)   {
+            ScriptHeapStats const stats = engine->GetHeapStats();
+            total.live_bytes += stats.live_bytes;
+            total.peak_bytes += stats.peak_bytes;
+            total.reserved_bytes += stats.reserved_bytes;
+            total.refused_allocs += stats.refused_allocs;
+        }
+        return total;
+    }
+
+    std::vector<bool> Parser::compileScripts(ScriptEngine &engine) const
+    {
+        std::vector<bool> list_compiled(m_definitions->list_function_key.size(),false);
+        for(size_t i=0; i < m_definitions->list_function_key.size(); i++)   {
+            list_compiled[i] = engine.Compile(u32(i),
+                                              m_definitions->list_function_key[i],
+                                              m_definitions->list_script[i]);
+        }
+        return list_compiled;
+    }
+
+    size_t Parser::getScriptEngineIndex(std::string const &engine_name) const
+    {
+        for(size_t i=0; i < m_list_script_engines.size(); i++)   {
+            if(m_list_script_engines[i]->GetName() == engine_name)   {
+                return i;
+            }
+        }
+        throw InvalidScriptEngine("Error: no script engine named "+engine_name);
     }
 
     // ============================================================= //
     // ============================================================= //
 
     void Parser::buildHeader_Legacy(ParameterFrame &param_frame,
-                                    pugi::xml_node xn_address) const
+                                    DefinitionAddress const &address) const
     {
         // store the request header data in
         // a MessageData struct
         MessageData msg;
 
         // request header bytes
-        pugi::xml_node xn_req = xn_address.child("request");
-        if(xn_req)   {
-            std::string prio(xn_req.attribute("prio").value());
-            std::string target(xn_req.attribute("target").value());
-            std::string source(xn_req.attribute("source").value());
+        DefinitionElement const &request = address.request;
+        if(request.Exists())   {
+            std::string prio(request.GetAttribute("prio"));
+            std::string target(request.GetAttribute("target"));
+            std::string source(request.GetAttribute("source"));
 
             // all three bytes must be defined
             if(prio.empty() || target.empty() || source.empty())   {
@@ -499,8 +1063,8 @@ namespace obdex
         else   {
             // for messages without requests,
             // we use an empty header
-            obdexlog.Warn() << "ISO 9141-2/SAE J1850,"
-                            << "No Request Header";
+            OBDEX_LOG_WARN(obdexlog) << "ISO 9141-2/SAE J1850,"
+                                     << "No Request Header";
         }
 
         // preemptively fill out response header
@@ -515,11 +1079,11 @@ namespace obdex
         msg.exp_header_mask.push_back(0);
 
         // response header bytes
-        pugi::xml_node xn_resp = xn_address.child("response");
-        if(xn_resp)   {
-            std::string prio(xn_resp.attribute("prio").value());
-            std::string target(xn_resp.attribute("target").value());
-            std::string source(xn_resp.attribute("source").value());
+        DefinitionElement const &response = address.response;
+        if(response.Exists())   {
+            std::string prio(response.GetAttribute("prio"));
+            std::string target(response.GetAttribute("target"));
+            std::string source(response.GetAttribute("source"));
 
             bool ok_prio = true;
             bool ok_target = true;
@@ -553,7 +1117,7 @@ namespace obdex
     // ============================================================= //
 
     void Parser::buildHeader_ISO_14230(ParameterFrame &param_frame,
-                                       pugi::xml_node xn_address) const
+                                       DefinitionAddress const &address) const
     {
         // ISO 14230
         // This protocol has a variable header:
@@ -584,9 +1148,9 @@ namespace obdex
         MessageData msg;
 
         // request header bytes
-        pugi::xml_node xn_req = xn_address.child("request");
-        if(xn_req)   {
-            std::string format(xn_req.attribute("format").value());
+        DefinitionElement const &request = address.request;
+        if(request.Exists())   {
+            std::string format(request.GetAttribute("format"));
             if(format.empty())   {
                 throw BuildParamFrameFailed(
                             "ISO 14230, request header "
@@ -606,8 +1170,8 @@ namespace obdex
             // check which type of header
             if((format_byte >> 6) != 0)   {
                 // [source] and [target] must be present
-                std::string target(xn_req.attribute("target").value());
-                std::string source(xn_req.attribute("source").value());
+                std::string target(request.GetAttribute("target"));
+                std::string source(request.GetAttribute("source"));
 
                 bool ok_target=false;
                 bool ok_source=false;
@@ -622,7 +1186,7 @@ namespace obdex
             }
         }
         else   {
-            obdexlog.Warn() << "ISO 14230, no request header";
+            OBDEX_LOG_WARN(obdexlog) << "ISO 14230, no request header";
         }
 
         // preemptively fill out response header
@@ -637,11 +1201,11 @@ namespace obdex
         msg.exp_header_mask.push_back(0);
 
         // response header bytes
-        pugi::xml_node xn_resp = xn_address.child("response");
-        if(xn_resp)   {
-            std::string format(xn_resp.attribute("format").value());
-            std::string target(xn_resp.attribute("target").value());
-            std::string source(xn_resp.attribute("source").value());
+        DefinitionElement const &response = address.response;
+        if(response.Exists())   {
+            std::string format(response.GetAttribute("format"));
+            std::string target(response.GetAttribute("target"));
+            std::string source(response.GetAttribute("source"));
 
             bool ok_format = true;
             bool ok_target = true;
@@ -676,7 +1240,7 @@ namespace obdex
     // ============================================================= //
 
     void Parser::buildHeader_ISO_15765(ParameterFrame &param_frame,
-                                       pugi::xml_node xn_address) const
+                                       DefinitionAddress const &address) const
     {
         // store the request header data in
         // a MessageData struct
@@ -686,9 +1250,9 @@ namespace obdex
         // store 11-bit header in two bytes
         if(!param_frame.iso15765_extended_id)   {
             // request header bytes
-            pugi::xml_node xn_req = xn_address.child("request");
-            if(xn_req)   {
-                std::string identifier(xn_req.attribute("identifier").value());
+            DefinitionElement const &request = address.request;
+            if(request.Exists())   {
+                std::string identifier(request.GetAttribute("identifier"));
                 if(identifier.empty())   {
                     throw BuildParamFrameFailed(
                                 "ISO 15765-4 std, "
@@ -708,7 +1272,7 @@ namespace obdex
                 msg.req_header_bytes.push_back(lower_byte);
             }
             else   {
-                obdexlog.Warn() << "ISO 15765 std, no request header";
+                OBDEX_LOG_WARN(obdexlog) << "ISO 15765 std, no request header";
             }
 
             // preemptively fill out response header
@@ -721,9 +1285,9 @@ namespace obdex
             msg.exp_header_mask.push_back(0);
 
             // response header bytes
-            pugi::xml_node xn_resp = xn_address.child("response");
-            if(xn_resp)   {
-                std::string identifier(xn_resp.attribute("identifier").value());
+            DefinitionElement const &response = address.response;
+            if(response.Exists())   {
+                std::string identifier(response.GetAttribute("identifier"));
                 if(identifier.empty())   {
                     throw BuildParamFrameFailed(
                                 "ISO 15765-4 std, "
@@ -747,12 +1311,12 @@ namespace obdex
         // store 29-bit header in two bytes
         else   {
             // request header bytes
-            pugi::xml_node xn_req = xn_address.child("request");
-            if(xn_req)   {
-                std::string prio(xn_req.attribute("prio").value());
-                std::string format(xn_req.attribute("format").value());
-                std::string target(xn_req.attribute("target").value());
-                std::string source(xn_req.attribute("source").value());
+            DefinitionElement const &request = address.request;
+            if(request.Exists())   {
+                std::string prio(request.GetAttribute("prio"));
+                std::string format(request.GetAttribute("format"));
+                std::string target(request.GetAttribute("target"));
+                std::string source(request.GetAttribute("source"));
 
                 // all four bytes must be defined
                 if(prio.empty() || format.empty() ||
@@ -776,7 +1340,7 @@ namespace obdex
 
             }
             else   {
-                obdexlog.Warn() << "ISO 15765 ext, no request header";
+                OBDEX_LOG_WARN(obdexlog) << "ISO 15765 ext, no request header";
             }
 
             // preemptively fill out response header
@@ -793,12 +1357,12 @@ namespace obdex
             msg.exp_header_mask.push_back(0);
 
             // response header bytes
-            pugi::xml_node xn_resp = xn_address.child("response");
-            if(xn_resp)   {
-                std::string prio(xn_req.attribute("prio").value());
-                std::string format(xn_req.attribute("format").value());
-                std::string target(xn_req.attribute("target").value());
-                std::string source(xn_req.attribute("source").value());
+            DefinitionElement const &response = address.response;
+            if(response.Exists())   {
+                std::string prio(response.GetAttribute("prio"));
+                std::string format(response.GetAttribute("format"));
+                std::string target(response.GetAttribute("target"));
+                std::string source(response.GetAttribute("source"));
 
                 bool ok_prio   = true;
                 bool ok_format = true;
@@ -817,7 +1381,7 @@ namespace obdex
                     msg.exp_header_bytes[2] = StringToUInt(target,ok_target);
                     msg.exp_header_mask[2] = 0xFF;
                 }
-                if(!target.empty())   {
+                if(!source.empty())   {
                     msg.exp_header_bytes[3] = StringToUInt(source,ok_source);
                     msg.exp_header_mask[3] = 0xFF;
                 }
@@ -837,8 +1401,8 @@ namespace obdex
     // ============================================================= //
     // ============================================================= //
 
-    void Parser::buildData(ParameterFrame &param_frame,
-                           pugi::xml_node xn_parameter) const
+    bool Parser::buildRequests(ParameterFrame &param_frame,
+                               DefinitionParameter const &param)
     {
         // If the parameter is only being used to parse
         // passively, it should not have any request or
@@ -846,12 +1410,12 @@ namespace obdex
         std::string request,request0;
         bool has_multiple_reqs=false;
         {
-            request = std::string(xn_parameter.attribute("request").value());
-            request0 = std::string(xn_parameter.attribute("request0").value());
+            request = std::string(param.attributes.GetAttribute("request"));
+            request0 = std::string(param.attributes.GetAttribute("request0"));
             if(request.empty() && request0.empty())   {
                 // assume that no requests will be made
                 // for this parameter so we are done
-                return;
+                return false;
             }
             else if((!request.empty()) && (!request0.empty()))   {
                 BuildParamFrameFailed("mixed single and multiple requests");
@@ -890,22 +1454,24 @@ namespace obdex
             std::string request_delay,response_prefix,response_bytes;
 
             if(!has_multiple_reqs)  {
-                request         = xn_parameter.attribute("request").value();
-                request_delay   = xn_parameter.attribute("request.delay").value();
-                response_prefix = xn_parameter.attribute("response.prefix").value();
-                response_bytes  = xn_parameter.attribute("response.bytes").value();
+                request         = param.attributes.GetAttribute("request");
+                request_delay   = param.attributes.GetAttribute("request.delay");
+                response_prefix = param.attributes.GetAttribute("response.prefix");
+                response_bytes  = param.attributes.GetAttribute("response.bytes");
             }
             else   {
-                std::string request_n           = "request"+ToString(n);
+                std::string request_n("request");
+                AppendUInt(request_n,n);
                 std::string request_delay_n     = request_n+".delay";
-                std::string response_n          = "response"+ToString(n);
+                std::string response_n("response");
+                AppendUInt(response_n,n);
                 std::string response_prefix_n   = response_n+".prefix";
                 std::string response_bytes_n    = response_n+".bytes";
 
-                request = xn_parameter.attribute(request_n.c_str()).value();
-                request_delay = xn_parameter.attribute(request_delay_n.c_str()).value();
-                response_prefix = xn_parameter.attribute(response_prefix_n.c_str()).value();
-                response_bytes = xn_parameter.attribute(response_bytes_n.c_str()).value();
+                request = param.attributes.GetAttribute(request_n.c_str());
+                request_delay = param.attributes.GetAttribute(request_delay_n.c_str());
+                response_prefix = param.attributes.GetAttribute(response_prefix_n.c_str());
+                response_bytes = param.attributes.GetAttribute(response_bytes_n.c_str());
 
                 if(request.empty())   {
                     param_frame.list_message_data.pop_back();
@@ -951,6 +1517,15 @@ namespace obdex
                 break;
             }
         }
+        return true;
+    }
+
+    void Parser::buildData(ParameterFrame &param_frame,
+                           DefinitionParameter const &param) const
+    {
+        if(!buildRequests(param_frame,param))   {
+            return;
+        }
 
         // copy over header data from first message in list
         // to other entries; only relevant for multi-response
@@ -1065,6 +1640,127 @@ namespace obdex
     // ============================================================= //
     // ============================================================= //
 
+    sint Parser::getResponderCount(ParameterFrame const &param_frame,
+                                   DefinitionAddress const &address) const
+    {
+        // A response header that specifies the source
+        // address (or the full identifier for 11-bit
+        // ISO 15765) can only be matched by one node.
+        // Otherwise the request may be functional and
+        // the number of responders isn't known until
+        // the vehicle has been queried
+        DefinitionElement const &response = address.response;
+        if(!response.Exists())   {
+            return -1;
+        }
+
+        std::string source;
+        if(param_frame.parse_protocol == PROTOCOL_ISO_15765 &&
+           !param_frame.iso15765_extended_id)   {
+            source = response.GetAttribute("identifier");
+        }
+        else   {
+            source = response.GetAttribute("source");
+        }
+
+        return (source.empty()) ? -1 : 1;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    sint Parser::getParseFunction(DefinitionParameter const &param,
+                                  std::string const &protocol) const
+    {
+        sint const function_idx = findParseFunction(param,protocol);
+        if(function_idx == -1 && !param.list_scripts.empty())   {
+            throw BuildParamFrameFailed(
+                        "Protocol specified not found in parse script");
+        }
+        return function_idx;
+    }
+
+    sint Parser::findParseFunction(DefinitionParameter const &param,
+                                   std::string const &protocol)
+    {
+        if(param.list_scripts.empty())   {
+            return -1;
+        }
+
+        // a script without protocols is used for all of them
+        if(param.list_scripts[0].protocols.empty())   {
+            return param.list_scripts[0].function_idx;
+        }
+
+        // get the script for the specified protocol
+        for(auto const &script : param.list_scripts)   {
+            if(StringContains(script.protocols,protocol))   {
+                return script.function_idx;
+            }
+        }
+        return -1;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void Parser::buildExpResponseCount(ParameterFrame &param_frame,
+                                       sint const responder_count) const
+    {
+        if(responder_count < 0)   {
+            return;
+        }
+
+        for(auto &msg : param_frame.list_message_data)
+        {
+            // passive messages and responses of unknown
+            // length can't be counted
+            if(msg.list_req_data_bytes.empty() ||
+               msg.exp_data_byte_count < 0)   {
+                continue;
+            }
+
+            sint const data_length =
+                    msg.exp_data_prefix.size() +
+                    msg.exp_data_byte_count;
+
+            sint frames_per_response = -1;
+
+            if(param_frame.parse_protocol < 0xA00)   {
+                // SAE J1850/ISO 9141-2 frames carry at most
+                // seven data bytes; longer responses are split
+                // in a manufacturer specific way
+                if(data_length <= 7)   {
+                    frames_per_response = 1;
+                }
+            }
+            else if(param_frame.parse_protocol == PROTOCOL_ISO_14230)   {
+                if(data_length <= 255)   {
+                    frames_per_response = 1;
+                }
+            }
+            else if(param_frame.parse_protocol == PROTOCOL_ISO_15765)   {
+                // single frame: [pci] [d0 ... d6]
+                // first frame: [pci] [pci] [d0 ... d5]
+                // consecutive frames: [pci] [d0 ... d6]
+                if(data_length <= 7)   {
+                    frames_per_response = 1;
+                }
+                else   {
+                    frames_per_response = 1 + ((data_length-6)+6)/7;
+                }
+            }
+
+            if(frames_per_response > 0)   {
+                msg.exp_response_count =
+                        frames_per_response*responder_count;
+            }
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
     void Parser::parseResponse(ParameterFrame const &msg_frame,
                                std::vector<Data> &list_data)
     {
@@ -1072,6 +1768,7 @@ namespace obdex
             throw ParseParamFrameFailed("Invalid function idx");
         }
         int js_f_idx = msg_frame.function_key_idx;
+        bool const use_cache = m_parse_cache->IsEnabled();
 
         if(msg_frame.parse_mode == PARSE_SEPARATELY)
         {
@@ -1081,6 +1778,8 @@ namespace obdex
             // * the data is accessed using "BYTE(N)" in js where N
             //   is the Nth data byte in a list_data entry
 
+            ParseLookupTable * lookup_table = getLookupTable(js_f_idx);
+
             for(uint i=0; i < msg_frame.list_message_data.size(); i++)
             {
                 MessageData const &msg = msg_frame.list_message_data[i];
@@ -1092,45 +1791,54 @@ namespace obdex
                     obdex::Data parsed_data;
 
                     // fill out parameter data
-                    parsed_data.param_name    = msg_frame.name;
-                    parsed_data.src_name      = msg_frame.address;
-
-                    // clear existing data in js context
-                    duk_dup(m_js_ctx,m_js_idx_f_clear_data);
-                    duk_call(m_js_ctx,0);
-                    duk_pop(m_js_ctx);
-
-                    // copy over data_bytes to js context
-                    duk_dup(m_js_ctx,m_js_idx_f_add_databytes);
-                    int list_arr_idx = duk_push_array(m_js_ctx);    // list_data_bytes
-                    int data_arr_idx = duk_push_array(m_js_ctx);    // data_bytes
-                    for(uint k=0; k < data_bytes.size(); k++)   {
-                        duk_push_number(m_js_ctx,data_bytes[k]);
-                        duk_put_prop_index(m_js_ctx,data_arr_idx,k);
+                    setDataNames(msg_frame,parsed_data);
+
+                    // check the lookup table
+                    size_t table_idx=0;
+                    bool const use_table = lookup_table &&
+                            lookup_table->GetIndex(data_bytes,table_idx);
+
+                    if(use_table)   {
+                        if(lookup_table->Find(table_idx,parsed_data))   {
+                            m_lookup_hits++;
+                            saveSourceAddress(header_bytes,parsed_data);
+                            list_data.push_back(parsed_data);
+                            continue;
+                        }
+                        m_lookup_misses++;
                     }
-                    duk_put_prop_index(m_js_ctx,list_arr_idx,0);
-                    duk_call(m_js_ctx,1);
-                    duk_pop(m_js_ctx);
 
-                    // parse the data
-                    duk_dup(m_js_ctx,m_js_list_function_idx[js_f_idx]);
-                    duk_call(m_js_ctx,0);
-                    duk_pop(m_js_ctx);
+                    // check for an earlier response with the
+                    // same bytes (the source address comes
+                    // from the header, so it's part of the key)
+                    u64 cache_hash=0;
+                    if(use_cache)   {
+                        m_parse_cache_key.clear();
+                        ParseCache::AppendKeyBytes(m_parse_cache_key,header_bytes);
+                        ParseCache::AppendKeyBytes(m_parse_cache_key,data_bytes);
+                        cache_hash = ParseCache::Hash(m_parse_cache_key);
+
+                        Data const * cached_data =
+                                m_parse_cache->Find(js_f_idx,cache_hash,m_parse_cache_key);
+                        if(cached_data)   {
+                            list_data.push_back(*cached_data);
+                            setDataNames(msg_frame,list_data.back());
+                            continue;
+                        }
+                    }
 
-                    // save results
-                    this->saveNumAndLitData(parsed_data);
+                    parseDataBytes(js_f_idx,data_bytes,parsed_data,false);
+
+                    if(use_table)   {
+                        lookup_table->Insert(table_idx,parsed_data);
+                    }
 
                     // save data source address info in LiteralData
-                    LiteralData src_address;
-                    src_address.property = "Source Address";
-                    for(uint k=0; k < header_bytes.size(); k++)   {
-                        std::string b_str = ConvUByteToHexStr(header_bytes[k]) + " ";
-                        src_address.value_if_true.append(b_str);
-                    }
-                    src_address.value_if_true = StringToUpper(src_address.value_if_true);
-                    src_address.value = true;
-                    parsed_data.list_literal_data.push_back(src_address);
+                    saveSourceAddress(header_bytes,parsed_data);
 
+                    if(use_cache)   {
+                        m_parse_cache->Insert(js_f_idx,cache_hash,m_parse_cache_key,parsed_data);
+                    }
                     list_data.push_back(parsed_data);
                 }
             }
@@ -1155,133 +1863,262 @@ namespace obdex
             //   - BYTE(N) is a single byte in that list of
             //     data bytes
 
-            // clear existing data in js context
-            duk_dup(m_js_ctx,m_js_idx_f_clear_data);
-            duk_call(m_js_ctx,0);
-            duk_pop(m_js_ctx);
+            // check for an earlier call with the same
+            // headers and data for every MessageData
+            u64 cache_hash=0;
+            if(use_cache)   {
+                m_parse_cache_key.clear();
+                ParseCache::AppendKeySize(m_parse_cache_key,msg_frame.list_message_data.size());
+                for(auto const &msg : msg_frame.list_message_data)   {
+                    ParseCache::AppendKeySize(m_parse_cache_key,msg.list_headers.size());
+                    for(auto const &header_bytes : msg.list_headers)   {
+                        ParseCache::AppendKeyBytes(m_parse_cache_key,header_bytes);
+                    }
+                    ParseCache::AppendKeySize(m_parse_cache_key,msg.list_data.size());
+                    for(auto const &data_bytes : msg.list_data)   {
+                        ParseCache::AppendKeyBytes(m_parse_cache_key,data_bytes);
+                    }
+                }
+                cache_hash = ParseCache::Hash(m_parse_cache_key);
+
+                Data const * cached_data =
+                        m_parse_cache->Find(js_f_idx,cache_hash,m_parse_cache_key);
+                if(cached_data)   {
+                    list_data.push_back(*cached_data);
+                    setDataNames(msg_frame,list_data.back());
+                    return;
+                }
+            }
 
             obdex::Data parsed_data;
-            parsed_data.param_name    = msg_frame.name;
-            parsed_data.src_name      = msg_frame.address;
+            setDataNames(msg_frame,parsed_data);
 
-            for(uint i=0; i < msg_frame.list_message_data.size(); i++)
-            {
-                MessageData const &msg = msg_frame.list_message_data[i];
-                duk_dup(m_js_ctx,m_js_idx_f_add_msg_data);
-                int list_arr_idx;
+            runScript(js_f_idx,msg_frame.list_message_data,parsed_data,false);
 
-                // build header bytes js array
-                list_arr_idx = duk_push_array(m_js_ctx);    // listheader_bytes
+            if(use_cache)   {
+                m_parse_cache->Insert(js_f_idx,cache_hash,m_parse_cache_key,parsed_data);
+            }
+            list_data.push_back(parsed_data);
+        }
+    }
 
-                for(uint j=0; j < msg.list_headers.size(); j++)   {
-                    ByteList const &header_bytes = msg.list_headers[j];
-                    int header_arr_idx = duk_push_array(m_js_ctx);    // header_bytes
-                    for(uint k=0; k < header_bytes.size(); k++)   {
-                        duk_push_number(m_js_ctx,header_bytes[k]);
-                        duk_put_prop_index(m_js_ctx,header_arr_idx,k);
-                    }
-                    duk_put_prop_index(m_js_ctx,list_arr_idx,j);
-                }
+    // ============================================================= //
+    // ============================================================= //
 
-                // build data bytes js array
-                list_arr_idx = duk_push_array(m_js_ctx);    // list_data_bytes
+    bool Parser::parseDataBytes(int js_f_idx,
+                                ByteList const &data_bytes,
+                                Data &parsed_data,
+                                bool catch_errors)
+    {
+        return runScript(js_f_idx,data_bytes,parsed_data,catch_errors);
+    }
 
-                for(uint j=0; j < msg.list_data.size(); j++)   {
-                    ByteList const &data_bytes = msg.list_data[j];
-                    int data_arr_idx = duk_push_array(m_js_ctx);    // data_bytes
-                    for(uint k=0; k < data_bytes.size(); k++)   {
-                        duk_push_number(m_js_ctx,data_bytes[k]);
-                        duk_put_prop_index(m_js_ctx,data_arr_idx,k);
-                    }
-                    duk_put_prop_index(m_js_ctx,list_arr_idx,j);
+    template<typename Input>
+    bool Parser::runScript(int js_f_idx,
+                           Input const &input,
+                           Data &parsed_data,
+                           bool catch_errors)
+    {
+        try {
+            size_t const engine_idx = m_js_list_engine_idx[js_f_idx];
+            if(engine_idx != 0 && m_list_engine_compiled[engine_idx][js_f_idx])   {
+                if(runEngine(*(m_list_script_engines[engine_idx]),js_f_idx,
+                             input,parsed_data,true))   {
+                    return true;
                 }
-                duk_call(m_js_ctx,2);
-                duk_pop(m_js_ctx);
             }
-            // parse the data
-            duk_dup(m_js_ctx,m_js_list_function_idx[js_f_idx]);
-            duk_call(m_js_ctx,0);
-            duk_pop(m_js_ctx);
 
-            // save results
-            this->saveNumAndLitData(parsed_data);
-            list_data.push_back(parsed_data);
+            // duktape can run any script
+            return runEngine(*(m_list_script_engines[0]),js_f_idx,
+                             input,parsed_data,catch_errors);
+        }
+        catch(ScriptBudgetExceeded &)   {
+            if(catch_errors)   {
+                return false;
+            }
+            throw;
+        }
+        catch(ScriptHeapLimitExceeded &)   {
+            if(catch_errors)   {
+                return false;
+            }
+            throw;
         }
     }
 
-    // ============================================================= //
-    // ============================================================= //
+    template<typename Input>
+    bool Parser::runEngine(ScriptEngine &engine,
+                           int js_f_idx,
+                           Input const &input,
+                           Data &parsed_data,
+                           bool catch_errors)
+    {
+        {
+            OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_JS_MARSHAL);
+            engine.BindInput(input);
+        }
+
+        if(m_script_budget.IsEnabled())   {
+            OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_SCRIPT);
+            if(!runEngineWithBudget(engine,js_f_idx,catch_errors))   {
+                return false;
+            }
+        }
+        else   {
+            OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_SCRIPT);
+            if(!engine.Run(u32(js_f_idx),catch_errors))   {
+                return false;
+            }
+        }
+
+        OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_EXTRACT);
+
+        // save results
+        if(catch_errors)   {
+            // ie. undefined strings in the results
+            try {
+                engine.ExtractResults(parsed_data);
+            }
+            catch(std::exception &)   {
+                return false;
+            }
+        }
+        else   {
+            engine.ExtractResults(parsed_data);
+        }
+        return true;
+    }
 
-    void Parser::saveNumAndLitData(Data &data)
+    bool Parser::runEngineWithBudget(ScriptEngine &engine,
+                                     int js_f_idx,
+                                     bool catch_errors)
     {
-        // save numerical data
-        duk_dup(m_js_ctx,m_js_idx_f_get_num_data);
-        duk_call(m_js_ctx,0);                       // <..., listNumData>
-        duk_get_prop_string(m_js_ctx,-1,"length");  // <..., listNumData, listNumData.length>
-        u32 listNumLength = u32(duk_get_number(m_js_ctx,-1));
-        duk_pop(m_js_ctx);                          // <..., listNumData>
+        if(m_js_list_budget_stats.size() <= size_t(js_f_idx))   {
+            m_js_list_budget_stats.resize(m_definitions->list_function_key.size());
+        }
+        ScriptBudgetStats &stats = m_js_list_budget_stats[js_f_idx];
+        stats.runs++;
+
+        TimePoint const start = std::chrono::high_resolution_clock::now();
+        bool exceeded=false;
+        bool ok=false;
+        try {
+            ok = engine.Run(u32(js_f_idx),catch_errors);
+        }
+        catch(ScriptBudgetExceeded &)   {
+            exceeded = true;
+        }
+
+        Microseconds const time =
+                std::chrono::duration_cast<Microseconds>(
+                    std::chrono::high_resolution_clock::now()-start);
 
-        for(u32 i=0; i < listNumLength; i++)   {
-            NumericalData numData;
-            duk_get_prop_index(m_js_ctx,-1,i);      // <..., listNumData, listNumData[i]>
+        stats.max_steps = std::max(stats.max_steps,engine.GetLastRunSteps());
+        stats.max_time = std::max(stats.max_time,time);
 
-            duk_get_prop_string(m_js_ctx,-1,"units");
-            numData.units = std::string(duk_get_string(m_js_ctx,-1));
-            duk_pop(m_js_ctx);
+        if(exceeded)   {
+            stats.exceeded++;
+            throw ScriptBudgetExceeded(
+                        "Error: parse script "+
+                        m_definitions->list_function_key[js_f_idx]+
+                        " exceeded its budget");
+        }
+        return ok;
+    }
 
-            duk_get_prop_string(m_js_ctx,-1,"min");
-            numData.min = duk_get_number(m_js_ctx,-1);
-            duk_pop(m_js_ctx);
+    void Parser::setDataNames(ParameterFrame const &msg_frame,
+                              Data &parsed_data) const
+    {
+        parsed_data.param_id    = msg_frame.param_id;
+        parsed_data.param_name  = msg_frame.name;
+        parsed_data.src_name    = msg_frame.address;
+    }
 
-            duk_get_prop_string(m_js_ctx,-1,"max");
-            numData.max = duk_get_number(m_js_ctx,-1);
-            duk_pop(m_js_ctx);
+    void Parser::saveSourceAddress(ByteList const &header_bytes,
+                                   Data &parsed_data) const
+    {
+        LiteralData src_address;
+        src_address.property = "Source Address";
+        src_address.value_if_true.reserve(header_bytes.size()*3);
+        for(uint k=0; k < header_bytes.size(); k++)   {
+            src_address.value_if_true.append(k_ubyte_hex_str[header_bytes[k]],2);
+            src_address.value_if_true.push_back(' ');
+        }
+        src_address.value = true;
+        parsed_data.list_literal_data.push_back(src_address);
+    }
 
-            duk_get_prop_string(m_js_ctx,-1,"value");
-            numData.value = duk_get_number(m_js_ctx,-1);
-            duk_pop(m_js_ctx);
+    // ============================================================= //
+    // ============================================================= //
 
-            duk_get_prop_string(m_js_ctx,-1,"property");
-            numData.property = std::string(duk_get_string(m_js_ctx,-1));
-            duk_pop(m_js_ctx);
+    Parser::LookupTableInfo
+    Parser::buildLookupTableInfo(std::string const &script,
+                                 DefinitionParameter const &param) const
+    {
+        LookupTableInfo info;
 
-            duk_pop(m_js_ctx);                      // <..., listNumData>
-            data.list_numerical_data.push_back(numData);
+        // lookup tables are only used for PARSE_SEPARATELY
+        if(param.attributes.GetAttribute("parse") == "combined")   {
+            return info;
         }
-        duk_pop(m_js_ctx);
 
-        // save literal data
-        duk_dup(m_js_ctx,m_js_idx_f_get_lit_data);
-        duk_call(m_js_ctx,0);                       // <..., listLitData>
-        duk_get_prop_string(m_js_ctx,-1,"length");  // <..., listLitData.length>
-        u32 listLitLength = u32(duk_get_number(m_js_ctx,-1));
-        duk_pop(m_js_ctx);                          // <..., listLitData>
+        ScriptAnalysis const analysis = AnalyzeScript(script);
+        if(!analysis.data_only)   {
+            return info;
+        }
 
-        for(u32 i=0; i < listLitLength; i++)   {
-            LiteralData litData;
-            duk_get_prop_index(m_js_ctx,-1,i);      // <..., listLitData, listLitData[i]>
+        // the expected data length is needed if the
+        // script's results depend on it
+        sint exp_data_length=-1;
+        if(param.attributes.HasAttribute("response.bytes"))   {
+            bool ok=false;
+            uint const length =
+                    StringToUInt(param.attributes.GetAttribute("response.bytes"),ok);
+            if(ok)   {
+                exp_data_length = sint(length);
+            }
+        }
 
-            duk_get_prop_string(m_js_ctx,-1,"value");
-            int litDataVal = duk_get_boolean(m_js_ctx,-1);
-            litData.value = (litDataVal == 1) ? true : false;
-            duk_pop(m_js_ctx);
+        if(analysis.dynamic_byte_positions)   {
+            if(exp_data_length < 0)   {
+                return info;
+            }
+            for(sint i=0; i < exp_data_length; i++)   {
+                info.list_byte_positions.push_back(uint(i));
+            }
+            info.exp_data_length = exp_data_length;
+        }
+        else   {
+            if(analysis.uses_length && exp_data_length < 0)   {
+                return info;
+            }
+            info.list_byte_positions = analysis.list_byte_positions;
+            info.exp_data_length = analysis.uses_length ? exp_data_length : -1;
+        }
 
-            duk_get_prop_string(m_js_ctx,-1,"valueIfFalse");
-            litData.value_if_false = std::string(duk_get_string(m_js_ctx,-1));
-            duk_pop(m_js_ctx);
+        // a table for more bytes would never fit in memory
+        if(info.list_byte_positions.size() > 4)   {
+            return info;
+        }
 
-            duk_get_prop_string(m_js_ctx,-1,"valueIfTrue");
-            litData.value_if_true = std::string(duk_get_string(m_js_ctx,-1));
-            duk_pop(m_js_ctx);
+        info.domain_size = u64(1) << (8*info.list_byte_positions.size());
+        info.eligible = true;
+        return info;
+    }
 
-            duk_get_prop_string(m_js_ctx,-1,"property");
-            litData.property = std::string(duk_get_string(m_js_ctx,-1));
-            duk_pop(m_js_ctx);
+    ParseLookupTable * Parser::getLookupTable(int js_f_idx)
+    {
+        LookupTableInfo const &info = m_js_list_lookup_info[js_f_idx];
+        if(!info.eligible || info.domain_size > m_lookup_table_max_domain)   {
+            return nullptr;
+        }
 
-            duk_pop(m_js_ctx);                      // <..., listLitData>
-            data.list_literal_data.push_back(litData);
+        std::unique_ptr<ParseLookupTable> &table = m_list_lookup_tables[js_f_idx];
+        if(!table)   {
+            table.reset(new ParseLookupTable(info.list_byte_positions,
+                                             info.exp_data_length));
         }
-        duk_pop(m_js_ctx);
+        return table.get();
     }
 
     // ============================================================= //
@@ -1289,11 +2126,20 @@ namespace obdex
 
     void Parser::cleanFrames_Legacy(MessageData &msg)
     {
+        OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_CLEAN);
+
         int const header_length=3;
         for(uint j=0; j < msg.list_raw_frames.size(); j++)
         {
             ByteList const &raw_frame = msg.list_raw_frames[j];
 
+            if(raw_frame.size() < uint(header_length))   {
+                countRejectedFrame(REJECT_TRUNCATED_FRAME);
+                throw ParseParamFrameFailed(
+                            "SAE J1850/ISO 9141-2/ISO 14230-4, "
+                            "truncated frame");
+            }
+
             // Split each raw frame into a header and its
             // corresponding data bytes
             // [h0 h1 h2] [d0 d1 d2 d3 d4 d5 d6 ...]
@@ -1310,12 +2156,19 @@ namespace obdex
             if(!checkBytesAgainstMask(msg.exp_header_bytes,
                                       msg.exp_header_mask,
                                       header_bytes))   {
+                countRejectedFrame(REJECT_HEADER_MISMATCH);
                 throw ParseParamFrameFailed(
                             "SAE J1850/ISO 9141-2/ISO 14230-4, "
                             "header bytes mismatch");
             }
 
             // check data prefix
+            if(data_bytes.size() < msg.exp_data_prefix.size())   {
+                countRejectedFrame(REJECT_TRUNCATED_FRAME);
+                throw ParseParamFrameFailed(
+                            "SAE J1850/ISO 9141-2/ISO 14230-4, "
+                            "truncated frame");
+            }
             bool data_prefix_ok = true;
             for(uint k=0; k < msg.exp_data_prefix.size(); k++)   {
                 ubyte data_byte = data_bytes[0];
@@ -1326,6 +2179,7 @@ namespace obdex
                 }
             }
             if(!data_prefix_ok)   {
+                countRejectedFrame(REJECT_PREFIX_MISMATCH);
                 throw ParseParamFrameFailed(
                             "SAE J1850/ISO 9141-2/ISO 14230-4, "
                             "data prefix mismatch");
@@ -1348,10 +2202,18 @@ namespace obdex
 
     void Parser::cleanFrames_ISO_14230(MessageData &msg)
     {
+        OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_CLEAN);
+
         for(uint j=0; j < msg.list_raw_frames.size(); j++)
         {
             ByteList const &raw_frame = msg.list_raw_frames[j];
 
+            if(raw_frame.empty())   {
+                rejectFrame(REJECT_TRUNCATED_FRAME,
+                            "ISO 14230, truncated frame");
+                continue;
+            }
+
             // determine header type:
             // A [format]
             // B [format] [target] [source]
@@ -1374,9 +2236,21 @@ namespace obdex
             if(no_addressing)   { header_length -= 2; }
             if(!has_length_bytes) { header_length -= 1; }
 
+            if(raw_frame.size() < header_length)   {
+                rejectFrame(REJECT_TRUNCATED_FRAME,
+                            "ISO 14230, truncated frame");
+                continue;
+            }
+
             ubyte data_length = (has_length_bytes) ?
                 raw_frame[header_length-1] : (raw_frame[0] & 0x3F);
 
+            if(raw_frame.size() < uint(header_length+data_length))   {
+                rejectFrame(REJECT_TRUNCATED_FRAME,
+                            "ISO 14230, truncated frame");
+                continue;
+            }
+
             // split each raw frame into a header and its
             // corresponding data bytes
             ByteList header_bytes;
@@ -1433,13 +2307,20 @@ namespace obdex
 
             // check for expected header bytes
             if(!checkBytesAgainstMask(exp_header_bytes,exp_header_mask,header_bytes))   {
-                obdexlog.Warn() << "ISO 14230, header bytes mismatch";
+                rejectFrame(REJECT_HEADER_MISMATCH,
+                            "ISO 14230, header bytes mismatch");
                 continue;
             }
 
             // check/remove data prefix
+            if(data_bytes.size() < msg.exp_data_prefix.size())   {
+                rejectFrame(REJECT_TRUNCATED_FRAME,
+                            "ISO 14230, truncated frame");
+                continue;
+            }
             if(!checkAndRemoveDataPrefix(msg.exp_data_prefix,data_bytes))   {
-                obdexlog.Warn() << "ISO 14230, data prefix mismatch";
+                rejectFrame(REJECT_PREFIX_MISMATCH,
+                            "ISO 14230, data prefix mismatch");
                 continue;
             }
 
@@ -1458,141 +2339,194 @@ namespace obdex
 
     void Parser::cleanFrames_ISO_15765(MessageData &msg, int const header_length)
     {
-        for(uint j=0; j < msg.list_raw_frames.size(); j++)
+        // keep track of CFs that have already been merged
+        // and FFs that are missing some of their CFs
+        std::vector<u8> list_merged_frames;
+        std::vector<u8> list_incomplete_frames;
+
         {
-            ByteList const &raw_frame = msg.list_raw_frames[j];
+            OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_CLEAN);
 
-            // split raw frame into a header and its
-            // corresponding data bytes
-            ByteList header_bytes;
-            for(int k=0; k < header_length; k++)   {
-                header_bytes.push_back(raw_frame[k]);
-            }
-            ByteList data_bytes;
-            for(uint k=header_length; k < raw_frame.size(); k++)   {
-                data_bytes.push_back(raw_frame[k]);
-            }
+            for(uint j=0; j < msg.list_raw_frames.size(); j++)
+            {
+                ByteList const &raw_frame = msg.list_raw_frames[j];
 
-            // check header
-            if(!checkBytesAgainstMask(msg.exp_header_bytes,
-                                      msg.exp_header_mask,
-                                      header_bytes))   {
-                obdexlog.Warn() << "ISO 15765-4, header bytes mismatch";
-                continue;
-            }
+                // every frame needs at least a pci byte
+                if(raw_frame.size() <= uint(header_length))   {
+                    rejectFrame(REJECT_TRUNCATED_FRAME,
+                                "ISO 15765-4, truncated frame");
+                    continue;
+                }
 
-            // save
-            msg.list_headers.push_back(header_bytes);
-            msg.list_data.push_back(data_bytes);
-        }
+                // split raw frame into a header and its
+                // corresponding data bytes
+                ByteList header_bytes;
+                for(int k=0; k < header_length; k++)   {
+                    header_bytes.push_back(raw_frame[k]);
+                }
+                ByteList data_bytes;
+                for(uint k=header_length; k < raw_frame.size(); k++)   {
+                    data_bytes.push_back(raw_frame[k]);
+                }
 
-        // go through the frames and merge multi-frame messages
+                // check header
+                if(!checkBytesAgainstMask(msg.exp_header_bytes,
+                                          msg.exp_header_mask,
+                                          header_bytes))   {
+                    rejectFrame(REJECT_HEADER_MISMATCH,
+                                "ISO 15765-4, header bytes mismatch");
+                    continue;
+                }
 
-        // keep track of CFs that have already been merged
-        std::vector<u8> list_merged_frames;
-        for(uint j=0; j < msg.list_headers.size(); j++)   {
-            list_merged_frames.push_back(false);
+                // check pci byte; responses should only
+                // have SF (0N), FF (1N NN) and CF (2N)
+                ubyte const pci_type = data_bytes[0] >> 4;
+                ubyte const pci_sf_length = data_bytes[0] & 0x0F;
+                if(pci_type > 2 || (pci_type == 0 && pci_sf_length == 0))   {
+                    rejectFrame(REJECT_BAD_PCI,
+                                "ISO 15765-4, bad pci byte");
+                    continue;
+                }
+                if((pci_type == 0 && pci_sf_length > data_bytes.size()-1) ||
+                   (pci_type == 1 && data_bytes.size() < 2))   {
+                    rejectFrame(REJECT_TRUNCATED_FRAME,
+                                "ISO 15765-4, truncated frame");
+                    continue;
+                }
+
+                // save
+                msg.list_headers.push_back(header_bytes);
+                msg.list_data.push_back(data_bytes);
+            }
         }
 
-        for(uint j=0; j < msg.list_headers.size(); j++)   {
-            // ignore already merged frames
-            if(list_merged_frames[j])   {
-                continue;
+        {
+            OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_REASSEMBLY);
+
+            // go through the frames and merge multi-frame messages
+            for(uint j=0; j < msg.list_headers.size(); j++)   {
+                list_merged_frames.push_back(false);
+                list_incomplete_frames.push_back(false);
             }
 
-            ubyte jPciByte = msg.list_data[j][0];
+            for(uint j=0; j < msg.list_headers.size(); j++)   {
+                // ignore already merged frames
+                if(list_merged_frames[j])   {
+                    continue;
+                }
 
-            // [first frame] pci byte: 1N
-            if((jPciByte >> 4) == 1)   {
-                ByteList & headerFF = msg.list_headers[j];
-                ubyte nextPciByte = 0x21;
+                ubyte jPciByte = msg.list_data[j][0];
 
-                // keep track of the total number of data
-                // bytes we expect to see
-                int dataLength = ((jPciByte & 0x0F) << 8) +
-                                 msg.list_data[j][1];
+                // [first frame] pci byte: 1N
+                if((jPciByte >> 4) == 1)   {
+                    ByteList & headerFF = msg.list_headers[j];
+                    ubyte nextPciByte = 0x21;
 
-                int data_bytesSeen = msg.list_data[j].size()-2;
+                    // keep track of the total number of data
+                    // bytes we expect to see
+                    int dataLength = ((jPciByte & 0x0F) << 8) +
+                                     msg.list_data[j][1];
 
-                for(uint k=0; k < msg.list_headers.size(); k++)   {
-                    // ignore already merged frames
-                    if(list_merged_frames[k])   {
-                        continue;
-                    }
+                    int data_bytesSeen = msg.list_data[j].size()-2;
 
-                    // if the header and target pci byte match
-                    if((msg.list_data[k][0] == nextPciByte) &&
-                        msg.list_headers[k] == headerFF)   {
-                        // this is the next CF frame
+                    for(uint k=0; k < msg.list_headers.size(); k++)   {
+                        // ignore already merged frames
+                        if(list_merged_frames[k])   {
+                            continue;
+                        }
 
-                        // remove the pci byte and merge this frame
-                        // to the first frame's data bytes
-                        msg.list_data[k].erase(msg.list_data[k].begin());
+                        // if the header and target pci byte match
+                        if((msg.list_data[k][0] == nextPciByte) &&
+                            msg.list_headers[k] == headerFF)   {
+                            // this is the next CF frame
 
-                        msg.list_data[j].insert(
-                                    msg.list_data[j].end(),
-                                    msg.list_data[k].begin(),
-                                    msg.list_data[k].end());
+                            // remove the pci byte and merge this frame
+                            // to the first frame's data bytes
+                            msg.list_data[k].erase(msg.list_data[k].begin());
 
-                        // mark as merged
-                        list_merged_frames[k] = true;
+                            msg.list_data[j].insert(
+                                        msg.list_data[j].end(),
+                                        msg.list_data[k].begin(),
+                                        msg.list_data[k].end());
 
-                        // we can stop once we've merged the
-                        // expected number of data bytes
-                        data_bytesSeen += msg.list_data[k].size();
-                        if(data_bytesSeen >= dataLength)   {
-                            break;
-                        }
+                            // mark as merged
+                            list_merged_frames[k] = true;
 
-                        // set next target pci byte
-                        nextPciByte+=0x01;
-                        if(nextPciByte == 0x30)   {
-                            nextPciByte = 0x20;
-                        }
+                            // we can stop once we've merged the
+                            // expected number of data bytes
+                            data_bytesSeen += msg.list_data[k].size();
+                            if(data_bytesSeen >= dataLength)   {
+                                break;
+                            }
+
+                            // set next target pci byte
+                            nextPciByte+=0x01;
+                            if(nextPciByte == 0x30)   {
+                                nextPciByte = 0x20;
+                            }
 
-                        // reset k
-                        k=0;
+                            // reset k
+                            k=0;
+                        }
                     }
+                    // once we get here, all the CF for the FF
+                    // at msg.list_data[j] should be merged
+                    list_incomplete_frames[j] = (data_bytesSeen < dataLength);
                 }
-                // once we get here, all the CF for the FF
-                // at msg.list_data[j] should be merged
             }
         }
 
+        OBDEX_STATS_STAGE(*m_stats,PARSE_STAGE_CLEAN);
+
         // clean up CFs and pci bytes
         for(uint j=msg.list_headers.size(); j-- > 0;)   {
-            if(list_merged_frames[j])   {
-                msg.list_headers.erase(std::next(msg.list_headers.begin(),j));
-                msg.list_data.erase(std::next(msg.list_data.begin(),j));
-                list_merged_frames.erase(std::next(list_merged_frames.begin(),j));
-                continue;
-            }
+            bool keep_frame = false;
             ubyte pciByte = msg.list_data[j][0];
-            if((pciByte >> 4) == 0)   {         // SF
-                msg.list_data[j].erase(msg.list_data[j].begin());
+
+            if(list_merged_frames[j])   {
+                // already merged into its FF
             }
-            else if((pciByte >> 4) == 1)   {    // FF
-                msg.list_data[j].erase(msg.list_data[j].begin());
-                msg.list_data[j].erase(msg.list_data[j].begin());
+            else if((pciByte >> 4) == 2 || list_incomplete_frames[j])   {
+                // CF without a FF or FF without all of its CFs
+                rejectFrame(REJECT_SEQUENCE_GAP,
+                            "ISO 15765-4, missing consecutive frame");
             }
+            else   {
+                // drop the pci bytes and any padding after the
+                // length they give (frames are often padded to
+                // eight bytes)
+                ByteList &data_bytes = msg.list_data[j];
+                if((pciByte >> 4) == 0)   {         // SF
+                    size_t const length = pciByte & 0x0F;
+                    data_bytes.resize(1+length);
+                    data_bytes.erase(data_bytes.begin());
+                }
+                else if((pciByte >> 4) == 1)   {    // FF
+                    size_t const length = ((pciByte & 0x0F) << 8) + data_bytes[1];
+                    if(data_bytes.size() > 2+length)   {
+                        data_bytes.resize(2+length);
+                    }
+                    data_bytes.erase(data_bytes.begin(),data_bytes.begin()+2);
+                }
 
-            // check data prefix
-            bool dataPrefixOk = true;
-            for(uint k=0; k < msg.exp_data_prefix.size(); k++)   {
-
-                ubyte dataByte = msg.list_data[j][0];
-                msg.list_data[j].erase(msg.list_data[j].begin());
-                if(dataByte != msg.exp_data_prefix[k])   {
-                    dataPrefixOk = false;
-                    break;
+                // check data prefix
+                if(msg.list_data[j].size() < msg.exp_data_prefix.size())   {
+                    rejectFrame(REJECT_TRUNCATED_FRAME,
+                                "ISO 15765-4, truncated frame");
+                }
+                else if(!checkAndRemoveDataPrefix(msg.exp_data_prefix,
+                                                  msg.list_data[j]))   {
+                    rejectFrame(REJECT_PREFIX_MISMATCH,
+                                "ISO 15765-4, data prefix mismatch");
+                }
+                else   {
+                    keep_frame = true;
                 }
             }
-            if(!dataPrefixOk)   {
-                obdexlog.Warn() << "ISO 15765-4, data prefix mismatch";
+
+            if(!keep_frame)   {
                 msg.list_headers.erase(std::next(msg.list_headers.begin(),j));
                 msg.list_data.erase(std::next(msg.list_data.begin(),j));
-                list_merged_frames.erase(std::next(list_merged_frames.begin(),j));
-                continue;
             }
         }
 
@@ -1646,20 +2580,192 @@ namespace obdex
     // ============================================================= //
     // ============================================================= //
 
-    std::string Parser::ConvUByteToHexStr(ubyte byte) const
+    void Parser::rejectFrame(RejectReason reason, char const * desc)
+    {
+        if(!obdexlog.IsLevelEnabled(Logger::Level::WARN))   {
+            countRejectedFrame(reason);
+            return;
+        }
+
+        u64 suppressed=0;
+        if(!m_reject_counters->Add(reason,suppressed))   {
+            return;
+        }
+
+        if(suppressed > 0)   {
+            OBDEX_LOG_WARN(obdexlog) << desc << " (" << suppressed
+                                     << " more since last warning)";
+        }
+        else   {
+            OBDEX_LOG_WARN(obdexlog) << desc;
+        }
+    }
+
+    void Parser::countRejectedFrame(RejectReason reason)
+    {
+        u64 suppressed=0;
+        m_reject_counters->Add(reason,suppressed);
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    ParseStatsSnapshot Parser::GetParseStats() const
+    {
+#ifdef OBDEX_ENABLE_STATS
+        return m_stats->GetSnapshot(m_definitions->list_function_key);
+#else
+        return ParseStatsSnapshot();
+#endif
+    }
+
+    void Parser::ResetParseStats()
+    {
+#ifdef OBDEX_ENABLE_STATS
+        m_stats->Reset();
+#endif
+    }
+
+    bool Parser::StatsEnabled()
+    {
+#ifdef OBDEX_ENABLE_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::array<u64,REJECT_REASON_COUNT> Parser::GetRejectedFrameCounts() const
+    {
+        return m_reject_counters->GetAll();
+    }
+
+    u64 Parser::GetRejectedFrameCount(RejectReason reason) const
+    {
+        return m_reject_counters->Get(reason);
+    }
+
+    void Parser::ResetRejectedFrameCounts()
+    {
+        m_reject_counters->Reset();
+    }
+
+    void Parser::SetRejectWarningInterval(Milliseconds interval)
+    {
+        m_reject_counters->SetWarningInterval(interval);
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void Parser::SetParseCacheCapacity(size_t capacity)
+    {
+        m_parse_cache->SetCapacity(capacity);
+    }
+
+    ParseCacheStats Parser::GetParseCacheStats() const
+    {
+        return m_parse_cache->GetStats();
+    }
+
+    void Parser::ResetParseCacheStats()
+    {
+        m_parse_cache->ResetStats();
+    }
+
+    void Parser::ClearParseCache()
+    {
+        m_parse_cache->Clear();
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void Parser::SetLookupTableMaxDomain(size_t max_domain)
     {
-        return m_lkup_ubyte_hex_str[byte];
+        m_lookup_table_max_domain = max_domain;
+
+        // free tables that are now too big
+        for(size_t i=0; i < m_list_lookup_tables.size(); i++)   {
+            if(m_list_lookup_tables[i] &&
+               m_js_list_lookup_info[i].domain_size > max_domain)   {
+                m_list_lookup_tables[i].reset();
+            }
+        }
     }
 
-    ubyte Parser::ConvHexStrToUByte(std::string const &str) const
+    void Parser::PrecomputeLookupTables()
     {
-        auto it = m_lkup_hex_str_ubyte.find(str);
-        if(it == m_lkup_hex_str_ubyte.end())
+        for(size_t i=0; i < m_js_list_lookup_info.size(); i++)
         {
+            ParseLookupTable * table = getLookupTable(int(i));
+            if(!table)   {
+                continue;
+            }
+
+            for(size_t idx=0; idx < table->GetDomainSize(); idx++)   {
+                if(table->IsEvaluated(idx))   {
+                    continue;
+                }
+
+                // inputs the script fails on are left
+                // to the script when they're parsed
+                Data parsed_data;
+                if(parseDataBytes(int(i),table->GetDataBytes(idx),parsed_data,true))   {
+                    table->Insert(idx,parsed_data);
+                }
+            }
+        }
+    }
+
+    LookupTableStats Parser::GetLookupTableStats() const
+    {
+        LookupTableStats stats;
+        stats.hits = m_lookup_hits;
+        stats.misses = m_lookup_misses;
+        for(auto const &table : m_list_lookup_tables)   {
+            if(table)   {
+                stats.table_count++;
+                stats.entries += table->GetEntryCount();
+                stats.memory_bytes += table->GetMemoryBytes();
+            }
+        }
+        return stats;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    std::string Parser::ConvUByteToHexStr(ubyte byte)
+    {
+        return std::string(k_ubyte_hex_str[byte],2);
+    }
+
+    char const * Parser::ConvUByteToHexStr(ubyte byte, char * str)
+    {
+        str[0] = k_ubyte_hex_str[byte][0];
+        str[1] = k_ubyte_hex_str[byte][1];
+        return str;
+    }
+
+    ubyte Parser::ConvHexStrToUByte(std::string const &str)
+    {
+        return ConvHexStrToUByte(str.data(),str.size());
+    }
+
+    ubyte Parser::ConvHexStrToUByte(char const * str, size_t length)
+    {
+        if(length != 2)   {
+            throw InvalidHexStr();
+        }
+
+        s8 const hi = k_hex_digit_value[u8(str[0])];
+        s8 const lo = k_hex_digit_value[u8(str[1])];
+        if(hi < 0 || lo < 0)   {
             throw InvalidHexStr();
         }
 
-        return it->second;
+        return ubyte((hi << 4) | lo);
     }
 
     // ============================================================= //
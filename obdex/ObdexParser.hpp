@@ -17,15 +17,17 @@
 #ifndef OBDEX_PARSER_HPP
 #define OBDEX_PARSER_HPP
 
-// pugixml
-#include <obdex/pugixml/pugixml.hpp>
-
-// duktape
-#include <obdex/duktape/duktape.h>
-
 // obdex
 #include <obdex/ObdexDataTypes.hpp>
-
+#include <obdex/ObdexDefinitions.hpp>
+#include <obdex/ObdexCatalog.hpp>
+#include <obdex/ObdexBusModel.hpp>
+#include <obdex/ObdexStats.hpp>
+#include <obdex/ObdexParseCache.hpp>
+#include <obdex/ObdexLookupTable.hpp>
+#include <obdex/ObdexScriptEngine.hpp>
+
+#include <memory>
 #include <unordered_map>
 
 namespace obdex
@@ -33,16 +35,80 @@ namespace obdex
     class Parser
     {
     public:
+        // throws XMLParsingFailed
         Parser(std::string const &file_path);
 
         ~Parser();
 
+        // Parsers can be moved but not copied (see Clone);
+        // a moved from Parser can only be destroyed or
+        // assigned to
+        Parser(Parser &&other);
+        Parser & operator = (Parser &&other);
+
+        Parser(Parser const &) = delete;
+        Parser & operator = (Parser const &) = delete;
+
+        // Clone
+        // * returns a Parser for the same definitions file
+        //   without reading it again; the definitions are
+        //   shared with the clone, which is safe since
+        //   they're never modified
+        // * the clone has new script engines (see
+        //   ScriptEngine::Clone) with the same settings,
+        //   the same engine selection, budget and heap
+        //   limit, and copies of the lookup tables
+        // * stats, reject counters and the parse cache's
+        //   contents aren't copied
+        Parser Clone() const;
+
         // BuildParameterFrame
         // * uses the definitions file to build
         //   up request message data for the spec,
         //   protocol and param defined in msgFrame
         void BuildParameterFrame(ParameterFrame& param_frame) const;
 
+        // BuildParameterFrame
+        // * builds the parameter @param_id instead of looking
+        //   up the spec, protocol, address and name strings
+        //   in param_frame, which are left as they are
+        // * throws InvalidParamId, BuildParamFrameFailed
+        void BuildParameterFrame(ParamId param_id,
+                                 ParameterFrame &param_frame) const;
+
+
+        // GetParamId
+        // * returns the handle for a parameter, or
+        //   k_invalid_param_id if there isn't one
+        // * ids are assigned when the definitions file is
+        //   loaded: they go from zero to GetParamIdCount()-1
+        //   and are the same for clones of a Parser
+        // * frames built from either the handle or the
+        //   strings have param_frame.param_id set, and
+        //   so does the Data parsed from them
+        ParamId GetParamId(std::string const &spec,
+                           std::string const &protocol,
+                           std::string const &address,
+                           std::string const &param_name) const;
+
+        // GetParamIds
+        // * returns the handles of the parameters that
+        //   GetParameterNames lists, in the same order
+        std::vector<ParamId>
+        GetParamIds(std::string const &spec,
+                    std::string const &protocol,
+                    std::string const &address) const;
+
+        size_t GetParamIdCount() const;
+
+        // GetParam[...]
+        // * the strings @param_id was resolved from
+        // * throws InvalidParamId
+        std::string const & GetParamSpec(ParamId param_id) const;
+        std::string const & GetParamProtocol(ParamId param_id) const;
+        std::string const & GetParamAddress(ParamId param_id) const;
+        std::string const & GetParamName(ParamId param_id) const;
+
 
         // ParseParameterFrame
         // * parses vehicle response data defined
@@ -53,6 +119,28 @@ namespace obdex
                 std::vector<Data> &listDataResults);
 
 
+        // CleanParameterFrame
+        // * checks the raw frames in each MessageData
+        //   against the expected header and prefix and
+        //   merges multi-frame messages, saving the result
+        //   in list_headers and list_data
+        // * ParseParameterFrame calls this before parsing;
+        //   it only needs to be called separately when the
+        //   cleaned data is shared or split up before it
+        //   is parsed
+        void CleanParameterFrame(ParameterFrame &msgFrame);
+
+
+        // ParseCleanedParameterFrame
+        // * parses data already saved in list_headers and
+        //   list_data of each MessageData in msgFrame (ie.
+        //   by CleanParameterFrame) and saves it in
+        //   listDataResults
+        void ParseCleanedParameterFrame(
+                ParameterFrame const &msgFrame,
+                std::vector<Data> &listDataResults);
+
+
         // GetParameterNames
         // * returns a list of parameter names from
         //   the definitions file based on input args
@@ -62,32 +150,329 @@ namespace obdex
                           std::string const &addressName) const;
 
 
+        // GetCatalog
+        // * returns every spec, protocol, address and
+        //   parameter in the definitions file with what
+        //   BuildParameterFrame would use to build them
+        //   (see ObdexCatalog.hpp)
+        // * doesn't build any frames, so it's much faster
+        //   than building every parameter to find out
+        Catalog GetCatalog() const;
+
+
+        // GetBusTiming
+        // * returns the bus timing for a protocol using its
+        //   baudrate and optional timing tags in the
+        //   definitions file; anything not specified there
+        //   uses the defaults from GetDefaultBusTiming
+        // * the fastest baudrate listed for the protocol is
+        //   used for estimates (the best a vehicle could do);
+        //   all of them are saved in BusTiming.list_baudrates
+        BusTiming GetBusTiming(std::string const &specName,
+                               std::string const &protocolName) const;
+
+
+        // GetParseStats
+        // * returns the calls, failures and per-stage latency
+        //   histograms recorded by ParseParameterFrame,
+        //   CleanParameterFrame and ParseCleanedParameterFrame
+        //   since the Parser was created or last reset
+        // * stats are only recorded if the library was built
+        //   with OBDEX_ENABLE_STATS (see StatsEnabled)
+        // * may be called from any thread
+        ParseStatsSnapshot GetParseStats() const;
+
+        // ResetParseStats
+        // * clears all recorded parse stats
+        void ResetParseStats();
+
+        // StatsEnabled
+        // * returns true if the library was built with
+        //   OBDEX_ENABLE_STATS
+        static bool StatsEnabled();
+
+
+        // GetRejectedFrameCounts
+        // * returns the number of raw frames dropped while
+        //   cleaning responses for each RejectReason (ie.
+        //   frames from other nodes or corrupted frames)
+        // * counts are always kept and may be read from
+        //   any thread
+        std::array<u64,REJECT_REASON_COUNT> GetRejectedFrameCounts() const;
+
+        u64 GetRejectedFrameCount(RejectReason reason) const;
+
+        void ResetRejectedFrameCounts();
+
+        // SetRejectWarningInterval
+        // * rejected frames are logged as a warning at most
+        //   once per @interval for each RejectReason, with
+        //   the number of rejects since the last warning
+        // * defaults to one second; zero logs every reject
+        //   and a negative interval disables the warnings
+        void SetRejectWarningInterval(Milliseconds interval);
+
+
+        // SetParseCacheCapacity
+        // * caches up to @capacity parsed Data so that responses
+        //   with the same cleaned header and data bytes as an
+        //   earlier response for the same parse function are
+        //   not run through the parse script again
+        // * only use the cache if parse scripts don't keep any
+        //   state between calls; their results must only
+        //   depend on the response bytes
+        // * the cache is disabled (capacity zero) by default;
+        //   setting the capacity to zero clears it
+        void SetParseCacheCapacity(size_t capacity);
+
+        // GetParseCacheStats
+        // * returns the cache hits, misses and evictions since
+        //   the Parser was created or ResetParseCacheStats
+        //   was called
+        // * may be called from any thread
+        ParseCacheStats GetParseCacheStats() const;
+
+        void ResetParseCacheStats();
+
+        // ClearParseCache
+        // * removes all cached Data, ie. if parse scripts
+        //   depend on something that changed
+        void ClearParseCache();
+
+
+        // SetLookupTableMaxDomain
+        // * scripts whose results only depend on the data
+        //   bytes they read (ie. BYTE(0)*0.5) are found when
+        //   the definitions file is loaded; for those reading
+        //   few enough bytes that they have at most
+        //   @max_domain possible inputs, results are saved in
+        //   a lookup table and parsing becomes a table lookup
+        // * each input is evaluated the first time it's seen;
+        //   PrecomputeLookupTables evaluates all of them
+        // * disabled (zero) by default; 65536 covers scripts
+        //   that read up to two bytes
+        void SetLookupTableMaxDomain(size_t max_domain);
+
+        // PrecomputeLookupTables
+        // * evaluates every input of every lookup table
+        //   (see SetLookupTableMaxDomain) so that parsing
+        //   never runs those scripts
+        void PrecomputeLookupTables();
+
+        // GetLookupTableStats
+        // * must be called from the thread that parses
+        LookupTableStats GetLookupTableStats() const;
+
+
+        // AddScriptEngine
+        // * compiles every parse function with @engine and
+        //   makes it available to SetScriptEngine; an engine
+        //   with the same name as an existing one replaces it
+        // * the "duktape" and "native" engines are added when
+        //   the Parser is created (see ObdexScriptEngine.hpp)
+        void AddScriptEngine(std::unique_ptr<ScriptEngine> engine);
+
+        // SetScriptEngine
+        // * runs every parameter with the engine @engine_name
+        // * scripts the engine can't run use "duktape" instead
+        // * "duktape" is used by default
+        // * throws InvalidScriptEngine if there's no engine
+        //   named @engine_name
+        void SetScriptEngine(std::string const &engine_name);
+
+        // SetParameterScriptEngine
+        // * runs the scripts for a single parameter with the
+        //   engine @engine_name, ie. to benchmark engines
+        //   against each other
+        // * throws InvalidScriptEngine if there's no engine
+        //   named @engine_name or no matching parameter
+        void SetParameterScriptEngine(std::string const &spec,
+                                      std::string const &address,
+                                      std::string const &param_name,
+                                      std::string const &engine_name);
+
+        // GetCompiledScriptCount
+        // * returns the number of parse functions the engine
+        //   @engine_name can run
+        // * throws InvalidScriptEngine if there's no engine
+        //   named @engine_name
+        size_t GetCompiledScriptCount(std::string const &engine_name) const;
+
+        // SetScriptBudget
+        // * limits every run of a parse script to @budget;
+        //   parsing a script that goes over it throws
+        //   ScriptBudgetExceeded (see ObdexScriptBudget.hpp)
+        // * scripts are compiled again when the budget is
+        //   set or removed, which is slow; scripts run a
+        //   little slower while a budget is set
+        void SetScriptBudget(ScriptBudget const &budget);
+
+        ScriptBudget GetScriptBudget() const;
+
+        // GetScriptBudgetStats
+        // * how close each parse function came to the budget,
+        //   for functions that ran while it was set
+        std::vector<ScriptBudgetStats> GetScriptBudgetStats() const;
+
+        void ResetScriptBudgetStats();
+
+        // SetScriptHeapLimit
+        // * limits the memory each script engine's scripts
+        //   can use to @max_bytes; parsing a script that
+        //   fails because of it throws ScriptHeapLimitExceeded
+        // * the limit includes the compiled scripts, so it
+        //   should be set well above GetScriptHeapStats().live_bytes
+        // * zero removes the limit
+        void SetScriptHeapLimit(size_t max_bytes);
+
+        // GetScriptHeapStats
+        // * the memory used by the script engines' heaps,
+        //   added together (see ObdexScriptHeap.hpp)
+        ScriptHeapStats GetScriptHeapStats() const;
+
+
         // helpers to convert bytes into strings and vice versa
-        std::string ConvUByteToHexStr(ubyte byte) const;
-        ubyte ConvHexStrToUByte(std::string const &str) const;
+        // * hex strings are two digits; ConvUByteToHexStr
+        //   writes uppercase digits and ConvHexStrToUByte
+        //   accepts either case
+        // * the char overloads don't allocate: @str must have
+        //   room for two chars (no null is written) and
+        //   the result is @str
+        // * ConvHexStrToUByte throws InvalidHexStr
+        static std::string ConvUByteToHexStr(ubyte byte);
+        static char const * ConvUByteToHexStr(ubyte byte, char * str);
+        static ubyte ConvHexStrToUByte(std::string const &str);
+        static ubyte ConvHexStrToUByte(char const * str, size_t length);
 
     private:
+        // LookupTableInfo
+        // * which data bytes a script's lookup table is
+        //   indexed by, if it can have one
+        // * domain_size is a u64 so that four bytes (2^32
+        //   entries) don't overflow a 32-bit size_t; it's
+        //   compared against m_lookup_table_max_domain
+        //   before a table is ever allocated
+        struct LookupTableInfo
+        {
+            LookupTableInfo() :
+                eligible(false),
+                exp_data_length(-1),
+                domain_size(0)
+            {}
+
+            bool eligible;
+            std::vector<uint> list_byte_positions;
+            sint exp_data_length;
+            u64 domain_size;
+        };
+
+        Parser(std::string const &file_path,
+               std::shared_ptr<Definitions const> definitions);
+
         void jsInit();
 
+        // findParamRef
+        // * finds the first parameter named @param_name for
+        //   @spec, @protocol and @address
+        // * returns false with a description of the first
+        //   name that wasn't found in @error
+        bool findParamRef(std::string const &spec,
+                          std::string const &protocol,
+                          std::string const &address,
+                          std::string const &param_name,
+                          DefinitionParamRef &ref,
+                          std::string &error) const;
+
+        // getParamId
+        // * returns the id of @ref, which must be in
+        //   list_param_refs
+        ParamId getParamId(DefinitionParamRef const &ref) const;
+
+        // getParamRef
+        // * throws InvalidParamId
+        DefinitionParamRef const & getParamRef(ParamId param_id) const;
+
+        // getFrameProtocol
+        // * the protocol name of @frame, from its
+        //   param_id if it has one
+        std::string const & getFrameProtocol(ParameterFrame const &frame) const;
+
+        // setProtocolOptions
+        // * sets parse_protocol and the protocol options in
+        //   @param_frame for @protocol
+        // * returns false if the protocol isn't supported
+        static bool setProtocolOptions(
+                ParameterFrame &param_frame,
+                DefinitionProtocol const &protocol);
+
+        // buildFrame
+        // * builds @param_frame for @param requested from
+        //   @address with @protocol
+        // * throws BuildParamFrameFailed
+        void buildFrame(ParameterFrame &param_frame,
+                        DefinitionProtocol const &protocol,
+                        DefinitionAddress const &address,
+                        DefinitionParameter const &param) const;
+
         void buildHeader_Legacy(
                 ParameterFrame &param_frame,
-                pugi::xml_node xn_address) const;
+                DefinitionAddress const &address) const;
 
         void buildHeader_ISO_14230(
                 ParameterFrame &param_frame,
-                pugi::xml_node xn_address) const;
+                DefinitionAddress const &address) const;
 
         void buildHeader_ISO_15765(
                 ParameterFrame &param_frame,
-                pugi::xml_node xn_address) const;
+                DefinitionAddress const &address) const;
 
         void buildData(
                 ParameterFrame & param_frame,
-                pugi::xml_node xn_parameter) const;
+                DefinitionParameter const &param) const;
+
+        // buildRequests
+        // * reads the requests of @param into the last
+        //   MessageData in @param_frame and new ones after
+        //   it, before they're split into frames
+        // * returns false for passive parameters
+        static bool buildRequests(
+                ParameterFrame & param_frame,
+                DefinitionParameter const &param);
+
+        // getResponderCount
+        // * returns the number of nodes expected to reply
+        //   to requests made with @address, or -1 if the
+        //   request may be answered by any number of nodes
+        sint getResponderCount(
+                ParameterFrame const &param_frame,
+                DefinitionAddress const &address) const;
+
+        // getParseFunction
+        // * returns the parse function @param uses for
+        //   @protocol, or -1 if it doesn't have a script
+        // * throws BuildParamFrameFailed if none of its
+        //   scripts are for @protocol
+        sint getParseFunction(
+                DefinitionParameter const &param,
+                std::string const &protocol) const;
+
+        // findParseFunction
+        // * returns the parse function @param uses for
+        //   @protocol, or -1 if there isn't one
+        static sint findParseFunction(
+                DefinitionParameter const &param,
+                std::string const &protocol);
+
+        // buildExpResponseCount
+        // * sets MessageData.exp_response_count using the
+        //   expected data length of each response
+        void buildExpResponseCount(
+                ParameterFrame &param_frame,
+                sint const responder_count) const;
 
         // parseResponse
         // * passes data processed by cleanRawData[] to
-        //   the javascript engine and uses the script
+        //   the script engine and uses the script
         //   defined in the definitions file to convert
         //   response data into meaningful values, which
         //   is saved in listData
@@ -101,11 +486,76 @@ namespace obdex
         void parseResponse(ParameterFrame const &msg_frame,
                            std::vector<Data> &list_data);
 
-        // saveNumAndLitData
-        // * helper function that saves the numerical
-        //   and literal data interpreted with the
-        //   vehicle response from the js context
-        void saveNumAndLitData(Data &myData);
+        // parseDataBytes
+        // * runs parse function @js_f_idx on a single
+        //   response's @data_bytes and saves the results
+        //   in @parsed_data
+        // * if @catch_errors is set, script errors return
+        //   false instead of reaching the js fatal handler
+        bool parseDataBytes(int js_f_idx,
+                            ByteList const &data_bytes,
+                            Data &parsed_data,
+                            bool catch_errors);
+
+        // runScript
+        // * runs parse function @js_f_idx on @input with its
+        //   selected engine, falling back to duktape if that
+        //   engine can't run it, and adds the results to
+        //   @parsed_data
+        // * if @catch_errors is set, script errors and results
+        //   that can't be extracted return false
+        template<typename Input>
+        bool runScript(int js_f_idx,
+                       Input const &input,
+                       Data &parsed_data,
+                       bool catch_errors);
+
+        template<typename Input>
+        bool runEngine(ScriptEngine &engine,
+                       int js_f_idx,
+                       Input const &input,
+                       Data &parsed_data,
+                       bool catch_errors);
+
+        // runEngineWithBudget
+        // * runs parse function @js_f_idx with @engine and
+        //   records its budget stats
+        // * throws ScriptBudgetExceeded
+        bool runEngineWithBudget(ScriptEngine &engine,
+                                 int js_f_idx,
+                                 bool catch_errors);
+
+        // compileScripts
+        // * compiles every parse function with @engine
+        std::vector<bool> compileScripts(ScriptEngine &engine) const;
+
+        // getScriptEngineIndex
+        // * throws InvalidScriptEngine if there's no engine
+        //   named @engine_name
+        size_t getScriptEngineIndex(std::string const &engine_name) const;
+
+        // setDataNames
+        // * sets the param_id and names of @parsed_data
+        //   from @msg_frame; also used for cached Data,
+        //   which may be from a frame for another protocol
+        void setDataNames(ParameterFrame const &msg_frame,
+                          Data &parsed_data) const;
+
+        // saveSourceAddress
+        // * adds the "Source Address" LiteralData with
+        //   @header_bytes to @parsed_data
+        void saveSourceAddress(ByteList const &header_bytes,
+                               Data &parsed_data) const;
+
+        // getLookupTable
+        // * returns the lookup table for @js_f_idx, creating
+        //   it if needed, or nullptr if it doesn't have one
+        ParseLookupTable * getLookupTable(int js_f_idx);
+
+        // buildLookupTableInfo
+        // * checks if @script can use a lookup table
+        LookupTableInfo buildLookupTableInfo(std::string const &script,
+                                             DefinitionParameter const &param) const;
 
         // cleanFrames_[...]
         // * cleans up rawDataFrames by checking for
@@ -127,6 +577,16 @@ namespace obdex
         void cleanFrames_ISO_15765(MessageData &msg,
                                    int const headerLength);
 
+        // rejectFrame
+        // * counts a frame dropped while cleaning and logs
+        //   @desc, rate limited by SetRejectWarningInterval
+        void rejectFrame(RejectReason reason, char const * desc);
+
+        // countRejectedFrame
+        // * counts a rejected frame without a warning, for
+        //   cleaners that throw instead
+        void countRejectedFrame(RejectReason reason);
+
         // checkHeaderBytes
         // * checks bytes against expected bytes with a mask
         // * returns false if the masked values do not match
@@ -144,26 +604,49 @@ namespace obdex
 
 
 
-        std::vector<std::string> m_lkup_ubyte_hex_str;
-        std::unordered_map<std::string,u8> m_lkup_hex_str_ubyte;
 
+        // definitions file
+        // * m_definitions->list_function_key and list_script
+        //   are the parse function registry
+        // * shared with clones
+        std::string m_xml_file_path;
+        std::shared_ptr<Definitions const> m_definitions;
+
+        // script engines
+        // * m_list_script_engines[0] is always duktape
+        // * m_list_engine_compiled[engine][js_f_idx] is set
+        //   if the engine compiled that parse function
+        // * m_js_list_engine_idx is the engine selected for
+        //   each parse function
+        std::vector<std::unique_ptr<ScriptEngine>> m_list_script_engines;
+        std::vector<std::vector<bool>> m_list_engine_compiled;
+        std::vector<size_t> m_js_list_engine_idx;
+
+        // script budget
+        ScriptBudget m_script_budget;
+        std::vector<ScriptBudgetStats> m_js_list_budget_stats;
+        size_t m_script_heap_limit;
+
+        // parse stats
+        // * these and the parse cache are held by pointer
+        //   so that the Parser can be moved
+        // * m_stats only exists with OBDEX_ENABLE_STATS
+#ifdef OBDEX_ENABLE_STATS
+        std::unique_ptr<ParseStatsRecorder> m_stats;
+#endif
+        std::unique_ptr<FrameRejectCounters> m_reject_counters;
 
-        // pugixml vars
-        std::string const m_xml_file_path;
-        pugi::xml_document m_xml_doc;
+        // parse cache
+        std::unique_ptr<ParseCache> m_parse_cache;
+        ByteList m_parse_cache_key;
 
-        // duktape
-        duk_context * m_js_ctx;
-        u32 m_js_idx_global_object;
-        u32 m_js_idx_f_add_databytes;
-        u32 m_js_idx_f_add_msg_data;
-        u32 m_js_idx_f_clear_data;
-        u32 m_js_idx_f_get_lit_data;
-        u32 m_js_idx_f_get_num_data;
+        // lookup tables
+        std::vector<LookupTableInfo> m_js_list_lookup_info;
+        std::vector<std::unique_ptr<ParseLookupTable>> m_list_lookup_tables;
+        size_t m_lookup_table_max_domain;
+        u64 m_lookup_hits;
+        u64 m_lookup_misses;
 
-        // duktape javascript parse function registry
-        std::vector<std::string> m_js_list_function_key;
-        std::vector<u32> m_js_list_function_idx;
     };
 }
 
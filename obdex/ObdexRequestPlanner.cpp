@@ -0,0 +1,464 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexRequestPlanner.hpp>
+#include <obdex/ObdexParser.hpp>
+#include <obdex/ObdexErrors.hpp>
+#include <obdex/ObdexUtil.hpp>
+
+#include <algorithm>
+
+namespace obdex
+{
+    namespace
+    {
+        // ============================================================= //
+        // ============================================================= //
+
+        // getMultiPidCandidate
+        // * returns true and saves the PID if @param_frame
+        //   is a mode 0x01 request that can be merged with
+        //   other mode 0x01 requests
+        bool getMultiPidCandidate(ParameterFrame const &param_frame,
+                                  ubyte &pid)
+        {
+            if(param_frame.parse_protocol != PROTOCOL_ISO_15765 ||
+               param_frame.list_message_data.size() != 1)   {
+                return false;
+            }
+
+            MessageData const &msg = param_frame.list_message_data[0];
+            if(msg.list_req_data_bytes.size() != 1 ||
+               msg.exp_data_byte_count < 0)   {
+                return false;
+            }
+
+            // skip the pci byte
+            ByteList const &req_data_bytes = msg.list_req_data_bytes[0];
+            uint const offset = (param_frame.iso15765_add_pci_byte) ? 1 : 0;
+            if(req_data_bytes.size() != offset+2)   {
+                return false;
+            }
+
+            if(req_data_bytes[offset] != 0x01)   {
+                return false;
+            }
+            pid = req_data_bytes[offset+1];
+
+            if(msg.exp_data_prefix.size() != 2 ||
+               msg.exp_data_prefix[0] != 0x41 ||
+               msg.exp_data_prefix[1] != pid)   {
+                return false;
+            }
+
+            return true;
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        // isSameMultiPidGroup
+        // * returns true if the requests in both frames go
+        //   to the same address and expect the same response
+        //   header so they can be merged into one request
+        bool isSameMultiPidGroup(ParameterFrame const &a,
+                                 ParameterFrame const &b)
+        {
+            MessageData const &msg_a = a.list_message_data[0];
+            MessageData const &msg_b = b.list_message_data[0];
+
+            return
+                    (a.iso15765_add_pci_byte == b.iso15765_add_pci_byte) &&
+                    (a.iso15765_extended_id == b.iso15765_extended_id) &&
+                    (msg_a.req_header_bytes == msg_b.req_header_bytes) &&
+                    (msg_a.exp_header_bytes == msg_b.exp_header_bytes) &&
+                    (msg_a.exp_header_mask == msg_b.exp_header_mask);
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        bool isSupportedPidsPid(ubyte const pid)
+        {
+            return ((pid % 0x20) == 0);
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        // buildMultiPidRequest
+        // * replaces the request in @group.request_frame
+        //   with one for all the unique PIDs in @list_pids
+        void buildMultiPidRequest(RequestGroup &group,
+                                  ByteList const &list_pids,
+                                  sint const exp_data_byte_count)
+        {
+            MessageData &msg = group.request_frame.list_message_data[0];
+
+            ByteList req_data_bytes;
+            req_data_bytes.push_back(0x01);
+            req_data_bytes.insert(req_data_bytes.end(),
+                                  list_pids.begin(),
+                                  list_pids.end());
+
+            // at most seven bytes, so it's always a single frame
+            if(group.request_frame.iso15765_add_pci_byte)   {
+                PushFront(req_data_bytes,ubyte(req_data_bytes.size()));
+            }
+
+            msg.list_req_data_bytes.clear();
+            msg.list_req_data_bytes.push_back(req_data_bytes);
+
+            // each responder may omit the PIDs it doesn't
+            // support, so only the mode is checked when
+            // cleaning and the response length is the
+            // maximum possible length
+            msg.exp_data_prefix = ByteList{0x41};
+            msg.exp_data_byte_count = exp_data_byte_count;
+            msg.exp_response_count = -1;
+
+            group.request_frame.name.clear();
+            group.request_frame.function_key_idx = -1;
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        // isSameRequest
+        // * returns true if both frames send the same
+        //   requests and clean responses the same way
+        bool isSameRequest(ParameterFrame const &a,
+                           ParameterFrame const &b)
+        {
+            if((a.parse_protocol != b.parse_protocol) ||
+               (a.iso15765_extended_id != b.iso15765_extended_id) ||
+               (a.list_message_data.size() != b.list_message_data.size()))   {
+                return false;
+            }
+
+            for(uint i=0; i < a.list_message_data.size(); i++)   {
+                MessageData const &msg_a = a.list_message_data[i];
+                MessageData const &msg_b = b.list_message_data[i];
+
+                if((msg_a.req_header_bytes != msg_b.req_header_bytes) ||
+                   (msg_a.list_req_data_bytes != msg_b.list_req_data_bytes) ||
+                   (msg_a.exp_header_bytes != msg_b.exp_header_bytes) ||
+                   (msg_a.exp_header_mask != msg_b.exp_header_mask) ||
+                   (msg_a.exp_data_prefix != msg_b.exp_data_prefix))   {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        void copyCleanedData(MessageData const &src,
+                             MessageData &dst)
+        {
+            dst.list_headers = src.list_headers;
+            dst.list_data = src.list_data;
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        void splitMultiPidResponse(RequestGroup const &group,
+                                   std::vector<ParameterFrame> &list_param_frames)
+        {
+            MessageData const &msg = group.request_frame.list_message_data[0];
+
+            for(auto param_idx : group.list_param_idx)   {
+                MessageData &param_msg =
+                        list_param_frames[param_idx].list_message_data[0];
+                param_msg.list_headers.clear();
+                param_msg.list_data.clear();
+            }
+
+            // each responder's data looks like
+            // [pid] [data] [pid] [data] ...
+            for(uint j=0; j < msg.list_data.size(); j++)
+            {
+                ByteList const &header_bytes = msg.list_headers[j];
+                ByteList const &data_bytes = msg.list_data[j];
+
+                uint k=0;
+                while(k < data_bytes.size())
+                {
+                    ubyte const pid = data_bytes[k];
+
+                    // find the length of this pid's data
+                    sint data_length = -1;
+                    for(auto param_idx : group.list_param_idx)   {
+                        MessageData const &param_msg =
+                                list_param_frames[param_idx].list_message_data[0];
+                        if(param_msg.exp_data_prefix[1] == pid)   {
+                            data_length = param_msg.exp_data_byte_count;
+                            break;
+                        }
+                    }
+
+                    // ISO 15765 padding is removed when cleaning,
+                    // but other protocols may still have bytes
+                    // after the last pid; anything that isn't a
+                    // requested pid ends the response
+                    if(data_length < 0)   {
+                        break;
+                    }
+
+                    if(k+1+data_length > data_bytes.size())   {
+                        OBDEX_LOG_WARN(obdexlog) << "Multi-PID response, "
+                                                    "truncated data for pid "
+                                                 << uint(pid);
+                        break;
+                    }
+
+                    auto it_begin = std::next(data_bytes.begin(),k+1);
+                    auto it_end = std::next(it_begin,data_length);
+
+                    for(auto param_idx : group.list_param_idx)   {
+                        MessageData &param_msg =
+                                list_param_frames[param_idx].list_message_data[0];
+                        if(param_msg.exp_data_prefix[1] == pid)   {
+                            param_msg.list_headers.push_back(header_bytes);
+                            param_msg.list_data.push_back(ByteList(it_begin,it_end));
+                        }
+                    }
+
+                    k += 1+data_length;
+                }
+            }
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    std::vector<RequestGroup>
+    PlanMultiPidRequests(std::vector<ParameterFrame> const &list_param_frames,
+                         uint const max_pids_per_req)
+    {
+        std::vector<RequestGroup> list_groups;
+
+        // pids requested by each group (same order)
+        std::vector<ByteList> list_group_pids;
+        std::vector<sint> list_group_byte_count;
+
+        for(uint i=0; i < list_param_frames.size(); i++)
+        {
+            ParameterFrame const &param_frame = list_param_frames[i];
+
+            ubyte pid;
+            if(max_pids_per_req < 2 ||
+               !getMultiPidCandidate(param_frame,pid))   {
+                RequestGroup group;
+                group.type = REQUEST_SINGLE;
+                group.request_frame = param_frame;
+                group.list_param_idx.push_back(i);
+                list_groups.push_back(group);
+                list_group_pids.push_back(ByteList());
+                list_group_byte_count.push_back(0);
+                continue;
+            }
+
+            sint const data_length =
+                    param_frame.list_message_data[0].exp_data_byte_count;
+
+            // find a group to merge with
+            sint group_idx=-1;
+            for(uint j=0; j < list_groups.size(); j++)
+            {
+                if(list_groups[j].type != REQUEST_MULTI_PID)   {
+                    continue;
+                }
+
+                ByteList const &list_pids = list_group_pids[j];
+                if(isSupportedPidsPid(list_pids[0]) != isSupportedPidsPid(pid) ||
+                   !isSameMultiPidGroup(list_groups[j].request_frame,param_frame))   {
+                    continue;
+                }
+
+                // the same pid can be shared with another
+                // parameter as long as its length is the same
+                bool has_pid = false;
+                bool length_ok = true;
+                for(auto param_idx : list_groups[j].list_param_idx)   {
+                    MessageData const &param_msg =
+                            list_param_frames[param_idx].list_message_data[0];
+                    if(param_msg.exp_data_prefix[1] == pid)   {
+                        has_pid = true;
+                        length_ok = (param_msg.exp_data_byte_count == data_length);
+                        break;
+                    }
+                }
+
+                if(!length_ok)   {
+                    continue;
+                }
+                if(has_pid || list_pids.size() < max_pids_per_req)   {
+                    group_idx = j;
+                    break;
+                }
+            }
+
+            if(group_idx < 0)   {
+                RequestGroup group;
+                group.type = REQUEST_MULTI_PID;
+                group.request_frame = param_frame;
+                list_groups.push_back(group);
+                list_group_pids.push_back(ByteList());
+                list_group_byte_count.push_back(0);
+                group_idx = list_groups.size()-1;
+            }
+
+            RequestGroup &group = list_groups[group_idx];
+            ByteList &list_pids = list_group_pids[group_idx];
+
+            group.list_param_idx.push_back(i);
+            if(std::find(list_pids.begin(),list_pids.end(),pid) == list_pids.end())   {
+                list_pids.push_back(pid);
+                list_group_byte_count[group_idx] += 1+data_length;
+            }
+        }
+
+        // build the merged requests
+        for(uint j=0; j < list_groups.size(); j++)
+        {
+            RequestGroup &group = list_groups[j];
+            if(group.type != REQUEST_MULTI_PID)   {
+                continue;
+            }
+
+            // a lone pid doesn't need to be changed
+            if(list_group_pids[j].size() == 1)   {
+                group.type = REQUEST_SINGLE;
+                continue;
+            }
+
+            buildMultiPidRequest(group,
+                                 list_group_pids[j],
+                                 list_group_byte_count[j]);
+        }
+
+        return list_groups;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    std::vector<RequestGroup>
+    PlanSharedRequests(std::vector<ParameterFrame> const &list_param_frames)
+    {
+        std::vector<RequestGroup> list_groups;
+
+        for(uint i=0; i < list_param_frames.size(); i++)
+        {
+            ParameterFrame const &param_frame = list_param_frames[i];
+
+            bool shared = false;
+            for(auto &group : list_groups)   {
+                if(isSameRequest(group.request_frame,param_frame))   {
+                    group.type = REQUEST_SHARED;
+                    group.list_param_idx.push_back(i);
+                    shared = true;
+                    break;
+                }
+            }
+
+            if(!shared)   {
+                RequestGroup group;
+                group.type = REQUEST_SINGLE;
+                group.request_frame = param_frame;
+                group.list_param_idx.push_back(i);
+                list_groups.push_back(group);
+            }
+        }
+
+        // the request frame no longer belongs to a
+        // single parameter
+        for(auto &group : list_groups)   {
+            if(group.type == REQUEST_SHARED)   {
+                group.request_frame.name.clear();
+                group.request_frame.function_key_idx = -1;
+            }
+        }
+
+        return list_groups;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void ParseRequestGroup(Parser &parser,
+                           RequestGroup &group,
+                           std::vector<ParameterFrame> &list_param_frames,
+                           std::vector<Data> &list_data)
+    {
+        for(auto param_idx : group.list_param_idx)   {
+            if(param_idx >= list_param_frames.size())   {
+                throw ParseParamFrameFailed(
+                            "Request group does not match "
+                            "list of parameter frames");
+            }
+        }
+
+        // clean once for every parameter in the group
+        parser.CleanParameterFrame(group.request_frame);
+
+        if(group.type == REQUEST_MULTI_PID)   {
+            splitMultiPidResponse(group,list_param_frames);
+        }
+        else   {
+            // REQUEST_SINGLE, REQUEST_SHARED
+            // * every parameter gets the same cleaned data
+            std::vector<MessageData> const &list_msg =
+                    group.request_frame.list_message_data;
+
+            for(auto param_idx : group.list_param_idx)   {
+                std::vector<MessageData> &list_param_msg =
+                        list_param_frames[param_idx].list_message_data;
+                for(uint i=0; i < list_param_msg.size(); i++)   {
+                    copyCleanedData(list_msg[i],list_param_msg[i]);
+                }
+            }
+        }
+
+        for(auto param_idx : group.list_param_idx)
+        {
+            ParameterFrame const &param_frame = list_param_frames[param_idx];
+
+            bool has_data = false;
+            for(auto const &msg : param_frame.list_message_data)   {
+                if(!msg.list_data.empty())   {
+                    has_data = true;
+                    break;
+                }
+            }
+
+            if(has_data)   {
+                parser.ParseCleanedParameterFrame(param_frame,list_data);
+            }
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
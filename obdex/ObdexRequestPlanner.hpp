@@ -0,0 +1,113 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_REQUEST_PLANNER_HPP
+#define OBDEX_REQUEST_PLANNER_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    class Parser;
+
+    enum RequestGroupType
+    {
+        // REQUEST_SINGLE
+        // * the group's request is the request of
+        //   its only ParameterFrame
+        REQUEST_SINGLE,
+
+        // REQUEST_MULTI_PID
+        // * SAE J1979 mode 0x01 request for up to six
+        //   PIDs at once (ISO 15765 only); each responder
+        //   replies with [0x41] [pid] [data] [pid] [data] ...
+        //   for the PIDs it supports
+        REQUEST_MULTI_PID,
+
+        // REQUEST_SHARED
+        // * several ParameterFrames with identical requests
+        //   and expected responses that are parsed from
+        //   the same cleaned data
+        REQUEST_SHARED
+    };
+
+    // RequestGroup
+    // * a single request sent to the vehicle on behalf
+    //   of one or more built ParameterFrames
+    struct RequestGroup
+    {
+        RequestGroupType type;
+
+        // The frame that should be used to send the request
+        // * responses received from the vehicle should be
+        //   saved in its list_message_data[N].list_raw_frames
+        //   just like any other ParameterFrame
+        ParameterFrame request_frame;
+
+        // indices of the ParameterFrames served by this
+        // request (in the list that was passed to the planner)
+        std::vector<uint> list_param_idx;
+
+        RequestGroup() :
+            type(REQUEST_SINGLE)
+        {}
+    };
+
+    // PlanMultiPidRequests
+    // * groups SAE J1979 mode 0x01 parameters in
+    //   @list_param_frames into multi-PID requests with
+    //   at most @max_pids_per_req PIDs each (SAE J1979
+    //   allows up to six on ISO 15765)
+    // * a parameter can be merged if it's built for
+    //   ISO 15765, has a single request of [0x01] [pid]
+    //   split into a single frame, expects a response
+    //   prefix of [0x41] [pid] and has a known response
+    //   byte count
+    // * requests for supported PIDs (0x00,0x20,...) are
+    //   only grouped with each other
+    // * every other parameter gets a REQUEST_SINGLE group
+    std::vector<RequestGroup>
+    PlanMultiPidRequests(std::vector<ParameterFrame> const &list_param_frames,
+                         uint const max_pids_per_req=6);
+
+    // PlanSharedRequests
+    // * groups ParameterFrames in @list_param_frames that
+    //   have the same request header and data bytes for
+    //   every MessageData so each distinct request is only
+    //   sent (and its response cleaned) once
+    // * frames are only grouped if they also expect the
+    //   same response header and data prefix, since that
+    //   determines how the response is cleaned
+    // * frames that don't share a request with any other
+    //   frame get a REQUEST_SINGLE group
+    std::vector<RequestGroup>
+    PlanSharedRequests(std::vector<ParameterFrame> const &list_param_frames);
+
+    // ParseRequestGroup
+    // * cleans the responses saved in @group.request_frame
+    //   once, hands each ParameterFrame in @list_param_frames
+    //   its part of the cleaned data and parses it into
+    //   @list_data
+    // * @list_param_frames must be the list used to plan
+    //   the group; ParameterFrames that no responder sent
+    //   data for are skipped
+    void ParseRequestGroup(Parser &parser,
+                           RequestGroup &group,
+                           std::vector<ParameterFrame> &list_param_frames,
+                           std::vector<Data> &list_data);
+}
+
+#endif // OBDEX_REQUEST_PLANNER_HPP
@@ -0,0 +1,151 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexResponseCount.hpp>
+
+#include <algorithm>
+
+namespace obdex
+{
+    // ============================================================= //
+    // ============================================================= //
+
+    void ResponseCountLearner::Learn(ParameterFrame const &param_frame)
+    {
+        for(auto const &msg : param_frame.list_message_data)
+        {
+            if(msg.list_req_data_bytes.empty() ||
+               msg.list_raw_frames.empty())   {
+                continue;
+            }
+
+            // count distinct responders
+            std::vector<ByteList const *> list_responders;
+            for(auto const &header_bytes : msg.list_headers)   {
+                bool seen = false;
+                for(auto responder : list_responders)   {
+                    if(*responder == header_bytes)   {
+                        seen = true;
+                        break;
+                    }
+                }
+                if(!seen)   {
+                    list_responders.push_back(&header_bytes);
+                }
+            }
+
+            ResponseCount &count = m_lkup_req_count[getRequestKey(msg)];
+            count.frames = std::max<uint>(count.frames,msg.list_raw_frames.size());
+            count.responders = std::max<uint>(count.responders,list_responders.size());
+            count.samples++;
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    bool ResponseCountLearner::Apply(ParameterFrame &param_frame) const
+    {
+        bool all_learned = true;
+        for(auto &msg : param_frame.list_message_data)
+        {
+            if(msg.list_req_data_bytes.empty())   {
+                continue;
+            }
+
+            auto it = m_lkup_req_count.find(getRequestKey(msg));
+            if(it == m_lkup_req_count.end())   {
+                all_learned = false;
+                continue;
+            }
+
+            msg.exp_response_count = it->second.frames;
+        }
+
+        return all_learned;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    ResponseCountLearner::ResponseCount
+    ResponseCountLearner::GetResponseCount(MessageData const &msg) const
+    {
+        auto it = m_lkup_req_count.find(getRequestKey(msg));
+        if(it == m_lkup_req_count.end())   {
+            return ResponseCount();
+        }
+
+        return it->second;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void ResponseCountLearner::Clear()
+    {
+        m_lkup_req_count.clear();
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    std::string ResponseCountLearner::getRequestKey(MessageData const &msg)
+    {
+        // [header length] [header] [frame length] [frame] ...
+        // * header and frame lengths never exceed a byte
+        std::string key;
+        key.push_back(char(msg.req_header_bytes.size()));
+        key.append(msg.req_header_bytes.begin(),
+                   msg.req_header_bytes.end());
+
+        for(auto const &req_data_bytes : msg.list_req_data_bytes)   {
+            key.push_back(char(req_data_bytes.size()));
+            key.append(req_data_bytes.begin(),req_data_bytes.end());
+        }
+
+        return key;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    std::string GetELM327RequestData(MessageData const &msg)
+    {
+        static char const hex_digits[] = "0123456789ABCDEF";
+
+        std::string req;
+        if(msg.list_req_data_bytes.empty())   {
+            return req;
+        }
+
+        for(auto byte : msg.list_req_data_bytes[0])   {
+            req.push_back(hex_digits[byte >> 4]);
+            req.push_back(hex_digits[byte & 0x0F]);
+        }
+
+        // the ELM327 accepts a single hex digit
+        if(msg.exp_response_count > 0 &&
+           msg.exp_response_count < 16)   {
+            req.push_back(hex_digits[msg.exp_response_count]);
+        }
+
+        return req;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
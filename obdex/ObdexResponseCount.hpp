@@ -0,0 +1,100 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_RESPONSE_COUNT_HPP
+#define OBDEX_RESPONSE_COUNT_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+#include <unordered_map>
+
+namespace obdex
+{
+    // ResponseCountLearner
+    // * keeps track of how many frames and responders
+    //   answer each request sent to a vehicle
+    // * the definitions file can't say how many ECUs
+    //   will answer a functional request, so the count
+    //   is learned from parsed responses and applied
+    //   to MessageData.exp_response_count when the
+    //   same request is built again
+    // * one instance should be used per vehicle
+    class ResponseCountLearner
+    {
+    public:
+        struct ResponseCount
+        {
+            ResponseCount() :
+                frames(0),
+                responders(0),
+                samples(0)
+            {}
+
+            // the largest number of frames and distinct
+            // response headers seen for the request
+            uint frames;
+            uint responders;
+
+            // number of responses learned from
+            uint samples;
+        };
+
+        // Learn
+        // * records the number of raw frames and the number
+        //   of distinct (cleaned) response headers seen in
+        //   each MessageData of @param_frame
+        // * should be called after the frame has been parsed
+        //   with Parser::ParseParameterFrame; messages without
+        //   a request or without any responses are ignored
+        // * the largest count seen so far is kept, since an
+        //   underestimate would cause an interface to stop
+        //   listening before all responses have arrived
+        void Learn(ParameterFrame const &param_frame);
+
+        // Apply
+        // * sets exp_response_count for each MessageData in
+        //   @param_frame whose request has been learned
+        // * returns true if all requests had a learned count
+        bool Apply(ParameterFrame &param_frame) const;
+
+        // GetResponseCount
+        // * returns the learned count for the request in
+        //   @msg (ResponseCount.samples is 0 if unknown)
+        ResponseCount GetResponseCount(MessageData const &msg) const;
+
+        // Clear
+        // * forgets all learned counts (ie. when connecting
+        //   to a different vehicle)
+        void Clear();
+
+    private:
+        static std::string getRequestKey(MessageData const &msg);
+
+        std::unordered_map<std::string,ResponseCount> m_lkup_req_count;
+    };
+
+    // GetELM327RequestData
+    // * returns the first frame of request data in @msg
+    //   as an ELM327 command, followed by the expected
+    //   response count digit if exp_response_count is
+    //   known and within [1,15], ie. "010C1"
+    // * ISO 15765 requests should be built without PCI
+    //   bytes (ParameterFrame.iso15765_add_pci_byte=false)
+    //   since the adapter adds them itself
+    std::string GetELM327RequestData(MessageData const &msg);
+}
+
+#endif // OBDEX_RESPONSE_COUNT_HPP
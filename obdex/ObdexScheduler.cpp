@@ -0,0 +1,290 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexScheduler.hpp>
+
+namespace obdex
+{
+    namespace
+    {
+        // number of recent polls used to
+        // calculate the achieved rate
+        uint const k_rate_window = 16;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    Scheduler::Scheduler() :
+        m_started(false),
+        m_in_flight(false)
+    {}
+
+    // ============================================================= //
+    // ============================================================= //
+
+    uint Scheduler::AddParameter(ParameterFrame const &param_frame,
+                                 double const rate_hz,
+                                 uint const priority)
+    {
+        Entry entry;
+        for(uint i=0; i < param_frame.list_message_data.size(); i++)   {
+            MessageData const &msg = param_frame.list_message_data[i];
+            if(msg.list_req_data_bytes.empty())   {
+                continue;
+            }
+            entry.list_msg_idx.push_back(i);
+            entry.list_msg_delay.push_back(
+                        std::chrono::duration_cast<Microseconds>(
+                            Milliseconds(msg.req_data_delay_ms)));
+        }
+
+        entry.period = (rate_hz > 0) ?
+                    Microseconds(s64(1000000.0/rate_hz)) :
+                    Microseconds(0);
+
+        entry.priority = priority;
+        entry.seq_idx = 0;
+
+        // parameters added after polling has started
+        // are due right away
+        entry.poll_due = m_last_now;
+        entry.ready = m_last_now;
+        if(!entry.list_msg_delay.empty())   {
+            entry.ready += entry.list_msg_delay[0];
+        }
+
+        m_list_entries.push_back(entry);
+        return m_list_entries.size()-1;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    bool Scheduler::Next(TimePoint const &now,
+                         ScheduledRequest &request)
+    {
+        if(!m_started)   {
+            start(now);
+        }
+        m_last_now = now;
+
+        if(m_in_flight)   {
+            return false;
+        }
+
+        sint best_idx=-1;
+        for(uint i=0; i < m_list_entries.size(); i++)
+        {
+            Entry const &entry = m_list_entries[i];
+            if(entry.list_msg_idx.empty() || entry.ready > now)   {
+                continue;
+            }
+
+            if(best_idx < 0)   {
+                best_idx = i;
+                continue;
+            }
+
+            Entry const &best = m_list_entries[best_idx];
+            if((entry.priority > best.priority) ||
+               (entry.priority == best.priority && entry.ready < best.ready))   {
+                best_idx = i;
+            }
+        }
+
+        if(best_idx < 0)   {
+            return false;
+        }
+
+        Entry const &entry = m_list_entries[best_idx];
+        request.param_idx = best_idx;
+        request.msg_idx = entry.list_msg_idx[entry.seq_idx];
+        request.send_time = now;
+
+        m_in_flight = true;
+        return true;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void Scheduler::OnRequestComplete(ScheduledRequest const &request,
+                                      TimePoint const &now)
+    {
+        m_in_flight = false;
+        m_last_now = now;
+
+        Entry &entry = m_list_entries[request.param_idx];
+        entry.seq_idx++;
+
+        // wait before sending the next request in the sequence
+        if(entry.seq_idx < entry.list_msg_idx.size())   {
+            entry.ready = now + entry.list_msg_delay[entry.seq_idx];
+            return;
+        }
+
+        // the poll is complete
+        entry.list_poll_complete.push_back(now);
+        if(entry.list_poll_complete.size() > k_rate_window)   {
+            entry.list_poll_complete.pop_front();
+        }
+
+        // schedule the next poll; if we've fallen behind by
+        // more than a period, start over from now instead
+        // of sending a burst of requests to catch up
+        entry.seq_idx = 0;
+        entry.poll_due += entry.period;
+        if(entry.poll_due + entry.period < now)   {
+            entry.poll_due = now;
+        }
+        entry.ready = entry.poll_due + entry.list_msg_delay[0];
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    TimePoint Scheduler::GetNextReadyTime() const
+    {
+        TimePoint next_ready = TimePoint::max();
+        for(auto const &entry : m_list_entries)   {
+            if(!entry.list_msg_idx.empty() && entry.ready < next_ready)   {
+                next_ready = entry.ready;
+            }
+        }
+
+        return next_ready;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    double Scheduler::GetAchievedRate(uint const param_idx) const
+    {
+        auto const &list_poll_complete =
+                m_list_entries[param_idx].list_poll_complete;
+
+        if(list_poll_complete.size() < 2)   {
+            return 0;
+        }
+
+        double const span_s =
+                std::chrono::duration_cast<Microseconds>(
+                    list_poll_complete.back()-
+                    list_poll_complete.front()).count()/1000000.0;
+
+        if(span_s <= 0)   {
+            return 0;
+        }
+
+        return (list_poll_complete.size()-1)/span_s;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    std::vector<ScheduledRequest>
+    Scheduler::Plan(Microseconds const duration,
+                    Microseconds const request_time) const
+    {
+        // run a copy of this scheduler from the start
+        // against a simulated clock
+        Scheduler sim(*this);
+        sim.m_started = false;
+        sim.m_in_flight = false;
+        for(auto &entry : sim.m_list_entries)   {
+            entry.seq_idx = 0;
+            entry.list_poll_complete.clear();
+        }
+
+        // every request must take some time or
+        // we'll never get anywhere
+        Microseconds const step =
+                (request_time.count() > 0) ? request_time : Microseconds(1);
+
+        std::vector<ScheduledRequest> list_requests;
+
+        TimePoint t;
+        TimePoint const t_end = t + duration;
+        while(t < t_end)
+        {
+            ScheduledRequest request;
+            if(sim.Next(t,request))   {
+                list_requests.push_back(request);
+                t += step;
+                sim.OnRequestComplete(request,t);
+                continue;
+            }
+
+            TimePoint const next_ready = sim.GetNextReadyTime();
+            if(next_ready == TimePoint::max())   {
+                break;
+            }
+            t = next_ready;
+        }
+
+        return list_requests;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    std::vector<double>
+    Scheduler::GetPlannedRates(Microseconds const duration,
+                               Microseconds const request_time) const
+    {
+        std::vector<double> list_rates(m_list_entries.size(),0.0);
+        if(duration.count() <= 0)   {
+            return list_rates;
+        }
+
+        // a poll is complete once the last
+        // request in its sequence is sent
+        auto const list_requests = Plan(duration,request_time);
+        for(auto const &request : list_requests)   {
+            Entry const &entry = m_list_entries[request.param_idx];
+            if(request.msg_idx == entry.list_msg_idx.back())   {
+                list_rates[request.param_idx] += 1.0;
+            }
+        }
+
+        double const duration_s = duration.count()/1000000.0;
+        for(auto &rate : list_rates)   {
+            rate /= duration_s;
+        }
+
+        return list_rates;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void Scheduler::start(TimePoint const &now)
+    {
+        for(auto &entry : m_list_entries)   {
+            entry.seq_idx = 0;
+            entry.poll_due = now;
+            entry.ready = now;
+            if(!entry.list_msg_delay.empty())   {
+                entry.ready += entry.list_msg_delay[0];
+            }
+        }
+        m_started = true;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
@@ -0,0 +1,146 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_SCHEDULER_HPP
+#define OBDEX_SCHEDULER_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+#include <deque>
+
+namespace obdex
+{
+    // ScheduledRequest
+    // * a single request that should be sent next
+    struct ScheduledRequest
+    {
+        // index of the parameter (in the order it was
+        // added to the Scheduler)
+        uint param_idx;
+
+        // index into the parameter's list_message_data
+        uint msg_idx;
+
+        // time the request was scheduled at
+        TimePoint send_time;
+    };
+
+    // Scheduler
+    // * decides the order in which requests for a set
+    //   of built ParameterFrames are sent to meet a
+    //   target poll rate for each parameter
+    // * only one request is in flight at a time; the
+    //   caller sends the request returned by Next() and
+    //   reports back with OnRequestComplete() once its
+    //   responses have been received
+    // * a parameter with multiple requests must wait
+    //   MessageData.req_data_delay_ms before sending
+    //   the next request in its sequence; requests for
+    //   other parameters are sent in the meantime
+    //   instead of leaving the bus idle
+    // * when more than one request is ready, the one
+    //   with the highest priority is sent first, and
+    //   the one that has been waiting longest breaks
+    //   any ties
+    class Scheduler
+    {
+    public:
+        Scheduler();
+
+        // AddParameter
+        // * adds a parameter to be polled @rate_hz times
+        //   per second (a rate of 0 polls it as often as
+        //   possible) and returns its index
+        // * larger @priority values are served first
+        // * messages without a request are skipped, so
+        //   a passive parameter is never scheduled
+        uint AddParameter(ParameterFrame const &param_frame,
+                          double const rate_hz,
+                          uint const priority=0);
+
+        // Next
+        // * returns true and saves the next request to
+        //   send in @request if one is ready at @now
+        // * returns false if a request is in flight or
+        //   nothing is ready yet; GetNextReadyTime()
+        //   says when to try again
+        bool Next(TimePoint const &now,
+                  ScheduledRequest &request);
+
+        // OnRequestComplete
+        // * marks the in flight @request as done at @now
+        void OnRequestComplete(ScheduledRequest const &request,
+                               TimePoint const &now);
+
+        // GetNextReadyTime
+        // * returns the earliest time a request will be
+        //   ready (TimePoint::max() if there is none)
+        TimePoint GetNextReadyTime() const;
+
+        // GetAchievedRate
+        // * returns the number of complete polls per second
+        //   recently achieved for parameter @param_idx
+        double GetAchievedRate(uint const param_idx) const;
+
+        // Plan
+        // * returns the order requests would be sent in
+        //   over @duration if each request took
+        //   @request_time to complete, without changing
+        //   the state of this Scheduler
+        std::vector<ScheduledRequest>
+        Plan(Microseconds const duration,
+             Microseconds const request_time) const;
+
+        // GetPlannedRates
+        // * returns the polls per second each parameter
+        //   would get under the conditions passed to Plan()
+        std::vector<double>
+        GetPlannedRates(Microseconds const duration,
+                        Microseconds const request_time) const;
+
+    private:
+        struct Entry
+        {
+            // messages that have requests to send
+            std::vector<uint> list_msg_idx;
+            std::vector<Microseconds> list_msg_delay;
+
+            Microseconds period;
+            uint priority;
+
+            // position in list_msg_idx of the next request
+            uint seq_idx;
+
+            // time the current poll was due to start
+            TimePoint poll_due;
+
+            // earliest time the next request can be sent
+            TimePoint ready;
+
+            // completion times of recent polls
+            std::deque<TimePoint> list_poll_complete;
+        };
+
+        void start(TimePoint const &now);
+
+        std::vector<Entry> m_list_entries;
+        TimePoint m_last_now;
+        bool m_started;
+        bool m_in_flight;
+    };
+}
+
+#endif // OBDEX_SCHEDULER_HPP
@@ -0,0 +1,808 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexScriptAnalysis.hpp>
+#include <obdex/ObdexUtil.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+namespace obdex
+{
+    namespace
+    {
+        // longest first so the longest match is taken
+        char const * const k_list_long_punctuators[] = {
+            ">>>=",
+            "===", "!==", ">>>", "<<=", ">>=",
+            "==", "!=", "<=", ">=", "&&", "||", "++", "--",
+            "<<", ">>", "+=", "-=", "*=", "/=", "%=", "&=",
+            "|=", "^="
+        };
+
+        char const * const k_single_punctuators = "{}()[];,<>+-*/%&|^!~?:=.";
+
+        // keywords after which a '/' starts a regular
+        // expression rather than being a division
+        char const * const k_list_regex_keywords[] = {
+            "return", "typeof", "case", "do", "else", "in",
+            "instanceof", "new", "delete", "void", "throw"
+        };
+
+        // names a data only script may use
+        char const * const k_list_allowed_keywords[] = {
+            "var", "if", "else", "for", "while", "do", "break",
+            "continue", "return", "new", "true", "false", "null",
+            "switch", "case", "default", "typeof", "in",
+            "instanceof", "function", "try", "catch", "finally",
+            "throw", "delete", "void", "undefined", "NaN",
+            "Infinity"
+        };
+
+        char const * const k_list_allowed_globals[] = {
+            "NumericalDataObj", "LiteralDataObj",
+            "saveNumericalData", "saveLiteralData",
+            "Math", "Number", "String", "Boolean", "Array",
+            "parseInt", "parseFloat", "isNaN", "isFinite"
+        };
+
+        // keywords that start a statement, which
+        // ends a var statement without a semicolon
+        char const * const k_list_statement_keywords[] = {
+            "var", "if", "for", "while", "do", "return",
+            "switch", "break", "continue", "function", "try",
+            "throw"
+        };
+
+        template<size_t N>
+        bool IsOneOf(std::string const &str, char const * const (&list)[N])
+        {
+            for(size_t i=0; i < N; i++)   {
+                if(str == list[i])   {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool IsIdentifierStart(char c)
+        {
+            return ((c >= 'a' && c <= 'z') ||
+                    (c >= 'A' && c <= 'Z') ||
+                    c == '_' || c == '$');
+        }
+
+        bool IsIdentifierPart(char c)
+        {
+            return (IsIdentifierStart(c) || (c >= '0' && c <= '9'));
+        }
+
+        bool IsDigit(char c)
+        {
+            return (c >= '0' && c <= '9');
+        }
+
+        bool IsHexDigit(char c)
+        {
+            return (IsDigit(c) ||
+                    (c >= 'a' && c <= 'f') ||
+                    (c >= 'A' && c <= 'F'));
+        }
+
+        bool IsRegexAllowed(std::vector<ScriptToken> const &list_tokens)
+        {
+            if(list_tokens.empty())   {
+                return true;
+            }
+
+            ScriptToken const &prev = list_tokens.back();
+            switch(prev.type)
+            {
+                case SCRIPT_TOKEN_NUMBER:
+                case SCRIPT_TOKEN_STRING:
+                    return false;
+                case SCRIPT_TOKEN_IDENTIFIER:
+                    return IsOneOf(prev.text,k_list_regex_keywords);
+                default:
+                    return !(prev.text == ")" ||
+                             prev.text == "]" ||
+                             prev.text == "}");
+            }
+        }
+
+        bool IsPunctuator(std::vector<ScriptToken> const &list_tokens,
+                          size_t idx,
+                          char const * text)
+        {
+            return (idx < list_tokens.size() &&
+                    list_tokens[idx].type == SCRIPT_TOKEN_PUNCTUATOR &&
+                    list_tokens[idx].text == text);
+        }
+
+        bool IsIdentifier(std::vector<ScriptToken> const &list_tokens,
+                          size_t idx)
+        {
+            return (idx < list_tokens.size() &&
+                    list_tokens[idx].type == SCRIPT_TOKEN_IDENTIFIER);
+        }
+
+        // adds the names declared by the var statement
+        // starting at @idx to @set_locals
+        void AddVarNames(std::vector<ScriptToken> const &list_tokens,
+                         size_t idx,
+                         std::set<std::string> &set_locals)
+        {
+            bool expect_name=true;
+            sint depth=0;
+            for(size_t i=idx+1; i < list_tokens.size(); i++)
+            {
+                ScriptToken const &token = list_tokens[i];
+                if(token.type == SCRIPT_TOKEN_IDENTIFIER)   {
+                    if(expect_name)   {
+                        set_locals.insert(token.text);
+                        expect_name = false;
+                        continue;
+                    }
+                    if(depth == 0 &&
+                       (token.text == "in" ||
+                        IsOneOf(token.text,k_list_statement_keywords)))   {
+                        return;
+                    }
+                }
+                else if(token.type == SCRIPT_TOKEN_PUNCTUATOR)   {
+                    std::string const &p = token.text;
+                    if(p == "(" || p == "[" || p == "{")   {
+                        depth++;
+                    }
+                    else if(p == ")" || p == "]" || p == "}")   {
+                        depth--;
+                        if(depth < 0)   {
+                            return;
+                        }
+                    }
+                    else if(depth == 0 && p == ";")   {
+                        return;
+                    }
+                    else if(depth == 0 && p == ",")   {
+                        expect_name = true;
+                    }
+                }
+            }
+        }
+
+        // adds the name and parameters of the function
+        // declared at @idx to @set_locals
+        void AddFunctionNames(std::vector<ScriptToken> const &list_tokens,
+                              size_t idx,
+                              std::set<std::string> &set_locals)
+        {
+            size_t i=idx+1;
+            if(IsIdentifier(list_tokens,i))   {
+                set_locals.insert(list_tokens[i].text);
+                i++;
+            }
+            if(!IsPunctuator(list_tokens,i,"("))   {
+                return;
+            }
+            for(i++; i < list_tokens.size(); i++)   {
+                if(IsIdentifier(list_tokens,i))   {
+                    set_locals.insert(list_tokens[i].text);
+                }
+                else if(!IsPunctuator(list_tokens,i,","))   {
+                    return;
+                }
+            }
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    namespace
+    {
+        // helpers that RewriteScriptHelpers replaces, the
+        // number of arguments they take and the js for a
+        // call (arguments are $0 and $1)
+        struct HelperRewrite
+        {
+            char const * name;
+            size_t arg_count;
+            char const * replacement;
+        };
+
+        HelperRewrite const k_list_helper_rewrites[] = {
+            { "BYTE",     1, "__obdex_bytes[($0)]" },
+            { "BIT",      2, "((__obdex_bytes[($0)] & (1 << ($1))) > 0 ? 1 : 0)" },
+            { "LENGTH",   0, "__obdex_bytes.length" },
+            { "DATA",     1, "__obdex_reqs[0].listDataBytes[($0)]" },
+            { "HEADER",   1, "__obdex_reqs[0].listHeaderBytes[($0)]" },
+            { "REQ",      1, "__obdex_reqs[($0)]" },
+            { "NUM_REQ",  0, "__obdex_reqs.length" },
+            { "NUM_RESP", 1, "__obdex_reqs[($0)].listDataBytes.length" }
+        };
+
+        // binds the response data; __obdex_bytes is left
+        // undefined if there's no data so that reading
+        // it throws like DATA(0).BYTE(N) would
+        char const * const k_helper_rewrite_prologue =
+                "var __obdex_reqs = global_param.listMessageData; "
+                "var __obdex_bytes = (__obdex_reqs[0] && __obdex_reqs[0].listDataBytes[0]) ? "
+                "__obdex_reqs[0].listDataBytes[0].bytes : undefined; ";
+
+        HelperRewrite const * FindHelperRewrite(std::string const &name)
+        {
+            for(auto const &helper : k_list_helper_rewrites)   {
+                if(name == helper.name)   {
+                    return &helper;
+                }
+            }
+            return nullptr;
+        }
+
+        class HelperRewriter
+        {
+        public:
+            HelperRewriter(std::string const &script,
+                           std::vector<ScriptToken> const &list_tokens) :
+                m_script(script),
+                m_list_tokens(list_tokens),
+                m_rewrite_count(0)
+            {}
+
+            // rewrites tokens [@first,@last), including the
+            // source from @begin to the first token and from
+            // the last token to @end
+            std::string Rewrite(size_t first, size_t last,
+                                size_t begin, size_t end)
+            {
+                std::string out;
+                size_t pos = begin;
+                size_t i = first;
+                while(i < last)
+                {
+                    HelperRewrite const * helper = getHelperCall(i);
+                    std::vector<std::pair<size_t,size_t>> list_args;
+                    size_t close=0;
+                    if(!helper ||
+                       !splitArgs(i+1,last,close,list_args) ||
+                       list_args.size() != helper->arg_count)   {
+                        i++;
+                        continue;
+                    }
+
+                    out.append(m_script,pos,m_list_tokens[i].offset-pos);
+                    for(char const * c = helper->replacement; *c; c++)   {
+                        if(c[0] == '$' && (c[1] == '0' || c[1] == '1'))   {
+                            auto const &arg = list_args[size_t(c[1]-'0')];
+                            out += Rewrite(arg.first,arg.second,
+                                           m_list_tokens[arg.first].offset,
+                                           tokenEnd(arg.second-1));
+                            c++;
+                            continue;
+                        }
+                        out.push_back(*c);
+                    }
+                    m_rewrite_count++;
+
+                    pos = tokenEnd(close);
+                    i = close+1;
+                }
+                out.append(m_script,pos,end-pos);
+                return out;
+            }
+
+            size_t GetRewriteCount() const
+            {
+                return m_rewrite_count;
+            }
+
+        private:
+            HelperRewrite const * getHelperCall(size_t idx) const
+            {
+                if(!IsIdentifier(m_list_tokens,idx) ||
+                   (idx > 0 && IsPunctuator(m_list_tokens,idx-1,".")))   {
+                    return nullptr;
+                }
+                return FindHelperRewrite(m_list_tokens[idx].text);
+            }
+
+            // splits the arguments of the call whose '(' is at
+            // @open into token ranges; @close is set to the
+            // index of the matching ')'
+            bool splitArgs(size_t open, size_t last, size_t &close,
+                           std::vector<std::pair<size_t,size_t>> &list_args) const
+            {
+                if(!IsPunctuator(m_list_tokens,open,"("))   {
+                    return false;
+                }
+
+                sint depth=0;
+                size_t arg_start=open+1;
+                for(size_t i=open+1; i < last; i++)
+                {
+                    ScriptToken const &token = m_list_tokens[i];
+                    if(token.type != SCRIPT_TOKEN_PUNCTUATOR)   {
+                        continue;
+                    }
+                    std::string const &p = token.text;
+                    if(p == "(" || p == "[" || p == "{")   {
+                        depth++;
+                    }
+                    else if(p == "]" || p == "}")   {
+                        depth--;
+                    }
+                    else if(p == ")")   {
+                        if(depth == 0)   {
+                            if(i > arg_start)   {
+                                list_args.emplace_back(arg_start,i);
+                            }
+                            else if(!list_args.empty())   {
+                                return false;   // trailing comma
+                            }
+                            close = i;
+                            return true;
+                        }
+                        depth--;
+                    }
+                    else if(p == "," && depth == 0)   {
+                        if(i == arg_start)   {
+                            return false;
+                        }
+                        list_args.emplace_back(arg_start,i);
+                        arg_start = i+1;
+                    }
+                }
+                return false;
+            }
+
+            size_t tokenEnd(size_t idx) const
+            {
+                return m_list_tokens[idx].offset+m_list_tokens[idx].text.size();
+            }
+
+            std::string const &m_script;
+            std::vector<ScriptToken> const &m_list_tokens;
+            size_t m_rewrite_count;
+        };
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    bool TokenizeScript(std::string const &script,
+                        std::vector<ScriptToken> &list_tokens)
+    {
+        list_tokens.clear();
+
+        size_t i=0;
+        size_t const length = script.size();
+        while(i < length)
+        {
+            char const c = script[i];
+            char const next = (i+1 < length) ? script[i+1] : '\0';
+
+            // whitespace
+            if(c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+               c == '\f' || c == '\v')   {
+                i++;
+                continue;
+            }
+
+            // comments
+            if(c == '/' && next == '/')   {
+                while(i < length && script[i] != '\n')   {
+                    i++;
+                }
+                continue;
+            }
+            if(c == '/' && next == '*')   {
+                size_t const end = script.find("*/",i+2);
+                if(end == std::string::npos)   {
+                    return false;
+                }
+                i = end+2;
+                continue;
+            }
+
+            ScriptToken token;
+            token.offset = i;
+
+            if(IsIdentifierStart(c))   {
+                size_t end=i+1;
+                while(end < length && IsIdentifierPart(script[end]))   {
+                    end++;
+                }
+                token.type = SCRIPT_TOKEN_IDENTIFIER;
+                token.text = script.substr(i,end-i);
+            }
+            else if(IsDigit(c) || (c == '.' && IsDigit(next)))   {
+                size_t end=i;
+                if(c == '0' && (next == 'x' || next == 'X'))   {
+                    end += 2;
+                    while(end < length && IsHexDigit(script[end]))   {
+                        end++;
+                    }
+                }
+                else   {
+                    while(end < length && IsDigit(script[end]))   {
+                        end++;
+                    }
+                    if(end < length && script[end] == '.')   {
+                        end++;
+                        while(end < length && IsDigit(script[end]))   {
+                            end++;
+                        }
+                    }
+                    if(end < length && (script[end] == 'e' || script[end] == 'E'))   {
+                        end++;
+                        if(end < length && (script[end] == '+' || script[end] == '-'))   {
+                            end++;
+                        }
+                        while(end < length && IsDigit(script[end]))   {
+                            end++;
+                        }
+                    }
+                }
+                token.type = SCRIPT_TOKEN_NUMBER;
+                token.text = script.substr(i,end-i);
+            }
+            else if(c == '"' || c == '\'')   {
+                size_t end=i+1;
+                while(end < length && script[end] != c)   {
+                    if(script[end] == '\n')   {
+                        return false;
+                    }
+                    end += (script[end] == '\\') ? 2 : 1;
+                }
+                if(end >= length)   {
+                    return false;
+                }
+                token.type = SCRIPT_TOKEN_STRING;
+                token.text = script.substr(i,end+1-i);
+            }
+            else if(c == '/' && IsRegexAllowed(list_tokens))   {
+                // regular expression literal
+                return false;
+            }
+            else   {
+                token.type = SCRIPT_TOKEN_PUNCTUATOR;
+                for(auto p : k_list_long_punctuators)   {
+                    if(script.compare(i,std::strlen(p),p) == 0)   {
+                        token.text = p;
+                        break;
+                    }
+                }
+                if(token.text.empty())   {
+                    if(std::strchr(k_single_punctuators,c) == nullptr)   {
+                        return false;
+                    }
+                    token.text = std::string(1,c);
+                }
+            }
+
+            i += token.text.size();
+            list_tokens.push_back(token);
+        }
+
+        return true;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    ScriptAnalysis AnalyzeScript(std::string const &script)
+    {
+        std::vector<ScriptToken> list_tokens;
+        if(!TokenizeScript(script,list_tokens))   {
+            return ScriptAnalysis();
+        }
+        return AnalyzeScript(list_tokens);
+    }
+
+    ScriptAnalysis AnalyzeScript(std::vector<ScriptToken> const &list_tokens)
+    {
+        ScriptAnalysis analysis;
+
+        // names declared in the script
+        std::set<std::string> set_locals;
+        for(size_t i=0; i < list_tokens.size(); i++)   {
+            if(list_tokens[i].type != SCRIPT_TOKEN_IDENTIFIER)   {
+                continue;
+            }
+            std::string const &text = list_tokens[i].text;
+            if(text == "var")   {
+                AddVarNames(list_tokens,i,set_locals);
+            }
+            else if(text == "function" || text == "catch")   {
+                AddFunctionNames(list_tokens,i,set_locals);
+            }
+        }
+
+        // every other name must be a keyword or one of
+        // the globals that don't depend on outside state
+        for(size_t i=0; i < list_tokens.size(); i++)
+        {
+            ScriptToken const &token = list_tokens[i];
+            if(token.type != SCRIPT_TOKEN_IDENTIFIER)   {
+                continue;
+            }
+
+            // properties (Math.random is the only
+            // nondeterministic one scripts could reach)
+            if(i > 0 && IsPunctuator(list_tokens,i-1,"."))   {
+                if(token.text == "random")   {
+                    return ScriptAnalysis();
+                }
+                continue;
+            }
+
+            // object literal keys
+            if(i > 0 && IsPunctuator(list_tokens,i+1,":") &&
+               (IsPunctuator(list_tokens,i-1,"{") ||
+                IsPunctuator(list_tokens,i-1,",")))   {
+                continue;
+            }
+
+            if(IsOneOf(token.text,k_list_allowed_keywords) ||
+               IsOneOf(token.text,k_list_allowed_globals) ||
+               set_locals.count(token.text) > 0)   {
+                continue;
+            }
+
+            if(token.text == "LENGTH")   {
+                analysis.uses_length = true;
+                continue;
+            }
+
+            if(token.text == "BYTE" || token.text == "BIT")   {
+                // BYTE(N) or BIT(N, ...)
+                char const * end = (token.text == "BYTE") ? ")" : ",";
+                bool ok = false;
+                uint pos = 0;
+                if(IsPunctuator(list_tokens,i+1,"(") &&
+                   i+2 < list_tokens.size() &&
+                   list_tokens[i+2].type == SCRIPT_TOKEN_NUMBER &&
+                   IsPunctuator(list_tokens,i+3,end))   {
+                    pos = StringToUInt(list_tokens[i+2].text,ok);
+                }
+
+                if(ok)   {
+                    analysis.list_byte_positions.push_back(pos);
+                }
+                else   {
+                    analysis.dynamic_byte_positions = true;
+                }
+                continue;
+            }
+
+            // anything else (HEADER, DATA, REQ, global
+            // variables, this, eval, Date, ...)
+            return ScriptAnalysis();
+        }
+
+        std::sort(analysis.list_byte_positions.begin(),
+                  analysis.list_byte_positions.end());
+
+        analysis.list_byte_positions.erase(
+                    std::unique(analysis.list_byte_positions.begin(),
+                                analysis.list_byte_positions.end()),
+                    analysis.list_byte_positions.end());
+
+        if(analysis.dynamic_byte_positions)   {
+            analysis.list_byte_positions.clear();
+        }
+
+        analysis.data_only = true;
+        return analysis;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    bool RewriteScriptHelpers(std::string const &script,
+                              std::string &rewritten)
+    {
+        rewritten.clear();
+
+        std::vector<ScriptToken> list_tokens;
+        if(!TokenizeScript(script,list_tokens))   {
+            return false;
+        }
+
+        for(size_t i=0; i < list_tokens.size(); i++)
+        {
+            ScriptToken const &token = list_tokens[i];
+            if(token.type != SCRIPT_TOKEN_IDENTIFIER ||
+               (i > 0 && IsPunctuator(list_tokens,i-1,".")))   {
+                continue;
+            }
+
+            // scripts that could see or change the bound
+            // data some other way are left as they are
+            if(token.text.compare(0,8,"__obdex_") == 0 ||
+               token.text == "global_param" ||
+               token.text == "eval" ||
+               token.text == "with")   {
+                return false;
+            }
+
+            // helpers must only be called; anything else
+            // (var BYTE, function BYTE, {BYTE: ...}) may
+            // give the name a different meaning
+            if(FindHelperRewrite(token.text) &&
+               (!IsPunctuator(list_tokens,i+1,"(") ||
+                (i > 0 && list_tokens[i-1].text == "function")))   {
+                return false;
+            }
+        }
+
+        if(list_tokens.empty())   {
+            return false;
+        }
+
+        HelperRewriter rewriter(script,list_tokens);
+        std::string body = rewriter.Rewrite(0,list_tokens.size(),0,script.size());
+        if(rewriter.GetRewriteCount() == 0)   {
+            return false;
+        }
+
+        rewritten = k_helper_rewrite_prologue;
+        rewritten += body;
+        return true;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    namespace
+    {
+        // returns the index of the bracket that closes the
+        // one at @open, or the number of tokens if it's
+        // never closed
+        size_t FindClosingBracket(std::vector<ScriptToken> const &list_tokens,
+                                  size_t open)
+        {
+            sint depth=0;
+            for(size_t i=open; i < list_tokens.size(); i++)
+            {
+                ScriptToken const &token = list_tokens[i];
+                if(token.type != SCRIPT_TOKEN_PUNCTUATOR)   {
+                    continue;
+                }
+                std::string const &p = token.text;
+                if(p == "(" || p == "[" || p == "{")   {
+                    depth++;
+                }
+                else if(p == ")" || p == "]" || p == "}")   {
+                    depth--;
+                    if(depth == 0)   {
+                        return i;
+                    }
+                }
+            }
+            return list_tokens.size();
+        }
+    }
+
+    bool InstrumentScriptSteps(std::string const &script,
+                               std::string const &step_function,
+                               std::string &instrumented)
+    {
+        instrumented.clear();
+
+        std::vector<ScriptToken> list_tokens;
+        if(!TokenizeScript(script,list_tokens))   {
+            return false;
+        }
+
+        // text to insert at each offset in the script
+        std::vector<std::pair<size_t,std::string>> list_inserts;
+        std::string const step_call = step_function+"()";
+
+        for(size_t i=0; i < list_tokens.size(); i++)
+        {
+            ScriptToken const &token = list_tokens[i];
+            if(token.type != SCRIPT_TOKEN_IDENTIFIER ||
+               (i > 0 && IsPunctuator(list_tokens,i-1,".")))   {
+                continue;
+            }
+
+            if(token.text == "while" && IsPunctuator(list_tokens,i+1,"("))   {
+                // while(cond) -> while(step() && (cond))
+                size_t const close = FindClosingBracket(list_tokens,i+1);
+                if(close == list_tokens.size())   {
+                    return false;
+                }
+                list_inserts.emplace_back(list_tokens[i+1].offset+1,step_call+" && (");
+                list_inserts.emplace_back(list_tokens[close].offset,")");
+            }
+            else if(token.text == "for" && IsPunctuator(list_tokens,i+1,"("))   {
+                // for(init; cond; update) -> for(init; step() && (cond); update)
+                size_t const close = FindClosingBracket(list_tokens,i+1);
+                if(close == list_tokens.size())   {
+                    return false;
+                }
+
+                std::vector<size_t> list_semicolons;
+                sint depth=0;
+                for(size_t j=i+2; j < close; j++)   {
+                    std::string const &p = list_tokens[j].text;
+                    if(list_tokens[j].type != SCRIPT_TOKEN_PUNCTUATOR)   {
+                        continue;
+                    }
+                    if(p == "(" || p == "[" || p == "{")   {
+                        depth++;
+                    }
+                    else if(p == ")" || p == "]" || p == "}")   {
+                        depth--;
+                    }
+                    else if(p == ";" && depth == 0)   {
+                        list_semicolons.push_back(j);
+                    }
+                }
+                if(list_semicolons.size() != 2)   {
+                    // for(key in obj) body -> for(key in obj) if(step()) body
+                    list_inserts.emplace_back(list_tokens[close].offset+1," if("+step_call+")");
+                    continue;
+                }
+
+                size_t const cond_begin = list_tokens[list_semicolons[0]].offset+1;
+                if(list_semicolons[1] == list_semicolons[0]+1)   {
+                    list_inserts.emplace_back(cond_begin," "+step_call);
+                }
+                else   {
+                    list_inserts.emplace_back(cond_begin," "+step_call+" && (");
+                    list_inserts.emplace_back(list_tokens[list_semicolons[1]].offset,")");
+                }
+            }
+            else if(token.text == "function")   {
+                // function name(args) { -> function name(args) { step();
+                size_t open = i+1;
+                if(IsIdentifier(list_tokens,open))   {
+                    open++;
+                }
+                if(!IsPunctuator(list_tokens,open,"("))   {
+                    return false;
+                }
+                size_t const close = FindClosingBracket(list_tokens,open);
+                if(!IsPunctuator(list_tokens,close+1,"{"))   {
+                    return false;
+                }
+                list_inserts.emplace_back(list_tokens[close+1].offset+1," "+step_call+";");
+            }
+        }
+
+        if(list_inserts.empty())   {
+            return true;
+        }
+
+        std::stable_sort(list_inserts.begin(),list_inserts.end(),
+                         [](std::pair<size_t,std::string> const &a,
+                            std::pair<size_t,std::string> const &b) {
+                                return a.first < b.first;
+                         });
+
+        size_t pos=0;
+        for(auto const &insert : list_inserts)   {
+            instrumented.append(script,pos,insert.first-pos);
+            instrumented += insert.second;
+            pos = insert.first;
+        }
+        instrumented.append(script,pos,std::string::npos);
+        return true;
+    }
+}
@@ -0,0 +1,120 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_SCRIPT_ANALYSIS_HPP
+#define OBDEX_SCRIPT_ANALYSIS_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    // ScriptTokenType
+    // * the kinds of tokens in a definitions file script;
+    //   comments and whitespace are skipped
+    enum ScriptTokenType
+    {
+        SCRIPT_TOKEN_IDENTIFIER,    // names and keywords
+        SCRIPT_TOKEN_NUMBER,
+        SCRIPT_TOKEN_STRING,        // text includes the quotes
+        SCRIPT_TOKEN_PUNCTUATOR
+    };
+
+    struct ScriptToken
+    {
+        ScriptTokenType type;
+        std::string text;
+        size_t offset;      // position of the token in the script
+    };
+
+    // TokenizeScript
+    // * splits the javascript in @script into tokens
+    // * returns false for anything the tokenizer doesn't
+    //   handle (regular expression literals, unterminated
+    //   strings and comments); scripts that fail to
+    //   tokenize are left to the js engine as they are
+    bool TokenizeScript(std::string const &script,
+                        std::vector<ScriptToken> &list_tokens);
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // ScriptAnalysis
+    // * data_only is true if the script only reads the
+    //   response with BYTE, BIT and LENGTH and only saves
+    //   results with saveNumericalData and saveLiteralData;
+    //   it doesn't read headers, other responses or any
+    //   other global state, so its results only depend on
+    //   the data bytes
+    // * list_byte_positions is the sorted list of data
+    //   bytes a data_only script reads if every BYTE and
+    //   BIT call uses a constant byte position; otherwise
+    //   dynamic_byte_positions is set
+    // * uses_length is set if the script calls LENGTH
+    struct ScriptAnalysis
+    {
+        ScriptAnalysis() :
+            data_only(false),
+            dynamic_byte_positions(false),
+            uses_length(false)
+        {}
+
+        bool data_only;
+        bool dynamic_byte_positions;
+        bool uses_length;
+        std::vector<uint> list_byte_positions;
+    };
+
+    ScriptAnalysis AnalyzeScript(std::string const &script);
+
+    ScriptAnalysis AnalyzeScript(std::vector<ScriptToken> const &list_tokens);
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // RewriteScriptHelpers
+    // * rewrites calls to the BYTE, BIT, LENGTH, DATA, HEADER,
+    //   REQ, NUM_REQ and NUM_RESP helpers in @script to read
+    //   the response data directly; the data is bound to
+    //   locals at the start of the script, so a script that
+    //   reads bytes in a loop doesn't go through a chain of
+    //   global lookups and calls for every byte
+    // * the rewritten script gives the same results as the
+    //   original, including for missing data
+    // * returns false and leaves @rewritten empty if there's
+    //   nothing to rewrite or the script can't be rewritten
+    //   safely (ie. it declares its own BYTE)
+    bool RewriteScriptHelpers(std::string const &script,
+                              std::string &rewritten);
+
+    // InstrumentScriptSteps
+    // * adds a call to @step_function to every loop
+    //   condition and at the start of every function in
+    //   @script, so that a runaway loop or recursion can
+    //   be stopped (see ScriptBudget)
+    // * @step_function must return true to continue
+    // * for-in loop bodies become if(@step_function()) ...
+    // * leaves @instrumented empty if there's nothing to
+    //   instrument
+    // * returns false and leaves @instrumented empty if
+    //   the script can't be tokenized or has a function
+    //   it doesn't understand; such a script has no
+    //   step checks at all
+    bool InstrumentScriptSteps(std::string const &script,
+                               std::string const &step_function,
+                               std::string &instrumented);
+}
+
+#endif // OBDEX_SCRIPT_ANALYSIS_HPP
@@ -0,0 +1,57 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexScriptBudget.hpp>
+
+#include <limits>
+
+namespace obdex
+{
+    // ============================================================= //
+    // ============================================================= //
+
+    u64 const ScriptBudgetCounter::k_time_check_steps;
+
+    ScriptBudgetCounter::ScriptBudgetCounter() :
+        m_steps(0),
+        m_max_steps(std::numeric_limits<u64>::max()),
+        m_check_time(false),
+        m_exceeded(false)
+    {}
+
+    void ScriptBudgetCounter::Start(ScriptBudget const &budget)
+    {
+        m_steps = 0;
+        m_max_steps = (budget.max_steps > 0) ?
+                    budget.max_steps : std::numeric_limits<u64>::max();
+
+        m_check_time = (budget.max_time.count() > 0);
+        m_exceeded = false;
+        if(m_check_time)   {
+            m_deadline = std::chrono::high_resolution_clock::now()+budget.max_time;
+        }
+    }
+
+    void ScriptBudgetCounter::checkTime()
+    {
+        if(std::chrono::high_resolution_clock::now() > m_deadline)   {
+            m_exceeded = true;
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
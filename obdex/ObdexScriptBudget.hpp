@@ -0,0 +1,120 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_SCRIPT_BUDGET_HPP
+#define OBDEX_SCRIPT_BUDGET_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    // ScriptBudget
+    // * limits how long a single run of a parse script
+    //   may take before it's stopped with a
+    //   ScriptBudgetExceeded error
+    // * max_steps is the number of loop iterations and
+    //   function calls the script may make
+    // * max_time is a wall clock deadline, checked every
+    //   k_time_check_steps steps
+    // * zero disables a limit; both are disabled by default
+    struct ScriptBudget
+    {
+        ScriptBudget() :
+            max_steps(0),
+            max_time(0)
+        {}
+
+        bool IsEnabled() const
+        {
+            return (max_steps > 0 || max_time.count() > 0);
+        }
+
+        u64 max_steps;
+        Microseconds max_time;
+    };
+
+    // ScriptBudgetStats
+    // * how close the runs of a parse function came to
+    //   the budget while it was set
+    // * function_key is "spec:address:parameter:protocols"
+    // * exceeded is the number of runs that were stopped
+    struct ScriptBudgetStats
+    {
+        ScriptBudgetStats() :
+            runs(0),
+            exceeded(0),
+            max_steps(0),
+            max_time(0)
+        {}
+
+        std::string function_key;
+        u64 runs;
+        u64 exceeded;
+        u64 max_steps;
+        Microseconds max_time;
+    };
+
+    // ScriptBudgetCounter
+    // * counts the steps of a single script run and
+    //   checks them against a ScriptBudget
+    class ScriptBudgetCounter
+    {
+    public:
+        static u64 const k_time_check_steps = 16;
+
+        ScriptBudgetCounter();
+
+        // Start
+        // * resets the count and starts the deadline
+        void Start(ScriptBudget const &budget);
+
+        // Step
+        // * counts a step; returns false if the budget is
+        //   exceeded, and for every step after that
+        bool Step()
+        {
+            m_steps++;
+            if(m_steps > m_max_steps)   {
+                m_exceeded = true;
+            }
+            else if(m_check_time && (m_steps % k_time_check_steps) == 0)   {
+                checkTime();
+            }
+            return !m_exceeded;
+        }
+
+        u64 GetSteps() const
+        {
+            return m_steps;
+        }
+
+        bool IsExceeded() const
+        {
+            return m_exceeded;
+        }
+
+    private:
+        void checkTime();
+
+        u64 m_steps;
+        u64 m_max_steps;
+        bool m_check_time;
+        bool m_exceeded;
+        TimePoint m_deadline;
+    };
+}
+
+#endif // OBDEX_SCRIPT_BUDGET_HPP
@@ -0,0 +1,494 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexScriptEngine.hpp>
+#include <obdex/ObdexErrors.hpp>
+#include <obdex/ObdexUtil.hpp>
+#include <obdex/ObdexLog.hpp>
+#include <obdex/ObdexJSGlobals.hpp>
+#include <obdex/ObdexScriptAnalysis.hpp>
+
+namespace obdex
+{
+    namespace
+    {
+        // counter for the script that's running on this
+        // thread, if it has a budget
+        thread_local ScriptBudgetCounter * tl_budget_counter = nullptr;
+
+        // __obdex_step
+        // * the step check InstrumentScriptSteps adds
+        //   to scripts; throws a RangeError once the
+        //   budget is exceeded
+        int ScriptStep(duk_context * ctx)
+        {
+            if(tl_budget_counter && !tl_budget_counter->Step())   {
+                return DUK_RET_RANGE_ERROR;
+            }
+            duk_push_true(ctx);
+            return 1;
+        }
+
+        char const * const k_step_function = "__obdex_step";
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    DuktapeScriptEngine::DuktapeScriptEngine(bool rewrite_helpers) :
+        m_rewrite_helpers(rewrite_helpers)
+    {
+        // create js heap and default context
+        m_js_ctx = duk_create_heap(ScriptHeap::Alloc,
+                                   ScriptHeap::Realloc,
+                                   ScriptHeap::Free,
+                                   &m_heap,
+                                   nullptr);
+        if(!m_js_ctx)   {
+            throw JSContextSetupFailed();
+        }
+
+        // push the global object onto the context's stack
+        duk_push_global_object(m_js_ctx);
+        m_js_idx_global_object = duk_normalize_index(m_js_ctx,-1);
+
+        // register properties to the global object
+        duk_eval_string(m_js_ctx,globals_js);
+        duk_pop(m_js_ctx);
+
+        duk_push_c_function(m_js_ctx,ScriptStep,0);
+        duk_put_prop_string(m_js_ctx,m_js_idx_global_object,k_step_function);
+
+        // add important properties to the stack and
+        // and save their location
+        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
+                            "__private_get_lit_data");
+
+        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
+                            "__private_get_num_data");
+
+        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
+                            "__private__clear_all_data");
+
+        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
+                            "__private__add_list_databytes");
+
+        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
+                            "__private__add_msg_data");
+
+        m_js_idx_f_add_msg_data     = duk_normalize_index(m_js_ctx,-1);
+        m_js_idx_f_add_databytes    = duk_normalize_index(m_js_ctx,-2);
+        m_js_idx_f_clear_data       = duk_normalize_index(m_js_ctx,-3);
+        m_js_idx_f_get_num_data     = duk_normalize_index(m_js_ctx,-4);
+        m_js_idx_f_get_lit_data     = duk_normalize_index(m_js_ctx,-5);
+    }
+
+    DuktapeScriptEngine::~DuktapeScriptEngine()
+    {
+        duk_destroy_heap(m_js_ctx);
+    }
+
+    std::string const & DuktapeScriptEngine::GetName() const
+    {
+        static std::string const name("duktape");
+        return name;
+    }
+
+    bool DuktapeScriptEngine::Compile(u32 function_idx,
+                                      std::string const &function_key,
+                                      std::string const &script)
+    {
+        // add parse function name and scope
+        std::string fname("f");
+        AppendUInt(fname,function_idx);
+
+        std::string rewritten;
+        if(m_rewrite_helpers)   {
+            RewriteScriptHelpers(script,rewritten);
+        }
+        std::string const &body_rewritten = rewritten.empty() ? script : rewritten;
+
+        std::string instrumented;
+        if(m_budget.IsEnabled() &&
+           !InstrumentScriptSteps(body_rewritten,k_step_function,instrumented))   {
+            // this version of duktape has no interrupt to fall
+            // back on, so the budget can't stop the script
+            OBDEX_LOG_WARN(obdexlog) << "Script budget: can't add step checks to "
+                                     << function_key << ", it runs without them";
+        }
+        std::string const &body = instrumented.empty() ? body_rewritten : instrumented;
+
+        std::string js_function;
+        js_function.reserve(body.size()+fname.size()+16);
+        js_function += "function "+fname+"() {";
+        js_function += body;
+        js_function += "}";
+
+        // register parse function to global js object
+        duk_eval_string(m_js_ctx,js_function.c_str());
+        duk_pop(m_js_ctx);
+
+        // add parse function to top of stack and
+        // save its stack index
+        duk_get_prop_string(m_js_ctx,m_js_idx_global_object,
+                            fname.c_str());
+
+        if(function_idx < m_js_list_function_idx.size())   {
+            // compiled again, reuse the stack index
+            duk_replace(m_js_ctx,m_js_list_function_idx[function_idx]);
+            return true;
+        }
+
+        m_js_list_function_idx.resize(function_idx+1,0);
+        m_js_list_function_idx[function_idx] = duk_normalize_index(m_js_ctx,-1);
+        return true;
+    }
+
+    void DuktapeScriptEngine::BindInput(ByteList const &data_bytes)
+    {
+        clearData();
+
+        // copy over data_bytes to js context
+        duk_dup(m_js_ctx,m_js_idx_f_add_databytes);
+        int list_arr_idx = duk_push_array(m_js_ctx);    // list_data_bytes
+        pushBytes(data_bytes);
+        duk_put_prop_index(m_js_ctx,list_arr_idx,0);
+        duk_call(m_js_ctx,1);
+        duk_pop(m_js_ctx);
+    }
+
+    void DuktapeScriptEngine::BindInput(std::vector<MessageData> const &list_msg_data)
+    {
+        clearData();
+
+        for(uint i=0; i < list_msg_data.size(); i++)
+        {
+            MessageData const &msg = list_msg_data[i];
+            duk_dup(m_js_ctx,m_js_idx_f_add_msg_data);
+            int list_arr_idx;
+
+            // build header bytes js array
+            list_arr_idx = duk_push_array(m_js_ctx);    // listheader_bytes
+            for(uint j=0; j < msg.list_headers.size(); j++)   {
+                pushBytes(msg.list_headers[j]);
+                duk_put_prop_index(m_js_ctx,list_arr_idx,j);
+            }
+
+            // build data bytes js array
+            list_arr_idx = duk_push_array(m_js_ctx);    // list_data_bytes
+            for(uint j=0; j < msg.list_data.size(); j++)   {
+                pushBytes(msg.list_data[j]);
+                duk_put_prop_index(m_js_ctx,list_arr_idx,j);
+            }
+            duk_call(m_js_ctx,2);
+            duk_pop(m_js_ctx);
+        }
+    }
+
+    bool DuktapeScriptEngine::Run(u32 function_idx, bool catch_errors)
+    {
+        // parse the data
+        duk_dup(m_js_ctx,m_js_list_function_idx[function_idx]);
+        if(m_budget.IsEnabled() || m_heap.HasLimit())   {
+            return runGuarded(catch_errors);
+        }
+
+        if(catch_errors)   {
+            bool const ok = (duk_pcall(m_js_ctx,0,DUK_INVALID_INDEX) == DUK_EXEC_SUCCESS);
+            duk_pop(m_js_ctx);
+            return ok;
+        }
+
+        duk_call(m_js_ctx,0);
+        duk_pop(m_js_ctx);
+        return true;
+    }
+
+    bool DuktapeScriptEngine::runGuarded(bool catch_errors)
+    {
+        ScriptBudgetCounter * const prev_counter = tl_budget_counter;
+        if(m_budget.IsEnabled())   {
+            m_budget_counter.Start(m_budget);
+            tl_budget_counter = &m_budget_counter;
+        }
+
+        // the heap limit only applies to the script; duktape
+        // can't recover from failed allocations outside of
+        // a protected call
+        m_heap.TakeLimitHit();
+        m_heap.SetLimitEnforced(true);
+        bool const ok = (duk_pcall(m_js_ctx,0,DUK_INVALID_INDEX) == DUK_EXEC_SUCCESS);
+        m_heap.SetLimitEnforced(false);
+        tl_budget_counter = prev_counter;
+
+        // a script may catch the error that stops it,
+        // but every step after that fails as well
+        if(m_budget.IsEnabled() && m_budget_counter.IsExceeded())   {
+            duk_pop(m_js_ctx);
+            throw ScriptBudgetExceeded("Error: script exceeded its budget");
+        }
+
+        // scripts that hit the limit but still finished
+        // (ie. after a garbage collection) are fine
+        if(m_heap.TakeLimitHit() && !ok)   {
+            duk_pop(m_js_ctx);
+            throw ScriptHeapLimitExceeded("Error: script exceeded the heap limit");
+        }
+
+        if(!ok && !catch_errors)   {
+            // same as an error in duk_call
+            duk_throw(m_js_ctx);
+        }
+
+        duk_pop(m_js_ctx);
+        return ok;
+    }
+
+    void DuktapeScriptEngine::ExtractResults(Data &data)
+    {
+        // save numerical data
+        duk_dup(m_js_ctx,m_js_idx_f_get_num_data);
+        duk_call(m_js_ctx,0);                       // <..., listNumData>
+        duk_get_prop_string(m_js_ctx,-1,"length");  // <..., listNumData, listNumData.length>
+        u32 listNumLength = u32(duk_get_number(m_js_ctx,-1));
+        duk_pop(m_js_ctx);                          // <..., listNumData>
+
+        for(u32 i=0; i < listNumLength; i++)   {
+            NumericalData numData;
+            duk_get_prop_index(m_js_ctx,-1,i);      // <..., listNumData, listNumData[i]>
+
+            duk_get_prop_string(m_js_ctx,-1,"units");
+            numData.units = std::string(duk_get_string(m_js_ctx,-1));
+            duk_pop(m_js_ctx);
+
+            duk_get_prop_string(m_js_ctx,-1,"min");
+            numData.min = duk_get_number(m_js_ctx,-1);
+            duk_pop(m_js_ctx);
+
+            duk_get_prop_string(m_js_ctx,-1,"max");
+            numData.max = duk_get_number(m_js_ctx,-1);
+            duk_pop(m_js_ctx);
+
+            duk_get_prop_string(m_js_ctx,-1,"value");
+            numData.value = duk_get_number(m_js_ctx,-1);
+            duk_pop(m_js_ctx);
+
+            duk_get_prop_string(m_js_ctx,-1,"property");
+            numData.property = std::string(duk_get_string(m_js_ctx,-1));
+            duk_pop(m_js_ctx);
+
+            duk_pop(m_js_ctx);                      // <..., listNumData>
+            data.list_numerical_data.push_back(numData);
+        }
+        duk_pop(m_js_ctx);
+
+        // save literal data
+        duk_dup(m_js_ctx,m_js_idx_f_get_lit_data);
+        duk_call(m_js_ctx,0);                       // <..., listLitData>
+        duk_get_prop_string(m_js_ctx,-1,"length");  // <..., listLitData.length>
+        u32 listLitLength = u32(duk_get_number(m_js_ctx,-1));
+        duk_pop(m_js_ctx);                          // <..., listLitData>
+
+        for(u32 i=0; i < listLitLength; i++)   {
+            LiteralData litData;
+            duk_get_prop_index(m_js_ctx,-1,i);      // <..., listLitData, listLitData[i]>
+
+            duk_get_prop_string(m_js_ctx,-1,"value");
+            int litDataVal = duk_get_boolean(m_js_ctx,-1);
+            litData.value = (litDataVal == 1) ? true : false;
+            duk_pop(m_js_ctx);
+
+            duk_get_prop_string(m_js_ctx,-1,"valueIfFalse");
+            litData.value_if_false = std::string(duk_get_string(m_js_ctx,-1));
+            duk_pop(m_js_ctx);
+
+            duk_get_prop_string(m_js_ctx,-1,"valueIfTrue");
+            litData.value_if_true = std::string(duk_get_string(m_js_ctx,-1));
+            duk_pop(m_js_ctx);
+
+            duk_get_prop_string(m_js_ctx,-1,"property");
+            litData.property = std::string(duk_get_string(m_js_ctx,-1));
+            duk_pop(m_js_ctx);
+
+            duk_pop(m_js_ctx);                      // <..., listLitData>
+            data.list_literal_data.push_back(litData);
+        }
+        duk_pop(m_js_ctx);
+    }
+
+    void DuktapeScriptEngine::SetBudget(ScriptBudget const &budget)
+    {
+        m_budget = budget;
+    }
+
+    u64 DuktapeScriptEngine::GetLastRunSteps() const
+    {
+        return m_budget.IsEnabled() ? m_budget_counter.GetSteps() : 0;
+    }
+
+    void DuktapeScriptEngine::SetHeapLimit(size_t max_bytes)
+    {
+        m_heap.SetLimit(max_bytes);
+    }
+
+    ScriptHeapStats DuktapeScriptEngine::GetHeapStats() const
+    {
+        return m_heap.GetStats();
+    }
+
+    std::unique_ptr<ScriptEngine> DuktapeScriptEngine::Clone() const
+    {
+        std::unique_ptr<ScriptEngine> engine(
+                    new DuktapeScriptEngine(m_rewrite_helpers));
+
+        engine->SetBudget(m_budget);
+        engine->SetHeapLimit(m_heap.GetStats().limit);
+        return engine;
+    }
+
+    void DuktapeScriptEngine::clearData()
+    {
+        // clear existing data in js context
+        duk_dup(m_js_ctx,m_js_idx_f_clear_data);
+        duk_call(m_js_ctx,0);
+        duk_pop(m_js_ctx);
+    }
+
+    void DuktapeScriptEngine::pushBytes(ByteList const &bytes)
+    {
+        int arr_idx = duk_push_array(m_js_ctx);
+        for(uint k=0; k < bytes.size(); k++)   {
+            duk_push_number(m_js_ctx,bytes[k]);
+            duk_put_prop_index(m_js_ctx,arr_idx,k);
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    NativeScriptEngine::NativeScriptEngine() :
+        m_data_bytes(nullptr),
+        m_list_msg_data(nullptr)
+    {}
+
+    std::string const & NativeScriptEngine::GetName() const
+    {
+        static std::string const name("native");
+        return name;
+    }
+
+    bool NativeScriptEngine::Compile(u32 function_idx,
+                                     std::string const &function_key,
+                                     std::string const &script)
+    {
+        if(m_list_functions.size() <= function_idx)   {
+            m_list_functions.resize(function_idx+1,nullptr);
+        }
+
+        // use a native version if one is linked in
+        m_list_functions[function_idx] =
+                FindNativeScript(function_key,HashScript(script));
+
+        return (m_list_functions[function_idx] != nullptr);
+    }
+
+    void NativeScriptEngine::BindInput(ByteList const &data_bytes)
+    {
+        m_data_bytes = &data_bytes;
+        m_list_msg_data = nullptr;
+    }
+
+    void NativeScriptEngine::BindInput(std::vector<MessageData> const &list_msg_data)
+    {
+        m_data_bytes = nullptr;
+        m_list_msg_data = &list_msg_data;
+    }
+
+    bool NativeScriptEngine::Run(u32 function_idx, bool)
+    {
+        m_results.list_numerical_data.clear();
+        m_results.list_literal_data.clear();
+
+        NativeParseFunction const function = m_list_functions[function_idx];
+        if(function == nullptr)   {
+            return false;
+        }
+
+        if(!m_list_msg_data && !m_data_bytes)   {
+            return false;
+        }
+
+        NativeScriptInput input = (m_list_msg_data) ?
+                    NativeScriptInput(*m_list_msg_data) :
+                    NativeScriptInput(*m_data_bytes);
+
+        if(m_budget.IsEnabled())   {
+            m_budget_counter.Start(m_budget);
+            input.SetBudgetCounter(&m_budget_counter);
+        }
+
+        try {
+            function(input,m_results);
+        }
+        catch(native::Bail &)   {
+            // the results wouldn't match the js version
+            return false;
+        }
+        return true;
+    }
+
+    void NativeScriptEngine::ExtractResults(Data &data)
+    {
+        for(auto &num_data : m_results.list_numerical_data)   {
+            data.list_numerical_data.push_back(std::move(num_data));
+        }
+        for(auto &lit_data : m_results.list_literal_data)   {
+            data.list_literal_data.push_back(std::move(lit_data));
+        }
+        m_results.list_numerical_data.clear();
+        m_results.list_literal_data.clear();
+    }
+
+    void NativeScriptEngine::SetBudget(ScriptBudget const &budget)
+    {
+        m_budget = budget;
+    }
+
+    u64 NativeScriptEngine::GetLastRunSteps() const
+    {
+        return m_budget.IsEnabled() ? m_budget_counter.GetSteps() : 0;
+    }
+
+    void NativeScriptEngine::SetHeapLimit(size_t)
+    {
+        // native scripts don't have a heap
+    }
+
+    ScriptHeapStats NativeScriptEngine::GetHeapStats() const
+    {
+        return ScriptHeapStats();
+    }
+
+    std::unique_ptr<ScriptEngine> NativeScriptEngine::Clone() const
+    {
+        std::unique_ptr<ScriptEngine> engine(new NativeScriptEngine);
+        engine->SetBudget(m_budget);
+        return engine;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
@@ -0,0 +1,234 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_SCRIPT_ENGINE_HPP
+#define OBDEX_SCRIPT_ENGINE_HPP
+
+// duktape
+#include <obdex/duktape/duktape.h>
+
+#include <obdex/ObdexDataTypes.hpp>
+#include <obdex/ObdexNativeScripts.hpp>
+#include <obdex/ObdexScriptBudget.hpp>
+#include <obdex/ObdexScriptHeap.hpp>
+
+#include <memory>
+
+namespace obdex
+{
+    // ScriptEngine
+    // * runs the parse scripts in a definitions file
+    // * the Parser compiles every script with every engine
+    //   it has when the definitions file is loaded, and
+    //   then for each response: binds the response data,
+    //   runs the parse function and extracts the results
+    // * scripts are referred to by their function index,
+    //   which is the order they appear in the definitions
+    //   file (see ParameterFrame.function_key_idx)
+    class ScriptEngine
+    {
+    public:
+        virtual ~ScriptEngine() {}
+
+        // GetName
+        // * the name used to select the engine
+        virtual std::string const & GetName() const = 0;
+
+        // Compile
+        // * prepares @script as parse function @function_idx;
+        //   @function_key is "spec:address:parameter:protocols"
+        // * returns false if the engine can't run the script;
+        //   it's run by the duktape engine instead
+        virtual bool Compile(u32 function_idx,
+                             std::string const &function_key,
+                             std::string const &script) = 0;
+
+        // BindInput
+        // * sets the response data the next Run uses; the
+        //   data must stay valid until then
+        // * PARSE_SEPARATELY: a single response's data bytes
+        // * PARSE_COMBINED: every MessageData's headers and data
+        virtual void BindInput(ByteList const &data_bytes) = 0;
+        virtual void BindInput(std::vector<MessageData> const &list_msg_data) = 0;
+
+        // Run
+        // * runs parse function @function_idx on the bound input
+        // * returns false if there are no results: the engine
+        //   can't give the same results as the script for the
+        //   input, or the script failed and @catch_errors is set
+        //   (without @catch_errors a failing script is fatal)
+        virtual bool Run(u32 function_idx, bool catch_errors) = 0;
+
+        // ExtractResults
+        // * appends the results of the last Run to @data
+        // * may throw std::exception for results that can't
+        //   be converted (ie. undefined strings)
+        virtual void ExtractResults(Data &data) = 0;
+
+        // SetBudget
+        // * limits each Run to @budget; Run throws
+        //   ScriptBudgetExceeded for scripts that go over it,
+        //   whether or not errors are caught
+        // * engines may need to compile scripts again after
+        //   a budget is set or removed; the Parser does this
+        virtual void SetBudget(ScriptBudget const &budget) = 0;
+
+        // GetLastRunSteps
+        // * the number of steps (loop iterations and function
+        //   calls) the last Run took; only counted while a
+        //   budget is set
+        virtual u64 GetLastRunSteps() const = 0;
+
+        // SetHeapLimit
+        // * limits the memory the engine's scripts can use
+        //   while they run to @max_bytes; Run throws
+        //   ScriptHeapLimitExceeded for scripts that fail
+        //   because of it; zero removes the limit
+        virtual void SetHeapLimit(size_t max_bytes) = 0;
+
+        // GetHeapStats
+        // * the memory used by the engine's script heap,
+        //   if it has one
+        virtual ScriptHeapStats GetHeapStats() const = 0;
+
+        // Clone
+        // * returns a new engine with the same settings
+        //   (ie. budget and heap limit) that hasn't
+        //   compiled any scripts; used by Parser::Clone
+        virtual std::unique_ptr<ScriptEngine> Clone() const = 0;
+    };
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // DuktapeScriptEngine
+    // * runs scripts with the duktape javascript engine
+    //   and the helpers in globals.js; can run any script
+    // * if @rewrite_helpers is set, calls to BYTE, BIT,
+    //   LENGTH and the other data helpers are replaced with
+    //   direct reads when scripts are compiled (see
+    //   RewriteScriptHelpers)
+    // * while a budget is set, scripts are compiled with a
+    //   step check in every loop condition and function
+    //   (see InstrumentScriptSteps); a single call into
+    //   duktape (ie. joining a huge array) can't be stopped
+    // * scripts InstrumentScriptSteps can't handle run
+    //   without a budget and a warning is logged
+    // * the js heap is allocated from a ScriptHeap; its
+    //   limit applies to allocations made by scripts, not
+    //   to compiling them or binding the input
+    class DuktapeScriptEngine : public ScriptEngine
+    {
+    public:
+        // throws JSContextSetupFailed
+        DuktapeScriptEngine(bool rewrite_helpers=true);
+        ~DuktapeScriptEngine();
+
+        // owns m_js_ctx, so it can't be copied (see Clone)
+        DuktapeScriptEngine(DuktapeScriptEngine const &) = delete;
+        DuktapeScriptEngine & operator = (DuktapeScriptEngine const &) = delete;
+
+        std::string const & GetName() const;
+
+        bool Compile(u32 function_idx,
+                     std::string const &function_key,
+                     std::string const &script);
+
+        void BindInput(ByteList const &data_bytes);
+        void BindInput(std::vector<MessageData> const &list_msg_data);
+
+        bool Run(u32 function_idx, bool catch_errors);
+
+        void ExtractResults(Data &data);
+
+        void SetBudget(ScriptBudget const &budget);
+
+        u64 GetLastRunSteps() const;
+
+        void SetHeapLimit(size_t max_bytes);
+
+        ScriptHeapStats GetHeapStats() const;
+
+        std::unique_ptr<ScriptEngine> Clone() const;
+
+    private:
+        bool runGuarded(bool catch_errors);
+        void clearData();
+        void pushBytes(ByteList const &bytes);
+
+        bool const m_rewrite_helpers;
+        ScriptBudget m_budget;
+        ScriptBudgetCounter m_budget_counter;
+
+        ScriptHeap m_heap;
+        duk_context * m_js_ctx;
+        u32 m_js_idx_global_object;
+        u32 m_js_idx_f_add_databytes;
+        u32 m_js_idx_f_add_msg_data;
+        u32 m_js_idx_f_clear_data;
+        u32 m_js_idx_f_get_lit_data;
+        u32 m_js_idx_f_get_num_data;
+
+        // stack index of each parse function
+        std::vector<u32> m_js_list_function_idx;
+    };
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // NativeScriptEngine
+    // * runs the C++ versions of scripts written by
+    //   obdex_codegen (see ObdexNativeScripts.hpp); only
+    //   compiles scripts that have a native version
+    class NativeScriptEngine : public ScriptEngine
+    {
+    public:
+        NativeScriptEngine();
+
+        std::string const & GetName() const;
+
+        bool Compile(u32 function_idx,
+                     std::string const &function_key,
+                     std::string const &script);
+
+        void BindInput(ByteList const &data_bytes);
+        void BindInput(std::vector<MessageData> const &list_msg_data);
+
+        bool Run(u32 function_idx, bool catch_errors);
+
+        void ExtractResults(Data &data);
+
+        void SetBudget(ScriptBudget const &budget);
+
+        u64 GetLastRunSteps() const;
+
+        void SetHeapLimit(size_t max_bytes);
+
+        ScriptHeapStats GetHeapStats() const;
+
+        std::unique_ptr<ScriptEngine> Clone() const;
+
+    private:
+        std::vector<NativeParseFunction> m_list_functions;
+        ByteList const * m_data_bytes;
+        std::vector<MessageData> const * m_list_msg_data;
+        Data m_results;
+        ScriptBudget m_budget;
+        ScriptBudgetCounter m_budget_counter;
+    };
+}
+
+#endif // OBDEX_SCRIPT_ENGINE_HPP
@@ -0,0 +1,303 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexScriptHeap.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+namespace obdex
+{
+    namespace
+    {
+        // block sizes, including the header; most of
+        // duktape's allocations are small objects,
+        // strings and property tables
+        size_t const k_list_size_classes[] = {
+            32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 2048
+        };
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // BlockHeader
+    // * stored before every allocation; size_class is
+    //   k_size_class_count for allocations from malloc
+    struct ScriptHeap::BlockHeader
+    {
+        size_t size;
+        size_t size_class;
+    };
+
+    struct ScriptHeap::FreeBlock
+    {
+        FreeBlock * next;
+    };
+
+    size_t const ScriptHeap::k_size_class_count;
+    size_t const ScriptHeap::k_chunk_size;
+
+    // ============================================================= //
+    // ============================================================= //
+
+    ScriptHeap::ScriptHeap() :
+        m_limit(0),
+        m_limit_enforced(false),
+        m_limit_hit(false)
+    {
+        static_assert(sizeof(k_list_size_classes)/sizeof(size_t) == k_size_class_count,
+                      "size class count mismatch");
+
+        for(size_t i=0; i < k_size_class_count; i++)   {
+            m_list_free[i] = nullptr;
+            m_list_chunk_pos[i] = nullptr;
+            m_list_chunk_end[i] = nullptr;
+        }
+    }
+
+    ScriptHeap::~ScriptHeap()
+    {
+        // large allocations are freed by the
+        // duktape heap before this
+        for(void * chunk : m_list_chunks)   {
+            std::free(chunk);
+        }
+    }
+
+    void ScriptHeap::SetLimit(size_t max_bytes)
+    {
+        m_limit = max_bytes;
+        m_stats.limit = max_bytes;
+    }
+
+    void ScriptHeap::SetLimitEnforced(bool enforced)
+    {
+        m_limit_enforced = enforced;
+    }
+
+    bool ScriptHeap::TakeLimitHit()
+    {
+        bool const limit_hit = m_limit_hit;
+        m_limit_hit = false;
+        return limit_hit;
+    }
+
+    ScriptHeapStats ScriptHeap::GetStats() const
+    {
+        return m_stats;
+    }
+
+    void ScriptHeap::ResetPeak()
+    {
+        m_stats.peak_bytes = m_stats.live_bytes;
+    }
+
+    void * ScriptHeap::Alloc(void * udata, size_t size)
+    {
+        return static_cast<ScriptHeap*>(udata)->alloc(size);
+    }
+
+    void * ScriptHeap::Realloc(void * udata, void * ptr, size_t size)
+    {
+        return static_cast<ScriptHeap*>(udata)->realloc(ptr,size);
+    }
+
+    void ScriptHeap::Free(void * udata, void * ptr)
+    {
+        static_cast<ScriptHeap*>(udata)->free(ptr);
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void * ScriptHeap::alloc(size_t size)
+    {
+        if(size == 0)   {
+            return nullptr;
+        }
+
+        size_t const block_size = size+sizeof(BlockHeader);
+        size_t const * size_class =
+                std::lower_bound(k_list_size_classes,
+                                 k_list_size_classes+k_size_class_count,
+                                 block_size);
+
+        BlockHeader * header = nullptr;
+        if(size_class != k_list_size_classes+k_size_class_count)   {
+            if(!reserve(*size_class))   {
+                return nullptr;
+            }
+            size_t const idx = size_t(size_class-k_list_size_classes);
+            header = static_cast<BlockHeader*>(allocFromPool(idx));
+            if(!header)   {
+                release(*size_class);
+                return nullptr;
+            }
+            header->size = *size_class;
+            header->size_class = idx;
+        }
+        else   {
+            if(!reserve(block_size))   {
+                return nullptr;
+            }
+            header = static_cast<BlockHeader*>(std::malloc(block_size));
+            if(!header)   {
+                release(block_size);
+                return nullptr;
+            }
+            header->size = block_size;
+            header->size_class = k_size_class_count;
+            m_stats.reserved_bytes += block_size;
+        }
+
+        return (header+1);
+    }
+
+    void * ScriptHeap::realloc(void * ptr, size_t size)
+    {
+        if(ptr == nullptr)   {
+            return alloc(size);
+        }
+        if(size == 0)   {
+            free(ptr);
+            return nullptr;
+        }
+
+        BlockHeader * header = static_cast<BlockHeader*>(ptr)-1;
+        size_t const block_size = size+sizeof(BlockHeader);
+        size_t const largest_class = k_list_size_classes[k_size_class_count-1];
+
+        if(header->size_class < k_size_class_count)   {
+            // still fits in the same block
+            if(block_size <= header->size)   {
+                return ptr;
+            }
+        }
+        else if(block_size > largest_class)   {
+            // resize a large allocation in place
+            size_t const prev_size = header->size;
+            if(block_size > prev_size && !reserve(block_size-prev_size))   {
+                return nullptr;
+            }
+            BlockHeader * resized =
+                    static_cast<BlockHeader*>(std::realloc(header,block_size));
+            if(!resized)   {
+                if(block_size > prev_size)   {
+                    release(block_size-prev_size);
+                }
+                return nullptr;
+            }
+            if(block_size < prev_size)   {
+                release(prev_size-block_size);
+            }
+            resized->size = block_size;
+            m_stats.reserved_bytes += block_size;
+            m_stats.reserved_bytes -= prev_size;
+            return (resized+1);
+        }
+
+        // move to a block of another size class
+        void * moved = alloc(size);
+        if(!moved)   {
+            return nullptr;
+        }
+        std::memcpy(moved,ptr,std::min(size,header->size-sizeof(BlockHeader)));
+        free(ptr);
+        return moved;
+    }
+
+    void ScriptHeap::free(void * ptr)
+    {
+        if(ptr == nullptr)   {
+            return;
+        }
+
+        BlockHeader * header = static_cast<BlockHeader*>(ptr)-1;
+        release(header->size);
+
+        if(header->size_class < k_size_class_count)   {
+            size_t const idx = header->size_class;
+            FreeBlock * block = reinterpret_cast<FreeBlock*>(header);
+            block->next = m_list_free[idx];
+            m_list_free[idx] = block;
+        }
+        else   {
+            m_stats.reserved_bytes -= header->size;
+            std::free(header);
+        }
+    }
+
+    bool ScriptHeap::reserve(size_t block_size)
+    {
+        if(m_limit_enforced && m_limit > 0 &&
+           m_stats.live_bytes+block_size > m_limit)   {
+            m_limit_hit = true;
+            m_stats.refused_allocs++;
+            return false;
+        }
+
+        m_stats.live_bytes += block_size;
+        m_stats.peak_bytes = std::max(m_stats.peak_bytes,m_stats.live_bytes);
+        return true;
+    }
+
+    void ScriptHeap::release(size_t block_size)
+    {
+        m_stats.live_bytes -= block_size;
+    }
+
+    void * ScriptHeap::allocFromPool(size_t size_class)
+    {
+        FreeBlock * block = m_list_free[size_class];
+        if(block)   {
+            m_list_free[size_class] = block->next;
+            return block;
+        }
+
+        size_t const block_size = k_list_size_classes[size_class];
+        if(m_list_chunk_pos[size_class] == nullptr ||
+           m_list_chunk_pos[size_class]+block_size > m_list_chunk_end[size_class])   {
+            // start a new chunk; the rest of
+            // the previous one is wasted
+            u8 * chunk = static_cast<u8*>(std::malloc(k_chunk_size));
+            if(!chunk)   {
+                return nullptr;
+            }
+            try {
+                // called from duktape, which can't
+                // handle exceptions
+                m_list_chunks.push_back(chunk);
+            }
+            catch(std::exception &)   {
+                std::free(chunk);
+                return nullptr;
+            }
+            m_list_chunk_pos[size_class] = chunk;
+            m_list_chunk_end[size_class] = chunk+k_chunk_size;
+            m_stats.reserved_bytes += k_chunk_size;
+        }
+
+        void * ptr = m_list_chunk_pos[size_class];
+        m_list_chunk_pos[size_class] += block_size;
+        return ptr;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
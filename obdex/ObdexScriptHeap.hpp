@@ -0,0 +1,129 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_SCRIPT_HEAP_HPP
+#define OBDEX_SCRIPT_HEAP_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    // ScriptHeapStats
+    // * live_bytes is the memory the engine has allocated,
+    //   rounded up to the size classes of the pools
+    // * peak_bytes is the highest live_bytes since the
+    //   heap was created or ResetPeak was called
+    // * reserved_bytes is the memory taken from the system:
+    //   pool chunks plus allocations too large for a pool
+    // * refused_allocs is the number of allocations that
+    //   failed because of the limit
+    struct ScriptHeapStats
+    {
+        ScriptHeapStats() :
+            live_bytes(0),
+            peak_bytes(0),
+            reserved_bytes(0),
+            limit(0),
+            refused_allocs(0)
+        {}
+
+        size_t live_bytes;
+        size_t peak_bytes;
+        size_t reserved_bytes;
+        size_t limit;
+        u64 refused_allocs;
+    };
+
+    // ScriptHeap
+    // * the allocator for a duktape heap; small allocations
+    //   come from pools with fixed size classes instead of
+    //   malloc, larger ones go to malloc directly
+    // * pool chunks are kept until the ScriptHeap is
+    //   destroyed and freed blocks are reused for
+    //   allocations of the same size class
+    // * not thread safe, like the duktape heap using it
+    class ScriptHeap
+    {
+    public:
+        ScriptHeap();
+        ~ScriptHeap();
+
+        ScriptHeap(ScriptHeap const &) = delete;
+        ScriptHeap & operator = (ScriptHeap const &) = delete;
+
+        // SetLimit
+        // * while the limit is enforced, allocations that
+        //   would take live_bytes over @max_bytes fail
+        // * zero removes the limit
+        void SetLimit(size_t max_bytes);
+
+        bool HasLimit() const
+        {
+            return (m_limit > 0);
+        }
+
+        // SetLimitEnforced
+        // * the limit is only applied while enforced so that
+        //   the owner can choose the allocations that are
+        //   allowed to fail (ie. the ones duktape can recover
+        //   from by throwing an error)
+        void SetLimitEnforced(bool enforced);
+
+        // TakeLimitHit
+        // * returns true if an allocation failed because of
+        //   the limit since the last call
+        bool TakeLimitHit();
+
+        ScriptHeapStats GetStats() const;
+
+        void ResetPeak();
+
+        // callbacks for duk_create_heap; @udata is
+        // the ScriptHeap
+        static void * Alloc(void * udata, size_t size);
+        static void * Realloc(void * udata, void * ptr, size_t size);
+        static void Free(void * udata, void * ptr);
+
+    private:
+        struct BlockHeader;
+        struct FreeBlock;
+
+        static size_t const k_size_class_count = 12;
+        static size_t const k_chunk_size = 16384;
+
+        void * alloc(size_t size);
+        void * realloc(void * ptr, size_t size);
+        void free(void * ptr);
+
+        bool reserve(size_t block_size);
+        void release(size_t block_size);
+        void * allocFromPool(size_t size_class);
+
+        // free blocks and the unused end of the
+        // current chunk for each size class
+        FreeBlock * m_list_free[k_size_class_count];
+        u8 * m_list_chunk_pos[k_size_class_count];
+        u8 * m_list_chunk_end[k_size_class_count];
+        std::vector<void*> m_list_chunks;
+
+        size_t m_limit;
+        bool m_limit_enforced;
+        bool m_limit_hit;
+        ScriptHeapStats m_stats;
+    };
+}
+
+#endif // OBDEX_SCRIPT_HEAP_HPP
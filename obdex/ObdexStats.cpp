@@ -0,0 +1,340 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexStats.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace obdex
+{
+    std::string GetParseStageName(ParseStage stage)
+    {
+        switch(stage)
+        {
+            case PARSE_STAGE_CLEAN:         return "clean";
+            case PARSE_STAGE_REASSEMBLY:    return "reassembly";
+            case PARSE_STAGE_JS_MARSHAL:    return "js_marshal";
+            case PARSE_STAGE_SCRIPT:        return "script";
+            case PARSE_STAGE_EXTRACT:       return "extract";
+            default:                        return "invalid";
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    LatencyHistogram::LatencyHistogram() :
+        m_count(0),
+        m_total_ns(0),
+        m_min_ns(std::numeric_limits<u64>::max()),
+        m_max_ns(0)
+    {
+        m_buckets.fill(0);
+    }
+
+    void LatencyHistogram::Add(u64 ns)
+    {
+        // bucket index is the position of the highest set bit
+        uint bucket=0;
+        for(u64 v=ns; v > 1; v >>= 1)   {
+            bucket++;
+        }
+        bucket = std::min(bucket,BUCKET_COUNT-1);
+
+        m_buckets[bucket]++;
+        m_count++;
+        m_total_ns += ns;
+        m_min_ns = std::min(m_min_ns,ns);
+        m_max_ns = std::max(m_max_ns,ns);
+    }
+
+    void LatencyHistogram::Merge(LatencyHistogram const &other)
+    {
+        for(uint i=0; i < BUCKET_COUNT; i++)   {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+        m_total_ns += other.m_total_ns;
+        m_min_ns = std::min(m_min_ns,other.m_min_ns);
+        m_max_ns = std::max(m_max_ns,other.m_max_ns);
+    }
+
+    u64 LatencyHistogram::GetCount() const
+    {
+        return m_count;
+    }
+
+    u64 LatencyHistogram::GetTotalNs() const
+    {
+        return m_total_ns;
+    }
+
+    u64 LatencyHistogram::GetMinNs() const
+    {
+        return (m_count == 0) ? 0 : m_min_ns;
+    }
+
+    u64 LatencyHistogram::GetMaxNs() const
+    {
+        return m_max_ns;
+    }
+
+    double LatencyHistogram::GetMeanNs() const
+    {
+        return (m_count == 0) ? 0 : double(m_total_ns)/m_count;
+    }
+
+    u64 LatencyHistogram::GetPercentileNs(double percentile) const
+    {
+        if(m_count == 0)   {
+            return 0;
+        }
+
+        percentile = std::max(0.0,std::min(100.0,percentile));
+        u64 rank = u64((percentile/100.0)*m_count+0.5);
+        rank = std::max(u64(1),std::min(m_count,rank));
+
+        u64 seen=0;
+        for(uint i=0; i < BUCKET_COUNT; i++)   {
+            seen += m_buckets[i];
+            if(seen >= rank)   {
+                u64 const upper = (u64(2) << i)-1;
+                return std::min(upper,m_max_ns);
+            }
+        }
+        return m_max_ns;
+    }
+
+    std::array<u64,LatencyHistogram::BUCKET_COUNT> const &
+    LatencyHistogram::GetBuckets() const
+    {
+        return m_buckets;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void ParseStats::Merge(ParseStats const &other)
+    {
+        calls += other.calls;
+        failures += other.failures;
+        total.Merge(other.total);
+        for(uint i=0; i < PARSE_STAGE_COUNT; i++)   {
+            list_stages[i].Merge(other.list_stages[i]);
+        }
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    namespace
+    {
+        s64 const k_never_warned = std::numeric_limits<s64>::min();
+
+        s64 GetSteadyTimeNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    std::string GetRejectReasonName(RejectReason reason)
+    {
+        switch(reason)
+        {
+            case REJECT_HEADER_MISMATCH:    return "header_mismatch";
+            case REJECT_PREFIX_MISMATCH:    return "prefix_mismatch";
+            case REJECT_BAD_PCI:            return "bad_pci";
+            case REJECT_SEQUENCE_GAP:       return "sequence_gap";
+            case REJECT_TRUNCATED_FRAME:    return "truncated_frame";
+            default:                        return "invalid";
+        }
+    }
+
+    FrameRejectCounters::FrameRejectCounters() :
+        m_warn_interval_ns(1000*1000*1000)
+    {
+        for(uint i=0; i < REJECT_REASON_COUNT; i++)   {
+            m_list_counts[i] = 0;
+            m_list_suppressed[i] = 0;
+            m_list_last_warn_ns[i] = k_never_warned;
+        }
+    }
+
+    bool FrameRejectCounters::Add(RejectReason reason, u64 &suppressed)
+    {
+        m_list_counts[reason].fetch_add(1,std::memory_order_relaxed);
+
+        s64 const interval_ns = m_warn_interval_ns.load(std::memory_order_relaxed);
+        if(interval_ns < 0)   {
+            return false;
+        }
+
+        // only the thread that moves the last warning
+        // time forward gets to log the warning
+        s64 const now_ns = GetSteadyTimeNs();
+        s64 last_ns = m_list_last_warn_ns[reason].load(std::memory_order_relaxed);
+        if((last_ns != k_never_warned && now_ns-last_ns < interval_ns) ||
+           !m_list_last_warn_ns[reason].compare_exchange_strong(last_ns,now_ns))
+        {
+            m_list_suppressed[reason].fetch_add(1,std::memory_order_relaxed);
+            return false;
+        }
+
+        suppressed = m_list_suppressed[reason].exchange(0,std::memory_order_relaxed);
+        return true;
+    }
+
+    u64 FrameRejectCounters::Get(RejectReason reason) const
+    {
+        return m_list_counts[reason].load(std::memory_order_relaxed);
+    }
+
+    std::array<u64,REJECT_REASON_COUNT> FrameRejectCounters::GetAll() const
+    {
+        std::array<u64,REJECT_REASON_COUNT> list_counts;
+        for(uint i=0; i < REJECT_REASON_COUNT; i++)   {
+            list_counts[i] = m_list_counts[i].load(std::memory_order_relaxed);
+        }
+        return list_counts;
+    }
+
+    void FrameRejectCounters::Reset()
+    {
+        for(uint i=0; i < REJECT_REASON_COUNT; i++)   {
+            m_list_counts[i] = 0;
+            m_list_suppressed[i] = 0;
+            m_list_last_warn_ns[i] = k_never_warned;
+        }
+    }
+
+    void FrameRejectCounters::SetWarningInterval(Milliseconds interval)
+    {
+        m_warn_interval_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    interval).count();
+    }
+
+    Milliseconds FrameRejectCounters::GetWarningInterval() const
+    {
+        return std::chrono::duration_cast<Milliseconds>(
+                    std::chrono::nanoseconds(m_warn_interval_ns.load()));
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    ParseStatsRecorder::ParseStatsRecorder() :
+        m_depth(0),
+        m_frame_function_idx(-1),
+        m_frame_protocol(nullptr)
+    {
+        m_frame_stage_ns.fill(0);
+        m_frame_stage_seen.fill(false);
+    }
+
+    void ParseStatsRecorder::BeginFrame(sint function_idx,
+                                        std::string const &protocol)
+    {
+        m_depth++;
+        if(m_depth > 1)   {
+            return;
+        }
+
+        m_frame_function_idx = function_idx;
+        m_frame_protocol = &protocol;
+        m_frame_stage_ns.fill(0);
+        m_frame_stage_seen.fill(false);
+        m_frame_start = Clock::now();
+    }
+
+    void ParseStatsRecorder::EndFrame(bool ok)
+    {
+        m_depth--;
+        if(m_depth > 0)   {
+            return;
+        }
+
+        u64 const total_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now()-m_frame_start).count();
+
+        ParseStats frame_stats;
+        frame_stats.calls = 1;
+        frame_stats.failures = ok ? 0 : 1;
+        frame_stats.total.Add(total_ns);
+        for(uint i=0; i < PARSE_STAGE_COUNT; i++)   {
+            if(m_frame_stage_seen[i])   {
+                frame_stats.list_stages[i].Add(m_frame_stage_ns[i]);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_all.Merge(frame_stats);
+
+        if(m_frame_function_idx >= 0)   {
+            uint const idx = uint(m_frame_function_idx);
+            if(idx >= m_list_param_stats.size())   {
+                m_list_param_stats.resize(idx+1);
+            }
+            m_list_param_stats[idx].Merge(frame_stats);
+        }
+
+        m_lkup_protocol_stats[*m_frame_protocol].Merge(frame_stats);
+        m_frame_protocol = nullptr;
+    }
+
+    void ParseStatsRecorder::AddStageTime(ParseStage stage, u64 ns)
+    {
+        if(m_depth == 0)   {
+            return;
+        }
+        m_frame_stage_ns[stage] += ns;
+        m_frame_stage_seen[stage] = true;
+    }
+
+    ParseStatsSnapshot
+    ParseStatsRecorder::GetSnapshot(std::vector<std::string> const &list_param_keys) const
+    {
+        ParseStatsSnapshot snapshot;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        snapshot.all = m_all;
+
+        for(uint i=0; i < m_list_param_stats.size(); i++)   {
+            if(m_list_param_stats[i].calls == 0 ||
+               i >= list_param_keys.size())   {
+                continue;
+            }
+            snapshot.lkup_params[list_param_keys[i]].Merge(m_list_param_stats[i]);
+        }
+
+        for(auto const &it : m_lkup_protocol_stats)   {
+            snapshot.lkup_protocols[it.first] = it.second;
+        }
+
+        return snapshot;
+    }
+
+    void ParseStatsRecorder::Reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_all = ParseStats();
+        m_list_param_stats.clear();
+        m_lkup_protocol_stats.clear();
+    }
+}
@@ -0,0 +1,319 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_STATS_HPP
+#define OBDEX_STATS_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+// Parse stats are only recorded if OBDEX_ENABLE_STATS is
+// defined when building the library (qmake CONFIG+=obdex_stats);
+// otherwise the OBDEX_STATS_[...] macros expand to nothing and
+// Parser::GetParseStats always returns an empty snapshot
+
+#define OBDEX_STATS_CONCAT_IMPL(a,b) a##b
+#define OBDEX_STATS_CONCAT(a,b) OBDEX_STATS_CONCAT_IMPL(a,b)
+
+#ifdef OBDEX_ENABLE_STATS
+
+    // OBDEX_STATS_FRAME
+    // * starts recording a ParameterFrame with parse
+    //   function @function_idx and @protocol for the rest
+    //   of the enclosing scope; the frame counts as failed
+    //   unless OBDEX_STATS_FRAME_OK is reached
+    #define OBDEX_STATS_FRAME(recorder,function_idx,protocol) \
+        obdex::ParseStatsFrameScope obdex_stats_frame(recorder,function_idx,protocol)
+
+    #define OBDEX_STATS_FRAME_OK() \
+        obdex_stats_frame.SetOk()
+
+    // OBDEX_STATS_STAGE
+    // * adds the time until the end of the enclosing
+    //   scope to @stage of the frame being recorded
+    #define OBDEX_STATS_STAGE(recorder,stage) \
+        obdex::ParseStatsStageTimer \
+        OBDEX_STATS_CONCAT(obdex_stats_stage_,__LINE__)(recorder,stage)
+
+#else
+
+    #define OBDEX_STATS_FRAME(recorder,function_idx,protocol) static_cast<void>(0)
+    #define OBDEX_STATS_FRAME_OK() static_cast<void>(0)
+    #define OBDEX_STATS_STAGE(recorder,stage) static_cast<void>(0)
+
+#endif
+
+namespace obdex
+{
+    // ParseStage
+    // * the steps ParseParameterFrame goes through
+    enum ParseStage
+    {
+        PARSE_STAGE_CLEAN,      // header/prefix checks
+        PARSE_STAGE_REASSEMBLY, // merging multi-frame messages
+        PARSE_STAGE_JS_MARSHAL, // copying data into the script engine
+        PARSE_STAGE_SCRIPT,     // running the parse script
+        PARSE_STAGE_EXTRACT,    // reading results from the script engine
+        PARSE_STAGE_COUNT
+    };
+
+    std::string GetParseStageName(ParseStage stage);
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // LatencyHistogram
+    // * counts durations in power of two buckets; bucket
+    //   N holds durations in [2^N,2^(N+1)) nanoseconds
+    //   (bucket 0 also holds zero)
+    class LatencyHistogram
+    {
+    public:
+        static uint const BUCKET_COUNT = 40;
+
+        LatencyHistogram();
+
+        void Add(u64 ns);
+
+        void Merge(LatencyHistogram const &other);
+
+        u64 GetCount() const;
+        u64 GetTotalNs() const;
+        u64 GetMinNs() const;
+        u64 GetMaxNs() const;
+        double GetMeanNs() const;
+
+        // GetPercentileNs
+        // * returns an upper bound on the @percentile
+        //   [0,100] duration; this is the upper edge of
+        //   the bucket it falls in, clamped to GetMaxNs
+        u64 GetPercentileNs(double percentile) const;
+
+        std::array<u64,BUCKET_COUNT> const & GetBuckets() const;
+
+    private:
+        std::array<u64,BUCKET_COUNT> m_buckets;
+        u64 m_count;
+        u64 m_total_ns;
+        u64 m_min_ns;
+        u64 m_max_ns;
+    };
+
+    // ParseStats
+    // * call and failure counts for a set of
+    //   parsed frames along with the time taken
+    //   by each frame, in total and per stage
+    // * stages a frame didn't go through (ie.
+    //   reassembly, which only applies to ISO 15765)
+    //   are not added to that stage's histogram
+    struct ParseStats
+    {
+        ParseStats() :
+            calls(0),
+            failures(0)
+        {}
+
+        void Merge(ParseStats const &other);
+
+        u64 calls;
+        u64 failures;
+        LatencyHistogram total;
+        std::array<LatencyHistogram,PARSE_STAGE_COUNT> list_stages;
+    };
+
+    // ParseStatsSnapshot
+    // * lkup_params is keyed by parse function, ie.
+    //   "spec:address:parameter:protocols"
+    // * lkup_protocols is keyed by protocol name
+    struct ParseStatsSnapshot
+    {
+        ParseStats all;
+        std::map<std::string,ParseStats> lkup_params;
+        std::map<std::string,ParseStats> lkup_protocols;
+    };
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // RejectReason
+    // * why a raw frame was dropped while cleaning
+    enum RejectReason
+    {
+        REJECT_HEADER_MISMATCH,     // header didn't match the expected bytes
+        REJECT_PREFIX_MISMATCH,     // data didn't start with the expected prefix
+        REJECT_BAD_PCI,             // invalid ISO 15765 PCI byte
+        REJECT_SEQUENCE_GAP,        // ISO 15765 message with missing frames
+        REJECT_TRUNCATED_FRAME,     // frame shorter than its header or length
+        REJECT_REASON_COUNT
+    };
+
+    std::string GetRejectReasonName(RejectReason reason);
+
+    // FrameRejectCounters
+    // * counts rejected frames for each RejectReason; unlike
+    //   ParseStats these are always recorded
+    // * Add may be called from any number of threads
+    class FrameRejectCounters
+    {
+    public:
+        FrameRejectCounters();
+
+        // Add
+        // * counts a rejected frame
+        // * returns true if a warning should be logged for
+        //   it, which is at most once per warning interval
+        //   for each reason; @suppressed is set to the number
+        //   of frames rejected for @reason without a warning
+        //   since the last one
+        bool Add(RejectReason reason, u64 &suppressed);
+
+        u64 Get(RejectReason reason) const;
+
+        std::array<u64,REJECT_REASON_COUNT> GetAll() const;
+
+        void Reset();
+
+        // SetWarningInterval
+        // * zero logs a warning for every rejected frame,
+        //   a negative interval disables warnings
+        void SetWarningInterval(Milliseconds interval);
+
+        Milliseconds GetWarningInterval() const;
+
+    private:
+        std::array<std::atomic<u64>,REJECT_REASON_COUNT> m_list_counts;
+        std::array<std::atomic<u64>,REJECT_REASON_COUNT> m_list_suppressed;
+        std::array<std::atomic<s64>,REJECT_REASON_COUNT> m_list_last_warn_ns;
+        std::atomic<s64> m_warn_interval_ns;
+    };
+
+    // ============================================================= //
+    // ============================================================= //
+
+    // ParseStatsRecorder
+    // * collects ParseStats for a Parser
+    // * frames are recorded by the parsing thread;
+    //   GetSnapshot and Reset may be called from
+    //   any thread
+    class ParseStatsRecorder
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        ParseStatsRecorder();
+
+        // BeginFrame, EndFrame
+        // * nested calls (ie. ParseParameterFrame calling
+        //   CleanParameterFrame) are part of the outermost
+        //   frame
+        // * @protocol must stay valid until EndFrame
+        void BeginFrame(sint function_idx,
+                        std::string const &protocol);
+        void EndFrame(bool ok);
+
+        // AddStageTime
+        // * adds @ns to @stage of the current frame
+        void AddStageTime(ParseStage stage, u64 ns);
+
+        // GetSnapshot
+        // * @list_param_keys maps parse function indices
+        //   to the keys used in lkup_params
+        ParseStatsSnapshot
+        GetSnapshot(std::vector<std::string> const &list_param_keys) const;
+
+        void Reset();
+
+    private:
+        // current frame
+        uint m_depth;
+        Clock::time_point m_frame_start;
+        sint m_frame_function_idx;
+        std::string const * m_frame_protocol;
+        std::array<u64,PARSE_STAGE_COUNT> m_frame_stage_ns;
+        std::array<bool,PARSE_STAGE_COUNT> m_frame_stage_seen;
+
+        // recorded frames
+        mutable std::mutex m_mutex;
+        ParseStats m_all;
+        std::vector<ParseStats> m_list_param_stats;
+        std::unordered_map<std::string,ParseStats> m_lkup_protocol_stats;
+    };
+
+    // ParseStatsFrameScope
+    // * calls BeginFrame on construction and
+    //   EndFrame on destruction
+    class ParseStatsFrameScope
+    {
+    public:
+        ParseStatsFrameScope(ParseStatsRecorder &recorder,
+                             sint function_idx,
+                             std::string const &protocol) :
+            m_recorder(recorder),
+            m_ok(false)
+        {
+            m_recorder.BeginFrame(function_idx,protocol);
+        }
+
+        ~ParseStatsFrameScope()
+        {
+            m_recorder.EndFrame(m_ok);
+        }
+
+        void SetOk()
+        {
+            m_ok = true;
+        }
+
+    private:
+        ParseStatsRecorder &m_recorder;
+        bool m_ok;
+    };
+
+    // ParseStatsStageTimer
+    // * adds the time between construction and
+    //   destruction to a stage of the current frame
+    class ParseStatsStageTimer
+    {
+    public:
+        ParseStatsStageTimer(ParseStatsRecorder &recorder,
+                             ParseStage stage) :
+            m_recorder(recorder),
+            m_stage(stage),
+            m_start(ParseStatsRecorder::Clock::now())
+        {}
+
+        ~ParseStatsStageTimer()
+        {
+            auto const elapsed = ParseStatsRecorder::Clock::now()-m_start;
+            m_recorder.AddStageTime(
+                        m_stage,
+                        std::chrono::duration_cast<
+                            std::chrono::nanoseconds>(elapsed).count());
+        }
+
+    private:
+        ParseStatsRecorder &m_recorder;
+        ParseStage const m_stage;
+        ParseStatsRecorder::Clock::time_point const m_start;
+    };
+}
+
+#endif // OBDEX_STATS_HPP
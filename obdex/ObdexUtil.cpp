@@ -16,15 +16,136 @@
 
 #include <obdex/ObdexUtil.hpp>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <clocale>
 #include <algorithm>
 
 namespace obdex
 {
+    namespace
+    {
+        char const k_digits_lower[] = "0123456789abcdef";
+        char const k_digits_upper[] = "0123456789ABCDEF";
+
+        // printf into a small stack buffer, only falling
+        // back to writing into @str for very long results
+        // * %g and %f use the C locale's decimal point, which
+        //   is replaced with '.' so the result always matches
+        //   the classic locale (like ostringstream did)
+        template<typename T>
+        void AppendPrintf(std::string &str,
+                          char const * format,
+                          int precision,
+                          T val)
+        {
+            size_t const start = str.size();
+
+            char buf[64];
+            int const len = std::snprintf(buf,sizeof(buf),format,precision,val);
+            if(len < 0)   {
+                return;
+            }
+            if(size_t(len) < sizeof(buf))   {
+                str.append(buf,size_t(len));
+            }
+            else   {
+                str.resize(start+size_t(len)+1);
+                std::snprintf(&str[start],size_t(len)+1,format,precision,val);
+                str.resize(start+size_t(len));
+            }
+
+            char const * point = std::localeconv()->decimal_point;
+            if(point[0] == '.' && point[1] == '\0')   {
+                return;
+            }
+
+            size_t const point_length = std::strlen(point);
+            size_t const pos = str.find(point,start,point_length);
+            if(point_length > 0 && pos != std::string::npos)   {
+                str.replace(pos,point_length,1,'.');
+            }
+        }
+    }
+
+    size_t FormatUInt(char * buf, u64 val)
+    {
+        // write the digits backwards then reverse them
+        size_t len=0;
+        do {
+            buf[len++] = char('0'+(val%10));
+            val /= 10;
+        }
+        while(val > 0);
+
+        std::reverse(buf,buf+len);
+        return len;
+    }
+
+    size_t FormatInt(char * buf, s64 val)
+    {
+        if(val >= 0)   {
+            return FormatUInt(buf,u64(val));
+        }
+
+        // negate as unsigned so the minimum value works
+        buf[0] = '-';
+        return 1+FormatUInt(buf+1,u64(0)-u64(val));
+    }
+
+    size_t FormatHex(char * buf, u64 val, bool uppercase, uint width)
+    {
+        char const * digits = uppercase ? k_digits_upper : k_digits_lower;
+        width = std::min(width,16u);
+
+        size_t len=0;
+        do {
+            buf[len++] = digits[val & 0xF];
+            val >>= 4;
+        }
+        while(val > 0);
+
+        while(len < width)   {
+            buf[len++] = '0';
+        }
+
+        std::reverse(buf,buf+len);
+        return len;
+    }
+
+    void AppendUInt(std::string &str, u64 val)
+    {
+        char buf[k_format_int_chars];
+        str.append(buf,FormatUInt(buf,val));
+    }
+
+    void AppendInt(std::string &str, s64 val)
+    {
+        char buf[k_format_int_chars];
+        str.append(buf,FormatInt(buf,val));
+    }
+
+    void AppendHex(std::string &str, u64 val, bool uppercase, uint width)
+    {
+        char buf[k_format_int_chars];
+        str.append(buf,FormatHex(buf,val,uppercase,width));
+    }
+
+    void AppendDouble(std::string &str, double val)
+    {
+        AppendPrintf(str,"%.*g",6,val);
+    }
+
+    void AppendFixed(std::string &str, double val, uint precision)
+    {
+        AppendPrintf(str,"%.*f",int(precision),val);
+    }
+
     std::string ToHexString(uint val)
     {
-        std::stringstream oss;
-        oss << std::hex << val;
-        return oss.str();
+        std::string str;
+        AppendHex(str,val);
+        return str;
     }
 
     void PrependString(std::string& target,
@@ -21,18 +21,131 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <type_traits>
 
 namespace obdex
 {
+    // Format[...]
+    // * writes the text for a number to @buf without using
+    //   streams or allocating and returns its length; @buf
+    //   must have room for at least k_format_int_chars
+    // * FormatHex pads with zeros up to @width digits (at
+    //   most 16)
+    size_t const k_format_int_chars = 24;
+
+    size_t FormatUInt(char * buf, u64 val);
+    size_t FormatInt(char * buf, s64 val);
+    size_t FormatHex(char * buf, u64 val, bool uppercase=false, uint width=0);
+
+    // Append[...]
+    // * appends the text for a number to @str without using
+    //   streams; @str only allocates if it has to grow
+    // * AppendDouble matches the default ostream format
+    //   (%g, 6 significant digits) and AppendFixed matches
+    //   std::fixed with @precision
+    void AppendUInt(std::string &str, u64 val);
+    void AppendInt(std::string &str, s64 val);
+    void AppendHex(std::string &str, u64 val, bool uppercase=false, uint width=0);
+    void AppendDouble(std::string &str, double val);
+    void AppendFixed(std::string &str, double val, uint precision);
+
+    namespace detail
+    {
+        // integer types formatted as numbers; the char
+        // types are written as characters by ostreams
+        template<typename T>
+        struct IsFormattedInt
+        {
+            static bool const value =
+                    std::is_integral<T>::value &&
+                    !std::is_same<T,char>::value &&
+                    !std::is_same<T,signed char>::value &&
+                    !std::is_same<T,unsigned char>::value &&
+                    !std::is_same<T,wchar_t>::value &&
+                    !std::is_same<T,char16_t>::value &&
+                    !std::is_same<T,char32_t>::value;
+        };
+    }
+
+    /// * Appends @val to @str the same way ToString would
+    /// * Numbers are formatted with the Append[...] functions;
+    ///   anything else goes through an ostringstream
+    template<typename T>
+    typename std::enable_if<
+        detail::IsFormattedInt<T>::value && std::is_signed<T>::value>::type
+    AppendString(std::string &str, T const &val)
+    {
+        AppendInt(str,s64(val));
+    }
+
+    template<typename T>
+    typename std::enable_if<
+        detail::IsFormattedInt<T>::value && !std::is_signed<T>::value>::type
+    AppendString(std::string &str, T const &val)
+    {
+        AppendUInt(str,u64(val));
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type
+    AppendString(std::string &str, T const &val)
+    {
+        AppendDouble(str,double(val));
+    }
+
+    template<typename T>
+    typename std::enable_if<
+        !detail::IsFormattedInt<T>::value && !std::is_floating_point<T>::value>::type
+    AppendString(std::string &str, T const &val)
+    {
+        std::ostringstream oss;
+        oss << val;
+        str.append(oss.str());
+    }
+
+    inline void AppendString(std::string &str, std::string const &val)
+    {
+        str.append(val);
+    }
+
+    inline void AppendString(std::string &str, char const * val)
+    {
+        str.append(val);
+    }
+
     /// * Converts common types to std::string
     /// * Included instead of using std::to_string because the latter
     ///   is missing on Android
     template<typename T>
     std::string ToString(T const &val)
     {
-        std::ostringstream oss;
-        oss << val;
-        return oss.str();
+        std::string str;
+        AppendString(str,val);
+        return str;
+    }
+
+    namespace detail
+    {
+        template<typename T>
+        typename std::enable_if<!std::is_arithmetic<T>::value>::type
+        AppendFormat(std::string &str, T const &val, uint precision)
+        {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(precision) << val;
+            str.append(oss.str());
+        }
+
+        template<typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value>::type
+        AppendFormat(std::string &str, T const &val, uint precision)
+        {
+            if(std::is_floating_point<T>::value)   {
+                AppendFixed(str,double(val),precision);
+            }
+            else   {
+                AppendString(str,val);
+            }
+        }
     }
 
     template<typename T>
@@ -41,12 +154,14 @@ namespace obdex
                                uint width,
                                char fill)
     {
-        std::ostringstream oss;
-        oss << std::fixed
-            << std::setw(width)
-            << std::setfill(fill)
-            << std::setprecision(precision) << val;
-        return oss.str();
+        // same as std::fixed, std::setw, std::setfill
+        // and std::setprecision (right aligned)
+        std::string str;
+        detail::AppendFormat(str,val,precision);
+        if(str.size() < width)   {
+            str.insert(0,width-str.size(),fill);
+        }
+        return str;
     }
 
     template<typename T>
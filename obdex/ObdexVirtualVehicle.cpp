@@ -0,0 +1,520 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexVirtualVehicle.hpp>
+#include <obdex/ObdexErrors.hpp>
+
+#include <algorithm>
+
+namespace obdex
+{
+    // ============================================================= //
+    // ============================================================= //
+
+    std::vector<ByteList>
+    SplitISO15765Frames(ByteList const &header,
+                        ByteList const &data,
+                        bool const pad,
+                        ubyte const pad_byte)
+    {
+        std::vector<ByteList> list_frames;
+
+        if(data.size() > 0xFFF)   {
+            throw BuildParamFrameFailed(
+                        "ISO 15765, invalid data "
+                        "length ( > 4095)");
+        }
+
+        auto add_frame = [&](ByteList const &pci,
+                             ByteList::const_iterator begin,
+                             ByteList::const_iterator end)
+        {
+            ByteList frame = header;
+            frame.insert(frame.end(),pci.begin(),pci.end());
+            frame.insert(frame.end(),begin,end);
+            if(pad)   {
+                while(frame.size() < header.size()+8)   {
+                    frame.push_back(pad_byte);
+                }
+            }
+            list_frames.push_back(std::move(frame));
+        };
+
+        if(data.size() <= 7)   {
+            // (single frame)
+            // [0000 LLLL] [d0 ... d6]
+            add_frame(ByteList{ubyte(data.size())},data.begin(),data.end());
+            return list_frames;
+        }
+
+        // (first frame)
+        // [0001 LLLL] [LLLL LLLL] [d0 ... d5]
+        ByteList const ff_pci {
+            ubyte(0x10 | ((data.size() >> 8) & 0x0F)),
+            ubyte(data.size() & 0xFF)
+        };
+        add_frame(ff_pci,data.begin(),data.begin()+6);
+
+        // (consecutive frames)
+        // [0010 NNNN] [d0 ... d6], N cycles 1-F,0-F...
+        uint sn = 1;
+        for(uint i=6; i < data.size(); i+=7)   {
+            uint const end = std::min(uint(data.size()),i+7);
+            add_frame(ByteList{ubyte(0x20 | (sn & 0x0F))},
+                      data.begin()+i,data.begin()+end);
+            sn++;
+        }
+
+        return list_frames;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    VirtualVehicle::VirtualVehicle(Protocol const protocol,
+                                   bool const iso15765_extended_id,
+                                   u32 const seed) :
+        m_protocol(protocol),
+        m_iso15765_extended_id(iso15765_extended_id),
+        m_pad_frames(false),
+        m_iso14230_header_length(0),
+        m_response_data_length(-1),
+        m_min_latency(0),
+        m_max_latency(0),
+        m_drop_rate(0),
+        m_corrupt_rate(0),
+        m_dropped_frame_count(0),
+        m_corrupted_frame_count(0),
+        m_random_gen(seed)
+    {}
+
+    // ============================================================= //
+    // ============================================================= //
+
+    uint VirtualVehicle::AddEcu(u32 const address)
+    {
+        Ecu ecu;
+        ecu.address = address;
+        m_list_ecus.push_back(ecu);
+
+        return m_list_ecus.size()-1;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void VirtualVehicle::SetResponse(uint const ecu_idx,
+                                     ByteList const &req_data,
+                                     ByteList const &resp_data)
+    {
+        m_list_ecus.at(ecu_idx).map_responses[req_data] = resp_data;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void VirtualVehicle::SetLatency(Microseconds const min_latency,
+                                    Microseconds const max_latency)
+    {
+        m_min_latency = min_latency;
+        m_max_latency = std::max(min_latency,max_latency);
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void VirtualVehicle::SetErrorRates(double const drop_rate,
+                                       double const corrupt_rate)
+    {
+        m_drop_rate = drop_rate;
+        m_corrupt_rate = corrupt_rate;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void VirtualVehicle::SetPadFrames(bool const pad_frames)
+    {
+        m_pad_frames = pad_frames;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void VirtualVehicle::SetISO14230HeaderLength(uint const header_length)
+    {
+        m_iso14230_header_length = header_length;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    void VirtualVehicle::SetResponseDataLength(sint const length)
+    {
+        m_response_data_length = length;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    Microseconds VirtualVehicle::Respond(ParameterFrame &param_frame)
+    {
+        Microseconds elapsed(0);
+
+        std::uniform_int_distribution<s64> dist_latency(
+                    m_min_latency.count(),m_max_latency.count());
+
+        std::uniform_real_distribution<double> dist_error(0.0,1.0);
+
+        for(auto &msg : param_frame.list_message_data)
+        {
+            ByteList const req_data = getRequestData(param_frame,msg);
+
+            // responses from each ECU, in the order they arrive
+            std::vector<std::pair<Microseconds,std::vector<ByteList>>> list_responses;
+
+            for(uint i=0; i < m_list_ecus.size(); i++)
+            {
+                if(isAddressedToOtherEcu(msg,i))   {
+                    continue;
+                }
+
+                ByteList resp_data;
+                if(!getResponseData(m_list_ecus[i],msg,req_data,resp_data))   {
+                    continue;
+                }
+
+                list_responses.emplace_back(
+                            Microseconds(dist_latency(m_random_gen)),
+                            buildFrames(m_list_ecus[i],msg,resp_data));
+            }
+
+            std::stable_sort(list_responses.begin(),list_responses.end(),
+                             [](std::pair<Microseconds,std::vector<ByteList>> const &a,
+                                std::pair<Microseconds,std::vector<ByteList>> const &b) {
+                                 return (a.first < b.first);
+                             });
+
+            elapsed += Milliseconds(msg.req_data_delay_ms);
+            if(!list_responses.empty())   {
+                elapsed += list_responses.back().first;
+            }
+
+            // save the frames
+            for(auto &response : list_responses)   {
+                for(auto &frame : response.second)   {
+                    if(m_drop_rate > 0 && dist_error(m_random_gen) < m_drop_rate)   {
+                        m_dropped_frame_count++;
+                        continue;
+                    }
+                    if(m_corrupt_rate > 0 && dist_error(m_random_gen) < m_corrupt_rate)   {
+                        std::uniform_int_distribution<uint> dist_idx(0,frame.size()-1);
+                        std::uniform_int_distribution<uint> dist_bits(1,255);
+                        frame[dist_idx(m_random_gen)] ^= ubyte(dist_bits(m_random_gen));
+                        m_corrupted_frame_count++;
+                    }
+                    msg.list_raw_frames.push_back(std::move(frame));
+                }
+            }
+        }
+
+        return elapsed;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    u64 VirtualVehicle::GetDroppedFrameCount() const
+    {
+        return m_dropped_frame_count;
+    }
+
+    u64 VirtualVehicle::GetCorruptedFrameCount() const
+    {
+        return m_corrupted_frame_count;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    ByteList VirtualVehicle::getRequestData(ParameterFrame const &param_frame,
+                                            MessageData const &msg) const
+    {
+        ByteList req_data;
+
+        auto const &list_req_frames = msg.list_req_data_bytes;
+        for(uint i=0; i < list_req_frames.size(); i++)
+        {
+            // remove the pci bytes: two for the first
+            // frame of a multi-frame request, otherwise one
+            uint offset = 0;
+            if(m_protocol == PROTOCOL_ISO_15765 &&
+               param_frame.iso15765_add_pci_byte)   {
+                offset = (i == 0 && list_req_frames.size() > 1) ? 2 : 1;
+            }
+
+            if(list_req_frames[i].size() > offset)   {
+                req_data.insert(req_data.end(),
+                                list_req_frames[i].begin()+offset,
+                                list_req_frames[i].end());
+            }
+        }
+
+        return req_data;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    bool VirtualVehicle::isAddressedToOtherEcu(MessageData const &msg,
+                                               uint const ecu_idx) const
+    {
+        ByteList const &header = msg.req_header_bytes;
+
+        // get the request's target as an ECU address
+        u32 target;
+        if(m_protocol == PROTOCOL_ISO_15765)   {
+            if(!m_iso15765_extended_id)   {
+                // [0000 0III] [IIII IIII]
+                // physical requests use the response id-8
+                if(header.size() < 2)   {
+                    return false;
+                }
+                target = ((u32(header[0]) << 8) | header[1]) + 8;
+            }
+            else   {
+                // [prio] [format] [target] [source]
+                if(header.size() < 4)   {
+                    return false;
+                }
+                target = header[2];
+            }
+        }
+        else   {
+            // [prio/format] [target] [source]
+            if(header.size() < 3)   {
+                return false;
+            }
+            target = header[1];
+        }
+
+        for(uint i=0; i < m_list_ecus.size(); i++)   {
+            if(m_list_ecus[i].address == target)   {
+                return (i != ecu_idx);
+            }
+        }
+
+        return false;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    bool VirtualVehicle::getResponseData(Ecu const &ecu,
+                                         MessageData const &msg,
+                                         ByteList const &req_data,
+                                         ByteList &resp_data)
+    {
+        // an ECU with set responses only answers those
+        if(!ecu.map_responses.empty())
+        {
+            auto it = ecu.map_responses.find(req_data);
+            if(it != ecu.map_responses.end())   {
+                resp_data = it->second;
+                return true;
+            }
+
+            // [0x01] [pid0] [pid1] ... is answered with
+            // [0x41] [pid0] [data] [pid1] [data] ...
+            // for the PIDs this ECU supports
+            if(req_data.size() > 2 && req_data[0] == 0x01)
+            {
+                resp_data.clear();
+                resp_data.push_back(0x41);
+
+                for(uint i=1; i < req_data.size(); i++)   {
+                    it = ecu.map_responses.find(ByteList{0x01,req_data[i]});
+                    if(it != ecu.map_responses.end() &&
+                       it->second.size() > 1)   {
+                        resp_data.insert(resp_data.end(),
+                                         it->second.begin()+1,
+                                         it->second.end());
+                    }
+                }
+
+                return (resp_data.size() > 1);
+            }
+
+            return false;
+        }
+
+        // random data after the expected prefix
+        sint byte_count = (msg.exp_data_byte_count >= 0) ?
+                    msg.exp_data_byte_count : 4;
+
+        if(m_response_data_length >= 0)   {
+            byte_count = m_response_data_length-sint(msg.exp_data_prefix.size());
+        }
+
+        std::uniform_int_distribution<uint> dist_byte(0,255);
+
+        resp_data = msg.exp_data_prefix;
+        for(sint i=0; i < byte_count; i++)   {
+            resp_data.push_back(ubyte(dist_byte(m_random_gen)));
+        }
+
+        return true;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+
+    std::vector<ByteList> VirtualVehicle::buildFrames(Ecu const &ecu,
+                                                      MessageData const &msg,
+                                                      ByteList const &resp_data)
+    {
+        ByteList const &exp_header = msg.exp_header_bytes;
+        ByteList const &exp_mask = msg.exp_header_mask;
+
+        // use the expected header byte where the mask
+        // requires one and a typical value otherwise
+        auto header_byte = [&](uint const idx, ubyte const value) -> ubyte
+        {
+            if(idx < exp_header.size() && idx < exp_mask.size())   {
+                return (exp_header[idx] & exp_mask[idx]) |
+                        (value & ~exp_mask[idx]);
+            }
+            return value;
+        };
+
+        // the tester's address, which the response is sent to
+        ByteList const &req_header = msg.req_header_bytes;
+        ubyte tester = 0xF1;
+
+        std::vector<ByteList> list_frames;
+
+        if(m_protocol == PROTOCOL_ISO_15765)
+        {
+            ByteList header;
+            if(!m_iso15765_extended_id)   {
+                // [0000 0III] [IIII IIII]
+                header.push_back(ubyte((ecu.address >> 8) & 0x07));
+                header.push_back(ubyte(ecu.address & 0xFF));
+            }
+            else   {
+                // [prio] [format] [target] [source]
+                if(req_header.size() > 3)   {
+                    tester = req_header[3];
+                }
+                header.push_back(header_byte(0,0x18));
+                header.push_back(header_byte(1,0xDA));
+                header.push_back(header_byte(2,tester));
+                header.push_back(ubyte(ecu.address));
+            }
+
+            return SplitISO15765Frames(header,resp_data,m_pad_frames);
+        }
+        else if(m_protocol == PROTOCOL_ISO_14230)
+        {
+            // [format] [target] [source] with the length in
+            // the format byte or [format] [target] [source] [length]
+            if(req_header.size() > 2)   {
+                tester = req_header[2];
+            }
+
+            if(resp_data.size() > 0xFF)   {
+                throw BuildParamFrameFailed(
+                            "ISO 14230, invalid data "
+                            "length ( > 255)");
+            }
+            ubyte const length = ubyte(resp_data.size());
+
+            // the length only fits in [format] up to 63 bytes,
+            // longer responses get a separate length byte
+            uint header_length = m_iso14230_header_length;
+            if(header_length == 0)   {
+                header_length = 3;
+            }
+            if(length > 0x3F && (header_length == 1 || header_length == 3))   {
+                header_length++;
+            }
+
+            // [format] and [format] [length] headers
+            // don't have address bytes
+            ByteList header;
+            if(header_length == 1)   {
+                header.push_back(length);
+            }
+            else if(header_length == 2)   {
+                header.push_back(0x00);
+                header.push_back(length);
+            }
+            else   {
+                header.push_back(header_byte(0,0x80) & 0xC0);
+                header.push_back(header_byte(1,tester));
+                header.push_back(ubyte(ecu.address));
+
+                if(header_length == 3)   {
+                    header[0] |= length;
+                }
+                else   {
+                    header.push_back(length);
+                }
+            }
+
+            ByteList frame = header;
+            frame.insert(frame.end(),resp_data.begin(),resp_data.end());
+            list_frames.push_back(std::move(frame));
+        }
+        else
+        {
+            // [prio] [target] [source]
+            if(req_header.size() > 2)   {
+                tester = req_header[2];
+            }
+
+            ByteList header;
+            header.push_back(header_byte(0,0x48));
+            header.push_back(header_byte(1,tester));
+            header.push_back(ubyte(ecu.address));
+
+            // legacy frames carry at most seven data bytes, so
+            // longer responses are split like SAE J1979 sends
+            // them (ie. mode 0x09): each frame repeats the
+            // expected prefix followed by its share of the data
+            uint const prefix_size = std::min(msg.exp_data_prefix.size(),resp_data.size());
+            uint const chunk_size = (prefix_size < 7) ? 7-prefix_size : 1;
+
+            uint i = prefix_size;
+            do {
+                uint const end = std::min(uint(resp_data.size()),i+chunk_size);
+
+                ByteList frame = header;
+                frame.insert(frame.end(),resp_data.begin(),resp_data.begin()+prefix_size);
+                frame.insert(frame.end(),resp_data.begin()+i,resp_data.begin()+end);
+                list_frames.push_back(std::move(frame));
+
+                i = end;
+            }
+            while(i < resp_data.size());
+        }
+
+        return list_frames;
+    }
+
+    // ============================================================= //
+    // ============================================================= //
+}
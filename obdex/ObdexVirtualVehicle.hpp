@@ -0,0 +1,182 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_VIRTUAL_VEHICLE_HPP
+#define OBDEX_VIRTUAL_VEHICLE_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+#include <map>
+#include <random>
+
+namespace obdex
+{
+    // SplitISO15765Frames
+    // * splits @data into ISO 15765-2 (ISO-TP) frames,
+    //   prepending @header and the PCI bytes to each
+    // * data longer than seven bytes is sent as a first
+    //   frame followed by consecutive frames
+    // * if @pad is true every frame is padded to eight
+    //   data bytes with @pad_byte
+    std::vector<ByteList>
+    SplitISO15765Frames(ByteList const &header,
+                        ByteList const &data,
+                        bool const pad=false,
+                        ubyte const pad_byte=0x55);
+
+    // VirtualVehicle
+    // * answers the requests in built ParameterFrames with
+    //   simulated responses from one or more ECUs so an
+    //   application can be run and measured without a car
+    // * responses are saved in list_raw_frames just like
+    //   an interface would save real responses
+    // * unless a response has been set for a request with
+    //   SetResponse, an ECU replies with the expected data
+    //   prefix followed by random bytes (exp_data_byte_count
+    //   of them, or four if the count isn't known)
+    // * SAE J1850 and ISO 9141-2 responses longer than a
+    //   frame are split like SAE J1979 responses: every
+    //   frame starts with MessageData.exp_data_prefix
+    //   (continuation frames without a prefix aren't
+    //   simulated)
+    // * an ECU ignores requests physically addressed to
+    //   another ECU in the vehicle and answers everything
+    //   else (functional requests, messages without a
+    //   request and requests to unknown addresses)
+    class VirtualVehicle
+    {
+    public:
+        // VirtualVehicle
+        // * @seed makes the random data, latencies and
+        //   errors reproducible
+        VirtualVehicle(Protocol const protocol,
+                       bool const iso15765_extended_id=false,
+                       u32 const seed=0);
+
+        // AddEcu
+        // * adds an ECU and returns its index
+        // * @address is the ECU's source address (SAE J1850,
+        //   ISO 9141-2, ISO 14230 and 29-bit ISO 15765) or
+        //   its response identifier (11-bit ISO 15765, where
+        //   physical requests are sent to @address-8)
+        uint AddEcu(u32 const address);
+
+        // SetResponse
+        // * makes the ECU at @ecu_idx reply to @req_data with
+        //   @resp_data (including the response prefix); the
+        //   data shouldn't include headers or PCI bytes
+        // * SAE J1979 mode 0x01 requests for several PIDs
+        //   are answered by combining the responses set for
+        //   each [0x01] [pid] request
+        void SetResponse(uint const ecu_idx,
+                         ByteList const &req_data,
+                         ByteList const &resp_data);
+
+        // SetLatency
+        // * each ECU takes a random time between @min_latency
+        //   and @max_latency to respond to a request
+        void SetLatency(Microseconds const min_latency,
+                        Microseconds const max_latency);
+
+        // SetErrorRates
+        // * each response frame is lost with a probability
+        //   of @drop_rate and has one of its bytes changed
+        //   with a probability of @corrupt_rate
+        void SetErrorRates(double const drop_rate,
+                           double const corrupt_rate);
+
+        // SetPadFrames
+        // * pads ISO 15765 frames to eight data bytes like
+        //   most vehicles do (false by default)
+        void SetPadFrames(bool const pad_frames);
+
+        // SetISO14230HeaderLength
+        // * makes ISO 14230 responses use a header that's
+        //   @header_length bytes long: [F], [F] [L],
+        //   [F] [T] [S] or [F] [T] [S] [L]
+        // * by default (0) the header is [F] [T] [S]
+        // * [F] only holds lengths up to 63 bytes, so longer
+        //   responses use [F] [L] or [F] [T] [S] [L] instead;
+        //   responses longer than 255 bytes throw
+        void SetISO14230HeaderLength(uint const header_length);
+
+        // SetResponseDataLength
+        // * makes random responses @length bytes long,
+        //   including the expected prefix, instead of using
+        //   the expected data byte count (ie. to fill some
+        //   number of ISO 15765 frames)
+        // * a @length less than zero restores the default
+        void SetResponseDataLength(sint const length);
+
+        // Respond
+        // * saves simulated responses to every MessageData
+        //   in @param_frame in its list_raw_frames (frames
+        //   that are already there are kept)
+        // * returns the simulated time taken from sending
+        //   the first request to receiving the last response,
+        //   which includes MessageData.req_data_delay_ms and
+        //   the latency of the slowest ECU for each request
+        Microseconds Respond(ParameterFrame &param_frame);
+
+        // Error counts
+        // * the number of frames dropped and corrupted
+        //   since the VirtualVehicle was created
+        u64 GetDroppedFrameCount() const;
+        u64 GetCorruptedFrameCount() const;
+
+    private:
+        struct Ecu
+        {
+            u32 address;
+            std::map<ByteList,ByteList> map_responses;
+        };
+
+        ByteList getRequestData(ParameterFrame const &param_frame,
+                                MessageData const &msg) const;
+
+        bool isAddressedToOtherEcu(MessageData const &msg,
+                                   uint const ecu_idx) const;
+
+        bool getResponseData(Ecu const &ecu,
+                             MessageData const &msg,
+                             ByteList const &req_data,
+                             ByteList &resp_data);
+
+        std::vector<ByteList> buildFrames(Ecu const &ecu,
+                                          MessageData const &msg,
+                                          ByteList const &resp_data);
+
+        Protocol m_protocol;
+        bool m_iso15765_extended_id;
+        bool m_pad_frames;
+        uint m_iso14230_header_length;
+        sint m_response_data_length;
+
+        std::vector<Ecu> m_list_ecus;
+
+        Microseconds m_min_latency;
+        Microseconds m_max_latency;
+        double m_drop_rate;
+        double m_corrupt_rate;
+
+        u64 m_dropped_frame_count;
+        u64 m_corrupted_frame_count;
+
+        std::mt19937 m_random_gen;
+    };
+}
+
+#endif // OBDEX_VIRTUAL_VEHICLE_HPP
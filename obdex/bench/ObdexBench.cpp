@@ -0,0 +1,783 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/ObdexParser.hpp>
+#include <obdex/ObdexErrors.hpp>
+#include <obdex/ObdexLog.hpp>
+#include <obdex/ObdexUtil.hpp>
+#include <obdex/ObdexVirtualVehicle.hpp>
+#include <obdex/bench/ObdexDefinitionsGenerator.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+
+// obdex_bench
+// * runs a fixed set of benchmarks and prints one result
+//   per line to stdout as JSON (default) or CSV so that
+//   results can be compared between builds
+// * each benchmark is calibrated to run for at least
+//   --min-time-ms per sample; the min, median and max
+//   time per operation over --samples samples are reported
+// * simulated responses use a fixed seed, so every run
+//   parses the same data
+// * --synthetic-params generates definitions files with
+//   that many parameters to measure how loading, building
+//   and parsing scale; --generate only writes a file
+
+namespace obdex
+{
+    namespace bench
+    {
+        // ============================================================= //
+
+        struct Options
+        {
+            std::vector<std::string> list_definitions_files;
+            std::string spec;
+            std::string address;
+            std::string filter;
+            std::string format;
+            uint samples;
+            uint min_time_ms;
+
+            // synthetic definitions
+            std::vector<uint> list_synthetic_param_counts;
+            DefinitionsGeneratorOptions gen_options;
+            std::string gen_file_path;
+
+            Options() :
+                spec("SAEJ1979"),
+                address("Default"),
+                format("json"),
+                samples(5),
+                min_time_ms(100)
+            {}
+        };
+
+        struct Result
+        {
+            std::string name;
+            u64 iterations;
+            double ns_per_op_min;
+            double ns_per_op_median;
+            double ns_per_op_max;
+        };
+
+        // written to by benchmarks so the work they
+        // do can't be optimized away
+        volatile u64 g_sink=0;
+
+        // ============================================================= //
+
+        std::string EscapeJSON(std::string const &str)
+        {
+            std::string escaped;
+            for(auto const c : str)   {
+                if(c == '"' || c == '\\')   {
+                    escaped.push_back('\\');
+                }
+                escaped.push_back(c);
+            }
+            return escaped;
+        }
+
+        // ============================================================= //
+
+        class Runner
+        {
+        public:
+            Runner(Options const &options) :
+                m_options(options),
+                m_printed_header(false)
+            {}
+
+            // Run
+            // * times @fn, which does @ops_per_call operations
+            //   each time it's called
+            void Run(std::string const &name,
+                     uint const ops_per_call,
+                     std::function<void()> const &fn)
+            {
+                if(!m_options.filter.empty() &&
+                   !StringContains(name,m_options.filter))   {
+                    return;
+                }
+
+                using Clock = std::chrono::steady_clock;
+                auto const min_time =
+                        std::chrono::duration_cast<Clock::duration>(
+                            Milliseconds(m_options.min_time_ms));
+
+                // calibrate (this also warms up caches)
+                u64 iterations = 1;
+                while(true)   {
+                    auto const start = Clock::now();
+                    for(u64 i=0; i < iterations; i++)   {
+                        fn();
+                    }
+                    auto const elapsed = Clock::now()-start;
+                    if(elapsed >= min_time)   {
+                        break;
+                    }
+                    iterations *= 2;
+                }
+
+                // sample
+                std::vector<double> list_ns_per_op;
+                for(uint s=0; s < m_options.samples; s++)   {
+                    auto const start = Clock::now();
+                    for(u64 i=0; i < iterations; i++)   {
+                        fn();
+                    }
+                    auto const elapsed =
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                Clock::now()-start);
+
+                    list_ns_per_op.push_back(
+                                double(elapsed.count())/(iterations*ops_per_call));
+                }
+                std::sort(list_ns_per_op.begin(),list_ns_per_op.end());
+
+                Result result;
+                result.name = name;
+                result.iterations = iterations*ops_per_call;
+                result.ns_per_op_min = list_ns_per_op.front();
+                result.ns_per_op_median = list_ns_per_op[list_ns_per_op.size()/2];
+                result.ns_per_op_max = list_ns_per_op.back();
+
+                print(result);
+            }
+
+        private:
+            void print(Result const &result)
+            {
+                if(m_options.format == "csv")   {
+                    if(!m_printed_header)   {
+                        std::printf("name,iterations,samples,"
+                                    "ns_per_op_min,ns_per_op_median,ns_per_op_max\n");
+                        m_printed_header = true;
+                    }
+                    std::printf("\"%s\",%llu,%u,%.1f,%.1f,%.1f\n",
+                                result.name.c_str(),
+                                static_cast<unsigned long long>(result.iterations),
+                                m_options.samples,
+                                result.ns_per_op_min,
+                                result.ns_per_op_median,
+                                result.ns_per_op_max);
+                }
+                else   {
+                    std::printf("{\"name\":\"%s\",\"iterations\":%llu,\"samples\":%u,"
+                                "\"ns_per_op_min\":%.1f,\"ns_per_op_median\":%.1f,"
+                                "\"ns_per_op_max\":%.1f}\n",
+                                EscapeJSON(result.name).c_str(),
+                                static_cast<unsigned long long>(result.iterations),
+                                m_options.samples,
+                                result.ns_per_op_min,
+                                result.ns_per_op_median,
+                                result.ns_per_op_max);
+                }
+                std::fflush(stdout);
+            }
+
+            Options const m_options;
+            bool m_printed_header;
+        };
+
+        // ============================================================= //
+
+        std::string GetFileName(std::string const &path)
+        {
+            auto const pos = path.find_last_of("/\\");
+            return (pos == std::string::npos) ? path : path.substr(pos+1);
+        }
+
+        // ============================================================= //
+
+        // GetEcuAddress
+        // * address of a simulated ECU that responds
+        //   to requests on @param_frame's protocol
+        u32 GetEcuAddress(ParameterFrame const &param_frame)
+        {
+            if(param_frame.parse_protocol == PROTOCOL_ISO_15765 &&
+               !param_frame.iso15765_extended_id)   {
+                return 0x7E8;
+            }
+            return 0x10;
+        }
+
+        // ============================================================= //
+
+        void BenchParserConstruction(Runner &runner,
+                                     Options const &options)
+        {
+            for(auto const &file : options.list_definitions_files)   {
+                runner.Run("parser/construct/"+GetFileName(file),1,[&]() {
+                    Parser parser(file);
+                    g_sink += parser.ConvHexStrToUByte("FF");
+                });
+            }
+        }
+
+        // ============================================================= //
+
+        void BenchProtocol(Runner &runner,
+                           Options const &options,
+                           Parser &parser,
+                           std::string const &protocol)
+        {
+            std::vector<std::string> const list_names =
+                    parser.GetParameterNames(options.spec,protocol,options.address);
+
+            // keep the parameters that build for this protocol
+            std::vector<ParameterFrame> list_frames;
+            for(auto const &name : list_names)   {
+                ParameterFrame param_frame;
+                param_frame.spec = options.spec;
+                param_frame.protocol = protocol;
+                param_frame.address = options.address;
+                param_frame.name = name;
+
+                try {
+                    parser.BuildParameterFrame(param_frame);
+                }
+                catch(Exception &e)   {
+                    continue;
+                }
+                list_frames.push_back(param_frame);
+            }
+
+            if(list_frames.empty())   {
+                return;
+            }
+
+            // [build]
+            runner.Run("build/"+protocol,list_frames.size(),[&]() {
+                for(auto const &built_frame : list_frames)   {
+                    ParameterFrame param_frame;
+                    param_frame.spec = built_frame.spec;
+                    param_frame.protocol = built_frame.protocol;
+                    param_frame.address = built_frame.address;
+                    param_frame.name = built_frame.name;
+                    parser.BuildParameterFrame(param_frame);
+                    g_sink += param_frame.list_message_data.size();
+                }
+            });
+
+            runner.Run("build/"+protocol+"/param_id",list_frames.size(),[&]() {
+                for(auto const &built_frame : list_frames)   {
+                    ParameterFrame param_frame;
+                    parser.BuildParameterFrame(built_frame.param_id,param_frame);
+                    g_sink += param_frame.list_message_data.size();
+                }
+            });
+
+            // [parse single frame responses]
+            // * parameters with a single request and a response
+            //   that fits in a single frame
+            VirtualVehicle vehicle(list_frames[0].parse_protocol,
+                                   list_frames[0].iso15765_extended_id,
+                                   1);
+            vehicle.AddEcu(GetEcuAddress(list_frames[0]));
+
+            std::vector<ParameterFrame> list_sf_frames;
+            for(auto const &built_frame : list_frames)   {
+                if(built_frame.list_message_data.size() != 1)   {
+                    continue;
+                }
+                MessageData const &msg = built_frame.list_message_data[0];
+                if(msg.list_req_data_bytes.empty() ||
+                   msg.exp_data_byte_count < 0 ||
+                   msg.exp_data_prefix.size()+msg.exp_data_byte_count > 7)   {
+                    continue;
+                }
+
+                ParameterFrame param_frame = built_frame;
+                vehicle.Respond(param_frame);
+
+                // skip parameters whose scripts fail on random data
+                try {
+                    std::vector<Data> list_data;
+                    parser.ParseParameterFrame(param_frame,list_data);
+                }
+                catch(Exception &e)   {
+                    continue;
+                }
+                list_sf_frames.push_back(param_frame);
+            }
+
+            if(!list_sf_frames.empty())   {
+                std::vector<Data> list_data;
+                runner.Run("parse/"+protocol+"/single_frame",list_sf_frames.size(),[&]() {
+                    for(auto &param_frame : list_sf_frames)   {
+                        list_data.clear();
+                        parser.ParseParameterFrame(param_frame,list_data);
+                        g_sink += list_data.size();
+                    }
+                });
+
+                // same responses with the parse cache; every
+                // parse after the first is a hit
+                parser.SetParseCacheCapacity(list_sf_frames.size());
+                runner.Run("parse/"+protocol+"/single_frame_cached",list_sf_frames.size(),[&]() {
+                    for(auto &param_frame : list_sf_frames)   {
+                        list_data.clear();
+                        parser.ParseParameterFrame(param_frame,list_data);
+                        g_sink += list_data.size();
+                    }
+                });
+                parser.SetParseCacheCapacity(0);
+
+                // same responses with lookup tables; scripts
+                // that can't use a table still run
+                parser.SetLookupTableMaxDomain(65536);
+                runner.Run("parse/"+protocol+"/single_frame_tables",list_sf_frames.size(),[&]() {
+                    for(auto &param_frame : list_sf_frames)   {
+                        list_data.clear();
+                        parser.ParseParameterFrame(param_frame,list_data);
+                        g_sink += list_data.size();
+                    }
+                });
+                parser.SetLookupTableMaxDomain(0);
+            }
+        }
+
+        // ============================================================= //
+
+        // writeEmptyScriptDefinitions
+        // * writes a definitions file with a single parameter
+        //   that has the same request and response prefix as
+        //   Engine RPM but an empty script
+        // * parsing it costs everything parsing Engine RPM does
+        //   except running the script, so it measures passing
+        //   the data to the js context on its own
+        bool writeEmptyScriptDefinitions(std::string const &file_path)
+        {
+            std::ofstream file(file_path,std::ios::out | std::ios::trunc);
+            if(!file)   {
+                return false;
+            }
+
+            file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n"
+                 << "<spec name=\"EMPTY\" desc=\"Empty Script Baseline\">\n"
+                 << "   <protocol name=\"ISO 15765 Standard Id\">\n"
+                 << "      <address name=\"Default\">\n"
+                 << "         <request identifier=\"0x7DF\" />\n"
+                 << "      </address>\n"
+                 << "   </protocol>\n"
+                 << "   <parameters address=\"Default\">\n"
+                 << "      <parameter name=\"Empty Script\"\n"
+                 << "         request=\"0x01 0x0C\" response.prefix=\"0x41 0x0C\">\n"
+                 << "         <script>\n"
+                 << "            <![CDATA[\n"
+                 << "            ]]>\n"
+                 << "         </script>\n"
+                 << "      </parameter>\n"
+                 << "   </parameters>\n"
+                 << "</spec>\n";
+            file.close();
+
+            return !file.fail();
+        }
+
+        // ============================================================= //
+
+        void BenchISOTP(Runner &runner,
+                        Options const &options,
+                        Parser &parser)
+        {
+            std::string const protocol = "ISO 15765 Standard Id";
+
+            ParameterFrame built_frame;
+            built_frame.spec = options.spec;
+            built_frame.protocol = protocol;
+            built_frame.address = options.address;
+            built_frame.name = "Engine RPM";
+
+            try {
+                parser.BuildParameterFrame(built_frame);
+            }
+            catch(Exception &e)   {
+                return;
+            }
+
+            // baseline with an empty script, see
+            // writeEmptyScriptDefinitions
+            std::string const empty_file_path = "obdex_bench_empty_script.xml";
+            if(!writeEmptyScriptDefinitions(empty_file_path))   {
+                std::fprintf(stderr,"could not write %s\n",empty_file_path.c_str());
+                return;
+            }
+            Parser empty_parser(empty_file_path);
+            std::remove(empty_file_path.c_str());
+
+            ParameterFrame empty_built_frame;
+            empty_built_frame.spec = "EMPTY";
+            empty_built_frame.protocol = protocol;
+            empty_built_frame.address = "Default";
+            empty_built_frame.name = "Empty Script";
+            empty_parser.BuildParameterFrame(empty_built_frame);
+
+            std::vector<uint> const list_lengths{2,64,512,4093};
+            for(auto const length : list_lengths)
+            {
+                // [0x41] [0x0C] followed by @length bytes
+                ByteList resp_data{0x41,0x0C};
+                for(uint i=0; i < length; i++)   {
+                    resp_data.push_back(ubyte(i));
+                }
+
+                VirtualVehicle vehicle(PROTOCOL_ISO_15765,false,1);
+                uint const ecu_idx = vehicle.AddEcu(0x7E8);
+                vehicle.SetResponse(ecu_idx,ByteList{0x01,0x0C},resp_data);
+
+                ParameterFrame param_frame = built_frame;
+                vehicle.Respond(param_frame);
+
+                std::string const suffix = "/"+ToString(length)+"B";
+                std::vector<Data> list_data;
+
+                runner.Run("parse/"+protocol+"/isotp"+suffix,1,[&]() {
+                    list_data.clear();
+                    parser.ParseParameterFrame(param_frame,list_data);
+                    g_sink += list_data.size();
+                });
+
+                runner.Run("clean/"+protocol+"/isotp"+suffix,1,[&]() {
+                    parser.CleanParameterFrame(param_frame);
+                    g_sink += param_frame.list_message_data[0].list_data.size();
+                });
+
+                // the cost of passing the cleaned data to the
+                // js context and running the script
+                parser.CleanParameterFrame(param_frame);
+                runner.Run("js/parse_cleaned"+suffix,1,[&]() {
+                    list_data.clear();
+                    parser.ParseCleanedParameterFrame(param_frame,list_data);
+                    g_sink += list_data.size();
+                });
+
+                // the same data with an empty script, so only the
+                // cost of passing the data to the js context; the
+                // script's own cost is the difference between the
+                // two results
+                ParameterFrame empty_frame = empty_built_frame;
+                vehicle.Respond(empty_frame);
+                empty_parser.CleanParameterFrame(empty_frame);
+                runner.Run("js/marshal_only"+suffix,1,[&]() {
+                    list_data.clear();
+                    empty_parser.ParseCleanedParameterFrame(empty_frame,list_data);
+                    g_sink += empty_frame.list_message_data[0].list_data.size();
+                });
+            }
+        }
+
+        // ============================================================= //
+
+        void BenchHex(Runner &runner,
+                      Parser &parser)
+        {
+            runner.Run("hex/ubyte_to_str",256,[&]() {
+                for(uint i=0; i < 256; i++)   {
+                    g_sink += parser.ConvUByteToHexStr(ubyte(i)).size();
+                }
+            });
+
+            std::vector<std::string> list_hex_str;
+            for(uint i=0; i < 256; i++)   {
+                list_hex_str.push_back(parser.ConvUByteToHexStr(ubyte(i)));
+            }
+
+            runner.Run("hex/str_to_ubyte",256,[&]() {
+                for(auto const &hex_str : list_hex_str)   {
+                    g_sink += parser.ConvHexStrToUByte(hex_str);
+                }
+            });
+
+            runner.Run("hex/ubyte_to_chars",256,[&]() {
+                char buf[2];
+                for(uint i=0; i < 256; i++)   {
+                    g_sink += Parser::ConvUByteToHexStr(ubyte(i),buf)[1];
+                }
+            });
+
+            runner.Run("hex/chars_to_ubyte",256,[&]() {
+                for(auto const &hex_str : list_hex_str)   {
+                    g_sink += Parser::ConvHexStrToUByte(hex_str.data(),2);
+                }
+            });
+
+            runner.Run("hex/to_hex_string",256,[&]() {
+                for(uint i=0; i < 256; i++)   {
+                    g_sink += ToHexString(i).size();
+                }
+            });
+        }
+
+        // ============================================================= //
+
+        void BenchSynthetic(Runner &runner,
+                            Options const &options)
+        {
+            std::string const protocol = "ISO 15765 Standard Id";
+
+            for(auto const param_count : options.list_synthetic_param_counts)
+            {
+                DefinitionsGeneratorOptions gen_options = options.gen_options;
+                gen_options.param_count = param_count;
+                gen_options.list_protocols = {protocol};
+
+                std::string const name = "synthetic_"+ToString(param_count);
+                std::string const file_path = "obdex_bench_"+name+".xml";
+                if(!WriteDefinitionsFile(file_path,gen_options))   {
+                    std::fprintf(stderr,"could not write %s\n",file_path.c_str());
+                    continue;
+                }
+
+                runner.Run("parser/construct/"+name,1,[&]() {
+                    Parser parser(file_path);
+                    g_sink += parser.ConvHexStrToUByte("FF");
+                });
+
+                Parser parser(file_path);
+                std::remove(file_path.c_str());
+
+                // build and respond to every parameter in the first spec
+                std::vector<ParameterFrame> list_frames;
+                for(uint a=0; a < gen_options.address_count; a++)   {
+                    VirtualVehicle vehicle(PROTOCOL_ISO_15765,false,1);
+                    vehicle.AddEcu(GetSyntheticEcuAddress(protocol,a));
+
+                    auto const list_names = GetSyntheticParameterNames(gen_options,0,a);
+                    for(auto const &param_name : list_names)   {
+                        ParameterFrame param_frame;
+                        param_frame.spec = GetSyntheticSpecName(0);
+                        param_frame.protocol = protocol;
+                        param_frame.address = GetSyntheticAddressName(a);
+                        param_frame.name = param_name;
+                        parser.BuildParameterFrame(param_frame);
+                        vehicle.Respond(param_frame);
+                        list_frames.push_back(param_frame);
+                    }
+                }
+
+                if(list_frames.empty())   {
+                    continue;
+                }
+
+                // time a fixed sample of parameters spread across
+                // the file so large files don't take too long
+                uint const stride = std::max(uint(list_frames.size()/256),uint(1));
+                std::vector<ParameterFrame> list_sample_frames;
+                for(uint i=0; i < list_frames.size(); i+=stride)   {
+                    list_sample_frames.push_back(list_frames[i]);
+                }
+
+                runner.Run("build/"+name,list_sample_frames.size(),[&]() {
+                    for(auto const &built_frame : list_sample_frames)   {
+                        ParameterFrame param_frame;
+                        param_frame.spec = built_frame.spec;
+                        param_frame.protocol = built_frame.protocol;
+                        param_frame.address = built_frame.address;
+                        param_frame.name = built_frame.name;
+                        parser.BuildParameterFrame(param_frame);
+                        g_sink += param_frame.list_message_data.size();
+                    }
+                });
+
+                runner.Run("catalog/"+name,1,[&]() {
+                    g_sink += parser.GetCatalog().list_params.size();
+                });
+
+                std::vector<Data> list_data;
+                runner.Run("parse/"+name,list_sample_frames.size(),[&]() {
+                    for(auto &param_frame : list_sample_frames)   {
+                        list_data.clear();
+                        parser.ParseParameterFrame(param_frame,list_data);
+                        g_sink += list_data.size();
+                    }
+                });
+            }
+        }
+
+        // ============================================================= //
+
+        void PrintUsage()
+        {
+            std::fprintf(stderr,
+                         "usage: obdex_bench --definitions-file /path/to/obd2.xml [options]\n"
+                         "  --definitions-file path  definitions file (may be repeated; the\n"
+                         "                           first is used for protocol benchmarks)\n"
+                         "  --spec name              spec to benchmark (SAEJ1979)\n"
+                         "  --address name           address to benchmark (Default)\n"
+                         "  --filter str             only run benchmarks with str in the name\n"
+                         "  --format json|csv        output format (json)\n"
+                         "  --samples N              samples per benchmark (5)\n"
+                         "  --min-time-ms N          minimum time per sample (100)\n"
+                         "\n"
+                         "synthetic definitions:\n"
+                         "  --synthetic-params N     benchmark a generated file with N parameters\n"
+                         "                           (may be repeated)\n"
+                         "  --generate path          write a generated file to path and exit\n"
+                         "  --gen-specs N            number of specs (1)\n"
+                         "  --gen-addresses N        number of addresses (1)\n"
+                         "  --gen-params N           parameters per spec for --generate (100)\n"
+                         "  --gen-combined R         fraction of parse=\"combined\" parameters (0.1)\n"
+                         "  --gen-multi-request R    fraction of multi-request parameters (0.1)\n"
+                         "  --gen-complex-script R   fraction of parameters with longer scripts (0.2)\n"
+                         "  --gen-seed N             seed for picking parameter types (0)\n");
+        }
+
+        // ============================================================= //
+
+        bool ParseArgs(int argc, char * const argv[], Options &options)
+        {
+            for(int i=1; i < argc; i++)
+            {
+                std::string const arg(argv[i]);
+                if(arg == "--help" || arg == "-h")   {
+                    return false;
+                }
+                if(i+1 >= argc)   {
+                    std::fprintf(stderr,"missing value for %s\n",arg.c_str());
+                    return false;
+                }
+
+                std::string const value(argv[++i]);
+                if(arg == "--definitions-file")   {
+                    options.list_definitions_files.push_back(value);
+                }
+                else if(arg == "--spec")   {
+                    options.spec = value;
+                }
+                else if(arg == "--address")   {
+                    options.address = value;
+                }
+                else if(arg == "--filter")   {
+                    options.filter = value;
+                }
+                else if(arg == "--format")   {
+                    options.format = value;
+                }
+                else if(arg == "--samples")   {
+                    options.samples = std::max(1,std::atoi(value.c_str()));
+                }
+                else if(arg == "--min-time-ms")   {
+                    options.min_time_ms = std::max(1,std::atoi(value.c_str()));
+                }
+                else if(arg == "--synthetic-params")   {
+                    options.list_synthetic_param_counts.push_back(
+                                std::max(1,std::atoi(value.c_str())));
+                }
+                else if(arg == "--generate")   {
+                    options.gen_file_path = value;
+                }
+                else if(arg == "--gen-specs")   {
+                    options.gen_options.spec_count = std::max(1,std::atoi(value.c_str()));
+                }
+                else if(arg == "--gen-addresses")   {
+                    options.gen_options.address_count = std::max(1,std::atoi(value.c_str()));
+                }
+                else if(arg == "--gen-params")   {
+                    options.gen_options.param_count = std::max(1,std::atoi(value.c_str()));
+                }
+                else if(arg == "--gen-combined")   {
+                    options.gen_options.combined_ratio = std::atof(value.c_str());
+                }
+                else if(arg == "--gen-multi-request")   {
+                    options.gen_options.multi_request_ratio = std::atof(value.c_str());
+                }
+                else if(arg == "--gen-complex-script")   {
+                    options.gen_options.complex_script_ratio = std::atof(value.c_str());
+                }
+                else if(arg == "--gen-seed")   {
+                    options.gen_options.seed = std::strtoul(value.c_str(),nullptr,10);
+                }
+                else   {
+                    std::fprintf(stderr,"unknown option %s\n",arg.c_str());
+                    return false;
+                }
+            }
+
+            return (!options.list_definitions_files.empty() ||
+                    !options.list_synthetic_param_counts.empty() ||
+                    !options.gen_file_path.empty());
+        }
+
+        // ============================================================= //
+    }
+}
+
+using namespace obdex;
+
+int main(int argc, char * const argv[])
+{
+    bench::Options options;
+    if(!bench::ParseArgs(argc,argv,options))   {
+        bench::PrintUsage();
+        return 1;
+    }
+
+    if(!options.gen_file_path.empty())   {
+        if(!bench::WriteDefinitionsFile(options.gen_file_path,options.gen_options))   {
+            std::fprintf(stderr,"could not write %s\n",options.gen_file_path.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    // results go to stdout, so keep it free of log output
+    obdexlog.UnsetLevel(Logger::Level::TRACE);
+    obdexlog.UnsetLevel(Logger::Level::DEBUG);
+    obdexlog.UnsetLevel(Logger::Level::INFO);
+    obdexlog.UnsetLevel(Logger::Level::WARN);
+
+    try {
+        bench::Runner runner(options);
+
+        bench::BenchParserConstruction(runner,options);
+
+        if(!options.list_definitions_files.empty())   {
+            Parser parser(options.list_definitions_files[0]);
+
+            std::vector<std::string> const list_protocols {
+                "SAE J1850 PWM",
+                "SAE J1850 VPW",
+                "ISO 9141-2",
+                "ISO 14230",
+                "ISO 15765 Standard Id",
+                "ISO 15765 Extended Id"
+            };
+
+            for(auto const &protocol : list_protocols)   {
+                bench::BenchProtocol(runner,options,parser,protocol);
+            }
+
+            bench::BenchISOTP(runner,options,parser);
+            bench::BenchHex(runner,parser);
+        }
+
+        bench::BenchSynthetic(runner,options);
+    }
+    catch(Exception &e)   {
+        std::fprintf(stderr,"obdex_bench failed: %s\n",e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,387 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/bench/ObdexDefinitionsGenerator.hpp>
+#include <obdex/ObdexUtil.hpp>
+#include <obdex/ObdexErrors.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace obdex
+{
+    namespace bench
+    {
+        namespace
+        {
+            // ============================================================= //
+
+            struct ParamType
+            {
+                bool combined;
+                bool complex_script;
+                uint request_count;
+            };
+
+            // getParamTypes
+            // * picks the type of every parameter so each
+            //   spec gets the same mix
+            std::vector<ParamType> getParamTypes(DefinitionsGeneratorOptions const &options)
+            {
+                std::mt19937 random_gen(options.seed);
+                std::uniform_real_distribution<double> dist(0.0,1.0);
+                std::uniform_int_distribution<uint> dist_reqs(
+                            2,std::max(options.max_requests,uint(2)));
+
+                std::vector<ParamType> list_param_types;
+                for(uint i=0; i < options.param_count; i++)   {
+                    ParamType param_type;
+                    param_type.combined = (dist(random_gen) < options.combined_ratio);
+                    param_type.complex_script = (dist(random_gen) < options.complex_script_ratio);
+                    param_type.request_count = 1;
+                    if(dist(random_gen) < options.multi_request_ratio)   {
+                        param_type.request_count = dist_reqs(random_gen);
+                    }
+                    list_param_types.push_back(param_type);
+                }
+
+                return list_param_types;
+            }
+
+            // ============================================================= //
+
+            // modes 0x22 to 0x3F (responses 0x62 to 0x7F)
+            // with a 16-bit identifier each
+            uint const k_first_request_mode = 0x22;
+            uint const k_last_request_mode = 0x3F;
+            u64 const k_max_request_ids =
+                    u64(k_last_request_mode-k_first_request_mode+1) << 16;
+
+            std::string toHexAttr(uint const value)
+            {
+                std::string hex_str = ToHexString(value);
+                while(hex_str.size() < 2)   {
+                    PrependString(hex_str,"0");
+                }
+                return "0x"+StringToUpper(hex_str);
+            }
+
+            // ============================================================= //
+
+            void writeAddress(std::ostringstream &xml,
+                              std::string const &protocol,
+                              uint const address_idx)
+            {
+                std::string const name = GetSyntheticAddressName(address_idx);
+                xml << "      <address name=\"" << name << "\">\n";
+
+                if(StringContains(protocol,"SAE J1850") ||
+                   protocol == "ISO 9141-2")
+                {
+                    if(address_idx == 0)   {
+                        xml << "         <request prio=\"0x68\" target=\"0x6A\" source=\"0xF1\" />\n"
+                            << "         <response prio=\"0x48\" target=\"0x6B\" />\n";
+                    }
+                    else   {
+                        std::string const ecu = toHexAttr(0x10+(address_idx%0xE0));
+                        xml << "         <request prio=\"0x6C\" target=\"" << ecu << "\" source=\"0xF1\" />\n"
+                            << "         <response prio=\"0x6C\" target=\"0xF1\" source=\"" << ecu << "\" />\n";
+                    }
+                }
+                else if(protocol == "ISO 14230")
+                {
+                    if(address_idx == 0)   {
+                        xml << "         <request format=\"0xC0\" target=\"0x33\" source=\"0xF1\" />\n"
+                            << "         <response format=\"0x80\" target=\"0xF1\" />\n";
+                    }
+                    else   {
+                        std::string const ecu = toHexAttr(0x10+(address_idx%0xE0));
+                        xml << "         <request format=\"0x80\" target=\"" << ecu << "\" source=\"0xF1\" />\n"
+                            << "         <response format=\"0x80\" target=\"0xF1\" source=\"" << ecu << "\" />\n";
+                    }
+                }
+                else if(protocol == "ISO 15765 Standard Id")
+                {
+                    if(address_idx == 0)   {
+                        xml << "         <request identifier=\"0x7DF\" />\n";
+                    }
+                    else   {
+                        uint const ecu = (address_idx-1)%0x80;
+                        xml << "         <request identifier=\"" << toHexAttr(0x600+ecu) << "\" />\n"
+                            << "         <response identifier=\"" << toHexAttr(0x680+ecu) << "\" />\n";
+                    }
+                }
+                else if(protocol == "ISO 15765 Extended Id")
+                {
+                    if(address_idx == 0)   {
+                        xml << "         <request prio=\"0x18\" format=\"0xDB\" target=\"0x33\" source=\"0xF1\" />\n"
+                            << "         <response prio=\"0x18\" format=\"0xDA\" target=\"0xF1\" />\n";
+                    }
+                    else   {
+                        std::string const ecu = toHexAttr(address_idx%0x100);
+                        xml << "         <request prio=\"0x18\" format=\"0xDA\" target=\"" << ecu << "\" source=\"0xF1\" />\n"
+                            << "         <response prio=\"0x18\" format=\"0xDA\" target=\"0xF1\" source=\"" << ecu << "\" />\n";
+                    }
+                }
+
+                xml << "      </address>\n";
+            }
+
+            // ============================================================= //
+
+            void writeScript(std::ostringstream &xml,
+                             ParamType const &param_type)
+            {
+                xml << "         <script>\n"
+                    << "            <![CDATA[\n";
+
+                if(param_type.combined && !param_type.complex_script)   {
+                    xml << "            var value = new NumericalDataObj();\n"
+                        << "            value.units = \"u\";\n"
+                        << "            value.min = 0;\n"
+                        << "            value.max = 255*NUM_REQ();\n"
+                        << "            value.value = 0;\n"
+                        << "            for(var i=0; i < NUM_REQ(); i++)   {\n"
+                        << "               if(NUM_RESP(i) > 0)   {\n"
+                        << "                  value.value += REQ(i).DATA(0).BYTE(0);\n"
+                        << "               }\n"
+                        << "            }\n"
+                        << "            saveNumericalData(value);\n";
+                }
+                else if(param_type.combined)   {
+                    xml << "            for(var i=0; i < NUM_REQ(); i++)   {\n"
+                        << "               for(var j=0; j < NUM_RESP(i); j++)   {\n"
+                        << "                  var data = REQ(i).DATA(j);\n"
+                        << "                  var sum = 0;\n"
+                        << "                  var dataBytes = \"\";\n"
+                        << "                  for(var k=0; k < data.LENGTH(); k++)   {\n"
+                        << "                     sum += data.BYTE(k);\n"
+                        << "                     dataBytes += data.BYTE(k).toString(16) + \" \";\n"
+                        << "                  }\n"
+                        << "                  var value = new NumericalDataObj();\n"
+                        << "                  value.property = \"req:\" + i.toString(10);\n"
+                        << "                  value.min = 0;\n"
+                        << "                  value.max = 255*data.LENGTH();\n"
+                        << "                  value.value = sum;\n"
+                        << "                  saveNumericalData(value);\n"
+                        << "                  var lit = new LiteralDataObj();\n"
+                        << "                  lit.property = \"req:\" + i.toString(10) + \" resp:\" + j.toString(10);\n"
+                        << "                  lit.valueIfTrue = dataBytes.toUpperCase();\n"
+                        << "                  lit.value = true;\n"
+                        << "                  saveLiteralData(lit);\n"
+                        << "               }\n"
+                        << "            }\n";
+                }
+                else if(!param_type.complex_script)   {
+                    xml << "            var value = new NumericalDataObj();\n"
+                        << "            value.units = \"u\";\n"
+                        << "            value.min = 0;\n"
+                        << "            value.max = 127.5;\n"
+                        << "            value.value = BYTE(0)*0.5;\n"
+                        << "            saveNumericalData(value);\n";
+                }
+                else   {
+                    xml << "            var sum = 0;\n"
+                        << "            var dataBytes = \"\";\n"
+                        << "            for(var i=0; i < LENGTH(); i++)   {\n"
+                        << "               sum += BYTE(i);\n"
+                        << "               dataBytes += BYTE(i).toString(16) + \" \";\n"
+                        << "            }\n"
+                        << "            var value = new NumericalDataObj();\n"
+                        << "            value.units = \"u\";\n"
+                        << "            value.min = 0;\n"
+                        << "            value.max = 255*LENGTH();\n"
+                        << "            value.value = sum;\n"
+                        << "            saveNumericalData(value);\n"
+                        << "            for(var b=0; b < 8; b++)   {\n"
+                        << "               var bit = new LiteralDataObj();\n"
+                        << "               bit.property = \"Bit \" + b.toString(10);\n"
+                        << "               bit.valueIfTrue = \"On\";\n"
+                        << "               bit.valueIfFalse = \"Off\";\n"
+                        << "               bit.value = (BIT(0,b) == 1);\n"
+                        << "               saveLiteralData(bit);\n"
+                        << "            }\n"
+                        << "            var lit = new LiteralDataObj();\n"
+                        << "            lit.property = \"Received\";\n"
+                        << "            lit.valueIfTrue = dataBytes.toUpperCase();\n"
+                        << "            lit.value = true;\n"
+                        << "            saveLiteralData(lit);\n";
+                }
+
+                xml << "            ]]>\n"
+                    << "         </script>\n";
+            }
+
+            // ============================================================= //
+
+            void writeParameter(std::ostringstream &xml,
+                                uint const param_idx,
+                                ParamType const &param_type,
+                                uint const max_requests)
+            {
+                xml << "      <parameter name=\"PARAM_" << param_idx << "\"";
+
+                // mode 0x22 requests with a unique data identifier
+                // and a response of one to four bytes; every 65536
+                // identifiers the mode is incremented so they stay
+                // unique (see k_max_request_ids)
+                for(uint i=0; i < param_type.request_count; i++)   {
+                    uint const request_id = param_idx*max_requests + i;
+                    uint const mode = k_first_request_mode + (request_id >> 16);
+                    std::string const req_mode = toHexAttr(mode);
+                    std::string const resp_mode = toHexAttr(mode+0x40);
+                    std::string const did_hi = toHexAttr((request_id >> 8) & 0xFF);
+                    std::string const did_lo = toHexAttr(request_id & 0xFF);
+                    uint const byte_count = 1 + ((param_idx+i) % 4);
+
+                    std::string const suffix = (param_type.request_count > 1) ?
+                                ToString(i) : std::string();
+
+                    xml << "\n         request" << suffix << "=\"" << req_mode << " " << did_hi << " " << did_lo << "\""
+                        << " response" << suffix << ".prefix=\"" << resp_mode << " " << did_hi << " " << did_lo << "\""
+                        << " response" << suffix << ".bytes=\"" << byte_count << "\"";
+                }
+                if(param_type.combined)   {
+                    xml << "\n         parse=\"combined\"";
+                }
+                xml << ">\n";
+
+                writeScript(xml,param_type);
+
+                xml << "      </parameter>\n";
+            }
+
+            // ============================================================= //
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        std::string GetSyntheticSpecName(uint const spec_idx)
+        {
+            return "SPEC"+ToString(spec_idx);
+        }
+
+        std::string GetSyntheticAddressName(uint const address_idx)
+        {
+            return (address_idx == 0) ? "Default" : "ECU"+ToString(address_idx);
+        }
+
+        u32 GetSyntheticEcuAddress(std::string const &protocol,
+                                   uint const address_idx)
+        {
+            if(protocol == "ISO 15765 Standard Id")   {
+                return (address_idx == 0) ? 0x7E8 : 0x680+((address_idx-1)%0x80);
+            }
+            if(protocol == "ISO 15765 Extended Id")   {
+                return (address_idx == 0) ? 0x10 : (address_idx%0x100);
+            }
+            return (address_idx == 0) ? 0x10 : 0x10+(address_idx%0xE0);
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        std::vector<std::string>
+        GetSyntheticParameterNames(DefinitionsGeneratorOptions const &options,
+                                   uint const spec_idx,
+                                   uint const address_idx)
+        {
+            (void)spec_idx;
+
+            std::vector<std::string> list_names;
+            uint const address_count = std::max(options.address_count,uint(1));
+            for(uint i=address_idx; i < options.param_count; i+=address_count)   {
+                list_names.push_back("PARAM_"+ToString(i));
+            }
+
+            return list_names;
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        std::string GenerateDefinitions(DefinitionsGeneratorOptions const &options)
+        {
+            std::vector<ParamType> const list_param_types = getParamTypes(options);
+            uint const address_count = std::max(options.address_count,uint(1));
+            uint const max_requests = std::max(options.max_requests,uint(2));
+            if(u64(options.param_count)*max_requests > k_max_request_ids)   {
+                throw InvalidArgument(
+                            "GenerateDefinitions: Too many parameters "
+                            "for unique request identifiers");
+            }
+
+            std::ostringstream xml;
+            xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n"
+                << "<!-- synthetic definitions: "
+                << options.spec_count << " specs, "
+                << address_count << " addresses, "
+                << options.param_count << " parameters per spec -->\n\n";
+
+            for(uint s=0; s < options.spec_count; s++)
+            {
+                xml << "<spec name=\"" << GetSyntheticSpecName(s)
+                    << "\" desc=\"Synthetic Spec\">\n\n";
+
+                for(auto const &protocol : options.list_protocols)   {
+                    xml << "   <protocol name=\"" << protocol << "\">\n";
+                    for(uint a=0; a < address_count; a++)   {
+                        writeAddress(xml,protocol,a);
+                    }
+                    xml << "   </protocol>\n\n";
+                }
+
+                for(uint a=0; a < address_count; a++)   {
+                    xml << "   <parameters address=\""
+                        << GetSyntheticAddressName(a) << "\">\n";
+
+                    for(uint i=a; i < options.param_count; i+=address_count)   {
+                        writeParameter(xml,i,list_param_types[i],max_requests);
+                    }
+
+                    xml << "   </parameters>\n\n";
+                }
+
+                xml << "</spec>\n\n";
+            }
+
+            return xml.str();
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        bool WriteDefinitionsFile(std::string const &file_path,
+                                  DefinitionsGeneratorOptions const &options)
+        {
+            std::ofstream file(file_path,std::ios::out | std::ios::trunc);
+            if(!file)   {
+                return false;
+            }
+
+            file << GenerateDefinitions(options);
+            file.close();
+
+            return !file.fail();
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+    }
+}
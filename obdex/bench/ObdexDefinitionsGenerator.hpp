@@ -0,0 +1,120 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_DEFINITIONS_GENERATOR_HPP
+#define OBDEX_DEFINITIONS_GENERATOR_HPP
+
+#include <obdex/ObdexDataTypes.hpp>
+
+namespace obdex
+{
+    namespace bench
+    {
+        // DefinitionsGeneratorOptions
+        // * describes a synthetic definitions file
+        struct DefinitionsGeneratorOptions
+        {
+            // number of specs (named SPEC0, SPEC1, ...)
+            uint spec_count;
+
+            // number of addresses in each protocol; the first
+            // is always "Default" (functional requests), the
+            // rest are named ECU1, ECU2, ...
+            uint address_count;
+
+            // number of parameters in each spec, split evenly
+            // between the addresses
+            uint param_count;
+
+            // fraction of parameters that use parse="combined"
+            double combined_ratio;
+
+            // fraction of parameters that send more than one
+            // request (request0, request1, ...), and the most
+            // requests such a parameter sends
+            double multi_request_ratio;
+            uint max_requests;
+
+            // fraction of parameters with a longer script that
+            // loops over the data and saves several values (the
+            // rest save a single numerical value)
+            double complex_script_ratio;
+
+            // protocols to define; all protocols by default
+            std::vector<std::string> list_protocols;
+
+            // seed for picking parameter types
+            u32 seed;
+
+            DefinitionsGeneratorOptions() :
+                spec_count(1),
+                address_count(1),
+                param_count(100),
+                combined_ratio(0.1),
+                multi_request_ratio(0.1),
+                max_requests(3),
+                complex_script_ratio(0.2),
+                list_protocols({
+                    "SAE J1850 PWM",
+                    "SAE J1850 VPW",
+                    "ISO 9141-2",
+                    "ISO 14230",
+                    "ISO 15765 Standard Id",
+                    "ISO 15765 Extended Id"}),
+                seed(0)
+            {}
+        };
+
+        // GenerateDefinitions
+        // * returns the contents of a valid definitions file
+        //   described by @options
+        // * every parameter uses mode 0x22 style requests with
+        //   a unique data identifier and responses that fit in
+        //   a single frame; past 65536 requests the mode byte
+        //   is incremented (0x23, 0x24 ... 0x3F) to keep the
+        //   identifiers unique
+        // * throws InvalidArgument if there are more requests
+        //   than that
+        std::string GenerateDefinitions(DefinitionsGeneratorOptions const &options);
+
+        // WriteDefinitionsFile
+        // * writes GenerateDefinitions(@options) to @file_path
+        // * returns false if the file couldn't be written
+        bool WriteDefinitionsFile(std::string const &file_path,
+                                  DefinitionsGeneratorOptions const &options);
+
+        // GetSyntheticParameterNames
+        // * returns the names of the parameters generated for
+        //   @spec_idx and @address_idx in the same order as
+        //   the definitions file
+        std::vector<std::string>
+        GetSyntheticParameterNames(DefinitionsGeneratorOptions const &options,
+                                   uint const spec_idx,
+                                   uint const address_idx);
+
+        std::string GetSyntheticSpecName(uint const spec_idx);
+
+        std::string GetSyntheticAddressName(uint const address_idx);
+
+        // GetSyntheticEcuAddress
+        // * returns the address a VirtualVehicle ECU should
+        //   use to answer requests sent to @address_idx
+        u32 GetSyntheticEcuAddress(std::string const &protocol,
+                                   uint const address_idx);
+    }
+}
+
+#endif // OBDEX_DEFINITIONS_GENERATOR_HPP
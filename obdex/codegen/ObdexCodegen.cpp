@@ -0,0 +1,264 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/codegen/ObdexScriptTranslator.hpp>
+#include <obdex/ObdexNativeScripts.hpp>
+#include <obdex/ObdexUtil.hpp>
+#include <obdex/pugixml/pugixml.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+// obdex_codegen
+// * translates the scripts in a definitions file to C++
+//   and writes them to a source file that registers them
+//   as native scripts (see ObdexNativeScripts.hpp)
+// * scripts that can't be translated are left out and
+//   keep running as js
+
+namespace obdex
+{
+    namespace codegen
+    {
+        struct Options
+        {
+            Options() : verbose(false) {}
+
+            std::string definitions_file;
+            std::string output_file;
+            std::vector<std::string> list_parameters;
+            bool verbose;
+        };
+
+        void PrintUsage()
+        {
+            std::fprintf(stderr,
+                         "usage: obdex_codegen --definitions-file /path/to/obd2.xml --output path.cpp [options]\n"
+                         "  --definitions-file path  definitions file to translate\n"
+                         "  --output path            C++ source file to write\n"
+                         "  --parameter name         only translate scripts for this parameter\n"
+                         "                           (may be repeated)\n"
+                         "  --verbose                list the scripts that weren't translated\n");
+        }
+
+        bool ParseArgs(int argc, char * const argv[], Options &options)
+        {
+            for(int i=1; i < argc; i++)
+            {
+                std::string const arg(argv[i]);
+                if(arg == "--help" || arg == "-h")   {
+                    return false;
+                }
+                if(arg == "--verbose")   {
+                    options.verbose = true;
+                    continue;
+                }
+                if(i+1 >= argc)   {
+                    std::fprintf(stderr,"missing value for %s\n",arg.c_str());
+                    return false;
+                }
+
+                std::string const value(argv[++i]);
+                if(arg == "--definitions-file")   {
+                    options.definitions_file = value;
+                }
+                else if(arg == "--output")   {
+                    options.output_file = value;
+                }
+                else if(arg == "--parameter")   {
+                    options.list_parameters.push_back(value);
+                }
+                else   {
+                    std::fprintf(stderr,"unknown option %s\n",arg.c_str());
+                    return false;
+                }
+            }
+            return !(options.definitions_file.empty() ||
+                     options.output_file.empty());
+        }
+
+        // ============================================================= //
+
+        std::string CStringLiteral(std::string const &str)
+        {
+            std::string literal = "\"";
+            for(char c : str)   {
+                if(c == '"' || c == '\\')   {
+                    literal.push_back('\\');
+                    literal.push_back(c);
+                }
+                else if(static_cast<unsigned char>(c) < 0x20)   {
+                    char buff[8];
+                    std::snprintf(buff,sizeof(buff),"\\%03o",uint(c));
+                    literal += buff;
+                }
+                else   {
+                    literal.push_back(c);
+                }
+            }
+            literal += "\"";
+            return literal;
+        }
+
+        std::string Comment(std::string const &str)
+        {
+            std::string comment = str;
+            std::replace(comment.begin(),comment.end(),'\n',' ');
+            std::replace(comment.begin(),comment.end(),'\r',' ');
+            return "// "+comment+"\n";
+        }
+
+        // ============================================================= //
+
+        struct TranslatedScript
+        {
+            std::string function_key;
+            std::string function_name;
+            u64 script_hash;
+        };
+
+        bool Generate(Options const &options)
+        {
+            pugi::xml_document xml_doc;
+            pugi::xml_parse_result const result =
+                    xml_doc.load_file(options.definitions_file.c_str());
+            if(!result)   {
+                std::fprintf(stderr,"could not load %s: %s\n",
+                             options.definitions_file.c_str(),
+                             result.description());
+                return false;
+            }
+
+            std::string functions;
+            std::vector<TranslatedScript> list_translated;
+            size_t script_count=0;
+            size_t script_idx=0;
+
+            // same order and keys as Parser::jsInit
+            pugi::xml_node xn_spec = xml_doc.child("spec");
+            for(; xn_spec!=NULL; xn_spec=xn_spec.next_sibling("spec"))
+            {
+                std::string spec(xn_spec.attribute("name").value());
+                pugi::xml_node xn_params = xn_spec.child("parameters");
+                for(; xn_params!=NULL; xn_params=xn_params.next_sibling("parameters"))
+                {
+                    std::string address(xn_params.attribute("address").value());
+                    pugi::xml_node xn_param = xn_params.child("parameter");
+                    for(; xn_param!=NULL; xn_param=xn_param.next_sibling("parameter"))
+                    {
+                        std::string param(xn_param.attribute("name").value());
+                        pugi::xml_node xn_script = xn_param.child("script");
+                        for(; xn_script!=NULL; xn_script=xn_script.next_sibling("script"))
+                        {
+                            std::string protocols(xn_script.attribute("protocols").value());
+                            std::string script(xn_script.child_value());
+                            std::string function_key = spec+":"+address+":"+param+":"+protocols;
+                            script_idx++;
+
+                            if(!options.list_parameters.empty() &&
+                               std::find(options.list_parameters.begin(),
+                                         options.list_parameters.end(),
+                                         param) == options.list_parameters.end())   {
+                                continue;
+                            }
+                            script_count++;
+
+                            TranslatedScript translated;
+                            translated.function_key = function_key;
+                            translated.function_name = "parse";
+                            AppendUInt(translated.function_name,script_idx-1);
+                            translated.script_hash = HashScript(script);
+
+                            std::string cpp_code;
+                            std::string error;
+                            if(!TranslateScript(script,translated.function_name,
+                                                cpp_code,error))   {
+                                if(options.verbose)   {
+                                    std::fprintf(stderr,"js: %s: %s\n",
+                                                 function_key.c_str(),
+                                                 error.c_str());
+                                }
+                                continue;
+                            }
+
+                            functions += Comment(function_key);
+                            functions += cpp_code;
+                            functions += "\n";
+                            list_translated.push_back(translated);
+                        }
+                    }
+                }
+            }
+
+            std::string file;
+            file += "// Generated by obdex_codegen from ";
+            file += options.definitions_file.substr(
+                        options.definitions_file.find_last_of("/\\")+1);
+            file += "; do not edit.\n";
+            file += "// Scripts that aren't listed here run as js.\n\n";
+            file += "#include <obdex/ObdexNativeScripts.hpp>\n\n";
+            file += "#include <cmath>\n\n";
+            file += "namespace\n{\n";
+            file += "using namespace obdex;\n";
+            file += "using namespace obdex::native;\n\n";
+            file += functions;
+
+            if(list_translated.empty())   {
+                file += "NativeScriptRegistration const registration(nullptr,0);\n";
+            }
+            else   {
+                file += "NativeScript const k_list_native_scripts[] = {\n";
+                for(auto const &translated : list_translated)   {
+                    file += "    { "+CStringLiteral(translated.function_key)+", 0x";
+                    AppendHex(file,translated.script_hash,false,16);
+                    file += "ull, "+translated.function_name+" },\n";
+                }
+                file += "};\n\n";
+                file += "NativeScriptRegistration const registration(\n";
+                file += "        k_list_native_scripts,\n";
+                file += "        sizeof(k_list_native_scripts)/sizeof(NativeScript));\n";
+            }
+            file += "}\n";
+
+            std::ofstream output(options.output_file.c_str(),
+                                 std::ios::out | std::ios::trunc);
+            output << file;
+            output.close();
+            if(!output)   {
+                std::fprintf(stderr,"could not write %s\n",
+                             options.output_file.c_str());
+                return false;
+            }
+
+            std::fprintf(stderr,"translated %zu of %zu scripts\n",
+                         list_translated.size(),script_count);
+            return true;
+        }
+    }
+}
+
+using namespace obdex;
+
+int main(int argc, char * const argv[])
+{
+    codegen::Options options;
+    if(!codegen::ParseArgs(argc,argv,options))   {
+        codegen::PrintUsage();
+        return 1;
+    }
+    return codegen::Generate(options) ? 0 : 1;
+}
@@ -0,0 +1,1373 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/codegen/ObdexScriptTranslator.hpp>
+#include <obdex/ObdexScriptAnalysis.hpp>
+#include <obdex/ObdexUtil.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+namespace obdex
+{
+    namespace codegen
+    {
+        namespace
+        {
+            // ValueType
+            // * every local and expression has a single type
+            //   that's known when the script is translated
+            enum ValueType
+            {
+                TYPE_UNDEFINED,     // untyped locals, void calls
+                TYPE_NUMBER,        // double
+                TYPE_BOOL,          // bool
+                TYPE_STRING,        // std::string (ascii only)
+                TYPE_NUM_OBJ,       // NumericalData *
+                TYPE_LIT_OBJ,       // LiteralData *
+                TYPE_STRING_ARRAY,  // std::vector<std::string>
+                TYPE_NUMBER_ARRAY,  // std::vector<double>
+                TYPE_MESSAGE,       // size_t (request index)
+                TYPE_BYTES          // ByteList const *
+            };
+
+            enum LValueKind
+            {
+                LVALUE_NONE,
+                LVALUE_VAR,
+                LVALUE_FIELD
+            };
+
+            struct Expr
+            {
+                Expr() :
+                    type(TYPE_UNDEFINED),
+                    lvalue(LVALUE_NONE),
+                    side_effects(false)
+                {}
+
+                Expr(ValueType type, std::string code, bool side_effects=false) :
+                    type(type),
+                    code(std::move(code)),
+                    lvalue(LVALUE_NONE),
+                    side_effects(side_effects)
+                {}
+
+                ValueType type;
+                std::string code;
+                LValueKind lvalue;
+                std::string var_name;   // LVALUE_VAR
+                bool side_effects;
+            };
+
+            struct TranslateError
+            {
+                std::string msg;
+            };
+
+            char const * const k_list_assign_ops[] = {
+                "=", "+=", "-=", "*=", "/=", "%=", "&=", "|=",
+                "^=", "<<=", ">>=", ">>>="
+            };
+
+            // binary operators by precedence, lowest first
+            struct BinaryOp
+            {
+                char const * op;
+                uint prec;
+            };
+
+            BinaryOp const k_list_binary_ops[] = {
+                {"||",1}, {"&&",2}, {"|",3}, {"^",4}, {"&",5},
+                {"==",6}, {"!=",6}, {"===",6}, {"!==",6},
+                {"<",7}, {">",7}, {"<=",7}, {">=",7},
+                {"<<",8}, {">>",8}, {">>>",8},
+                {"+",9}, {"-",9},
+                {"*",10}, {"/",10}, {"%",10}
+            };
+
+            template<size_t N>
+            bool IsOneOf(std::string const &str, char const * const (&list)[N])
+            {
+                for(size_t i=0; i < N; i++)   {
+                    if(str == list[i])   {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            std::string CppType(ValueType type)
+            {
+                switch(type)
+                {
+                    case TYPE_NUMBER:       return "double";
+                    case TYPE_BOOL:         return "bool";
+                    case TYPE_STRING:       return "std::string";
+                    case TYPE_NUM_OBJ:      return "NumericalData *";
+                    case TYPE_LIT_OBJ:      return "LiteralData *";
+                    case TYPE_STRING_ARRAY: return "std::vector<std::string>";
+                    case TYPE_NUMBER_ARRAY: return "std::vector<double>";
+                    case TYPE_MESSAGE:      return "size_t";
+                    case TYPE_BYTES:        return "ByteList const *";
+                    default:                return "";
+                }
+            }
+
+            // CppInitialValue
+            // * locals start out as undefined in js; these
+            //   values behave the same way when they're used
+            //   (NaN in arithmetic, "undefined" in strings and
+            //   a bail for objects)
+            std::string CppInitialValue(ValueType type)
+            {
+                switch(type)
+                {
+                    case TYPE_NUMBER:   return "NAN";
+                    case TYPE_BOOL:     return "false";
+                    case TYPE_STRING:   return "\"undefined\"";
+                    case TYPE_MESSAGE:  return "size_t(-1)";
+                    case TYPE_NUM_OBJ:
+                    case TYPE_LIT_OBJ:
+                    case TYPE_BYTES:    return "nullptr";
+                    default:            return "";
+                }
+            }
+
+            std::string NumberLiteral(double val)
+            {
+                char buff[40];
+                if(val == std::floor(val) && std::fabs(val) < 1e15)   {
+                    std::snprintf(buff,sizeof(buff),"%.1f",val);
+                }
+                else   {
+                    std::snprintf(buff,sizeof(buff),"%.17g",val);
+                }
+                std::string literal(buff);
+                if(literal.find_first_of(".e") == std::string::npos)   {
+                    literal += ".0";
+                }
+                return literal;
+            }
+
+            std::string StringLiteral(std::string const &str)
+            {
+                std::string literal = "std::string(\"";
+                bool has_nul = false;
+                for(char c : str)   {
+                    if(c == '"' || c == '\\')   {
+                        literal.push_back('\\');
+                        literal.push_back(c);
+                    }
+                    else if(c < 0x20 || c == 0x7F)   {
+                        // octal escapes take at most three digits
+                        char buff[8];
+                        std::snprintf(buff,sizeof(buff),"\\%03o",uint(c));
+                        literal += buff;
+                        has_nul = has_nul || (c == 0);
+                    }
+                    else   {
+                        literal.push_back(c);
+                    }
+                }
+                literal += "\"";
+                if(has_nul)   {
+                    literal += ",";
+                    AppendUInt(literal,str.size());
+                }
+                literal += ")";
+                return literal;
+            }
+
+            // StripParens
+            // * removes parentheses around all of @code
+            std::string StripParens(std::string const &code)
+            {
+                if(code.size() < 2 || code.front() != '(' || code.back() != ')')   {
+                    return code;
+                }
+
+                // skips parentheses in string literals
+                int depth=0;
+                bool in_string=false;
+                for(size_t i=0; i+1 < code.size(); i++)   {
+                    char const c = code[i];
+                    if(in_string)   {
+                        if(c == '\\')   { i++; }
+                        else if(c == '"')   { in_string = false; }
+                        continue;
+                    }
+                    if(c == '"')   { in_string = true; }
+                    else if(c == '(')   { depth++; }
+                    else if(c == ')')   { depth--; }
+                    if(depth == 0)   {
+                        return code;
+                    }
+                }
+                return code.substr(1,code.size()-2);
+            }
+
+            // ============================================================= //
+            // ============================================================= //
+
+            class Translator
+            {
+            public:
+                Translator(std::string const &script,
+                           std::vector<ScriptToken> const &list_tokens) :
+                    m_script(script),
+                    m_list_tokens(list_tokens),
+                    m_pos(0),
+                    m_loop_depth(0),
+                    m_break_depth(0),
+                    m_switch_count(0)
+                {}
+
+                void Translate(std::string const &function_name,
+                               std::string &cpp_code)
+                {
+                    std::string body;
+                    while(m_pos < m_list_tokens.size())   {
+                        statement(body,1);
+                    }
+
+                    std::string const run_name = "run_"+function_name;
+
+                    cpp_code += "void "+run_name+"(NativeScriptInput const &input, Objects &objs)\n";
+                    cpp_code += "{\n";
+                    cpp_code += "    (void)input;\n";
+                    cpp_code += "    (void)objs;\n";
+                    for(auto const &name : m_list_var_names)   {
+                        ValueType const type = m_lkup_var_types[name];
+                        if(type == TYPE_UNDEFINED)   {
+                            continue;
+                        }
+                        cpp_code += "    "+CppType(type)+" v_"+name;
+                        std::string const init = CppInitialValue(type);
+                        if(!init.empty())   {
+                            cpp_code += " = "+init;
+                        }
+                        cpp_code += "; (void)v_"+name+";\n";
+                    }
+                    if(!m_list_var_names.empty())   {
+                        cpp_code += "\n";
+                    }
+                    cpp_code += body;
+                    cpp_code += "}\n\n";
+
+                    cpp_code += "void "+function_name+"(NativeScriptInput const &input, Data &data)\n";
+                    cpp_code += "{\n";
+                    cpp_code += "    Objects objs;\n";
+                    cpp_code += "    "+run_name+"(input,objs);\n";
+                    cpp_code += "    objs.SaveTo(data);\n";
+                    cpp_code += "}\n";
+                }
+
+            private:
+                // ============================================================= //
+
+                [[noreturn]] void fail(std::string const &msg) const
+                {
+                    TranslateError error;
+                    error.msg = msg;
+                    if(m_pos < m_list_tokens.size())   {
+                        error.msg += " at '"+m_list_tokens[m_pos].text+"' (offset ";
+                        AppendUInt(error.msg,m_list_tokens[m_pos].offset);
+                        error.msg += ")";
+                    }
+                    else   {
+                        error.msg += " at end of script";
+                    }
+                    throw error;
+                }
+
+                bool atEnd() const
+                {
+                    return (m_pos >= m_list_tokens.size());
+                }
+
+                bool isPunct(char const * text, size_t ahead=0) const
+                {
+                    size_t const idx = m_pos+ahead;
+                    return (idx < m_list_tokens.size() &&
+                            m_list_tokens[idx].type == SCRIPT_TOKEN_PUNCTUATOR &&
+                            m_list_tokens[idx].text == text);
+                }
+
+                bool isName(char const * text, size_t ahead=0) const
+                {
+                    size_t const idx = m_pos+ahead;
+                    return (idx < m_list_tokens.size() &&
+                            m_list_tokens[idx].type == SCRIPT_TOKEN_IDENTIFIER &&
+                            m_list_tokens[idx].text == text);
+                }
+
+                bool acceptPunct(char const * text)
+                {
+                    if(isPunct(text))   {
+                        m_pos++;
+                        return true;
+                    }
+                    return false;
+                }
+
+                bool acceptName(char const * text)
+                {
+                    if(isName(text))   {
+                        m_pos++;
+                        return true;
+                    }
+                    return false;
+                }
+
+                void expectPunct(char const * text)
+                {
+                    if(!acceptPunct(text))   {
+                        fail(std::string("expected '")+text+"'");
+                    }
+                }
+
+                std::string expectIdentifier()
+                {
+                    if(atEnd() || m_list_tokens[m_pos].type != SCRIPT_TOKEN_IDENTIFIER)   {
+                        fail("expected a name");
+                    }
+                    return m_list_tokens[m_pos++].text;
+                }
+
+                // newlineBefore
+                // * true if there's a line break between the
+                //   previous token and the current one
+                bool newlineBefore() const
+                {
+                    if(m_pos == 0 || atEnd())   {
+                        return true;
+                    }
+                    ScriptToken const &prev = m_list_tokens[m_pos-1];
+                    size_t const begin = prev.offset+prev.text.size();
+                    size_t const end = m_list_tokens[m_pos].offset;
+                    return (m_script.find('\n',begin) < end);
+                }
+
+                // endStatement
+                // * semicolons can be left out at the end of
+                //   a line, before a '}' and at the end
+                void endStatement()
+                {
+                    if(acceptPunct(";") || atEnd() ||
+                       isPunct("}") || newlineBefore())   {
+                        return;
+                    }
+                    fail("expected ';'");
+                }
+
+                // ============================================================= //
+
+                void statement(std::string &out, uint depth)
+                {
+                    std::string const indent(depth*4,' ');
+
+                    if(acceptPunct(";"))   {
+                        return;
+                    }
+                    if(acceptPunct("{"))   {
+                        out += indent+"{\n";
+                        while(!acceptPunct("}"))   {
+                            if(atEnd())   {
+                                fail("expected '}'");
+                            }
+                            statement(out,depth+1);
+                        }
+                        out += indent+"}\n";
+                        return;
+                    }
+                    if(acceptName("var"))   {
+                        varDeclarations(out,indent);
+                        endStatement();
+                        return;
+                    }
+                    if(acceptName("if"))   {
+                        expectPunct("(");
+                        Expr const cond = expression();
+                        expectPunct(")");
+                        out += indent+"if("+truthy(cond)+")\n";
+                        subStatement(out,depth);
+                        if(acceptName("else"))   {
+                            out += indent+"else\n";
+                            subStatement(out,depth);
+                        }
+                        return;
+                    }
+                    if(acceptName("for"))   {
+                        forStatement(out,depth);
+                        return;
+                    }
+                    if(acceptName("while"))   {
+                        expectPunct("(");
+                        Expr const cond = expression();
+                        expectPunct(")");
+                        out += indent+"while("+loopCondition(truthy(cond))+")\n";
+                        loopBody(out,depth);
+                        return;
+                    }
+                    if(acceptName("do"))   {
+                        out += indent+"do\n";
+                        loopBody(out,depth);
+                        if(!acceptName("while"))   {
+                            fail("expected 'while'");
+                        }
+                        expectPunct("(");
+                        Expr const cond = expression();
+                        expectPunct(")");
+                        acceptPunct(";");
+                        out += indent+"while("+loopCondition(truthy(cond))+");\n";
+                        return;
+                    }
+                    if(acceptName("switch"))   {
+                        switchStatement(out,depth);
+                        return;
+                    }
+                    if(acceptName("break"))   {
+                        if(m_break_depth == 0)   {
+                            fail("break outside of a loop or switch");
+                        }
+                        endStatement();
+                        out += indent+"break;\n";
+                        return;
+                    }
+                    if(acceptName("continue"))   {
+                        if(m_loop_depth == 0)   {
+                            fail("continue outside of a loop");
+                        }
+                        endStatement();
+                        out += indent+"continue;\n";
+                        return;
+                    }
+                    if(acceptName("return"))   {
+                        if(!(atEnd() || isPunct(";") || isPunct("}") || newlineBefore()))   {
+                            Expr const e = expression();
+                            out += indent+discard(e)+";\n";
+                        }
+                        endStatement();
+                        out += indent+"return;\n";
+                        return;
+                    }
+
+                    if(!atEnd() && m_list_tokens[m_pos].type == SCRIPT_TOKEN_IDENTIFIER)   {
+                        std::string const &name = m_list_tokens[m_pos].text;
+                        if(name == "function" || name == "try" ||
+                           name == "throw" || name == "with" ||
+                           name == "else" || name == "case" ||
+                           name == "default")   {
+                            fail("unsupported statement");
+                        }
+                    }
+
+                    Expr const e = expression();
+                    endStatement();
+                    out += indent+discard(e)+";\n";
+                }
+
+                // subStatement
+                // * the body of an if, else or loop; always
+                //   emitted as a block
+                void subStatement(std::string &out, uint depth)
+                {
+                    if(isPunct("{"))   {
+                        statement(out,depth);
+                        return;
+                    }
+                    std::string const indent(depth*4,' ');
+                    out += indent+"{\n";
+                    statement(out,depth+1);
+                    out += indent+"}\n";
+                }
+
+                void loopBody(std::string &out, uint depth)
+                {
+                    m_loop_depth++;
+                    m_break_depth++;
+                    subStatement(out,depth);
+                    m_loop_depth--;
+                    m_break_depth--;
+                }
+
+                void varDeclarations(std::string &out, std::string const &indent)
+                {
+                    do   {
+                        std::string const name = expectIdentifier();
+                        declareVar(name);
+                        if(acceptPunct("="))   {
+                            Expr lhs;
+                            lhs.lvalue = LVALUE_VAR;
+                            lhs.var_name = name;
+                            lhs.type = m_lkup_var_types[name];
+                            lhs.code = "v_"+name;
+                            Expr const rhs = assignment();
+                            out += indent+discard(assign(lhs,"=",rhs))+";\n";
+                        }
+                    }
+                    while(acceptPunct(","));
+                }
+
+                void forStatement(std::string &out, uint depth)
+                {
+                    std::string const indent(depth*4,' ');
+                    std::string const inner_indent((depth+1)*4,' ');
+
+                    expectPunct("(");
+                    std::string init;
+                    if(acceptName("var"))   {
+                        varDeclarations(init,inner_indent);
+                    }
+                    else if(!isPunct(";"))   {
+                        init += inner_indent+discard(expression())+";\n";
+                    }
+                    expectPunct(";");
+
+                    std::string cond = "true";
+                    if(!isPunct(";"))   {
+                        cond = truthy(expression());
+                    }
+                    expectPunct(";");
+
+                    std::string update;
+                    if(!isPunct(")"))   {
+                        update = StripParens(expression().code);
+                    }
+                    expectPunct(")");
+
+                    out += indent+"{\n";
+                    out += init;
+                    out += inner_indent+"for(; "+loopCondition(cond)+"; "+update+")\n";
+                    loopBody(out,depth+1);
+                    out += indent+"}\n";
+                }
+
+                // switchStatement
+                // * the matching clause is found first (js uses
+                //   strict equality) and then a C++ switch on its
+                //   index jumps to it, which keeps fall through
+                //   and break the same as js
+                void switchStatement(std::string &out, uint depth)
+                {
+                    std::string const indent(depth*4,' ');
+                    std::string const inner_indent((depth+1)*4,' ');
+
+                    std::string const id = std::to_string(m_switch_count++);
+                    std::string const value_name = "switch_value"+id;
+                    std::string const case_name = "switch_case"+id;
+
+                    expectPunct("(");
+                    Expr const value = expression();
+                    expectPunct(")");
+                    expectPunct("{");
+                    if(CppType(value.type).empty() ||
+                       value.type == TYPE_STRING_ARRAY ||
+                       value.type == TYPE_NUMBER_ARRAY)   {
+                        fail("unsupported switch value");
+                    }
+
+                    std::string match;
+                    std::string body;
+                    int default_idx = -1;
+                    int clause_idx = 0;
+
+                    m_break_depth++;
+                    while(!acceptPunct("}"))
+                    {
+                        if(acceptName("case"))   {
+                            Expr const label = expression();
+                            if(label.side_effects)   {
+                                fail("case label with side effects");
+                            }
+                            std::string const cond = strictEquals(value,value_name,label);
+                            match += inner_indent+(match.empty() ? "if(" : "else if(")+
+                                     cond+") { "+case_name+" = "+
+                                     std::to_string(clause_idx)+"; }\n";
+                        }
+                        else if(acceptName("default"))   {
+                            default_idx = clause_idx;
+                        }
+                        else   {
+                            fail("expected 'case' or 'default'");
+                        }
+                        expectPunct(":");
+
+                        body += inner_indent+"case "+std::to_string(clause_idx)+":\n";
+                        while(!(isName("case") || isName("default") || isPunct("}")))   {
+                            if(atEnd())   {
+                                fail("expected '}'");
+                            }
+                            statement(body,depth+2);
+                        }
+                        clause_idx++;
+                    }
+                    m_break_depth--;
+
+                    out += indent+"{\n";
+                    out += inner_indent+CppType(value.type)+" const "+value_name+" = "+value.code+";\n";
+                    out += inner_indent+"int "+case_name+" = "+std::to_string(default_idx)+";\n";
+                    out += match;
+                    out += inner_indent+"switch("+case_name+")\n";
+                    out += inner_indent+"{\n";
+                    out += body;
+                    out += inner_indent+"default:\n";
+                    out += inner_indent+"    break;\n";
+                    out += inner_indent+"}\n";
+                    out += indent+"}\n";
+                }
+
+                std::string strictEquals(Expr const &value,
+                                         std::string const &value_name,
+                                         Expr const &label)
+                {
+                    if(value.type != label.type)   {
+                        // evaluated for any bails it might have
+                        return "(static_cast<void>("+label.code+"), false)";
+                    }
+                    return "("+value_name+" == "+label.code+")";
+                }
+
+                // ============================================================= //
+
+                void declareVar(std::string const &name)
+                {
+                    for(char c : name)   {
+                        if(c == '$')   {
+                            fail("unsupported name");
+                        }
+                    }
+                    if(m_lkup_var_types.count(name) == 0)   {
+                        m_lkup_var_types[name] = TYPE_UNDEFINED;
+                        m_list_var_names.push_back(name);
+                    }
+                }
+
+                std::string discard(Expr const &e) const
+                {
+                    if(e.type == TYPE_UNDEFINED || e.side_effects)   {
+                        return StripParens(e.code);
+                    }
+                    return "static_cast<void>("+e.code+")";
+                }
+
+                std::string num(Expr const &e) const
+                {
+                    if(e.type == TYPE_NUMBER)   {
+                        return e.code;
+                    }
+                    if(e.type == TYPE_BOOL)   {
+                        return "("+e.code+" ? 1.0 : 0.0)";
+                    }
+                    fail("expected a number");
+                }
+
+                std::string str(Expr const &e) const
+                {
+                    if(e.type == TYPE_STRING)   {
+                        return e.code;
+                    }
+                    if(e.type == TYPE_NUMBER)   {
+                        return "NumberToString("+e.code+",10.0)";
+                    }
+                    if(e.type == TYPE_BOOL)   {
+                        return "std::string("+e.code+" ? \"true\" : \"false\")";
+                    }
+                    fail("expected a string");
+                }
+
+                std::string truthy(Expr const &e) const
+                {
+                    switch(e.type)
+                    {
+                        case TYPE_BOOL:     return e.code;
+                        case TYPE_NUMBER:   return "Truthy("+e.code+")";
+                        case TYPE_STRING:   return "(!"+e.code+".empty())";
+                        case TYPE_NUM_OBJ:
+                        case TYPE_LIT_OBJ:
+                        case TYPE_BYTES:    return "("+e.code+" != nullptr)";
+                        default:            fail("unsupported condition");
+                    }
+                }
+
+                // loopCondition
+                // * counts a step for the script budget before
+                //   every check of a loop's condition
+                std::string loopCondition(std::string const &cond) const
+                {
+                    return "input.Step() && ("+cond+")";
+                }
+
+                // noSideEffects
+                // * C++ doesn't define the order operands and
+                //   arguments are evaluated in, so they can't
+                //   change anything
+                void noSideEffects(Expr const &a, Expr const &b) const
+                {
+                    if(a.side_effects || b.side_effects)   {
+                        fail("operands with side effects");
+                    }
+                }
+
+                // ============================================================= //
+
+                Expr expression()
+                {
+                    Expr e = assignment();
+                    while(acceptPunct(","))   {
+                        Expr const next = assignment();
+                        e = Expr(next.type,
+                                 "("+discard(e)+", "+next.code+")",
+                                 e.side_effects || next.side_effects);
+                    }
+                    return e;
+                }
+
+                Expr assignment()
+                {
+                    Expr lhs = conditional();
+                    if(!atEnd() &&
+                       m_list_tokens[m_pos].type == SCRIPT_TOKEN_PUNCTUATOR &&
+                       IsOneOf(m_list_tokens[m_pos].text,k_list_assign_ops))
+                    {
+                        std::string const op = m_list_tokens[m_pos++].text;
+                        Expr const rhs = assignment();
+                        return assign(lhs,op,rhs);
+                    }
+                    return lhs;
+                }
+
+                Expr assign(Expr const &lhs, std::string const &op, Expr const &rhs)
+                {
+                    if(lhs.lvalue == LVALUE_NONE)   {
+                        fail("invalid assignment");
+                    }
+                    if(lhs.lvalue == LVALUE_FIELD)   {
+                        noSideEffects(lhs,rhs);
+                    }
+
+                    ValueType type = lhs.type;
+                    if(op == "=")   {
+                        if(rhs.type == TYPE_UNDEFINED)   {
+                            fail("assigning undefined");
+                        }
+                        if(lhs.lvalue == LVALUE_VAR && type == TYPE_UNDEFINED)   {
+                            // a local's first assignment sets its type
+                            type = rhs.type;
+                            m_lkup_var_types[lhs.var_name] = type;
+                        }
+                        if(type != rhs.type)   {
+                            fail("assignment changes the type");
+                        }
+                        return Expr(type,"("+lhs.code+" = "+rhs.code+")",true);
+                    }
+
+                    if(type == TYPE_STRING && op == "+=")   {
+                        return Expr(type,"("+lhs.code+" += "+str(rhs)+")",true);
+                    }
+                    if(type != TYPE_NUMBER || rhs.type == TYPE_STRING)   {
+                        fail("compound assignment changes the type");
+                    }
+
+                    std::string const value = num(rhs);
+                    std::string code;
+                    if(op == "+=" || op == "-=" || op == "*=" || op == "/=")   {
+                        code = lhs.code+" "+op+" "+value;
+                    }
+                    else   {
+                        std::string fn;
+                        if(op == "%=")   { fn = "std::fmod"; }
+                        else if(op == "&=")   { fn = "BitAnd"; }
+                        else if(op == "|=")   { fn = "BitOr"; }
+                        else if(op == "^=")   { fn = "BitXor"; }
+                        else if(op == "<<=")   { fn = "ShiftLeft"; }
+                        else if(op == ">>=")   { fn = "ShiftRight"; }
+                        else   { fn = "ShiftRightUnsigned"; }
+                        code = lhs.code+" = "+fn+"("+lhs.code+","+value+")";
+                    }
+                    return Expr(type,"("+code+")",true);
+                }
+
+                Expr conditional()
+                {
+                    Expr const cond = binary(1);
+                    if(!acceptPunct("?"))   {
+                        return cond;
+                    }
+                    Expr const a = assignment();
+                    expectPunct(":");
+                    Expr const b = assignment();
+                    if(a.type != b.type || a.type == TYPE_UNDEFINED)   {
+                        fail("conditional with different types");
+                    }
+                    return Expr(a.type,
+                                "("+truthy(cond)+" ? "+a.code+" : "+b.code+")",
+                                cond.side_effects || a.side_effects || b.side_effects);
+                }
+
+                Expr binary(uint min_prec)
+                {
+                    Expr lhs = unary();
+                    while(!atEnd() && m_list_tokens[m_pos].type == SCRIPT_TOKEN_PUNCTUATOR)
+                    {
+                        std::string const &op = m_list_tokens[m_pos].text;
+                        uint prec=0;
+                        for(auto const &bin_op : k_list_binary_ops)   {
+                            if(op == bin_op.op)   {
+                                prec = bin_op.prec;
+                                break;
+                            }
+                        }
+                        if(prec == 0 || prec < min_prec)   {
+                            break;
+                        }
+                        std::string const op_text = op;
+                        m_pos++;
+                        Expr const rhs = binary(prec+1);
+                        lhs = binaryOp(op_text,lhs,rhs);
+                    }
+                    return lhs;
+                }
+
+                Expr binaryOp(std::string const &op, Expr const &a, Expr const &b)
+                {
+                    // && and || keep js short circuiting for
+                    // booleans; numbers evaluate both sides
+                    if(op == "&&" || op == "||")   {
+                        if(a.type == TYPE_BOOL && b.type == TYPE_BOOL)   {
+                            return Expr(TYPE_BOOL,"("+a.code+" "+op+" "+b.code+")",
+                                        a.side_effects || b.side_effects);
+                        }
+                        if(a.type == TYPE_NUMBER && b.type == TYPE_NUMBER)   {
+                            noSideEffects(a,b);
+                            std::string const fn = (op == "&&") ? "JsAnd" : "JsOr";
+                            return Expr(TYPE_NUMBER,fn+"("+a.code+","+b.code+")");
+                        }
+                        fail("logical operator on different types");
+                    }
+
+                    noSideEffects(a,b);
+
+                    if(op == "+")   {
+                        if(a.type == TYPE_STRING || b.type == TYPE_STRING)   {
+                            return Expr(TYPE_STRING,"("+str(a)+" + "+str(b)+")");
+                        }
+                        return Expr(TYPE_NUMBER,"("+num(a)+" + "+num(b)+")");
+                    }
+                    if(op == "-" || op == "*" || op == "/")   {
+                        return Expr(TYPE_NUMBER,"("+num(a)+" "+op+" "+num(b)+")");
+                    }
+                    if(op == "%")   {
+                        return Expr(TYPE_NUMBER,"std::fmod("+num(a)+","+num(b)+")");
+                    }
+
+                    std::string fn;
+                    if(op == "&")   { fn = "BitAnd"; }
+                    else if(op == "|")   { fn = "BitOr"; }
+                    else if(op == "^")   { fn = "BitXor"; }
+                    else if(op == "<<")   { fn = "ShiftLeft"; }
+                    else if(op == ">>")   { fn = "ShiftRight"; }
+                    else if(op == ">>>")   { fn = "ShiftRightUnsigned"; }
+                    if(!fn.empty())   {
+                        return Expr(TYPE_NUMBER,fn+"("+num(a)+","+num(b)+")");
+                    }
+
+                    // comparisons
+                    bool const strict = (op == "===" || op == "!==");
+                    std::string const cpp_op = strict ? op.substr(0,2) : op;
+                    bool const equality = (cpp_op == "==" || cpp_op == "!=");
+
+                    if(a.type == TYPE_STRING || b.type == TYPE_STRING)   {
+                        if(a.type != b.type)   {
+                            fail("comparing a string to another type");
+                        }
+                        return Expr(TYPE_BOOL,"("+a.code+" "+cpp_op+" "+b.code+")");
+                    }
+                    if(equality && a.type == b.type &&
+                       (a.type == TYPE_NUM_OBJ || a.type == TYPE_LIT_OBJ ||
+                        a.type == TYPE_BOOL))   {
+                        return Expr(TYPE_BOOL,"("+a.code+" "+cpp_op+" "+b.code+")");
+                    }
+                    if(strict && a.type != b.type)   {
+                        fail("strict comparison of different types");
+                    }
+                    return Expr(TYPE_BOOL,"("+num(a)+" "+cpp_op+" "+num(b)+")");
+                }
+
+                Expr unary()
+                {
+                    if(acceptPunct("!"))   {
+                        Expr const e = unary();
+                        return Expr(TYPE_BOOL,"(!"+truthy(e)+")",e.side_effects);
+                    }
+                    if(acceptPunct("-"))   {
+                        Expr const e = unary();
+                        return Expr(TYPE_NUMBER,"(-"+num(e)+")",e.side_effects);
+                    }
+                    if(acceptPunct("+"))   {
+                        Expr const e = unary();
+                        return Expr(TYPE_NUMBER,num(e),e.side_effects);
+                    }
+                    if(acceptPunct("~"))   {
+                        Expr const e = unary();
+                        return Expr(TYPE_NUMBER,"BitNot("+num(e)+")",e.side_effects);
+                    }
+                    if(isPunct("++") || isPunct("--"))   {
+                        std::string const op = m_list_tokens[m_pos++].text;
+                        Expr const e = unary();
+                        if(e.lvalue == LVALUE_NONE || e.type != TYPE_NUMBER)   {
+                            fail("invalid increment");
+                        }
+                        return Expr(TYPE_NUMBER,"("+op+e.code+")",true);
+                    }
+                    if(isName("typeof") || isName("void") || isName("delete"))   {
+                        fail("unsupported operator");
+                    }
+
+                    Expr e = leftHandSide();
+                    if((isPunct("++") || isPunct("--")) && !newlineBefore())   {
+                        std::string const op = m_list_tokens[m_pos++].text;
+                        if(e.lvalue == LVALUE_NONE || e.type != TYPE_NUMBER)   {
+                            fail("invalid increment");
+                        }
+                        return Expr(TYPE_NUMBER,"("+e.code+op+")",true);
+                    }
+                    return e;
+                }
+
+                std::vector<Expr> arguments(size_t count)
+                {
+                    std::vector<Expr> list_args;
+                    expectPunct("(");
+                    if(!isPunct(")"))   {
+                        do   {
+                            list_args.push_back(assignment());
+                        }
+                        while(acceptPunct(","));
+                    }
+                    expectPunct(")");
+                    if(list_args.size() != count)   {
+                        fail("wrong number of arguments");
+                    }
+                    for(auto const &arg : list_args)   {
+                        if(arg.side_effects && count > 1)   {
+                            fail("arguments with side effects");
+                        }
+                    }
+                    return list_args;
+                }
+
+                Expr leftHandSide()
+                {
+                    Expr e = primary();
+                    while(true)
+                    {
+                        if(acceptPunct("."))   {
+                            std::string const name = expectIdentifier();
+                            e = member(e,name);
+                        }
+                        else if(acceptPunct("["))   {
+                            Expr const idx = expression();
+                            expectPunct("]");
+                            noSideEffects(e,idx);
+                            if(e.type == TYPE_STRING_ARRAY)   {
+                                e = Expr(TYPE_STRING,"At("+e.code+","+num(idx)+")");
+                            }
+                            else if(e.type == TYPE_NUMBER_ARRAY)   {
+                                e = Expr(TYPE_NUMBER,"At("+e.code+","+num(idx)+")");
+                            }
+                            else   {
+                                fail("unsupported index");
+                            }
+                        }
+                        else if(isPunct("("))   {
+                            fail("unsupported call");
+                        }
+                        else   {
+                            break;
+                        }
+                    }
+                    return e;
+                }
+
+                Expr member(Expr const &e, std::string const &name)
+                {
+                    // data object fields
+                    if(e.type == TYPE_NUM_OBJ || e.type == TYPE_LIT_OBJ)   {
+                        bool const num_obj = (e.type == TYPE_NUM_OBJ);
+                        Expr field;
+                        if(name == "value")   {
+                            field.type = num_obj ? TYPE_NUMBER : TYPE_BOOL;
+                            field.code = "value";
+                        }
+                        else if(num_obj && (name == "min" || name == "max"))   {
+                            field.type = TYPE_NUMBER;
+                            field.code = name;
+                        }
+                        else if(name == "property" || (num_obj && name == "units"))   {
+                            field.type = TYPE_STRING;
+                            field.code = name;
+                        }
+                        else if(!num_obj && name == "valueIfFalse")   {
+                            field.type = TYPE_STRING;
+                            field.code = "value_if_false";
+                        }
+                        else if(!num_obj && name == "valueIfTrue")   {
+                            field.type = TYPE_STRING;
+                            field.code = "value_if_true";
+                        }
+                        else   {
+                            fail("unsupported property");
+                        }
+                        field.code = "Obj("+e.code+")->"+field.code;
+                        field.lvalue = LVALUE_FIELD;
+                        field.side_effects = e.side_effects;
+                        return field;
+                    }
+
+                    if(e.type == TYPE_BYTES)   {
+                        if(name == "BYTE")   {
+                            std::vector<Expr> const args = arguments(1);
+                            noSideEffects(e,args[0]);
+                            return Expr(TYPE_NUMBER,"Byte("+e.code+","+num(args[0])+")");
+                        }
+                        if(name == "BIT")   {
+                            std::vector<Expr> const args = arguments(2);
+                            noSideEffects(e,args[0]);
+                            return Expr(TYPE_NUMBER,"Bit("+e.code+","+num(args[0])+","+num(args[1])+")");
+                        }
+                        if(name == "LENGTH")   {
+                            arguments(0);
+                            return Expr(TYPE_NUMBER,"Length("+e.code+")",e.side_effects);
+                        }
+                    }
+
+                    if(e.type == TYPE_MESSAGE && (name == "DATA" || name == "HEADER"))   {
+                        std::vector<Expr> const args = arguments(1);
+                        noSideEffects(e,args[0]);
+                        std::string const fn = (name == "DATA") ? "DataBytes" : "HeaderBytes";
+                        return Expr(TYPE_BYTES,fn+"(input,"+e.code+","+num(args[0])+")");
+                    }
+
+                    if(e.type == TYPE_NUMBER && name == "toString")   {
+                        std::string radix = "10.0";
+                        if(isPunct(")",1))   {
+                            arguments(0);
+                        }
+                        else   {
+                            std::vector<Expr> const args = arguments(1);
+                            noSideEffects(e,args[0]);
+                            radix = num(args[0]);
+                        }
+                        return Expr(TYPE_STRING,"NumberToString("+e.code+","+radix+")",e.side_effects);
+                    }
+
+                    if(e.type == TYPE_STRING)   {
+                        if(name == "toUpperCase" || name == "toLowerCase")   {
+                            arguments(0);
+                            std::string const fn = (name == "toUpperCase") ? "ToUpperCase" : "ToLowerCase";
+                            return Expr(TYPE_STRING,fn+"("+e.code+")",e.side_effects);
+                        }
+                        if(name == "length")   {
+                            return Expr(TYPE_NUMBER,"double("+e.code+".size())",e.side_effects);
+                        }
+                    }
+
+                    if((e.type == TYPE_STRING_ARRAY || e.type == TYPE_NUMBER_ARRAY) &&
+                       name == "length")   {
+                        return Expr(TYPE_NUMBER,"double("+e.code+".size())",e.side_effects);
+                    }
+
+                    fail("unsupported property");
+                }
+
+                Expr primary()
+                {
+                    if(atEnd())   {
+                        fail("expected an expression");
+                    }
+
+                    ScriptToken const &token = m_list_tokens[m_pos];
+                    if(token.type == SCRIPT_TOKEN_NUMBER)   {
+                        m_pos++;
+                        return Expr(TYPE_NUMBER,NumberLiteral(parseNumber(token.text)));
+                    }
+                    if(token.type == SCRIPT_TOKEN_STRING)   {
+                        m_pos++;
+                        return Expr(TYPE_STRING,StringLiteral(parseString(token.text)));
+                    }
+                    if(acceptPunct("("))   {
+                        Expr e = expression();
+                        expectPunct(")");
+                        e.code = "("+e.code+")";
+                        return e;
+                    }
+                    if(acceptPunct("["))   {
+                        return arrayLiteral();
+                    }
+                    if(token.type != SCRIPT_TOKEN_IDENTIFIER)   {
+                        fail("expected an expression");
+                    }
+
+                    std::string const name = token.text;
+                    m_pos++;
+
+                    if(name == "true" || name == "false")   {
+                        return Expr(TYPE_BOOL,name);
+                    }
+
+                    // locals
+                    auto it = m_lkup_var_types.find(name);
+                    if(it != m_lkup_var_types.end())   {
+                        Expr e(it->second,"v_"+name);
+                        e.lvalue = LVALUE_VAR;
+                        e.var_name = name;
+                        return e;
+                    }
+
+                    if(name == "new")   {
+                        std::string const type_name = expectIdentifier();
+                        arguments(0);
+                        if(type_name == "NumericalDataObj")   {
+                            return Expr(TYPE_NUM_OBJ,"objs.NewNumerical()",true);
+                        }
+                        if(type_name == "LiteralDataObj")   {
+                            return Expr(TYPE_LIT_OBJ,"objs.NewLiteral()",true);
+                        }
+                        fail("unsupported object");
+                    }
+
+                    if(name == "Math")   {
+                        expectPunct(".");
+                        std::string const fn_name = expectIdentifier();
+                        std::string fn;
+                        if(fn_name == "floor")   { fn = "std::floor"; }
+                        else if(fn_name == "ceil")   { fn = "std::ceil"; }
+                        else if(fn_name == "abs")   { fn = "std::fabs"; }
+                        else if(fn_name == "sqrt")   { fn = "std::sqrt"; }
+                        else if(fn_name == "round")   { fn = "MathRound"; }
+                        else   {
+                            fail("unsupported Math function");
+                        }
+                        std::vector<Expr> const args = arguments(1);
+                        return Expr(TYPE_NUMBER,fn+"("+num(args[0])+")",args[0].side_effects);
+                    }
+
+                    // helpers
+                    if(name == "BYTE")   {
+                        std::vector<Expr> const args = arguments(1);
+                        return Expr(TYPE_NUMBER,"Byte(input.GetData(0,0),"+num(args[0])+")",
+                                    args[0].side_effects);
+                    }
+                    if(name == "BIT")   {
+                        std::vector<Expr> const args = arguments(2);
+                        return Expr(TYPE_NUMBER,"Bit(input.GetData(0,0),"+
+                                    num(args[0])+","+num(args[1])+")");
+                    }
+                    if(name == "LENGTH")   {
+                        arguments(0);
+                        return Expr(TYPE_NUMBER,"Length(input.GetData(0,0))");
+                    }
+                    if(name == "DATA" || name == "HEADER")   {
+                        std::vector<Expr> const args = arguments(1);
+                        std::string const fn = (name == "DATA") ? "DataBytes" : "HeaderBytes";
+                        return Expr(TYPE_BYTES,fn+"(input,0,"+num(args[0])+")",
+                                    args[0].side_effects);
+                    }
+                    if(name == "REQ")   {
+                        std::vector<Expr> const args = arguments(1);
+                        return Expr(TYPE_MESSAGE,"Req(input,"+num(args[0])+")",
+                                    args[0].side_effects);
+                    }
+                    if(name == "NUM_REQ")   {
+                        arguments(0);
+                        return Expr(TYPE_NUMBER,"double(input.GetRequestCount())");
+                    }
+                    if(name == "NUM_RESP")   {
+                        std::vector<Expr> const args = arguments(1);
+                        return Expr(TYPE_NUMBER,"double(input.GetResponseCount(Req(input,"+
+                                    num(args[0])+")))",args[0].side_effects);
+                    }
+                    if(name == "saveNumericalData" || name == "saveLiteralData")   {
+                        std::vector<Expr> const args = arguments(1);
+                        bool const num_obj = (name == "saveNumericalData");
+                        if(args[0].type != (num_obj ? TYPE_NUM_OBJ : TYPE_LIT_OBJ))   {
+                            fail("saving the wrong type of object");
+                        }
+                        std::string const fn = num_obj ? "SaveNumerical" : "SaveLiteral";
+                        return Expr(TYPE_UNDEFINED,"objs."+fn+"("+args[0].code+")",true);
+                    }
+
+                    m_pos--;
+                    fail("unsupported name");
+                }
+
+                Expr arrayLiteral()
+                {
+                    std::vector<Expr> list_elements;
+                    if(!isPunct("]"))   {
+                        do   {
+                            list_elements.push_back(assignment());
+                        }
+                        while(acceptPunct(","));
+                    }
+                    expectPunct("]");
+
+                    if(list_elements.empty())   {
+                        fail("empty array");
+                    }
+                    ValueType const elem_type = list_elements[0].type;
+                    if(elem_type != TYPE_STRING && elem_type != TYPE_NUMBER)   {
+                        fail("unsupported array");
+                    }
+
+                    Expr e;
+                    e.type = (elem_type == TYPE_STRING) ?
+                                TYPE_STRING_ARRAY : TYPE_NUMBER_ARRAY;
+                    e.code = CppType(e.type)+"{";
+                    for(size_t i=0; i < list_elements.size(); i++)   {
+                        if(list_elements[i].type != elem_type)   {
+                            fail("array with different types");
+                        }
+                        e.code += (i == 0) ? "" : ",";
+                        e.code += list_elements[i].code;
+                        e.side_effects = e.side_effects || list_elements[i].side_effects;
+                    }
+                    e.code += "}";
+                    return e;
+                }
+
+                double parseNumber(std::string const &text) const
+                {
+                    double val=0;
+                    if(text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))   {
+                        val = double(std::strtoull(text.c_str()+2,nullptr,16));
+                    }
+                    else   {
+                        // legacy octal literals
+                        if(text.size() > 1 && text[0] == '0' &&
+                           text[1] >= '0' && text[1] <= '9')   {
+                            fail("unsupported number");
+                        }
+                        val = std::strtod(text.c_str(),nullptr);
+                    }
+                    if(!std::isfinite(val))   {
+                        fail("unsupported number");
+                    }
+                    return val;
+                }
+
+                std::string parseString(std::string const &text) const
+                {
+                    std::string str;
+                    for(size_t i=1; i+1 < text.size(); i++)
+                    {
+                        char c = text[i];
+                        if(static_cast<unsigned char>(c) > 0x7F)   {
+                            fail("non ascii string");
+                        }
+                        if(c != '\\')   {
+                            str.push_back(c);
+                            continue;
+                        }
+
+                        c = text[++i];
+                        switch(c)
+                        {
+                            case 'n': str.push_back('\n'); break;
+                            case 't': str.push_back('\t'); break;
+                            case 'r': str.push_back('\r'); break;
+                            case 'b': str.push_back('\b'); break;
+                            case 'f': str.push_back('\f'); break;
+                            case 'v': str.push_back('\v'); break;
+                            case '\n': break;
+                            case 'x':
+                            case 'u':   {
+                                size_t const digits = (c == 'x') ? 2 : 4;
+                                if(i+digits+1 >= text.size())   {
+                                    fail("invalid escape");
+                                }
+                                std::string const hex = text.substr(i+1,digits);
+                                char * end = nullptr;
+                                unsigned long const code = std::strtoul(hex.c_str(),&end,16);
+                                if(end != hex.c_str()+digits || code > 0x7F)   {
+                                    fail("unsupported escape");
+                                }
+                                str.push_back(char(code));
+                                i += digits;
+                                break;
+                            }
+                            default:   {
+                                if(c >= '0' && c <= '9')   {
+                                    fail("unsupported escape");
+                                }
+                                if(static_cast<unsigned char>(c) > 0x7F)   {
+                                    fail("non ascii string");
+                                }
+                                str.push_back(c);
+                            }
+                        }
+                    }
+                    return str;
+                }
+
+                // ============================================================= //
+
+                std::string const &m_script;
+                std::vector<ScriptToken> const &m_list_tokens;
+                size_t m_pos;
+                uint m_loop_depth;
+                uint m_break_depth;
+                uint m_switch_count;
+
+                std::map<std::string,ValueType> m_lkup_var_types;
+                std::vector<std::string> m_list_var_names;
+            };
+        }
+
+        // ============================================================= //
+        // ============================================================= //
+
+        bool TranslateScript(std::string const &script,
+                             std::string const &function_name,
+                             std::string &cpp_code,
+                             std::string &error)
+        {
+            cpp_code.clear();
+            error.clear();
+
+            std::vector<ScriptToken> list_tokens;
+            if(!TokenizeScript(script,list_tokens))   {
+                error = "could not tokenize script";
+                return false;
+            }
+
+            try   {
+                Translator translator(script,list_tokens);
+                translator.Translate(function_name,cpp_code);
+            }
+            catch(TranslateError &e)   {
+                cpp_code.clear();
+                error = e.msg;
+                return false;
+            }
+            return true;
+        }
+    }
+}
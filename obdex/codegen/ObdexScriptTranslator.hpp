@@ -0,0 +1,47 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef OBDEX_SCRIPT_TRANSLATOR_HPP
+#define OBDEX_SCRIPT_TRANSLATOR_HPP
+
+#include <string>
+
+namespace obdex
+{
+    namespace codegen
+    {
+        // TranslateScript
+        // * translates the definitions file script in @script
+        //   to a C++ NativeParseFunction named @function_name
+        //   and sets @cpp_code to its definition
+        // * only a subset of javascript that maps directly to
+        //   C++ is translated: locals with a single type
+        //   (number, boolean, string, data objects, arrays),
+        //   the usual operators, if/else, loops, switch, the
+        //   helper functions (BYTE, BIT, LENGTH, DATA, HEADER,
+        //   REQ, NUM_REQ, NUM_RESP, saveNumericalData,
+        //   saveLiteralData), Math.floor/ceil/round/abs/sqrt,
+        //   toString, toUpperCase and toLowerCase
+        // * returns false and sets @error for scripts that
+        //   use anything else; those keep running as js
+        bool TranslateScript(std::string const &script,
+                             std::string const &function_name,
+                             std::string &cpp_code,
+                             std::string &error);
+    }
+}
+
+#endif // OBDEX_SCRIPT_TRANSLATOR_HPP
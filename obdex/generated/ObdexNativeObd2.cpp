@@ -0,0 +1,663 @@
+// Generated by obdex_codegen from obd2.xml; do not edit.
+// Scripts that aren't listed here run as js.
+
+#include <obdex/ObdexNativeScripts.hpp>
+
+#include <cmath>
+
+namespace
+{
+using namespace obdex;
+using namespace obdex::native;
+
+// SAEJ1979:Default:PIDs Supported 0x01-0x20:
+void run_parse0(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    double v_k = NAN; (void)v_k;
+    double v_i = NAN; (void)v_i;
+    double v_j = NAN; (void)v_j;
+    LiteralData * v_pid = nullptr; (void)v_pid;
+
+    v_k = 1.0;
+    {
+        v_i = 0.0;
+        for(; input.Step() && ((v_i < 4.0)); v_i++)
+        {
+            {
+                v_j = 0.0;
+                for(; input.Step() && ((v_j < 8.0)); v_j++)
+                {
+                    v_pid = objs.NewLiteral();
+                    Obj(v_pid)->property = (std::string("PID ") + NumberToString(v_k,16.0));
+                    Obj(v_pid)->value_if_true = std::string("Supported");
+                    Obj(v_pid)->value_if_false = std::string("Unsupported");
+                    Obj(v_pid)->value = (Truthy(Bit(input.GetData(0,0),v_i,((7.0 - v_j)))) ? true : false);
+                    objs.SaveLiteral(v_pid);
+                    v_k++;
+                }
+            }
+        }
+    }
+}
+
+void parse0(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse0(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Monitor Status Since DTCs Cleared:
+void run_parse1(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    NumericalData * v_availDTCs = nullptr; (void)v_availDTCs;
+    LiteralData * v_litData = nullptr; (void)v_litData;
+    std::vector<std::string> v_commProperties; (void)v_commProperties;
+    double v_i = NAN; (void)v_i;
+    std::vector<std::string> v_compProperties; (void)v_compProperties;
+    std::vector<std::string> v_sparkProperties; (void)v_sparkProperties;
+
+    v_availDTCs = objs.NewNumerical();
+    Obj(v_availDTCs)->min = 0.0;
+    Obj(v_availDTCs)->max = 127.0;
+    Obj(v_availDTCs)->value = BitAnd(Byte(input.GetData(0,0),0.0),127.0);
+    Obj(v_availDTCs)->property = std::string("Number of confirmed DTCs available");
+    objs.SaveNumerical(v_availDTCs);
+    v_litData = objs.NewLiteral();
+    Obj(v_litData)->property = std::string("Check Engine Light State");
+    Obj(v_litData)->value_if_true = std::string("ON");
+    Obj(v_litData)->value_if_false = std::string("OFF");
+    Obj(v_litData)->value = (Truthy((Bit(input.GetData(0,0),0.0,7.0))) ? true : false);
+    objs.SaveLiteral(v_litData);
+    v_commProperties = std::vector<std::string>{std::string("Misfire"),std::string("Fuel System"),std::string("Components")};
+    {
+        v_i = 0.0;
+        for(; input.Step() && ((v_i < 3.0)); v_i++)
+        {
+            v_litData = objs.NewLiteral();
+            Obj(v_litData)->property = (At(v_commProperties,v_i) + std::string(" Monitoring"));
+            Obj(v_litData)->value_if_true = std::string("Test Available");
+            Obj(v_litData)->value_if_false = std::string("Test Unavailable");
+            Obj(v_litData)->value = (Truthy((Bit(input.GetData(0,0),1.0,v_i))) ? true : false);
+            objs.SaveLiteral(v_litData);
+        }
+    }
+    {
+        v_i = 4.0;
+        for(; input.Step() && ((v_i < 7.0)); v_i++)
+        {
+            v_litData = objs.NewLiteral();
+            Obj(v_litData)->property = (At(v_commProperties,(v_i - 4.0)) + std::string(" Test Status"));
+            Obj(v_litData)->value_if_true = std::string("Complete");
+            Obj(v_litData)->value_if_false = std::string("Incomplete");
+            Obj(v_litData)->value = (Truthy((Bit(input.GetData(0,0),1.0,v_i))) ? true : false);
+            objs.SaveLiteral(v_litData);
+        }
+    }
+    v_litData = objs.NewLiteral();
+    Obj(v_litData)->property = std::string("Vehicle Ignition Type");
+    Obj(v_litData)->value_if_true = std::string("Compression");
+    Obj(v_litData)->value_if_false = std::string("Spark");
+    Obj(v_litData)->value = (Truthy((Bit(input.GetData(0,0),1.0,3.0))) ? true : false);
+    objs.SaveLiteral(v_litData);
+    if(Truthy(Bit(input.GetData(0,0),1.0,3.0)))
+    {
+        v_compProperties = std::vector<std::string>{std::string("NMHC Cat"),std::string("NOx/SCR Monitor"),std::string(""),std::string("Boost Pressure"),std::string(""),std::string("Exhaust Gas Sensor"),std::string("PM Filter Monitoring"),std::string("EGR/VVT System")};
+        {
+            v_i = 0.0;
+            for(; input.Step() && ((v_i < 8.0)); v_i++)
+            {
+                if(((v_i == 2.0) || (v_i == 4.0)))
+                {
+                    continue;
+                }
+                v_litData = objs.NewLiteral();
+                Obj(v_litData)->property = (At(v_compProperties,v_i) + std::string(" Test"));
+                Obj(v_litData)->value_if_true = std::string("Test Available");
+                Obj(v_litData)->value_if_false = std::string("Test Unavailable");
+                Obj(v_litData)->value = (Truthy((Bit(input.GetData(0,0),2.0,v_i))) ? true : false);
+                objs.SaveLiteral(v_litData);
+            }
+        }
+        {
+            v_i = 0.0;
+            for(; input.Step() && ((v_i < 8.0)); v_i++)
+            {
+                if(((v_i == 2.0) || (v_i == 4.0)))
+                {
+                    continue;
+                }
+                v_litData = objs.NewLiteral();
+                Obj(v_litData)->property = (At(v_compProperties,v_i) + std::string(" Test Status"));
+                Obj(v_litData)->value_if_true = std::string("Incomplete");
+                Obj(v_litData)->value_if_false = std::string("Complete");
+                Obj(v_litData)->value = (Truthy((Bit(input.GetData(0,0),3.0,v_i))) ? true : false);
+                objs.SaveLiteral(v_litData);
+            }
+        }
+    }
+    else
+    {
+        v_sparkProperties = std::vector<std::string>{std::string("Catalyst"),std::string("Heated Catalyst"),std::string("Evaporative System"),std::string("Secondary Air System"),std::string("A/C Refrigerant"),std::string("Oxygen Sensor"),std::string("Oxygen Sensor Heater"),std::string("EGR System")};
+        {
+            v_i = 0.0;
+            for(; input.Step() && ((v_i < 8.0)); v_i++)
+            {
+                v_litData = objs.NewLiteral();
+                Obj(v_litData)->property = (At(v_sparkProperties,v_i) + std::string("Test"));
+                Obj(v_litData)->value_if_true = std::string("Test Available");
+                Obj(v_litData)->value_if_false = std::string("Test Unavailable");
+                Obj(v_litData)->value = (Truthy((Bit(input.GetData(0,0),2.0,v_i))) ? true : false);
+                objs.SaveLiteral(v_litData);
+            }
+        }
+        {
+            v_i = 0.0;
+            for(; input.Step() && ((v_i < 8.0)); v_i++)
+            {
+                v_litData = objs.NewLiteral();
+                Obj(v_litData)->property = (At(v_sparkProperties,v_i) + std::string(" Test Status"));
+                Obj(v_litData)->value_if_true = std::string("Incomplete");
+                Obj(v_litData)->value_if_false = std::string("Complete");
+                Obj(v_litData)->value = (Truthy((Bit(input.GetData(0,0),3.0,v_i))) ? true : false);
+                objs.SaveLiteral(v_litData);
+            }
+        }
+    }
+}
+
+void parse1(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse1(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Fuel System Status:
+void run_parse2(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    std::vector<std::string> v_fsWhenTrue; (void)v_fsWhenTrue;
+    double v_i = NAN; (void)v_i;
+    LiteralData * v_fuelSysData = nullptr; (void)v_fuelSysData;
+
+    v_fsWhenTrue = std::vector<std::string>{std::string("Open Loop: Insufficient engine temperature"),std::string("Closed Loop: Using oxygen sensor feedback to determine fuel mix"),std::string("Open Loop: Due to engine load OR fuel cut due to acceleration"),std::string("Open Loop: Due to system failure"),std::string("Closed loop: Using at least one oxygen sensor but there is a fault in the feedback system")};
+    {
+        v_i = 0.0;
+        for(; input.Step() && ((v_i < 5.0)); v_i++)
+        {
+            if(Truthy(Bit(input.GetData(0,0),0.0,v_i)))
+            {
+                v_fuelSysData = objs.NewLiteral();
+                Obj(v_fuelSysData)->property = std::string("Fuel System 1 Status");
+                Obj(v_fuelSysData)->value_if_true = At(v_fsWhenTrue,v_i);
+                Obj(v_fuelSysData)->value = true;
+                objs.SaveLiteral(v_fuelSysData);
+            }
+        }
+    }
+    {
+        v_i = 0.0;
+        for(; input.Step() && ((v_i < 5.0)); v_i++)
+        {
+            if(Truthy(Bit(input.GetData(0,0),1.0,v_i)))
+            {
+                v_fuelSysData = objs.NewLiteral();
+                Obj(v_fuelSysData)->property = std::string("Fuel System 2 Status");
+                Obj(v_fuelSysData)->value_if_true = At(v_fsWhenTrue,v_i);
+                Obj(v_fuelSysData)->value = true;
+                objs.SaveLiteral(v_fuelSysData);
+            }
+        }
+    }
+}
+
+void parse2(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse2(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Engine Coolant Temperature:
+void run_parse4(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    NumericalData * v_coolantTemp = nullptr; (void)v_coolantTemp;
+
+    v_coolantTemp = objs.NewNumerical();
+    Obj(v_coolantTemp)->units = std::string("C");
+    Obj(v_coolantTemp)->min = (-40.0);
+    Obj(v_coolantTemp)->max = 215.0;
+    Obj(v_coolantTemp)->value = (Byte(input.GetData(0,0),0.0) - 40.0);
+    objs.SaveNumerical(v_coolantTemp);
+}
+
+void parse4(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse4(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Engine RPM:
+void run_parse11(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    NumericalData * v_engSpd = nullptr; (void)v_engSpd;
+
+    v_engSpd = objs.NewNumerical();
+    Obj(v_engSpd)->units = std::string("rpm");
+    Obj(v_engSpd)->min = 0.0;
+    Obj(v_engSpd)->max = 16383.75;
+    Obj(v_engSpd)->value = ((((Byte(input.GetData(0,0),0.0) * 256.0) + Byte(input.GetData(0,0),1.0))) / 4.0);
+    objs.SaveNumerical(v_engSpd);
+}
+
+void parse11(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse11(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Bank 1, Sensor 1: Oxygen Sensor Voltage, Short Term Fuel Trim:
+void run_parse19(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    NumericalData * v_voltage = nullptr; (void)v_voltage;
+    NumericalData * v_fuelTrim = nullptr; (void)v_fuelTrim;
+
+    v_voltage = objs.NewNumerical();
+    Obj(v_voltage)->units = std::string("V");
+    Obj(v_voltage)->min = 0.0;
+    Obj(v_voltage)->max = 1.2749999999999999;
+    Obj(v_voltage)->value = (Byte(input.GetData(0,0),0.0) / 200.0);
+    objs.SaveNumerical(v_voltage);
+    v_fuelTrim = objs.NewNumerical();
+    Obj(v_fuelTrim)->units = std::string("%");
+    Obj(v_fuelTrim)->min = (-100.0);
+    Obj(v_fuelTrim)->max = 99.200000000000003;
+    Obj(v_fuelTrim)->value = ((((Byte(input.GetData(0,0),1.0) - 128.0)) * 100.0) / 128.0);
+    objs.SaveNumerical(v_fuelTrim);
+}
+
+void parse19(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse19(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:OBD Standards This Vehicle Conforms To:
+void run_parse27(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    LiteralData * v_obdStd = nullptr; (void)v_obdStd;
+
+    v_obdStd = objs.NewLiteral();
+    Obj(v_obdStd)->value = true;
+    {
+        double const switch_value0 = Byte(input.GetData(0,0),0.0);
+        int switch_case0 = 13;
+        if((switch_value0 == 1.0)) { switch_case0 = 0; }
+        else if((switch_value0 == 2.0)) { switch_case0 = 1; }
+        else if((switch_value0 == 3.0)) { switch_case0 = 2; }
+        else if((switch_value0 == 4.0)) { switch_case0 = 3; }
+        else if((switch_value0 == 5.0)) { switch_case0 = 4; }
+        else if((switch_value0 == 6.0)) { switch_case0 = 5; }
+        else if((switch_value0 == 7.0)) { switch_case0 = 6; }
+        else if((switch_value0 == 8.0)) { switch_case0 = 7; }
+        else if((switch_value0 == 9.0)) { switch_case0 = 8; }
+        else if((switch_value0 == 10.0)) { switch_case0 = 9; }
+        else if((switch_value0 == 11.0)) { switch_case0 = 10; }
+        else if((switch_value0 == 12.0)) { switch_case0 = 11; }
+        else if((switch_value0 == 13.0)) { switch_case0 = 12; }
+        switch(switch_case0)
+        {
+        case 0:
+            Obj(v_obdStd)->value_if_true = std::string("OBDII as defined by the CARB");
+            break;
+        case 1:
+            Obj(v_obdStd)->value_if_true = std::string("OBD as defined by the EPA");
+            break;
+        case 2:
+            Obj(v_obdStd)->value_if_true = std::string("OBD and OBDII");
+            break;
+        case 3:
+            Obj(v_obdStd)->value_if_true = std::string("OBDI");
+            break;
+        case 4:
+            Obj(v_obdStd)->value_if_true = std::string("Does not comply with any OBD Standard");
+            break;
+        case 5:
+            Obj(v_obdStd)->value_if_true = std::string("EOBD (Europe)");
+            break;
+        case 6:
+            Obj(v_obdStd)->value_if_true = std::string("EOBD and OBDII");
+            break;
+        case 7:
+            Obj(v_obdStd)->value_if_true = std::string("EOBD and OBD");
+            break;
+        case 8:
+            Obj(v_obdStd)->value_if_true = std::string("EOBD, OBD and OBDII");
+            break;
+        case 9:
+            Obj(v_obdStd)->value_if_true = std::string("JOBD (Japan)");
+            break;
+        case 10:
+            Obj(v_obdStd)->value_if_true = std::string("JOBD and OBDII");
+            break;
+        case 11:
+            Obj(v_obdStd)->value_if_true = std::string("JOBD and EOBD");
+            break;
+        case 12:
+            Obj(v_obdStd)->value_if_true = std::string("JOBD, EOBD, and OBDII");
+            break;
+        case 13:
+            Obj(v_obdStd)->value = false;
+        default:
+            break;
+        }
+    }
+    objs.SaveLiteral(v_obdStd);
+}
+
+void parse27(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse27(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Evaporative System Vapour Pressure (1):
+void run_parse49(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    NumericalData * v_numData = nullptr; (void)v_numData;
+
+    v_numData = objs.NewNumerical();
+    Obj(v_numData)->units = std::string("Pa");
+    Obj(v_numData)->min = (-8192.0);
+    Obj(v_numData)->max = 8192.0;
+    if(Truthy(Bit(input.GetData(0,0),0.0,7.0)))
+    {
+        Obj(v_numData)->value = ((((((BitNot(((Byte(input.GetData(0,0),0.0) - 1.0)))) * 256.0)) + Byte(input.GetData(0,0),1.0))) / 4.0);
+    }
+    else
+    {
+        Obj(v_numData)->value = (((((Byte(input.GetData(0,0),0.0) * 256.0)) + Byte(input.GetData(0,0),1.0))) / 4.0);
+    }
+    objs.SaveNumerical(v_numData);
+}
+
+void parse49(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse49(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Fuel Type:
+void run_parse80(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    std::vector<std::string> v_listFuelTypes; (void)v_listFuelTypes;
+    double v_i = NAN; (void)v_i;
+    LiteralData * v_fuelType = nullptr; (void)v_fuelType;
+
+    v_listFuelTypes = std::vector<std::string>{std::string("Gasoline"),std::string("Methanol"),std::string("Ethanol"),std::string("Diesel"),std::string("LPG"),std::string("CNG"),std::string("Propane"),std::string("Electric"),std::string("Bifuel running Gasoline"),std::string("Bifuel running Methanol"),std::string("Bifuel running LPG"),std::string("Bifuel running CNG"),std::string("Bifuel running Propane"),std::string("Bifuel running Electricity"),std::string("Bifuel Mixed Gas/Electric"),std::string("Hybrid Gasoline"),std::string("Hybrid Ethanol"),std::string("Hybrid Diesel"),std::string("Hybrid Electric"),std::string("Hybrid Mixed Fuel"),std::string("Hybrid Regenrative")};
+    {
+        v_i = 0.0;
+        for(; input.Step() && ((v_i < 22.0)); v_i++)
+        {
+            if((Byte(input.GetData(0,0),0.0) == v_i))
+            {
+                v_fuelType = objs.NewLiteral();
+                Obj(v_fuelType)->value = true;
+                Obj(v_fuelType)->value_if_true = At(v_listFuelTypes,v_i);
+                objs.SaveLiteral(v_fuelType);
+            }
+        }
+    }
+}
+
+void parse80(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse80(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Freeze Frame Diagnostic Trouble Code:
+void run_parse94(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    LiteralData * v_dtcData = nullptr; (void)v_dtcData;
+
+    if((!Truthy((JsOr(Byte(input.GetData(0,0),0.0),Byte(input.GetData(0,0),1.0))))))
+    {
+        v_dtcData = objs.NewLiteral();
+        Obj(v_dtcData)->value_if_true = std::string("No DTCs Stored");
+        Obj(v_dtcData)->value = true;
+        objs.SaveLiteral(v_dtcData);
+    }
+    else
+    {
+        v_dtcData = objs.NewLiteral();
+        Obj(v_dtcData)->property = std::string("Diagnostic Trouble Code");
+        Obj(v_dtcData)->value = true;
+        if(((ShiftRight(Byte(input.GetData(0,0),0.0),6.0)) == 0.0))
+        {
+            Obj(v_dtcData)->value_if_true = std::string("P");
+        }
+        else
+        {
+            if(((ShiftRight(Byte(input.GetData(0,0),0.0),6.0)) == 1.0))
+            {
+                Obj(v_dtcData)->value_if_true = std::string("C");
+            }
+            else
+            {
+                if(((ShiftRight(Byte(input.GetData(0,0),0.0),6.0)) == 2.0))
+                {
+                    Obj(v_dtcData)->value_if_true = std::string("B");
+                }
+                else
+                {
+                    if(((ShiftRight(Byte(input.GetData(0,0),0.0),6.0)) == 3.0))
+                    {
+                        Obj(v_dtcData)->value_if_true = std::string("U");
+                    }
+                }
+            }
+        }
+        Obj(v_dtcData)->value_if_true += NumberToString((BitAnd((ShiftRight(Byte(input.GetData(0,0),0.0),4.0)),3.0)),16.0);
+        Obj(v_dtcData)->value_if_true += NumberToString((BitAnd(Byte(input.GetData(0,0),0.0),15.0)),16.0);
+        Obj(v_dtcData)->value_if_true += NumberToString((ShiftRight(Byte(input.GetData(0,0),1.0),4.0)),16.0);
+        Obj(v_dtcData)->value_if_true += NumberToString((BitAnd(Byte(input.GetData(0,0),1.0),15.0)),16.0);
+        Obj(v_dtcData)->value_if_true = ToUpperCase(Obj(v_dtcData)->value_if_true);
+        objs.SaveLiteral(v_dtcData);
+    }
+}
+
+void parse94(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse94(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Request Stored Diagnostic Trouble Codes:SAE J1850 JPW, SAE J1850 PWM, ISO 9141-2, ISO 14230
+void run_parse95(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    LiteralData * v_dtcData = nullptr; (void)v_dtcData;
+    double v_i = NAN; (void)v_i;
+
+    if((((Byte(input.GetData(0,0),0.0) == 0.0)) && ((Byte(input.GetData(0,0),1.0) == 0.0))))
+    {
+        v_dtcData = objs.NewLiteral();
+        Obj(v_dtcData)->value_if_true = std::string("No DTCs Stored");
+        Obj(v_dtcData)->value = true;
+        objs.SaveLiteral(v_dtcData);
+    }
+    else
+    {
+        {
+            v_i = 0.0;
+            for(; input.Step() && ((v_i < Length(input.GetData(0,0)))); v_i += 2.0)
+            {
+                if((((Byte(input.GetData(0,0),v_i) == 0.0)) && ((Byte(input.GetData(0,0),(v_i + 1.0)) == 0.0))))
+                {
+                    break;
+                }
+                v_dtcData = objs.NewLiteral();
+                Obj(v_dtcData)->property = std::string("Diagnostic Trouble Code");
+                Obj(v_dtcData)->value = true;
+                if(((ShiftRight(Byte(input.GetData(0,0),v_i),6.0)) == 0.0))
+                {
+                    Obj(v_dtcData)->value_if_true = std::string("P");
+                }
+                else
+                {
+                    if(((ShiftRight(Byte(input.GetData(0,0),v_i),6.0)) == 1.0))
+                    {
+                        Obj(v_dtcData)->value_if_true = std::string("C");
+                    }
+                    else
+                    {
+                        if(((ShiftRight(Byte(input.GetData(0,0),v_i),6.0)) == 2.0))
+                        {
+                            Obj(v_dtcData)->value_if_true = std::string("B");
+                        }
+                        else
+                        {
+                            if(((ShiftRight(Byte(input.GetData(0,0),v_i),6.0)) == 3.0))
+                            {
+                                Obj(v_dtcData)->value_if_true = std::string("U");
+                            }
+                        }
+                    }
+                }
+                Obj(v_dtcData)->value_if_true += NumberToString((BitAnd((ShiftRight(Byte(input.GetData(0,0),v_i),4.0)),3.0)),16.0);
+                Obj(v_dtcData)->value_if_true += NumberToString((BitAnd(Byte(input.GetData(0,0),v_i),15.0)),16.0);
+                Obj(v_dtcData)->value_if_true += NumberToString((ShiftRight(Byte(input.GetData(0,0),(v_i + 1.0)),4.0)),16.0);
+                Obj(v_dtcData)->value_if_true += NumberToString((BitAnd(Byte(input.GetData(0,0),(v_i + 1.0)),15.0)),16.0);
+                Obj(v_dtcData)->value_if_true = ToUpperCase(Obj(v_dtcData)->value_if_true);
+                objs.SaveLiteral(v_dtcData);
+            }
+        }
+    }
+}
+
+void parse95(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse95(input,objs);
+    objs.SaveTo(data);
+}
+
+// SAEJ1979:Default:Request Stored Diagnostic Trouble Codes:ISO 15765 Standard Id, ISO 15765 Extended Id
+void run_parse96(NativeScriptInput const &input, Objects &objs)
+{
+    (void)input;
+    (void)objs;
+    LiteralData * v_dtcData = nullptr; (void)v_dtcData;
+    double v_i = NAN; (void)v_i;
+
+    if((Byte(input.GetData(0,0),0.0) == 0.0))
+    {
+        v_dtcData = objs.NewLiteral();
+        Obj(v_dtcData)->value_if_true = std::string("No DTCs Stored");
+        Obj(v_dtcData)->value = true;
+        objs.SaveLiteral(v_dtcData);
+    }
+    else
+    {
+        {
+            v_i = 1.0;
+            for(; input.Step() && ((v_i < Length(input.GetData(0,0)))); v_i += 2.0)
+            {
+                if((((Byte(input.GetData(0,0),v_i) == 0.0)) && ((Byte(input.GetData(0,0),(v_i + 1.0)) == 0.0))))
+                {
+                    break;
+                }
+                v_dtcData = objs.NewLiteral();
+                Obj(v_dtcData)->property = std::string("Diagnostic Trouble Code");
+                Obj(v_dtcData)->value = true;
+                if(((ShiftRight(Byte(input.GetData(0,0),v_i),6.0)) == 0.0))
+                {
+                    Obj(v_dtcData)->value_if_true = std::string("P");
+                }
+                else
+                {
+                    if(((ShiftRight(Byte(input.GetData(0,0),v_i),6.0)) == 1.0))
+                    {
+                        Obj(v_dtcData)->value_if_true = std::string("C");
+                    }
+                    else
+                    {
+                        if(((ShiftRight(Byte(input.GetData(0,0),v_i),6.0)) == 2.0))
+                        {
+                            Obj(v_dtcData)->value_if_true = std::string("B");
+                        }
+                        else
+                        {
+                            if(((ShiftRight(Byte(input.GetData(0,0),v_i),6.0)) == 3.0))
+                            {
+                                Obj(v_dtcData)->value_if_true = std::string("U");
+                            }
+                        }
+                    }
+                }
+                Obj(v_dtcData)->value_if_true += NumberToString((BitAnd((ShiftRight(Byte(input.GetData(0,0),v_i),4.0)),3.0)),16.0);
+                Obj(v_dtcData)->value_if_true += NumberToString((BitAnd(Byte(input.GetData(0,0),v_i),15.0)),16.0);
+                Obj(v_dtcData)->value_if_true += NumberToString((ShiftRight(Byte(input.GetData(0,0),(v_i + 1.0)),4.0)),16.0);
+                Obj(v_dtcData)->value_if_true += NumberToString((BitAnd(Byte(input.GetData(0,0),(v_i + 1.0)),15.0)),16.0);
+                Obj(v_dtcData)->value_if_true = ToUpperCase(Obj(v_dtcData)->value_if_true);
+                objs.SaveLiteral(v_dtcData);
+            }
+        }
+    }
+}
+
+void parse96(NativeScriptInput const &input, Data &data)
+{
+    Objects objs;
+    run_parse96(input,objs);
+    objs.SaveTo(data);
+}
+
+NativeScript const k_list_native_scripts[] = {
+    { "SAEJ1979:Default:PIDs Supported 0x01-0x20:", 0x2edf33134f39d380ull, parse0 },
+    { "SAEJ1979:Default:Monitor Status Since DTCs Cleared:", 0xbd1b12d80e943a4bull, parse1 },
+    { "SAEJ1979:Default:Fuel System Status:", 0xc18b99d045f5e347ull, parse2 },
+    { "SAEJ1979:Default:Engine Coolant Temperature:", 0xc86be17ebb3a8a3full, parse4 },
+    { "SAEJ1979:Default:Engine RPM:", 0x42321e24c596e296ull, parse11 },
+    { "SAEJ1979:Default:Bank 1, Sensor 1: Oxygen Sensor Voltage, Short Term Fuel Trim:", 0x0c8cdd9a07ee957full, parse19 },
+    { "SAEJ1979:Default:OBD Standards This Vehicle Conforms To:", 0x229ccb4d5753efd3ull, parse27 },
+    { "SAEJ1979:Default:Evaporative System Vapour Pressure (1):", 0x7c6dead15d416c7aull, parse49 },
+    { "SAEJ1979:Default:Fuel Type:", 0x2f45c8eb89576273ull, parse80 },
+    { "SAEJ1979:Default:Freeze Frame Diagnostic Trouble Code:", 0x62cb8261ff8d275full, parse94 },
+    { "SAEJ1979:Default:Request Stored Diagnostic Trouble Codes:SAE J1850 JPW, SAE J1850 PWM, ISO 9141-2, ISO 14230", 0x9ea53199255cb8edull, parse95 },
+    { "SAEJ1979:Default:Request Stored Diagnostic Trouble Codes:ISO 15765 Standard Id, ISO 15765 Extended Id", 0x6e3c9fc7cb784a62ull, parse96 },
+};
+
+NativeScriptRegistration const registration(
+        k_list_native_scripts,
+        sizeof(k_list_native_scripts)/sizeof(NativeScript));
+}
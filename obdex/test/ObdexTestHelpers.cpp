@@ -16,8 +16,10 @@
 
 #include <obdex/ObdexUtil.hpp>
 #include <obdex/ObdexLog.hpp>
+#include <obdex/ObdexVirtualVehicle.hpp>
 #include <obdex/test/ObdexTestHelpers.hpp>
 
+#include <algorithm>
 #include <random>
 
 namespace obdex
@@ -72,41 +74,40 @@ namespace obdex
 
         // ============================================================= //
 
+        // sim_vehicle_message_*
+        // * thin wrappers over VirtualVehicle with a single
+        //   ECU at the expected source address
+        // * @frames is the number of responses for legacy
+        //   and ISO 14230, and the number of frames a single
+        //   response fills for ISO 15765
+        // * randomizing the header clears the expected header
+        //   mask and gives the ECU a random address
+
         void sim_vehicle_message_legacy(ParameterFrame &param,
                                         uint const frames,
                                         bool const random_header)
         {
-            if(param.parse_protocol < 0xA00)   {
-                // legacy obd message structure
-                for(uint i=0; i < param.list_message_data.size(); i++)   {
-                    MessageData &msg = param.list_message_data[i];
-                    uint exp_data_byte_count = (msg.exp_data_byte_count > 0) ?
-                                msg.exp_data_byte_count : 4;
-
-                    // create the header
-                    ByteList header = msg.exp_header_bytes;
-                    if(random_header)   {
-                        for(uint j=0; j < msg.exp_header_bytes.size(); j++)   {
-                            msg.exp_header_bytes[j] = 0x00;
-                            msg.exp_header_mask[j] = 0x00;
-                            header[j] = GenRandomByte();
-                        }
-                    }
-                    // save frames
-                    for(uint j=0; j < frames; j++)
-                    {   // for each frame
-                        ByteList data = msg.exp_data_prefix;
-                        for(uint k=0; k < exp_data_byte_count; k++)   {
-                            data.push_back(GenRandomByte());
-                        }
-                        ByteList frame;
-
-                        frame.insert(frame.end(),header.begin(),header.end());
-                        frame.insert(frame.end(),data.begin(),data.end());
-                        msg.list_raw_frames.push_back(frame);
-                    }
+            if(param.parse_protocol >= 0xA00 ||
+               param.list_message_data.empty())   {
+                return;
+            }
+
+            // [prio] [target] [source]
+            ByteList const &exp_header = param.list_message_data[0].exp_header_bytes;
+            u32 address = (exp_header.size() > 2) ? exp_header[2] : 0x10;
+            if(random_header)   {
+                address = GenRandomByte();
+                for(auto &msg : param.list_message_data)   {
+                    std::fill(msg.exp_header_mask.begin(),
+                              msg.exp_header_mask.end(),0x00);
                 }
             }
+
+            VirtualVehicle vehicle(param.parse_protocol,false,random_gen());
+            vehicle.AddEcu(address);
+            for(uint j=0; j < frames; j++)   {
+                vehicle.Respond(param);
+            }
         }
 
         // ============================================================= //
@@ -116,70 +117,28 @@ namespace obdex
                                           bool const randomizeHeader,
                                           uint const iso14230_headerLength)
         {
-            if(param.parse_protocol == obdex::PROTOCOL_ISO_14230)
-            {
-                for(uint i=0; i < param.list_message_data.size(); i++)   {
-                    obdex::MessageData &msg = param.list_message_data[i];
-
-                    // data length
-                    obdex::ubyte exp_data_byte_count =
-                        (msg.exp_data_byte_count > 0) ? msg.exp_data_byte_count : 4;
-
-                    obdex::ubyte dataLength =
-                            exp_data_byte_count+msg.exp_data_prefix.size();
-
-                    // create the header
-                    // for iso14230 exp_header_bytes is always [F] [T] [S]
-                    obdex::ByteList header;
-
-                    if(iso14230_headerLength == 1)   { // [F]
-                        header.push_back(0x3F & dataLength);
-                    }
-                    else if(iso14230_headerLength == 2)   { // [F] [L]
-                        header.push_back(msg.exp_header_bytes[0] & 0x3F);
-                        header.push_back(dataLength);
-                    }
-                    else if(iso14230_headerLength == 3)   { // [F] [T] [S]
-                        header.push_back(0x3F & dataLength);
-                        header.push_back(msg.exp_header_bytes[1]);
-                        header.push_back(msg.exp_header_bytes[2]);
-
-                        // encode that [T] and [S] is present in [F] byte
-                        header[0] |= 0x80;  // or 0xC0 it doesnt matter for sim
-                    }
-                    else if(iso14230_headerLength == 4)   { // [F] [T] [S] [L]
-                        header.push_back(msg.exp_header_bytes[0]);
-                        header.push_back(msg.exp_header_bytes[1]);
-                        header.push_back(msg.exp_header_bytes[2]);
-                        header.push_back(dataLength);
-
-                        // encode that [T] and [S] is present in [F] byte
-                        if((header[0] & 0xC0) == 0)   {
-                            header[0] |= 0x80;  // or 0xC0 it doesnt matter for sim
-                        }
-                    }
-
-                    if(randomizeHeader)   {
-                        msg.exp_header_bytes[1] = GenRandomByte();
-                        msg.exp_header_mask[1] = 0x00;
+            if(param.parse_protocol != obdex::PROTOCOL_ISO_14230 ||
+               param.list_message_data.empty())   {
+                return;
+            }
 
-                        msg.exp_header_bytes[2] = GenRandomByte();
-                        msg.exp_header_mask[2] = 0x00;
-                    }
-                    // save frames
-                    for(uint j=0; j < frames; j++)
-                    {   // for each frame
-                        obdex::ByteList data = msg.exp_data_prefix;
-                        for(int k=0; k < exp_data_byte_count; k++)   {
-                            data.push_back(GenRandomByte());
-                        }
-                        obdex::ByteList frame;
-                        frame.insert(frame.end(),header.begin(),header.end());
-                        frame.insert(frame.end(),data.begin(),data.end());
-                        msg.list_raw_frames.push_back(frame);
-                    }
+            // for iso14230 exp_header_bytes is always [F] [T] [S]
+            ByteList const &exp_header = param.list_message_data[0].exp_header_bytes;
+            u32 address = (exp_header.size() > 2) ? exp_header[2] : 0x10;
+            if(randomizeHeader)   {
+                address = GenRandomByte();
+                for(auto &msg : param.list_message_data)   {
+                    msg.exp_header_mask[1] = 0x00;
+                    msg.exp_header_mask[2] = 0x00;
                 }
             }
+
+            VirtualVehicle vehicle(param.parse_protocol,false,random_gen());
+            vehicle.AddEcu(address);
+            vehicle.SetISO14230HeaderLength(iso14230_headerLength);
+            for(uint j=0; j < frames; j++)   {
+                vehicle.Respond(param);
+            }
         }
 
         // ============================================================= //
@@ -188,80 +147,39 @@ namespace obdex
                                           uint const frames,
                                           bool const randomizeHeader)
         {
-            if(param.parse_protocol == obdex::PROTOCOL_ISO_15765)   {
-                for(uint i=0; i < param.list_message_data.size(); i++)   {
-                    obdex::MessageData &msg = param.list_message_data[i];
-                    obdex::ByteList header = msg.exp_header_bytes;
-                    if(randomizeHeader)   {
-                        for(uint j=0; j < header.size(); j++)   {
-                            header[j] = GenRandomByte();
-                            msg.exp_header_mask[j] = 0x00;
-                        }
-                    }
+            if(param.parse_protocol != obdex::PROTOCOL_ISO_15765 ||
+               param.list_message_data.empty() || frames == 0)   {
+                return;
+            }
 
-                    if(frames == 1)   {   // single frame
-                        obdex::ByteList data;
-                        data.push_back(0x07);   // pci byte
-                        data.insert(data.end(),msg.exp_data_prefix.begin(),msg.exp_data_prefix.end());
-                        for(int j=0; j < int(8-(msg.exp_data_prefix.size()+1)); j++)   {
-                            data.push_back(GenRandomByte());
-                        }
-
-                        obdex::ByteList frame;
-                        frame.insert(frame.end(),header.begin(),header.end());
-                        frame.insert(frame.end(),data.begin(),data.end());
-                        msg.list_raw_frames.push_back(frame);
-                    }
-                    else if(frames > 1)   {
-                        // multi frame
-                        int dataLength=(frames*7)-1;
-                        obdex::ubyte dataLengthLow = dataLength & 0xFF;
-                        obdex::ubyte dataLengthHigh = (dataLength >> 8) && 0xFF;
-
-                        if((dataLengthHigh & 0xF0) != 1)   {
-                            dataLengthHigh = dataLengthHigh & 0x0F;
-                            dataLengthHigh = dataLengthHigh | 0x10;
-                        }
-                        obdex::ByteList catData; // concatenated data
-                        catData.insert(catData.end(),msg.exp_data_prefix.begin(),msg.exp_data_prefix.end());
-                        for(int j=0; j < int(dataLength-msg.exp_data_prefix.size()); j++)   {
-                            catData.push_back(GenRandomByte());
-                        }
-
-                        for(uint f=0; f < frames; f++)   {
-                            if(f==0)   {
-                                // first frame
-                                obdex::ByteList data;
-                                data.push_back(dataLengthHigh);
-                                data.push_back(dataLengthLow);
-                                for(obdex::ubyte i=0; i < 6; i++)   {
-                                    data.push_back(catData[0]);
-                                    catData.erase(catData.begin());
-                                }
-                                obdex::ByteList frame;
-                                frame.insert(frame.end(),header.begin(),header.end());
-                                frame.insert(frame.end(),data.begin(),data.end());
-                                msg.list_raw_frames.push_back(frame);
-                            }
-                            else   {
-                                // consecutive frame
-                                obdex::ubyte cfNumber = f%0x10;
-                                obdex::ubyte cfPciByte = 0x20 | cfNumber;
-                                obdex::ByteList data;
-                                data.push_back(cfPciByte);
-                                for(obdex::ubyte i=0; i < 7; i++)   {
-                                    data.push_back(catData[0]);
-                                    catData.erase(catData.begin());
-                                }
-                                obdex::ByteList frame;
-                                frame.insert(frame.end(),header.begin(),header.end());
-                                frame.insert(frame.end(),data.begin(),data.end());
-                                msg.list_raw_frames.push_back(frame);
-                            }
-                        }
-                    }
+            // [0000 0III] [IIII IIII] or
+            // [prio] [format] [target] [source]
+            bool const extended_id = param.iso15765_extended_id;
+            ByteList const &exp_header = param.list_message_data[0].exp_header_bytes;
+
+            u32 address = 0x7E8;
+            if(randomizeHeader)   {
+                address = extended_id ? GenRandomByte() :
+                        ((u32(GenRandomByte() & 0x07) << 8) | GenRandomByte());
+
+                for(auto &msg : param.list_message_data)   {
+                    std::fill(msg.exp_header_mask.begin(),
+                              msg.exp_header_mask.end(),0x00);
                 }
             }
+            else if(extended_id && exp_header.size() > 3)   {
+                address = exp_header[3];
+            }
+            else if(!extended_id && exp_header.size() > 1)   {
+                address = (u32(exp_header[0]) << 8) | exp_header[1];
+            }
+
+            // fill a single frame (seven data bytes) or a
+            // first frame and frames-1 consecutive frames
+            VirtualVehicle vehicle(param.parse_protocol,extended_id,random_gen());
+            vehicle.AddEcu(address);
+            vehicle.SetResponseDataLength((frames == 1) ? 7 : sint(frames*7)-1);
+            vehicle.Respond(param);
         }
 
         // ============================================================= //
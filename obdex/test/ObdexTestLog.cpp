@@ -0,0 +1,239 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/test/catch/catch.hpp>
+#include <obdex/ObdexLog.hpp>
+
+#include <atomic>
+#include <thread>
+
+using namespace obdex;
+
+namespace
+{
+    class LogSinkToList : public LogSink
+    {
+    public:
+        void log(std::string const &line)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_list_lines.push_back(line);
+        }
+
+        std::vector<std::string> GetLines()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_list_lines;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::vector<std::string> m_list_lines;
+    };
+
+    Logger * CreateLogger(std::shared_ptr<LogSink> const &sink)
+    {
+        return new Logger(
+                    true,
+                    sink,
+                    {{
+                       { new LogFBCustomStr("T: ") },
+                       { new LogFBCustomStr("D: ") },
+                       { new LogFBCustomStr("I: ") },
+                       { new LogFBCustomStr("W: ") },
+                       { new LogFBCustomStr("E: ") },
+                       { new LogFBCustomStr("F: ") }
+                     }});
+    }
+}
+
+TEST_CASE("TestLog","[log]")
+{
+    auto sink = std::make_shared<LogSinkToList>();
+    std::unique_ptr<Logger> logger(CreateLogger(sink));
+
+    SECTION("Sync")
+    {
+        logger->Info() << "one " << 2;
+        logger->UnsetLevel(Logger::Level::DEBUG);
+        logger->Debug() << "filtered";
+        logger->Warn() << "three";
+
+        std::vector<std::string> const list_lines = sink->GetLines();
+        REQUIRE(list_lines.size() == 2);
+        REQUIRE(list_lines[0] == "I: one 2");
+        REQUIRE(list_lines[1] == "W: three");
+    }
+
+    SECTION("Format blocks")
+    {
+        LogFBRunTimeMs fb_time;
+        auto const start = std::chrono::system_clock::now();
+        std::string const time_str = fb_time.GetAt(start+Hours(1)+Milliseconds(61007));
+        REQUIRE(time_str.size() == 12);
+        REQUIRE(time_str.substr(0,9) == "01:01:01.");
+
+        std::string line = "T: ";
+        fb_time.AppendTo(line,start+Hours(123));
+        REQUIRE(line.substr(0,13) == "T: 123:00:00.");
+    }
+
+    SECTION("Disabled levels")
+    {
+        uint eval_count=0;
+        auto eval = [&eval_count]() {
+            eval_count++;
+            return "eval";
+        };
+
+        logger->UnsetLevel(Logger::Level::DEBUG);
+        REQUIRE_FALSE(logger->IsLevelEnabled(Logger::Level::DEBUG));
+        REQUIRE(logger->IsLevelEnabled(Logger::Level::INFO));
+
+        // the macros don't evaluate arguments of disabled levels
+        OBDEX_LOG_DEBUG(*logger) << eval();
+        REQUIRE(eval_count == 0);
+
+        OBDEX_LOG_INFO(*logger) << eval() << " " << 1;
+        REQUIRE(eval_count == 1);
+
+        if(eval_count == 0)
+            OBDEX_LOG_INFO(*logger) << "not logged";
+        else
+            OBDEX_LOG_INFO(*logger) << "else branch";
+
+        std::vector<std::string> const list_lines = sink->GetLines();
+        REQUIRE(list_lines.size() == 2);
+        REQUIRE(list_lines[0] == "I: eval 1");
+        REQUIRE(list_lines[1] == "I: else branch");
+
+        // disabled levels don't wait on the logger's mutex,
+        // which is held by the current line
+        {
+            Logger::Line line = logger->Info();
+            line << "held";
+            std::thread thread([&logger]() {
+                logger->Debug() << "filtered";
+            });
+            thread.join();
+        }
+        REQUIRE(sink->GetLines().size() == 3);
+    }
+
+    SECTION("Async")
+    {
+        logger->StartAsync(1024);
+        REQUIRE(logger->IsAsync());
+
+        uint const thread_count = 4;
+        uint const line_count = 200;
+
+        std::vector<std::thread> list_threads;
+        for(uint t=0; t < thread_count; t++) {
+            list_threads.emplace_back([&logger,t,line_count]() {
+                for(uint i=0; i < line_count; i++) {
+                    logger->Info() << t << ":" << i;
+                }
+            });
+        }
+        for(auto &thread : list_threads) {
+            thread.join();
+        }
+
+        logger->UnsetLevel(Logger::Level::TRACE);
+        logger->Trace() << "filtered";
+
+        logger->Flush();
+
+        std::vector<std::string> const list_lines = sink->GetLines();
+        REQUIRE(logger->GetDroppedLineCount() == 0);
+        REQUIRE(list_lines.size() == thread_count*line_count);
+
+        // lines from each thread keep their order
+        std::vector<uint> list_next_line(thread_count,0);
+        for(auto const &line : list_lines) {
+            REQUIRE(line.substr(0,3) == "I: ");
+            std::vector<std::string> list_tokens = SplitString(line.substr(3),":");
+            REQUIRE(list_tokens.size() == 2);
+            uint const t = std::stoul(list_tokens[0]);
+            uint const i = std::stoul(list_tokens[1]);
+            REQUIRE(t < thread_count);
+            REQUIRE(i == list_next_line[t]);
+            list_next_line[t]++;
+        }
+
+        logger->StopAsync();
+        REQUIRE_FALSE(logger->IsAsync());
+
+        logger->Info() << "sync again";
+        REQUIRE(sink->GetLines().back() == "I: sync again");
+    }
+
+    SECTION("Async stop while logging")
+    {
+        logger->StartAsync(64);
+
+        uint const thread_count = 4;
+        uint const line_count = 2000;
+
+        std::atomic<uint> started(0);
+        std::vector<std::thread> list_threads;
+        for(uint t=0; t < thread_count; t++) {
+            list_threads.emplace_back([&logger,&started,line_count]() {
+                started++;
+                for(uint i=0; i < line_count; i++) {
+                    logger->Info() << i;
+                }
+            });
+        }
+        while(started < thread_count) {
+            std::this_thread::yield();
+        }
+
+        // lines are either written asynchronously,
+        // dropped, or written after StopAsync returns
+        logger->StopAsync();
+        for(auto &thread : list_threads) {
+            thread.join();
+        }
+
+        u64 const logged_count =
+                sink->GetLines().size()+logger->GetDroppedLineCount();
+        REQUIRE(logged_count == thread_count*line_count);
+    }
+
+    SECTION("Async full ring and long lines")
+    {
+        // the async thread only drains the ring when it
+        // starts and when it's stopped
+        logger->StartAsync(4,Hours(1));
+
+        std::string const long_line(Logger::k_async_max_line_length+10,'x');
+        logger->Info() << long_line;
+        for(uint i=0; i < 9; i++) {
+            logger->Info() << i;
+        }
+
+        // StopAsync flushes whatever fit
+        logger->StopAsync();
+
+        std::vector<std::string> const list_lines = sink->GetLines();
+        REQUIRE(list_lines.size() >= 4);
+        u64 const line_count = list_lines.size()+logger->GetDroppedLineCount();
+        REQUIRE(line_count == 10);
+        REQUIRE(list_lines[0].size() == 3+Logger::k_async_max_line_length);
+    }
+}
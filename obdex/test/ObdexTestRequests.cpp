@@ -0,0 +1,549 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/test/catch/catch.hpp>
+#include <obdex/test/ObdexTestHelpers.hpp>
+#include <obdex/ObdexUtil.hpp>
+#include <obdex/ObdexErrors.hpp>
+#include <obdex/ObdexLog.hpp>
+#include <obdex/ObdexParser.hpp>
+#include <obdex/ObdexResponseCount.hpp>
+#include <obdex/ObdexRequestPlanner.hpp>
+#include <obdex/ObdexScheduler.hpp>
+#include <obdex/ObdexBusModel.hpp>
+#include <obdex/ObdexVirtualVehicle.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+namespace obdex
+{
+    namespace test
+    {
+        // ============================================================= //
+
+        ParameterFrame BuildSAEJ1979Param(Parser &parser,
+                                          std::string const &name,
+                                          bool const add_pci_byte=true,
+                                          std::string const &protocol="ISO 15765 Standard Id")
+        {
+            ParameterFrame param;
+            param.spec = "SAEJ1979";
+            param.protocol = protocol;
+            param.address = "Default";
+            param.name = name;
+            param.iso15765_add_pci_byte = add_pci_byte;
+
+            parser.BuildParameterFrame(param);
+            return param;
+        }
+
+        // ============================================================= //
+
+        // physically addressed requests with responses of
+        // 6, 22 and 302 data bytes (including the prefix)
+        char const * const k_physical_definitions =
+                "<spec name=\"PHYSICAL\">\n"
+                "  <protocol name=\"ISO 9141-2\">\n"
+                "    <timing p2=\"\" p3=\"55\" />\n"
+                "    <address name=\"ECU\">\n"
+                "      <request prio=\"0x6C\" target=\"0x10\" source=\"0xF1\" />\n"
+                "      <response prio=\"0x6C\" target=\"0xF1\" source=\"0x10\" />\n"
+                "    </address>\n"
+                "  </protocol>\n"
+                "  <protocol name=\"ISO 14230\">\n"
+                "    <option name=\"Length Byte\" value=\"true\" />\n"
+                "    <address name=\"ECU\">\n"
+                "      <request format=\"0x80\" target=\"0x10\" source=\"0xF1\" />\n"
+                "      <response format=\"0x80\" target=\"0xF1\" source=\"0x10\" />\n"
+                "    </address>\n"
+                "  </protocol>\n"
+                "  <protocol name=\"ISO 15765 Standard Id\">\n"
+                "    <address name=\"ECU\">\n"
+                "      <request identifier=\"0x7E0\" />\n"
+                "      <response identifier=\"0x7E8\" />\n"
+                "    </address>\n"
+                "  </protocol>\n"
+                "  <parameters address=\"ECU\">\n"
+                "    <parameter name=\"SHORT\" request=\"0x22 0x01\"\n"
+                "      response.prefix=\"0x62 0x01\" response.bytes=\"4\">\n"
+                "      <script>saveNumericalData(new NumericalDataObj());</script>\n"
+                "    </parameter>\n"
+                "    <parameter name=\"LONG\" request=\"0x22 0x02\"\n"
+                "      response.prefix=\"0x62 0x02\" response.bytes=\"20\">\n"
+                "      <script>saveNumericalData(new NumericalDataObj());</script>\n"
+                "    </parameter>\n"
+                "    <parameter name=\"HUGE\" request=\"0x22 0x03\"\n"
+                "      response.prefix=\"0x62 0x03\" response.bytes=\"300\">\n"
+                "      <script>saveNumericalData(new NumericalDataObj());</script>\n"
+                "    </parameter>\n"
+                "  </parameters>\n"
+                "</spec>\n";
+
+        sint GetPhysicalResponseCount(Parser &parser,
+                                      std::string const &protocol,
+                                      std::string const &name)
+        {
+            ParameterFrame param;
+            param.spec = "PHYSICAL";
+            param.protocol = protocol;
+            param.address = "ECU";
+            param.name = name;
+            parser.BuildParameterFrame(param);
+            return param.list_message_data[0].exp_response_count;
+        }
+
+        // ============================================================= //
+    }
+}
+
+using namespace obdex;
+
+TEST_CASE("TestRequests","[requests]")
+{
+    if(test::cli_definitions_file.empty())
+    {
+        obdexlog.Trace() << "\n**********************************************************************\n"
+                         << "Invalid args for TestRequests\n"
+                            "To run TestRequests, pass in the obd2 definitions\n"
+                            "file as an argument: \n"
+                            "./test_obdex TestRequests --obdex-definitions-file /path/to/obd2.xml\n"
+                            "**********************************************************************\n";
+
+        bool cli_defn_file_avail=false;
+        REQUIRE(cli_defn_file_avail);
+    }
+
+    obdex::Parser parser(test::cli_definitions_file);
+
+    SECTION("learn expected response counts")
+    {
+        ResponseCountLearner learner;
+
+        // functional request, so the count isn't known
+        ParameterFrame param = test::BuildSAEJ1979Param(parser,"Engine RPM",false);
+        REQUIRE(param.list_message_data[0].exp_response_count < 0);
+        REQUIRE(GetELM327RequestData(param.list_message_data[0]) == "010C");
+        REQUIRE(learner.Apply(param) == false);
+
+        // two ecus respond
+        param.list_message_data[0].list_raw_frames.push_back(
+                    ByteList{0x07,0xE8,0x04,0x41,0x0C,0x1A,0xF8,0x00,0x00,0x00});
+        param.list_message_data[0].list_raw_frames.push_back(
+                    ByteList{0x07,0xE9,0x04,0x41,0x0C,0x1A,0xF8,0x00,0x00,0x00});
+
+        std::vector<Data> list_data;
+        parser.ParseParameterFrame(param,list_data);
+        learner.Learn(param);
+
+        auto count = learner.GetResponseCount(param.list_message_data[0]);
+        REQUIRE(count.frames == 2);
+        REQUIRE(count.responders == 2);
+        REQUIRE(count.samples == 1);
+
+        // the next build of the same request gets the count
+        ParameterFrame next_param = test::BuildSAEJ1979Param(parser,"Engine RPM",false);
+        REQUIRE(learner.Apply(next_param));
+        REQUIRE(next_param.list_message_data[0].exp_response_count == 2);
+        REQUIRE(GetELM327RequestData(next_param.list_message_data[0]) == "010C2");
+
+        // other requests aren't affected
+        ParameterFrame other_param = test::BuildSAEJ1979Param(parser,"Vehicle Speed",false);
+        REQUIRE(learner.Apply(other_param) == false);
+        REQUIRE(other_param.list_message_data[0].exp_response_count < 0);
+
+        learner.Clear();
+        REQUIRE(learner.GetResponseCount(param.list_message_data[0]).samples == 0);
+    }
+
+    SECTION("expected response counts for physical addresses")
+    {
+        std::string const file_path = "obdex_test_physical.xml";
+        {
+            std::ofstream file(file_path.c_str());
+            file << test::k_physical_definitions;
+        }
+        Parser physical_parser(file_path);
+        std::remove(file_path.c_str());
+
+        // an empty timing attribute isn't read as 0 ms
+        REQUIRE_THROWS_AS(physical_parser.GetBusTiming("PHYSICAL","ISO 9141-2"),
+                          XMLParsingFailed&);
+
+        // legacy frames carry at most seven data bytes
+        REQUIRE(test::GetPhysicalResponseCount(physical_parser,"ISO 9141-2","SHORT") == 1);
+        REQUIRE(test::GetPhysicalResponseCount(physical_parser,"ISO 9141-2","LONG") < 0);
+
+        // ISO 14230 frames carry up to 255 data bytes
+        REQUIRE(test::GetPhysicalResponseCount(physical_parser,"ISO 14230","SHORT") == 1);
+        REQUIRE(test::GetPhysicalResponseCount(physical_parser,"ISO 14230","LONG") == 1);
+        REQUIRE(test::GetPhysicalResponseCount(physical_parser,"ISO 14230","HUGE") < 0);
+
+        // ISO 15765: a single frame, or a first frame with six
+        // data bytes followed by consecutive frames with seven
+        std::string const iso15765 = "ISO 15765 Standard Id";
+        REQUIRE(test::GetPhysicalResponseCount(physical_parser,iso15765,"SHORT") == 1);
+        REQUIRE(test::GetPhysicalResponseCount(physical_parser,iso15765,"LONG") == 4);
+        REQUIRE(test::GetPhysicalResponseCount(physical_parser,iso15765,"HUGE") == 44);
+
+        // and that's how many frames the response is sent in
+        REQUIRE(SplitISO15765Frames(ByteList{0x07,0xE8},ByteList(22,0x62)).size() == 4);
+        REQUIRE(SplitISO15765Frames(ByteList{0x07,0xE8},ByteList(302,0x62)).size() == 44);
+    }
+
+    SECTION("coalesce mode 0x01 requests")
+    {
+        std::vector<ParameterFrame> list_params;
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"Engine RPM"));
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"Vehicle Speed"));
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"PIDs Supported 0x01-0x20"));
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"Engine Coolant Temperature"));
+
+        auto list_groups = PlanMultiPidRequests(list_params);
+        REQUIRE(list_groups.size() == 2);
+
+        RequestGroup &group = list_groups[0];
+        REQUIRE(group.type == REQUEST_MULTI_PID);
+        REQUIRE(group.list_param_idx == (std::vector<uint>{0,1,3}));
+        REQUIRE(group.request_frame.list_message_data[0].list_req_data_bytes[0] ==
+                (ByteList{0x04,0x01,0x0C,0x0D,0x05}));
+
+        // supported pids aren't mixed with other pids
+        REQUIRE(list_groups[1].type == REQUEST_SINGLE);
+        REQUIRE(list_groups[1].list_param_idx == (std::vector<uint>{2}));
+
+        // ecu1 responds to all pids with a multi-frame message:
+        // [41] [0C 1A F8] [0D 32] [05 7B]
+        // ecu2 only supports vehicle speed:
+        // [41] [0D 32]
+        MessageData &msg = group.request_frame.list_message_data[0];
+        msg.list_raw_frames.push_back(
+                    ByteList{0x07,0xE8,0x10,0x08,0x41,0x0C,0x1A,0xF8,0x0D,0x32});
+        msg.list_raw_frames.push_back(
+                    ByteList{0x07,0xE9,0x03,0x41,0x0D,0x32,0x00,0x00,0x00,0x00});
+        msg.list_raw_frames.push_back(
+                    ByteList{0x07,0xE8,0x21,0x05,0x7B,0x00,0x00,0x00,0x00,0x00});
+
+        std::vector<Data> list_data;
+        ParseRequestGroup(parser,group,list_params,list_data);
+        REQUIRE(list_data.size() == 4);
+
+        uint rpm_count=0;
+        uint speed_count=0;
+        uint coolant_count=0;
+        for(auto const &data : list_data)   {
+            REQUIRE(data.list_numerical_data.size() == 1);
+            double const value = data.list_numerical_data[0].value;
+            if(data.param_name == "Engine RPM")   {
+                REQUIRE(value == Approx(1726.0));
+                rpm_count++;
+            }
+            else if(data.param_name == "Vehicle Speed")   {
+                REQUIRE(value == Approx(50.0));
+                speed_count++;
+            }
+            else if(data.param_name == "Engine Coolant Temperature")   {
+                REQUIRE(value == Approx(83.0));
+                coolant_count++;
+            }
+        }
+        REQUIRE(rpm_count == 1);
+        REQUIRE(speed_count == 2);
+        REQUIRE(coolant_count == 1);
+    }
+
+    SECTION("coalesce padded multi-frame responses")
+    {
+        std::vector<ParameterFrame> list_params;
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"PIDs Supported 0x01-0x20"));
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"PIDs Supported 0x21-0x40"));
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"PIDs Supported 0x41-0x60"));
+
+        auto list_groups = PlanMultiPidRequests(list_params);
+        REQUIRE(list_groups.size() == 1);
+        RequestGroup &group = list_groups[0];
+        REQUIRE(group.type == REQUEST_MULTI_PID);
+
+        // [41] [00 FF FF FF FF] [20 FF FF FF FF] [40 FF FF FF FF],
+        // with the last consecutive frame padded with zeros
+        MessageData &msg = group.request_frame.list_message_data[0];
+        msg.list_raw_frames = SplitISO15765Frames(
+                    ByteList{0x07,0xE8},
+                    ByteList{0x41,
+                             0x00,0xFF,0xFF,0xFF,0xFF,
+                             0x20,0xFF,0xFF,0xFF,0xFF,
+                             0x40,0xFF,0xFF,0xFF,0xFF},
+                    true,0x00);
+        REQUIRE(msg.list_raw_frames.size() == 3);
+
+        std::vector<Data> list_data;
+        ParseRequestGroup(parser,group,list_params,list_data);
+        REQUIRE(list_data.size() == 3);
+        REQUIRE(list_data[0].param_name == "PIDs Supported 0x01-0x20");
+        REQUIRE(list_data[1].param_name == "PIDs Supported 0x21-0x40");
+        REQUIRE(list_data[2].param_name == "PIDs Supported 0x41-0x60");
+
+        // a padded single frame is trimmed to its pci length
+        ParameterFrame param = test::BuildSAEJ1979Param(parser,"Engine RPM");
+        param.list_message_data[0].list_raw_frames.push_back(
+                    ByteList{0x07,0xE8,0x04,0x41,0x0C,0x1A,0xF8,0x00,0x00,0x00});
+        parser.CleanParameterFrame(param);
+        REQUIRE(param.list_message_data[0].list_data[0] == (ByteList{0x1A,0xF8}));
+    }
+
+    SECTION("share identical requests")
+    {
+        std::vector<ParameterFrame> list_params;
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"Engine RPM"));
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"Vehicle Speed"));
+        list_params.push_back(test::BuildSAEJ1979Param(parser,"Engine RPM"));
+
+        auto list_groups = PlanSharedRequests(list_params);
+        REQUIRE(list_groups.size() == 2);
+        REQUIRE(list_groups[0].type == REQUEST_SHARED);
+        REQUIRE(list_groups[0].list_param_idx == (std::vector<uint>{0,2}));
+        REQUIRE(list_groups[1].type == REQUEST_SINGLE);
+        REQUIRE(list_groups[1].list_param_idx == (std::vector<uint>{1}));
+
+        RequestGroup &group = list_groups[0];
+        group.request_frame.list_message_data[0].list_raw_frames.push_back(
+                    ByteList{0x07,0xE8,0x04,0x41,0x0C,0x1A,0xF8,0x00,0x00,0x00});
+
+        std::vector<Data> list_data;
+        ParseRequestGroup(parser,group,list_params,list_data);
+        REQUIRE(list_data.size() == 2);
+        for(auto const &data : list_data)   {
+            REQUIRE(data.param_name == "Engine RPM");
+            REQUIRE(data.list_numerical_data[0].value == Approx(1726.0));
+        }
+    }
+
+    SECTION("schedule requests")
+    {
+        ParameterFrame param_fast = test::BuildSAEJ1979Param(parser,"Engine RPM");
+
+        // two requests with a delay between them
+        ParameterFrame param_slow = param_fast;
+        param_slow.list_message_data.push_back(param_slow.list_message_data[0]);
+        param_slow.list_message_data[1].req_data_delay_ms = 100;
+
+        Scheduler scheduler;
+        uint const fast_idx = scheduler.AddParameter(param_fast,10.0);
+        uint const slow_idx = scheduler.AddParameter(param_slow,1.0,1);
+
+        auto const duration = std::chrono::duration_cast<Microseconds>(Seconds(1));
+        auto const request_time = std::chrono::duration_cast<Microseconds>(Milliseconds(10));
+        auto list_requests = scheduler.Plan(duration,request_time);
+
+        // the higher priority parameter goes first, and other
+        // requests are sent while it waits for its delay
+        REQUIRE(list_requests.size() > 3);
+        REQUIRE(list_requests[0].param_idx == slow_idx);
+        REQUIRE(list_requests[0].msg_idx == 0);
+        REQUIRE(list_requests[1].param_idx == fast_idx);
+
+        TimePoint slow_req1_time = TimePoint::max();
+        for(auto const &request : list_requests)   {
+            if(request.param_idx == slow_idx && request.msg_idx == 1)   {
+                slow_req1_time = request.send_time;
+                break;
+            }
+        }
+        REQUIRE((slow_req1_time-list_requests[0].send_time) >=
+                (request_time+Milliseconds(100)));
+
+        auto list_rates = scheduler.GetPlannedRates(duration,request_time);
+        REQUIRE(list_rates[fast_idx] == Approx(10.0));
+        REQUIRE(list_rates[slow_idx] == Approx(1.0));
+
+        // achieved rates from the real scheduler
+        TimePoint t;
+        for(uint i=0; i < 20; i++)   {
+            ScheduledRequest request;
+            while(!scheduler.Next(t,request))   {
+                t = scheduler.GetNextReadyTime();
+            }
+            t += request_time;
+            scheduler.OnRequestComplete(request,t);
+        }
+        REQUIRE(scheduler.GetAchievedRate(fast_idx) == Approx(10.0).epsilon(0.05));
+    }
+
+    SECTION("estimate bus load")
+    {
+        BusTiming can_timing = parser.GetBusTiming("SAEJ1979","ISO 15765 Standard Id");
+        REQUIRE(can_timing.protocol == PROTOCOL_ISO_15765);
+        REQUIRE(can_timing.list_baudrates.size() == 2);
+        REQUIRE(can_timing.baudrate == 500000);
+
+        BusTiming kline_timing = parser.GetBusTiming("SAEJ1979","ISO 9141-2");
+        REQUIRE(kline_timing.baudrate == 10400);
+        REQUIRE(kline_timing.bits_per_byte == 10);
+        REQUIRE(kline_timing.p2_req_to_resp == Milliseconds(25));
+
+        REQUIRE_THROWS(parser.GetBusTiming("SAEJ1979","Invalid Protocol"));
+
+        // 11-bit CAN: (47 + 64 + 24 stuff bits) @ 500 kbps
+        // for the request and the response
+        ParameterFrame can_param = test::BuildSAEJ1979Param(parser,"Engine RPM");
+        REQUIRE(EstimateWireTime(can_timing,can_param) == Microseconds(270*2));
+        REQUIRE(EstimatePollTime(can_timing,can_param) == Microseconds(270*2));
+
+        // K-line: [68 6A F1] [01 0C] [cs] with P4 between bytes,
+        // P2, then [48 6B xx] [41 0C aa bb] [cs] and P3
+        ParameterFrame kline_param =
+                test::BuildSAEJ1979Param(parser,"Engine RPM",true,"ISO 9141-2");
+
+        Microseconds const req_time = Microseconds(5770)+Milliseconds(5*5);
+        Microseconds const resp_time = Microseconds(7693);
+        REQUIRE(EstimateWireTime(kline_timing,kline_param) == req_time+resp_time);
+
+        Microseconds const poll_time =
+                req_time+resp_time+Milliseconds(25)+Milliseconds(55);
+        REQUIRE(EstimatePollTime(kline_timing,kline_param) == poll_time);
+
+        // ten parameters already drop K-line below 1 Hz
+        std::vector<ParameterFrame> list_params(10,kline_param);
+        double const max_rate = EstimateMaxPollRate(kline_timing,list_params);
+        REQUIRE(max_rate == Approx(1000000.0/(poll_time.count()*10)));
+        REQUIRE(max_rate < 1.0);
+
+        std::vector<ParameterFrame> list_can_params(10,can_param);
+        REQUIRE(EstimateMaxPollRate(can_timing,list_can_params) > 50.0);
+
+        std::vector<double> list_rates(10,0.5);
+        REQUIRE(EstimateBusLoad(kline_timing,list_params,list_rates) < 1.0);
+        list_rates.assign(10,1.0);
+        REQUIRE(EstimateBusLoad(kline_timing,list_params,list_rates) > 1.0);
+
+        list_rates.pop_back();
+        REQUIRE_THROWS_AS(EstimateBusLoad(kline_timing,list_params,list_rates),
+                          InvalidArgument&);
+    }
+
+    SECTION("simulate a vehicle")
+    {
+        // ISO 15765: two ECUs answer a functional request
+        VirtualVehicle can_vehicle(PROTOCOL_ISO_15765,false,1234);
+        can_vehicle.AddEcu(0x7E8);
+        uint const ecu2 = can_vehicle.AddEcu(0x7E9);
+        can_vehicle.SetLatency(Milliseconds(5),Milliseconds(20));
+
+        ParameterFrame param = test::BuildSAEJ1979Param(parser,"Engine RPM");
+        Microseconds const elapsed = can_vehicle.Respond(param);
+        REQUIRE(elapsed >= Milliseconds(5));
+        REQUIRE(elapsed <= Milliseconds(20));
+        REQUIRE(param.list_message_data[0].list_raw_frames.size() == 2);
+
+        std::vector<Data> list_data;
+        parser.ParseParameterFrame(param,list_data);
+        REQUIRE(list_data.size() == 2);
+
+        // long responses are sent as ISO-TP multi-frame messages
+        ByteList long_resp {0x41,0x0C};
+        for(uint i=0; i < 18; i++)   {
+            long_resp.push_back(i);
+        }
+        can_vehicle.SetResponse(ecu2,ByteList{0x01,0x0C},long_resp);
+        can_vehicle.SetPadFrames(true);
+
+        param = test::BuildSAEJ1979Param(parser,"Engine RPM");
+        can_vehicle.Respond(param);
+        MessageData &msg = param.list_message_data[0];
+        REQUIRE(msg.list_raw_frames.size() == 1+3);
+        for(auto const &frame : msg.list_raw_frames)   {
+            REQUIRE(frame.size() == 2+8);
+        }
+
+        parser.CleanParameterFrame(param);
+        bool found_long_resp = false;
+        for(auto const &data : msg.list_data)   {
+            if(data.size() >= 18)   {
+                found_long_resp = (data[0] == 0 && data[17] == 17);
+            }
+        }
+        REQUIRE(found_long_resp);
+
+        // ISO 9141-2: a physical request to one of two ECUs
+        ParameterFrame kline_param =
+                test::BuildSAEJ1979Param(parser,"Engine RPM",true,"ISO 9141-2");
+        kline_param.list_message_data[0].req_header_bytes[1] = 0x10;
+
+        VirtualVehicle kline_vehicle(PROTOCOL_ISO_9141_2);
+        kline_vehicle.AddEcu(0x10);
+        kline_vehicle.AddEcu(0x18);
+        kline_vehicle.Respond(kline_param);
+        REQUIRE(kline_param.list_message_data[0].list_raw_frames.size() == 1);
+        REQUIRE(kline_param.list_message_data[0].list_raw_frames[0][2] == 0x10);
+
+        list_data.clear();
+        parser.ParseParameterFrame(kline_param,list_data);
+        REQUIRE(list_data.size() == 1);
+
+        // ISO 14230 header formats: [F], [F] [L], [F] [T] [S]
+        // and [F] [T] [S] [L]; Engine RPM is 0x41 0x0C [A] [B]
+        ParameterFrame kwp_param =
+                test::BuildSAEJ1979Param(parser,"Engine RPM",true,"ISO 14230");
+
+        VirtualVehicle kwp_vehicle(PROTOCOL_ISO_14230);
+        kwp_vehicle.AddEcu(0x10);
+        for(uint header_length=1; header_length <= 4; header_length++)   {
+            kwp_param.list_message_data[0].list_raw_frames.clear();
+            kwp_vehicle.SetISO14230HeaderLength(header_length);
+            kwp_vehicle.Respond(kwp_param);
+            ByteList const &frame = kwp_param.list_message_data[0].list_raw_frames[0];
+            REQUIRE(frame.size() == header_length+4);
+            REQUIRE((header_length == 2 || header_length == 4) ==
+                    ((frame[0] & 0x3F) == 0));
+        }
+
+        // [F] can't hold lengths over 63 bytes
+        ByteList kwp_long_resp {0x41,0x0C};
+        kwp_long_resp.resize(100,0x00);
+        kwp_vehicle.SetResponse(0,ByteList{0x01,0x0C},kwp_long_resp);
+        for(uint header_length=1; header_length <= 4; header_length++)   {
+            kwp_param.list_message_data[0].list_raw_frames.clear();
+            kwp_vehicle.SetISO14230HeaderLength(header_length);
+            kwp_vehicle.Respond(kwp_param);
+            ByteList const &frame = kwp_param.list_message_data[0].list_raw_frames[0];
+            uint const long_header_length = (header_length < 3) ? 2 : 4;
+            REQUIRE(frame.size() == long_header_length+100);
+            REQUIRE((frame[0] & 0x3F) == 0);
+            REQUIRE(frame[long_header_length-1] == 100);
+        }
+
+        kwp_long_resp.resize(256,0x00);
+        kwp_vehicle.SetResponse(0,ByteList{0x01,0x0C},kwp_long_resp);
+        REQUIRE_THROWS_AS(kwp_vehicle.Respond(kwp_param),BuildParamFrameFailed&);
+
+        // random responses that fill some number of frames
+        VirtualVehicle fill_vehicle(PROTOCOL_ISO_15765);
+        fill_vehicle.AddEcu(0x7E8);
+        fill_vehicle.SetResponseDataLength(20);
+
+        param = test::BuildSAEJ1979Param(parser,"Engine RPM");
+        fill_vehicle.Respond(param);
+        REQUIRE(param.list_message_data[0].list_raw_frames.size() == 3);
+        REQUIRE(param.list_message_data[0].list_raw_frames[0][3] == 20);
+
+        // errors
+        kline_vehicle.SetErrorRates(1.0,0.0);
+        kline_param.list_message_data[0].list_raw_frames.clear();
+        kline_vehicle.Respond(kline_param);
+        REQUIRE(kline_param.list_message_data[0].list_raw_frames.empty());
+        REQUIRE(kline_vehicle.GetDroppedFrameCount() == 1);
+    }
+}
@@ -0,0 +1,645 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/test/catch/catch.hpp>
+#include <obdex/test/ObdexTestHelpers.hpp>
+#include <obdex/codegen/ObdexScriptTranslator.hpp>
+#include <obdex/ObdexErrors.hpp>
+#include <obdex/ObdexLog.hpp>
+#include <obdex/ObdexNativeScripts.hpp>
+#include <obdex/ObdexParser.hpp>
+#include <obdex/ObdexScriptAnalysis.hpp>
+#include <obdex/ObdexVirtualVehicle.hpp>
+
+#include <cmath>
+#include <cstring>
+
+namespace obdex
+{
+    namespace test
+    {
+        // ============================================================= //
+
+        bool SameValue(double a, double b)
+        {
+            return ((std::isnan(a) && std::isnan(b)) || a == b);
+        }
+
+        bool SameData(Data const &a, Data const &b)
+        {
+            if(a.param_name != b.param_name ||
+               a.src_name != b.src_name ||
+               a.list_numerical_data.size() != b.list_numerical_data.size() ||
+               a.list_literal_data.size() != b.list_literal_data.size())   {
+                return false;
+            }
+
+            for(size_t i=0; i < a.list_numerical_data.size(); i++)   {
+                NumericalData const &na = a.list_numerical_data[i];
+                NumericalData const &nb = b.list_numerical_data[i];
+                if(!SameValue(na.value,nb.value) ||
+                   !SameValue(na.min,nb.min) ||
+                   !SameValue(na.max,nb.max) ||
+                   na.units != nb.units ||
+                   na.property != nb.property)   {
+                    return false;
+                }
+            }
+
+            for(size_t i=0; i < a.list_literal_data.size(); i++)   {
+                LiteralData const &la = a.list_literal_data[i];
+                LiteralData const &lb = b.list_literal_data[i];
+                if(la.value != lb.value ||
+                   la.value_if_false != lb.value_if_false ||
+                   la.value_if_true != lb.value_if_true ||
+                   la.property != lb.property)   {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // ParseAndCompare
+        // * parses random responses to every SAEJ1979 parameter
+        //   with both parsers and checks that the results match
+        void ParseAndCompare(Parser &parser_js,
+                             Parser &parser_test,
+                             uint const rounds)
+        {
+            std::string const protocol = "ISO 15765 Standard Id";
+            std::vector<std::string> const list_names =
+                    parser_js.GetParameterNames("SAEJ1979",protocol,"Default");
+            REQUIRE_FALSE(list_names.empty());
+
+            VirtualVehicle vehicle(PROTOCOL_ISO_15765,false,1);
+            vehicle.AddEcu(0x7E8);
+
+            for(auto const &name : list_names)
+            {
+                ParameterFrame param;
+                param.spec = "SAEJ1979";
+                param.protocol = protocol;
+                param.address = "Default";
+                param.name = name;
+                parser_js.BuildParameterFrame(param);
+
+                for(uint i=0; i < rounds; i++)   {
+                    for(auto &msg : param.list_message_data)   {
+                        msg.list_raw_frames.clear();
+                    }
+                    vehicle.SetPadFrames(i%2 == 1);
+                    vehicle.Respond(param);
+
+                    std::vector<Data> list_data_js;
+                    std::vector<Data> list_data_test;
+                    parser_js.ParseParameterFrame(param,list_data_js);
+                    parser_test.ParseParameterFrame(param,list_data_test);
+
+                    REQUIRE(list_data_js.size() == list_data_test.size());
+                    for(size_t k=0; k < list_data_js.size(); k++)   {
+                        g_test_desc = name;
+                        REQUIRE(SameData(list_data_js[k],list_data_test[k]));
+                    }
+                }
+            }
+        }
+
+        // ============================================================= //
+    }
+}
+
+using namespace obdex;
+
+TEST_CASE("TestScript","[script]")
+{
+    SECTION("Tokenize")
+    {
+        std::vector<ScriptToken> list_tokens;
+        REQUIRE(TokenizeScript("var x = BYTE(0x1F)>>>=2; // comment\n"
+                               "/* block */ s = 'a\\'b' + 1.5e3;",
+                               list_tokens));
+
+        std::vector<std::string> const list_expected {
+            "var","x","=","BYTE","(","0x1F",")",">>>=","2",";",
+            "s","=","'a\\'b'","+","1.5e3",";"
+        };
+        REQUIRE(list_tokens.size() == list_expected.size());
+        for(size_t i=0; i < list_tokens.size(); i++)   {
+            REQUIRE(list_tokens[i].text == list_expected[i]);
+        }
+        REQUIRE(list_tokens[0].type == SCRIPT_TOKEN_IDENTIFIER);
+        REQUIRE(list_tokens[5].type == SCRIPT_TOKEN_NUMBER);
+        REQUIRE(list_tokens[12].type == SCRIPT_TOKEN_STRING);
+        REQUIRE(list_tokens[7].type == SCRIPT_TOKEN_PUNCTUATOR);
+        REQUIRE(list_tokens[3].offset == 8);
+
+        // division isn't a regular expression
+        REQUIRE(TokenizeScript("var a = BYTE(0)/2/4;",list_tokens));
+
+        // unsupported
+        REQUIRE_FALSE(TokenizeScript("var r = /ab+/;",list_tokens));
+        REQUIRE_FALSE(TokenizeScript("var s = 'open;",list_tokens));
+        REQUIRE_FALSE(TokenizeScript("/* open",list_tokens));
+    }
+
+    SECTION("Analyze")
+    {
+        ScriptAnalysis analysis;
+
+        analysis = AnalyzeScript(
+                    "var v = new NumericalDataObj();\n"
+                    "v.units = \"%\"; v.min = 0; v.max = 100;\n"
+                    "v.value = ((BYTE(1)*256)+BYTE(0))*100/65535;\n"
+                    "saveNumericalData(v);");
+        REQUIRE(analysis.data_only);
+        REQUIRE_FALSE(analysis.dynamic_byte_positions);
+        REQUIRE_FALSE(analysis.uses_length);
+        REQUIRE(analysis.list_byte_positions == std::vector<uint>({0,1}));
+
+        // literal positions, dynamic bits, local functions
+        analysis = AnalyzeScript(
+                    "function bitName(b) { return 'Bit ' + b; }\n"
+                    "for(var i=0, n=8; i < n; i++) {\n"
+                    "  var lit = new LiteralDataObj();\n"
+                    "  lit.property = bitName(i);\n"
+                    "  lit.value = BIT(2,i) ? true : false;\n"
+                    "  saveLiteralData(lit);\n"
+                    "}");
+        REQUIRE(analysis.data_only);
+        REQUIRE(analysis.list_byte_positions == std::vector<uint>({2}));
+
+        analysis = AnalyzeScript("for(var i=0; i < LENGTH(); i++) { BYTE(i); }");
+        REQUIRE(analysis.data_only);
+        REQUIRE(analysis.dynamic_byte_positions);
+        REQUIRE(analysis.uses_length);
+        REQUIRE(analysis.list_byte_positions.empty());
+
+        // results that depend on more than the data bytes
+        REQUIRE_FALSE(AnalyzeScript("var h = HEADER(0).BYTE(0);").data_only);
+        REQUIRE_FALSE(AnalyzeScript("var d = REQ(0).DATA(1).BYTE(0);").data_only);
+        REQUIRE_FALSE(AnalyzeScript("count = count + BYTE(0);").data_only);
+        REQUIRE_FALSE(AnalyzeScript("var r = Math.random()*BYTE(0);").data_only);
+        REQUIRE_FALSE(AnalyzeScript("var t = this.x;").data_only);
+        REQUIRE_FALSE(AnalyzeScript("var r = /x/.test('x');").data_only);
+
+        // object keys and properties aren't globals
+        REQUIRE(AnalyzeScript("var o = {value: BYTE(0), units: 'C'};"
+                              "var f = Math.floor(o.value);").data_only);
+    }
+
+    SECTION("Rewrite")
+    {
+        std::string rewritten;
+        REQUIRE(RewriteScriptHelpers(
+                    "var v = BYTE(0) + BIT(1, i) + LENGTH(); // BYTE(3)",
+                    rewritten));
+        REQUIRE(rewritten.find("var v = __obdex_bytes[(0)] + "
+                               "((__obdex_bytes[(1)] & (1 << (i))) > 0 ? 1 : 0) + "
+                               "__obdex_bytes.length; // BYTE(3)") != std::string::npos);
+
+        // nested calls, methods are left as they are
+        REQUIRE(RewriteScriptHelpers("var b = REQ(1).DATA(BYTE(0)).BYTE(NUM_REQ()-1);",rewritten));
+        REQUIRE(rewritten.find("var b = __obdex_reqs[(1)].DATA(__obdex_bytes[(0)])"
+                               ".BYTE(__obdex_reqs.length-1);") != std::string::npos);
+
+        // calls with the wrong number of arguments
+        REQUIRE(RewriteScriptHelpers("var b = BYTE(0,1) + BYTE(2);",rewritten));
+        REQUIRE(rewritten.find("BYTE(0,1) + __obdex_bytes[(2)]") != std::string::npos);
+
+        // nothing to rewrite, or helpers that
+        // may not mean what they usually do
+        REQUIRE_FALSE(RewriteScriptHelpers("var b = x.BYTE(0);",rewritten));
+        REQUIRE_FALSE(RewriteScriptHelpers("var BYTE = 1; var b = BYTE;",rewritten));
+        REQUIRE_FALSE(RewriteScriptHelpers("function BIT(a,b) { return 0; } BIT(0,1);",rewritten));
+        REQUIRE_FALSE(RewriteScriptHelpers("var b = eval('BYTE(0)');",rewritten));
+        REQUIRE(rewritten.empty());
+    }
+
+    SECTION("Translate")
+    {
+        std::string cpp_code;
+        std::string error;
+
+        REQUIRE(codegen::TranslateScript(
+                    "var v = new NumericalDataObj();\n"
+                    "v.units = 'rpm'; v.min = 0; v.max = 16383.75\n"
+                    "v.value = ((BYTE(0)*256)+BYTE(1))/4;\n"
+                    "saveNumericalData(v);",
+                    "parse_rpm",cpp_code,error));
+        REQUIRE(error.empty());
+        REQUIRE(cpp_code.find("void parse_rpm(NativeScriptInput const &input, Data &data)") !=
+                std::string::npos);
+
+        REQUIRE(codegen::TranslateScript(
+                    "var names = ['A','B'];\n"
+                    "for(var i=0; i < 2; i++) {\n"
+                    "  var lit = new LiteralDataObj();\n"
+                    "  lit.property = 'PID ' + (i+1).toString(16).toUpperCase();\n"
+                    "  lit.valueIfTrue = names[i];\n"
+                    "  switch(BYTE(0) >> 4) { case 1: lit.value = true; break; default: break; }\n"
+                    "  if(REQ(0).DATA(0).BIT(1,i) == 1 && NUM_RESP(0) > 0) { continue; }\n"
+                    "  saveLiteralData(lit);\n"
+                    "}",
+                    "parse_lit",cpp_code,error));
+
+        // js results that depend on type conversions
+        // or anything outside the subset stay in js
+        REQUIRE_FALSE(codegen::TranslateScript("var l = new LiteralDataObj(); l.value = BIT(0,1);",
+                                               "f",cpp_code,error));
+        REQUIRE_FALSE(error.empty());
+        REQUIRE(cpp_code.empty());
+        REQUIRE_FALSE(codegen::TranslateScript("var n = new NumericalDataObj(); n.max = '255';",
+                                               "f",cpp_code,error));
+        REQUIRE_FALSE(codegen::TranslateScript("var x = 1; x = 'a';","f",cpp_code,error));
+        REQUIRE_FALSE(codegen::TranslateScript("count = BYTE(0);","f",cpp_code,error));
+        REQUIRE_FALSE(codegen::TranslateScript("function f(b) { return b; }","f",cpp_code,error));
+        REQUIRE_FALSE(codegen::TranslateScript("var o = {value: 1};","f",cpp_code,error));
+        REQUIRE_FALSE(codegen::TranslateScript("var r = Math.random();","f",cpp_code,error));
+        REQUIRE_FALSE(codegen::TranslateScript("var x = BYTE(0) + BYTE(1)++;","f",cpp_code,error));
+        REQUIRE_FALSE(codegen::TranslateScript("var x = 010;","f",cpp_code,error));
+    }
+
+    SECTION("Native helpers")
+    {
+        ByteList const data_bytes {0x12,0x80};
+        NativeScriptInput const input(data_bytes);
+        REQUIRE(native::Byte(input.GetData(0,0),1) == 0x80);
+        REQUIRE(native::Bit(input.GetData(0,0),1,7) == 1);
+        REQUIRE(native::Bit(input.GetData(0,0),0,32) == 0);
+        REQUIRE(native::Bit(input.GetData(0,0),0,33) == 1);
+        REQUIRE_THROWS_AS(native::Byte(input.GetData(0,0),2),native::Bail);
+        REQUIRE_THROWS_AS(native::Byte(input.GetData(0,0),0.5),native::Bail);
+        REQUIRE_THROWS_AS(input.GetData(0,1),native::Bail);
+        REQUIRE_THROWS_AS(input.GetHeader(0,0),native::Bail);
+
+        REQUIRE(native::ToInt32(4294967295.0) == -1);
+        REQUIRE(native::ToInt32(-1.5) == -1);
+        REQUIRE(native::ShiftRightUnsigned(-1,28) == 15);
+        REQUIRE(native::ShiftLeft(1,31) == -2147483648.0);
+        REQUIRE(native::MathRound(-2.5) == -2);
+        REQUIRE(std::signbit(native::MathRound(-0.2)));
+        REQUIRE(native::JsOr(0,5) == 5);
+
+        REQUIRE(native::NumberToString(255,16) == "ff");
+        REQUIRE(native::NumberToString(-10,10) == "-10");
+        REQUIRE(native::NumberToString(NAN,10) == "NaN");
+        REQUIRE_THROWS_AS(native::NumberToString(0.5,10),native::Bail);
+        REQUIRE(native::ToUpperCase("a1f") == "A1F");
+    }
+
+    if(test::cli_definitions_file.empty())
+    {
+        obdexlog.Trace() << "\n**********************************************************************\n"
+                         << "Invalid args for TestScript\n"
+                            "To run TestScript, pass in the obd2 definitions\n"
+                            "file as an argument: \n"
+                            "./test_obdex TestScript --obdex-definitions-file /path/to/obd2.xml\n"
+                            "**********************************************************************\n";
+
+        bool cli_defn_file_avail=false;
+        REQUIRE(cli_defn_file_avail);
+    }
+
+    SECTION("Lookup tables")
+    {
+        Parser parser_js(test::cli_definitions_file);
+        Parser parser_table(test::cli_definitions_file);
+        parser_table.SetLookupTableMaxDomain(65536);
+
+        // entries are filled in as they're parsed
+        test::ParseAndCompare(parser_js,parser_table,8);
+
+        LookupTableStats stats = parser_table.GetLookupTableStats();
+        REQUIRE(stats.table_count > 0);
+        REQUIRE(stats.misses > 0);
+        REQUIRE(stats.entries > 0);
+        REQUIRE(parser_js.GetLookupTableStats().table_count == 0);
+
+        // precomputed tables only run the script for
+        // inputs with a different layout of results
+        // (one byte scripts only to keep this quick)
+        parser_table.SetLookupTableMaxDomain(256);
+        stats = parser_table.GetLookupTableStats();
+        parser_table.PrecomputeLookupTables();
+        LookupTableStats const precomputed = parser_table.GetLookupTableStats();
+        REQUIRE(precomputed.entries > stats.entries);
+
+        test::ParseAndCompare(parser_js,parser_table,8);
+        stats = parser_table.GetLookupTableStats();
+        u64 const hits = stats.hits-precomputed.hits;
+        u64 const misses = stats.misses-precomputed.misses;
+        REQUIRE(hits > misses);
+
+        // lowering the limit frees the tables
+        parser_table.SetLookupTableMaxDomain(0);
+        REQUIRE(parser_table.GetLookupTableStats().table_count == 0);
+        test::ParseAndCompare(parser_js,parser_table,1);
+    }
+
+    SECTION("Native scripts")
+    {
+        // obdex/generated/ObdexNativeObd2.cpp is generated
+        // from some of the obd2.xml scripts by obdex_codegen
+        Parser parser_js(test::cli_definitions_file);
+
+        Parser parser_native(test::cli_definitions_file);
+        parser_native.SetScriptEngine("native");
+        REQUIRE(parser_native.GetCompiledScriptCount("native") > 0);
+        REQUIRE(parser_native.GetCompiledScriptCount("native") <= GetRegisteredNativeScriptCount());
+
+        test::ParseAndCompare(parser_js,parser_native,8);
+    }
+
+    SECTION("Script engines")
+    {
+        Parser parser_js(test::cli_definitions_file);
+        parser_js.SetScriptEngine("duktape");
+        size_t const script_count = parser_js.GetCompiledScriptCount("duktape");
+        REQUIRE(script_count > 0);
+
+        // scripts with rewritten helper calls
+        // give the same results as the originals
+        Parser parser_plain(test::cli_definitions_file);
+        parser_plain.AddScriptEngine(std::unique_ptr<ScriptEngine>(new DuktapeScriptEngine(false)));
+        parser_plain.SetScriptEngine("duktape");
+        REQUIRE(parser_plain.GetCompiledScriptCount("duktape") == script_count);
+        test::ParseAndCompare(parser_plain,parser_js,4);
+
+        // an engine that can't run any scripts
+        // falls back to duktape
+        class NoScriptEngine : public ScriptEngine
+        {
+        public:
+            std::string const & GetName() const
+            {
+                static std::string const name("none");
+                return name;
+            }
+            bool Compile(u32,std::string const &,std::string const &) { return false; }
+            void BindInput(ByteList const &) {}
+            void BindInput(std::vector<MessageData> const &) {}
+            bool Run(u32,bool) { return false; }
+            void ExtractResults(Data &) {}
+            void SetBudget(ScriptBudget const &) {}
+            u64 GetLastRunSteps() const { return 0; }
+            void SetHeapLimit(size_t) {}
+            ScriptHeapStats GetHeapStats() const { return ScriptHeapStats(); }
+            std::unique_ptr<ScriptEngine> Clone() const
+            {
+                return std::unique_ptr<ScriptEngine>(new NoScriptEngine);
+            }
+        };
+
+        Parser parser_mixed(test::cli_definitions_file);
+        parser_mixed.AddScriptEngine(std::unique_ptr<ScriptEngine>(new NoScriptEngine));
+        REQUIRE(parser_mixed.GetCompiledScriptCount("none") == 0);
+        parser_mixed.SetScriptEngine("none");
+        parser_mixed.SetParameterScriptEngine("SAEJ1979","Default","Engine RPM","native");
+        test::ParseAndCompare(parser_js,parser_mixed,2);
+
+        // clones have the same engines and selection
+        Parser parser_mixed_clone = parser_mixed.Clone();
+        REQUIRE(parser_mixed_clone.GetCompiledScriptCount("none") == 0);
+        test::ParseAndCompare(parser_js,parser_mixed_clone,2);
+
+        REQUIRE_THROWS_AS(parser_mixed.SetScriptEngine("v8"),InvalidScriptEngine&);
+        REQUIRE_THROWS_AS(parser_mixed.GetCompiledScriptCount("v8"),InvalidScriptEngine&);
+        REQUIRE_THROWS_AS(parser_mixed.SetParameterScriptEngine(
+                              "SAEJ1979","Default","Not A Parameter","native"),
+                          InvalidScriptEngine&);
+    }
+
+    SECTION("Script budgets")
+    {
+        std::string instrumented;
+        REQUIRE(InstrumentScriptSteps(
+                    "while(i < 4) { i++; } for(var k=0; k < 2; k++) {} for(;;) {}",
+                    "step",instrumented));
+        REQUIRE(instrumented == "while(step() && (i < 4)) { i++; } "
+                                "for(var k=0; step() && ( k < 2); k++) {} "
+                                "for(; step();) {}");
+
+        REQUIRE(InstrumentScriptSteps("function f(a) { return a; } do {} while(f(0));",
+                                      "step",instrumented));
+        REQUIRE(instrumented == "function f(a) { step(); return a; } "
+                                "do {} while(step() && (f(0)));");
+
+        REQUIRE(InstrumentScriptSteps("for(var k in o) {} for(k in o) k++;",
+                                      "step",instrumented));
+        REQUIRE(instrumented == "for(var k in o) if(step()) {} "
+                                "for(k in o) if(step()) k++;");
+
+        // nothing to instrument
+        REQUIRE(InstrumentScriptSteps("var v = BYTE(0);","step",instrumented));
+        REQUIRE(instrumented.empty());
+
+        // scripts that can't be tokenized aren't instrumented
+        REQUIRE_FALSE(InstrumentScriptSteps("var r = /a+/; while(true) {}",
+                                            "step",instrumented));
+        REQUIRE(instrumented.empty());
+
+        // a budget stops scripts that never finish,
+        // even if they catch the error
+        ByteList const data_bytes {0x12,0x80};
+        ScriptBudget budget;
+        budget.max_steps = 1000;
+
+        DuktapeScriptEngine engine;
+        engine.SetBudget(budget);
+        REQUIRE(engine.Compile(0,"loop","while(true) {}"));
+        REQUIRE(engine.Compile(1,"catch","while(true) { try { while(true) {} } catch(e) {} }"));
+        REQUIRE(engine.Compile(2,"done","for(var i=0; i < 10; i++) {}"));
+        engine.BindInput(data_bytes);
+        REQUIRE_THROWS_AS(engine.Run(0,true),ScriptBudgetExceeded&);
+        REQUIRE(engine.GetLastRunSteps() == 1001);
+        REQUIRE_THROWS_AS(engine.Run(1,false),ScriptBudgetExceeded&);
+        REQUIRE(engine.Run(2,false));
+        REQUIRE(engine.GetLastRunSteps() == 11);
+
+        budget.max_steps = 0;
+        budget.max_time = Microseconds(2000);
+        engine.SetBudget(budget);
+        REQUIRE(engine.Compile(0,"loop","while(true) {}"));
+        REQUIRE_THROWS_AS(engine.Run(0,false),ScriptBudgetExceeded&);
+
+        ScriptBudgetCounter counter;
+        budget.max_steps = 2;
+        budget.max_time = Microseconds(0);
+        counter.Start(budget);
+        NativeScriptInput input(data_bytes);
+        input.SetBudgetCounter(&counter);
+        REQUIRE(input.Step());
+        REQUIRE(input.Step());
+        REQUIRE_THROWS_AS(input.Step(),ScriptBudgetExceeded&);
+
+        // a budget that's large enough doesn't change
+        // any results and records how close scripts came
+        Parser parser_js(test::cli_definitions_file);
+        parser_js.SetScriptEngine("duktape");
+
+        budget.max_steps = 100000;
+        Parser parser_budget(test::cli_definitions_file);
+        parser_budget.SetScriptBudget(budget);
+        REQUIRE(parser_budget.GetScriptBudget().max_steps == budget.max_steps);
+        test::ParseAndCompare(parser_js,parser_budget,2);
+
+        std::vector<ScriptBudgetStats> list_stats =
+                parser_budget.GetScriptBudgetStats();
+        REQUIRE_FALSE(list_stats.empty());
+        u64 max_steps=0;
+        for(auto const &stats : list_stats)   {
+            REQUIRE(stats.runs > 0);
+            REQUIRE(stats.exceeded == 0);
+            REQUIRE(stats.max_steps <= budget.max_steps);
+            max_steps = std::max(max_steps,stats.max_steps);
+        }
+        REQUIRE(max_steps > 0);
+
+        parser_budget.ResetScriptBudgetStats();
+        REQUIRE(parser_budget.GetScriptBudgetStats().empty());
+
+        // a budget that's too small
+        ParameterFrame param;
+        param.spec = "SAEJ1979";
+        param.protocol = "ISO 15765 Standard Id";
+        param.address = "Default";
+        param.name = "PIDs Supported 0x01-0x20";
+        parser_budget.BuildParameterFrame(param);
+
+        VirtualVehicle vehicle(PROTOCOL_ISO_15765,false,1);
+        vehicle.AddEcu(0x7E8);
+        vehicle.Respond(param);
+
+        std::vector<Data> list_data;
+        budget.max_steps = 1;
+        for(auto const &engine_name : {"native","duktape"})   {
+            parser_budget.SetScriptEngine(engine_name);
+            parser_budget.SetScriptBudget(budget);
+            REQUIRE_THROWS_AS(parser_budget.ParseParameterFrame(param,list_data),
+                              ScriptBudgetExceeded&);
+        }
+        list_stats = parser_budget.GetScriptBudgetStats();
+        REQUIRE(list_stats.size() == 1);
+        REQUIRE(list_stats[0].exceeded == 2);
+
+        // no budget
+        parser_budget.SetScriptBudget(ScriptBudget());
+        parser_budget.ParseParameterFrame(param,list_data);
+        REQUIRE_FALSE(list_data.empty());
+    }
+
+    SECTION("Script heaps")
+    {
+        ScriptHeap heap;
+        void * small = ScriptHeap::Alloc(&heap,10);
+        void * large = ScriptHeap::Alloc(&heap,5000);
+        REQUIRE(small);
+        REQUIRE(large);
+        std::memset(small,0xAB,10);
+        std::memset(large,0xCD,5000);
+        REQUIRE(heap.GetStats().live_bytes >= 5010);
+        REQUIRE(heap.GetStats().reserved_bytes >= heap.GetStats().live_bytes);
+
+        // moving to another size class keeps the contents
+        small = ScriptHeap::Realloc(&heap,small,300);
+        REQUIRE(static_cast<u8*>(small)[9] == 0xAB);
+        large = ScriptHeap::Realloc(&heap,large,20000);
+        REQUIRE(static_cast<u8*>(large)[4999] == 0xCD);
+
+        // freed blocks are reused
+        ScriptHeap::Free(&heap,small);
+        REQUIRE(ScriptHeap::Alloc(&heap,300) == small);
+        ScriptHeap::Free(&heap,small);
+        ScriptHeap::Free(&heap,large);
+        REQUIRE(heap.GetStats().live_bytes == 0);
+        REQUIRE(heap.GetStats().peak_bytes >= 20000);
+
+        // the limit only applies while it's enforced
+        heap.SetLimit(1024);
+        REQUIRE(ScriptHeap::Alloc(&heap,2000) != nullptr);
+        heap.SetLimitEnforced(true);
+        REQUIRE(ScriptHeap::Alloc(&heap,100) == nullptr);
+        REQUIRE(heap.TakeLimitHit());
+        REQUIRE_FALSE(heap.TakeLimitHit());
+        REQUIRE(heap.GetStats().refused_allocs == 1);
+
+        // scripts that go over the limit are stopped,
+        // others still run
+        ByteList const data_bytes {0x12,0x80};
+        DuktapeScriptEngine engine;
+        REQUIRE(engine.Compile(0,"grow","var a = []; while(true) { a.push('x' + a.length); }"));
+        REQUIRE(engine.Compile(1,"done","var a = []; for(var i=0; i < 10; i++) { a.push(i); }"));
+        size_t const live_bytes = engine.GetHeapStats().live_bytes;
+        REQUIRE(live_bytes > 0);
+        engine.SetHeapLimit(live_bytes+256*1024);
+        engine.BindInput(data_bytes);
+        REQUIRE_THROWS_AS(engine.Run(0,true),ScriptHeapLimitExceeded&);
+        REQUIRE(engine.GetHeapStats().refused_allocs > 0);
+        REQUIRE(engine.Run(1,false));
+
+        // a limit that's large enough doesn't change any results
+        Parser parser_js(test::cli_definitions_file);
+        parser_js.SetScriptEngine("duktape");
+
+        Parser parser_heap(test::cli_definitions_file);
+        parser_heap.SetScriptEngine("duktape");
+        ScriptHeapStats stats = parser_heap.GetScriptHeapStats();
+        REQUIRE(stats.live_bytes > 0);
+        REQUIRE(stats.limit == 0);
+
+        parser_heap.SetScriptHeapLimit(stats.live_bytes+1024*1024);
+        test::ParseAndCompare(parser_js,parser_heap,2);
+        stats = parser_heap.GetScriptHeapStats();
+        REQUIRE(stats.peak_bytes >= stats.live_bytes);
+        REQUIRE(stats.peak_bytes <= stats.limit);
+        REQUIRE(stats.refused_allocs == 0);
+    }
+
+    SECTION("Clone")
+    {
+        Parser parser_js(test::cli_definitions_file);
+        parser_js.SetScriptEngine("duktape");
+
+        ScriptBudget budget;
+        budget.max_steps = 100000;
+
+        Parser parser(test::cli_definitions_file);
+        parser.SetScriptEngine("native");
+        parser.SetScriptBudget(budget);
+        parser.SetLookupTableMaxDomain(256);
+        parser.SetParameterScriptEngine("SAEJ1979","Default","Engine RPM","duktape");
+        test::ParseAndCompare(parser_js,parser,1);
+
+        Parser clone = parser.Clone();
+        REQUIRE(clone.GetScriptBudget().max_steps == budget.max_steps);
+        REQUIRE(clone.GetCompiledScriptCount("native") ==
+                parser.GetCompiledScriptCount("native"));
+        REQUIRE(clone.GetScriptHeapStats().live_bytes > 0);
+        REQUIRE(parser.GetLookupTableStats().table_count > 0);
+        REQUIRE(clone.GetLookupTableStats().table_count ==
+                parser.GetLookupTableStats().table_count);
+        test::ParseAndCompare(parser_js,clone,2);
+
+        // moved parsers keep working
+        Parser moved(std::move(clone));
+        test::ParseAndCompare(parser_js,moved,1);
+
+        Parser assigned = parser.Clone();
+        assigned = std::move(moved);
+        test::ParseAndCompare(parser_js,assigned,1);
+    }
+}
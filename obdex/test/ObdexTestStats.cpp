@@ -0,0 +1,361 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/test/catch/catch.hpp>
+#include <obdex/ObdexParser.hpp>
+#include <obdex/ObdexVirtualVehicle.hpp>
+#include <obdex/bench/ObdexDefinitionsGenerator.hpp>
+
+#include <cstdio>
+
+using namespace obdex;
+
+TEST_CASE("TestStats","[stats]")
+{
+    SECTION("LatencyHistogram")
+    {
+        LatencyHistogram hist;
+        REQUIRE(hist.GetCount() == 0);
+        REQUIRE(hist.GetMinNs() == 0);
+        REQUIRE(hist.GetPercentileNs(50) == 0);
+
+        hist.Add(0);
+        hist.Add(1);
+        hist.Add(100);  // bucket 6, [64,128)
+        hist.Add(1000); // bucket 9, [512,1024)
+
+        REQUIRE(hist.GetCount() == 4);
+        REQUIRE(hist.GetTotalNs() == 1101);
+        REQUIRE(hist.GetMinNs() == 0);
+        REQUIRE(hist.GetMaxNs() == 1000);
+        REQUIRE(hist.GetBuckets()[0] == 2);
+        REQUIRE(hist.GetBuckets()[6] == 1);
+        REQUIRE(hist.GetBuckets()[9] == 1);
+        REQUIRE(hist.GetPercentileNs(50) == 1);
+        REQUIRE(hist.GetPercentileNs(75) == 127);
+        REQUIRE(hist.GetPercentileNs(100) == 1000);
+
+        LatencyHistogram other;
+        other.Add(5);
+        hist.Merge(other);
+        REQUIRE(hist.GetCount() == 5);
+        REQUIRE(hist.GetBuckets()[2] == 1);
+    }
+
+    SECTION("Parser stats")
+    {
+        bench::DefinitionsGeneratorOptions options;
+        options.param_count = 4;
+        options.combined_ratio = 0.5;
+        options.list_protocols = { "ISO 15765 Standard Id" };
+
+        std::string const file_path = "obdex_test_stats.xml";
+        REQUIRE(bench::WriteDefinitionsFile(file_path,options));
+
+        Parser parser(file_path);
+        std::remove(file_path.c_str());
+
+        std::string const spec = bench::GetSyntheticSpecName(0);
+        std::string const address = bench::GetSyntheticAddressName(0);
+        std::vector<std::string> const list_names =
+                parser.GetParameterNames(spec,options.list_protocols[0],address);
+
+        uint const parse_count = 3;
+        for(auto const &name : list_names)
+        {
+            ParameterFrame param;
+            param.spec = spec;
+            param.protocol = options.list_protocols[0];
+            param.address = address;
+            param.name = name;
+            parser.BuildParameterFrame(param);
+
+            VirtualVehicle vehicle(param.parse_protocol);
+            vehicle.AddEcu(bench::GetSyntheticEcuAddress(param.protocol,0));
+
+            for(uint i=0; i < parse_count; i++)   {
+                vehicle.Respond(param);
+                std::vector<Data> list_data;
+                parser.ParseParameterFrame(param,list_data);
+            }
+
+            // a frame without any valid responses fails to clean
+            for(auto &msg : param.list_message_data)   {
+                msg.list_raw_frames.clear();
+            }
+            std::vector<Data> list_data;
+            REQUIRE_THROWS(parser.ParseParameterFrame(param,list_data));
+        }
+
+        ParseStatsSnapshot stats = parser.GetParseStats();
+
+        if(!Parser::StatsEnabled())   {
+            REQUIRE(stats.all.calls == 0);
+            REQUIRE(stats.lkup_params.empty());
+            REQUIRE(stats.lkup_protocols.empty());
+            return;
+        }
+
+        u64 const total_calls = list_names.size()*(parse_count+1);
+        REQUIRE(stats.all.calls == total_calls);
+        REQUIRE(stats.all.failures == list_names.size());
+        REQUIRE(stats.all.total.GetCount() == total_calls);
+
+        // every frame was cleaned, only successfully
+        // cleaned frames reached the js stages
+        REQUIRE(stats.all.list_stages[PARSE_STAGE_CLEAN].GetCount() == total_calls);
+        REQUIRE(stats.all.list_stages[PARSE_STAGE_REASSEMBLY].GetCount() == total_calls);
+        REQUIRE(stats.all.list_stages[PARSE_STAGE_JS_MARSHAL].GetCount() ==
+                list_names.size()*parse_count);
+        REQUIRE(stats.all.list_stages[PARSE_STAGE_SCRIPT].GetCount() ==
+                list_names.size()*parse_count);
+        REQUIRE(stats.all.list_stages[PARSE_STAGE_EXTRACT].GetCount() ==
+                list_names.size()*parse_count);
+
+        REQUIRE(stats.lkup_params.size() == list_names.size());
+        for(auto const &it : stats.lkup_params)   {
+            REQUIRE(it.second.calls == parse_count+1);
+            REQUIRE(it.second.failures == 1);
+        }
+
+        REQUIRE(stats.lkup_protocols.size() == 1);
+        REQUIRE(stats.lkup_protocols[options.list_protocols[0]].calls == total_calls);
+
+        // CleanParameterFrame on its own counts as a call
+        parser.ResetParseStats();
+        REQUIRE(parser.GetParseStats().all.calls == 0);
+
+        ParameterFrame param;
+        param.spec = spec;
+        param.protocol = options.list_protocols[0];
+        param.address = address;
+        param.name = list_names[0];
+        parser.BuildParameterFrame(param);
+
+        VirtualVehicle vehicle(param.parse_protocol);
+        vehicle.AddEcu(bench::GetSyntheticEcuAddress(param.protocol,0));
+        vehicle.Respond(param);
+        parser.CleanParameterFrame(param);
+
+        stats = parser.GetParseStats();
+        REQUIRE(stats.all.calls == 1);
+        REQUIRE(stats.all.failures == 0);
+        REQUIRE(stats.all.list_stages[PARSE_STAGE_SCRIPT].GetCount() == 0);
+    }
+
+    SECTION("Rejected frames")
+    {
+        bench::DefinitionsGeneratorOptions options;
+        options.param_count = 1;
+        options.combined_ratio = 0;
+        options.multi_request_ratio = 0;
+        options.list_protocols = { "ISO 15765 Extended Id" };
+
+        std::string const file_path = "obdex_test_stats.xml";
+        REQUIRE(bench::WriteDefinitionsFile(file_path,options));
+
+        Parser parser(file_path);
+        std::remove(file_path.c_str());
+        parser.SetRejectWarningInterval(Milliseconds(-1));
+
+        ParameterFrame param;
+        param.spec = bench::GetSyntheticSpecName(0);
+        param.protocol = options.list_protocols[0];
+        param.address = bench::GetSyntheticAddressName(0);
+        param.name = bench::GetSyntheticParameterNames(options,0,0)[0];
+        parser.BuildParameterFrame(param);
+
+        VirtualVehicle vehicle(param.parse_protocol,true);
+        vehicle.AddEcu(bench::GetSyntheticEcuAddress(param.protocol,0));
+        vehicle.Respond(param);
+
+        auto &list_raw_frames = param.list_message_data[0].list_raw_frames;
+        REQUIRE(list_raw_frames.size() == 1);
+        ByteList const valid_frame = list_raw_frames[0];
+        ByteList const header(valid_frame.begin(),valid_frame.begin()+4);
+        auto make_frame = [&header](ByteList const &data) {
+            ByteList frame = header;
+            frame.insert(frame.end(),data.begin(),data.end());
+            return frame;
+        };
+
+        list_raw_frames.push_back({0x18,0xDA,0x01,0x23,0x03,0x62,0x00,0x00}); // header
+        list_raw_frames.push_back(make_frame({0x03,0x00,0x00,0x00}));         // prefix
+        list_raw_frames.push_back(make_frame({0x30,0x00,0x00,0x00}));         // pci
+        list_raw_frames.push_back(make_frame({0x21,0x00,0x00,0x00}));         // gap
+        list_raw_frames.push_back(header);                                    // truncated
+        list_raw_frames.push_back(make_frame({0x07,0x62,0x00}));              // truncated
+
+        std::vector<Data> list_data;
+        parser.ParseParameterFrame(param,list_data);
+        REQUIRE(list_data.size() == 1);
+
+        auto const list_counts = parser.GetRejectedFrameCounts();
+        REQUIRE(list_counts[REJECT_HEADER_MISMATCH] == 1);
+        REQUIRE(list_counts[REJECT_PREFIX_MISMATCH] == 1);
+        REQUIRE(list_counts[REJECT_BAD_PCI] == 1);
+        REQUIRE(list_counts[REJECT_SEQUENCE_GAP] == 1);
+        REQUIRE(list_counts[REJECT_TRUNCATED_FRAME] == 2);
+
+        // a first frame without its consecutive frames
+        list_raw_frames = { valid_frame, make_frame({0x10,0x0A,0x62,0x00,0x00,0x00}) };
+        list_data.clear();
+        parser.ParseParameterFrame(param,list_data);
+        REQUIRE(parser.GetRejectedFrameCount(REJECT_SEQUENCE_GAP) == 2);
+
+        parser.ResetRejectedFrameCounts();
+        for(auto count : parser.GetRejectedFrameCounts())   {
+            REQUIRE(count == 0);
+        }
+    }
+
+    SECTION("FrameRejectCounters warnings")
+    {
+        FrameRejectCounters counters;
+        u64 suppressed=0;
+
+        // default interval: the first reject warns, the
+        // rest are counted until the interval passes
+        REQUIRE(counters.Add(REJECT_BAD_PCI,suppressed));
+        REQUIRE(suppressed == 0);
+        REQUIRE_FALSE(counters.Add(REJECT_BAD_PCI,suppressed));
+        REQUIRE_FALSE(counters.Add(REJECT_BAD_PCI,suppressed));
+
+        // reasons are rate limited separately
+        REQUIRE(counters.Add(REJECT_SEQUENCE_GAP,suppressed));
+
+        counters.SetWarningInterval(Milliseconds(0));
+        REQUIRE(counters.Add(REJECT_BAD_PCI,suppressed));
+        REQUIRE(suppressed == 2);
+        REQUIRE(counters.Get(REJECT_BAD_PCI) == 4);
+
+        counters.SetWarningInterval(Milliseconds(-1));
+        REQUIRE_FALSE(counters.Add(REJECT_BAD_PCI,suppressed));
+        REQUIRE(counters.Get(REJECT_BAD_PCI) == 5);
+    }
+
+    SECTION("ParseCache")
+    {
+        ParseCache cache;
+        ByteList key_a,key_b,key_c;
+        ParseCache::AppendKeyBytes(key_a,{0x41,0x05});
+        ParseCache::AppendKeyBytes(key_b,{0x41});
+        ParseCache::AppendKeyBytes(key_b,{0x05});
+        ParseCache::AppendKeyBytes(key_c,{0x41,0x06});
+        REQUIRE(key_a != key_b);
+
+        Data data;
+        data.param_name = "a";
+
+        // disabled by default
+        cache.Insert(0,ParseCache::Hash(key_a),key_a,data);
+        REQUIRE(cache.Find(0,ParseCache::Hash(key_a),key_a) == nullptr);
+
+        cache.SetCapacity(2);
+        cache.Insert(0,ParseCache::Hash(key_a),key_a,data);
+        data.param_name = "b";
+        cache.Insert(0,ParseCache::Hash(key_b),key_b,data);
+
+        Data const * cached = cache.Find(0,ParseCache::Hash(key_a),key_a);
+        REQUIRE(cached != nullptr);
+        REQUIRE(cached->param_name == "a");
+        REQUIRE(cache.Find(1,ParseCache::Hash(key_a),key_a) == nullptr);
+
+        // b is the least recently used entry
+        data.param_name = "c";
+        cache.Insert(0,ParseCache::Hash(key_c),key_c,data);
+        REQUIRE(cache.Find(0,ParseCache::Hash(key_b),key_b) == nullptr);
+        REQUIRE(cache.Find(0,ParseCache::Hash(key_a),key_a) != nullptr);
+
+        // same hash with different key bytes is a miss
+        REQUIRE(cache.Find(0,ParseCache::Hash(key_a),key_c) == nullptr);
+
+        ParseCacheStats stats = cache.GetStats();
+        REQUIRE(stats.hits == 2);
+        REQUIRE(stats.misses == 4);
+        REQUIRE(stats.evictions == 1);
+        REQUIRE(stats.size == 2);
+        REQUIRE(stats.capacity == 2);
+
+        cache.SetCapacity(0);
+        REQUIRE(cache.GetStats().size == 0);
+    }
+
+    SECTION("Parser cache")
+    {
+        bench::DefinitionsGeneratorOptions options;
+        options.param_count = 4;
+        options.combined_ratio = 0.5;
+        options.list_protocols = { "ISO 15765 Standard Id" };
+
+        std::string const file_path = "obdex_test_stats.xml";
+        REQUIRE(bench::WriteDefinitionsFile(file_path,options));
+
+        Parser parser(file_path);
+        std::remove(file_path.c_str());
+        parser.SetParseCacheCapacity(16);
+
+        std::string const spec = bench::GetSyntheticSpecName(0);
+        std::string const address = bench::GetSyntheticAddressName(0);
+        std::vector<std::string> const list_names =
+                parser.GetParameterNames(spec,options.list_protocols[0],address);
+
+        uint const parse_count = 3;
+        for(auto const &name : list_names)
+        {
+            ParameterFrame param;
+            param.spec = spec;
+            param.protocol = options.list_protocols[0];
+            param.address = address;
+            param.name = name;
+            parser.BuildParameterFrame(param);
+
+            VirtualVehicle vehicle(param.parse_protocol);
+            vehicle.AddEcu(bench::GetSyntheticEcuAddress(param.protocol,0));
+            vehicle.Respond(param);
+
+            // identical responses give identical results
+            std::vector<Data> list_first;
+            parser.ParseParameterFrame(param,list_first);
+            REQUIRE_FALSE(list_first.empty());
+
+            for(uint i=1; i < parse_count; i++)   {
+                std::vector<Data> list_data;
+                parser.ParseParameterFrame(param,list_data);
+                REQUIRE(list_data.size() == list_first.size());
+                for(uint k=0; k < list_data.size(); k++)   {
+                    REQUIRE(list_data[k].param_name == list_first[k].param_name);
+                    REQUIRE(list_data[k].list_numerical_data.size() ==
+                            list_first[k].list_numerical_data.size());
+                    REQUIRE(list_data[k].list_literal_data.size() ==
+                            list_first[k].list_literal_data.size());
+                }
+            }
+        }
+
+        // the first parse of each parameter misses
+        ParseCacheStats stats = parser.GetParseCacheStats();
+        REQUIRE(stats.misses == list_names.size());
+        REQUIRE(stats.hits == list_names.size()*(parse_count-1));
+        REQUIRE(stats.size == list_names.size());
+
+        parser.ResetParseCacheStats();
+        parser.ClearParseCache();
+        stats = parser.GetParseCacheStats();
+        REQUIRE(stats.hits == 0);
+        REQUIRE(stats.size == 0);
+    }
+}
@@ -0,0 +1,282 @@
+/*
+   Copyright (C) 2012-2016 Preet Desai (preet.desai@gmail.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <obdex/test/catch/catch.hpp>
+#include <obdex/ObdexDefinitions.hpp>
+#include <obdex/ObdexErrors.hpp>
+#include <obdex/ObdexParser.hpp>
+#include <obdex/ObdexVirtualVehicle.hpp>
+#include <obdex/bench/ObdexDefinitionsGenerator.hpp>
+
+#include <cstdio>
+
+using namespace obdex;
+
+TEST_CASE("TestSynthetic","[synthetic]")
+{
+    bench::DefinitionsGeneratorOptions options;
+    options.spec_count = 2;
+    options.address_count = 3;
+    options.param_count = 30;
+    options.combined_ratio = 0.3;
+    options.multi_request_ratio = 0.3;
+    options.complex_script_ratio = 0.5;
+
+    std::string const file_path = "obdex_test_synthetic.xml";
+    REQUIRE(bench::WriteDefinitionsFile(file_path,options));
+
+    Parser parser(file_path);
+    std::remove(file_path.c_str());
+
+    SECTION("build and parse every synthetic parameter")
+    {
+        for(uint s=0; s < options.spec_count; s++)   {
+            for(auto const &protocol : options.list_protocols)   {
+                for(uint a=0; a < options.address_count; a++)
+                {
+                    std::string const spec = bench::GetSyntheticSpecName(s);
+                    std::string const address = bench::GetSyntheticAddressName(a);
+
+                    std::vector<std::string> const list_names =
+                            parser.GetParameterNames(spec,protocol,address);
+
+                    REQUIRE(list_names == bench::GetSyntheticParameterNames(options,s,a));
+
+                    for(auto const &name : list_names)
+                    {
+                        ParameterFrame param;
+                        param.spec = spec;
+                        param.protocol = protocol;
+                        param.address = address;
+                        param.name = name;
+                        parser.BuildParameterFrame(param);
+
+                        VirtualVehicle vehicle(param.parse_protocol,
+                                               param.iso15765_extended_id);
+                        vehicle.AddEcu(bench::GetSyntheticEcuAddress(protocol,a));
+                        vehicle.Respond(param);
+
+                        std::vector<Data> list_data;
+                        parser.ParseParameterFrame(param,list_data);
+                        REQUIRE(list_data.size() > 0);
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("parameter ids")
+    {
+        size_t id_count=0;
+        for(uint s=0; s < options.spec_count; s++)   {
+            for(auto const &protocol : options.list_protocols)   {
+                for(uint a=0; a < options.address_count; a++)
+                {
+                    std::string const spec = bench::GetSyntheticSpecName(s);
+                    std::string const address = bench::GetSyntheticAddressName(a);
+
+                    std::vector<std::string> const list_names =
+                            parser.GetParameterNames(spec,protocol,address);
+                    std::vector<ParamId> const list_ids =
+                            parser.GetParamIds(spec,protocol,address);
+                    REQUIRE(list_ids.size() == list_names.size());
+                    id_count += list_ids.size();
+
+                    for(size_t i=0; i < list_ids.size(); i++)
+                    {
+                        ParamId const id = list_ids[i];
+                        REQUIRE(parser.GetParamId(spec,protocol,address,list_names[i]) == id);
+                        REQUIRE(parser.GetParamSpec(id) == spec);
+                        REQUIRE(parser.GetParamProtocol(id) == protocol);
+                        REQUIRE(parser.GetParamAddress(id) == address);
+                        REQUIRE(parser.GetParamName(id) == list_names[i]);
+
+                        // frames built from the names and
+                        // the id are the same
+                        ParameterFrame named;
+                        named.spec = spec;
+                        named.protocol = protocol;
+                        named.address = address;
+                        named.name = list_names[i];
+                        parser.BuildParameterFrame(named);
+                        REQUIRE(named.param_id == id);
+
+                        ParameterFrame param;
+                        parser.BuildParameterFrame(id,param);
+                        REQUIRE(param.param_id == id);
+                        REQUIRE(param.function_key_idx == named.function_key_idx);
+                        REQUIRE(param.parse_mode == named.parse_mode);
+                        REQUIRE(param.list_message_data.size() ==
+                                named.list_message_data.size());
+                        for(size_t k=0; k < param.list_message_data.size(); k++)   {
+                            REQUIRE(param.list_message_data[k].req_header_bytes ==
+                                    named.list_message_data[k].req_header_bytes);
+                            REQUIRE(param.list_message_data[k].list_req_data_bytes ==
+                                    named.list_message_data[k].list_req_data_bytes);
+                        }
+
+                        VirtualVehicle vehicle(param.parse_protocol,
+                                               param.iso15765_extended_id);
+                        vehicle.AddEcu(bench::GetSyntheticEcuAddress(protocol,a));
+                        vehicle.Respond(param);
+
+                        std::vector<Data> list_data;
+                        parser.ParseParameterFrame(param,list_data);
+                        REQUIRE(list_data.size() > 0);
+                        REQUIRE(list_data[0].param_id == id);
+                        REQUIRE(list_data[0].param_name.empty());
+                    }
+                }
+            }
+        }
+        REQUIRE(id_count == parser.GetParamIdCount());
+
+        std::string const spec = bench::GetSyntheticSpecName(0);
+        std::string const protocol = options.list_protocols[0];
+        std::string const address = bench::GetSyntheticAddressName(0);
+        REQUIRE(parser.GetParamId(spec,protocol,address,"not a parameter") ==
+                k_invalid_param_id);
+        REQUIRE(parser.GetParamId(spec,"not a protocol",address,
+                                  parser.GetParamName(0)) == k_invalid_param_id);
+
+        ParameterFrame param;
+        REQUIRE_THROWS_AS(parser.BuildParameterFrame(k_invalid_param_id,param),
+                          InvalidParamId&);
+        REQUIRE_THROWS_AS(parser.GetParamName(ParamId(parser.GetParamIdCount())),
+                          InvalidParamId&);
+
+        // clones share the ids
+        Parser clone = parser.Clone();
+        REQUIRE(clone.GetParamIdCount() == parser.GetParamIdCount());
+        REQUIRE(clone.GetParamName(0) == parser.GetParamName(0));
+    }
+
+    SECTION("catalog")
+    {
+        Catalog const catalog = parser.GetCatalog();
+        REQUIRE(catalog.list_specs.size() == options.spec_count);
+        REQUIRE(catalog.list_params.size() == parser.GetParamIdCount());
+
+        for(uint s=0; s < options.spec_count; s++)
+        {
+            CatalogSpec const &cat_spec = catalog.list_specs[s];
+            REQUIRE(cat_spec.name == bench::GetSyntheticSpecName(s));
+            REQUIRE(cat_spec.list_protocols.size() == options.list_protocols.size());
+
+            for(auto const &cat_protocol : cat_spec.list_protocols)   {
+                REQUIRE(cat_protocol.supported);
+                REQUIRE(cat_protocol.list_addresses.size() == options.address_count);
+                for(auto const &cat_address : cat_protocol.list_addresses)   {
+                    std::vector<std::string> const list_names =
+                            parser.GetParameterNames(cat_spec.name,
+                                                     cat_protocol.name,
+                                                     cat_address.name);
+                    REQUIRE(cat_address.param_count == list_names.size());
+                    for(u32 i=0; i < cat_address.param_count; i++)   {
+                        ParamId const id = cat_address.first_param_id+i;
+                        CatalogParam const &cat_param = catalog.list_params[id];
+                        REQUIRE(catalog.list_parameters[cat_param.parameter_idx].name ==
+                                list_names[i]);
+                    }
+                }
+            }
+        }
+
+        // the catalog has what building each parameter would
+        for(ParamId id=0; id < catalog.list_params.size(); id++)
+        {
+            CatalogParam const &cat_param = catalog.list_params[id];
+            CatalogParameter const &parameter = catalog.list_parameters[cat_param.parameter_idx];
+            CatalogProtocol const &cat_protocol =
+                    catalog.list_specs[cat_param.spec_idx].list_protocols[cat_param.protocol_idx];
+            REQUIRE(parameter.valid);
+            REQUIRE(parameter.name == parser.GetParamName(id));
+            REQUIRE(parameter.address == parser.GetParamAddress(id));
+            REQUIRE(cat_protocol.name == parser.GetParamProtocol(id));
+            REQUIRE(cat_protocol.list_addresses[cat_param.address_idx].name ==
+                    parser.GetParamAddress(id));
+
+            ParameterFrame param;
+            parser.BuildParameterFrame(id,param);
+            REQUIRE(param.function_key_idx == cat_param.function_key_idx);
+            REQUIRE(param.parse_mode == parameter.parse_mode);
+            REQUIRE(param.parse_protocol == cat_protocol.parse_protocol);
+            REQUIRE(param.iso15765_extended_id == cat_protocol.iso15765_extended_id);
+            REQUIRE(param.list_message_data.size() == parameter.list_requests.size());
+            for(size_t k=0; k < parameter.list_requests.size(); k++)   {
+                MessageData const &msg = param.list_message_data[k];
+                CatalogRequest const &request = parameter.list_requests[k];
+                REQUIRE(msg.exp_data_prefix == request.exp_data_prefix);
+                REQUIRE(msg.exp_data_byte_count == request.exp_data_byte_count);
+                REQUIRE(msg.req_data_delay_ms == request.req_data_delay_ms);
+                REQUIRE(msg.list_req_data_bytes.size() > 0);
+            }
+        }
+    }
+
+    SECTION("unique request identifiers")
+    {
+        // request ids 0 and 65536 (PARAM_32768) share their
+        // identifier bytes but not their mode
+        bench::DefinitionsGeneratorOptions large_options;
+        large_options.spec_count = 1;
+        large_options.address_count = 1;
+        large_options.param_count = 32769;
+        large_options.max_requests = 2;
+        large_options.multi_request_ratio = 0.0;
+        large_options.list_protocols = { "ISO 15765 Standard Id" };
+
+        std::string const xml = bench::GenerateDefinitions(large_options);
+        REQUIRE(xml.find("request=\"0x22 0x00 0x00\"") != std::string::npos);
+        REQUIRE(xml.find("request=\"0x23 0x00 0x00\"") != std::string::npos);
+        REQUIRE(xml.find("response.prefix=\"0x63 0x00 0x00\"") != std::string::npos);
+
+        large_options.param_count = 30*65536;
+        REQUIRE_THROWS_AS(bench::GenerateDefinitions(large_options),InvalidArgument&);
+    }
+
+    SECTION("definitions tables")
+    {
+        REQUIRE(bench::WriteDefinitionsFile(file_path,options));
+        Definitions definitions;
+        LoadDefinitions(file_path,definitions);
+        std::remove(file_path.c_str());
+
+        REQUIRE(definitions.list_specs.size() == options.spec_count);
+        REQUIRE(definitions.list_function_key.size() == definitions.list_script.size());
+
+        size_t script_count=0;
+        for(auto const &spec : definitions.list_specs)   {
+            REQUIRE(spec.list_protocols.size() == options.list_protocols.size());
+            for(auto const &group : spec.list_param_groups)   {
+                for(auto const &param : group.list_parameters)   {
+                    REQUIRE(param.attributes.Exists());
+                    REQUIRE(param.attributes.GetAttribute("name") == param.name);
+                    REQUIRE(param.attributes.GetAttribute("not an attribute").empty());
+                    for(auto const &script : param.list_scripts)   {
+                        REQUIRE(definitions.list_function_key[script.function_idx] ==
+                                spec.name+":"+group.address+":"+param.name+":"+script.protocols);
+                        script_count++;
+                    }
+                }
+            }
+        }
+        REQUIRE(script_count == definitions.list_script.size());
+
+        Definitions missing;
+        REQUIRE_THROWS_AS(LoadDefinitions("not_a_file.xml",missing),XMLParsingFailed&);
+    }
+}
@@ -18,6 +18,10 @@
 #include <obdex/ObdexUtil.hpp>
 #include <obdex/ObdexLog.hpp>
 #include <obdex/ObdexParser.hpp>
+#include <obdex/ObdexErrors.hpp>
+
+#include <clocale>
+#include <limits>
 
 using namespace obdex;
 
@@ -40,6 +44,99 @@ TEST_CASE("TestUtils","[utils]")
         REQUIRE(ok);
     }
 
+    SECTION("Convert bytes to and from hex strings")
+    {
+        REQUIRE(Parser::ConvUByteToHexStr(0x00) == "00");
+        REQUIRE(Parser::ConvUByteToHexStr(0x0A) == "0A");
+        REQUIRE(Parser::ConvUByteToHexStr(0xFF) == "FF");
+
+        char buf[2];
+        Parser::ConvUByteToHexStr(0x7E,buf);
+        REQUIRE((buf[0] == '7' && buf[1] == 'E'));
+
+        bool ok=true;
+        for(uint i=0; i < 256; i++)   {
+            std::string const hex_str = Parser::ConvUByteToHexStr(ubyte(i));
+            ok = ok && Parser::ConvHexStrToUByte(hex_str) == i;
+            ok = ok && Parser::ConvHexStrToUByte(StringToLower(hex_str)) == i;
+        }
+        REQUIRE(ok);
+
+        REQUIRE(Parser::ConvHexStrToUByte("aF",2) == 0xAF);
+        REQUIRE_THROWS_AS(Parser::ConvHexStrToUByte("F"),InvalidHexStr&);
+        REQUIRE_THROWS_AS(Parser::ConvHexStrToUByte("0FF"),InvalidHexStr&);
+        REQUIRE_THROWS_AS(Parser::ConvHexStrToUByte("0G"),InvalidHexStr&);
+        REQUIRE_THROWS_AS(Parser::ConvHexStrToUByte("0x",2),InvalidHexStr&);
+    }
+
+    SECTION("Append numbers to string")
+    {
+        std::string str = "v=";
+        AppendUInt(str,0);
+        REQUIRE(str == "v=0");
+
+        str.clear();
+        AppendUInt(str,18446744073709551615ull);
+        REQUIRE(str == "18446744073709551615");
+
+        str.clear();
+        AppendInt(str,-42);
+        str.push_back(' ');
+        AppendInt(str,std::numeric_limits<s64>::min());
+        REQUIRE(str == "-42 -9223372036854775808");
+
+        str.clear();
+        AppendHex(str,0xAB);
+        str.push_back(' ');
+        AppendHex(str,0xAB,true,4);
+        str.push_back(' ');
+        AppendHex(str,0,false,2);
+        REQUIRE(str == "ab 00AB 00");
+
+        char buf[k_format_int_chars];
+        REQUIRE(std::string(buf,FormatInt(buf,-7)) == "-7");
+        REQUIRE(std::string(buf,FormatHex(buf,0x1F,true)) == "1F");
+
+        // same output as the default ostream and std::fixed
+        str.clear();
+        AppendDouble(str,1.5);
+        str.push_back(' ');
+        AppendDouble(str,1234567.0);
+        str.push_back(' ');
+        AppendFixed(str,-2.345,2);
+        str.push_back(' ');
+        AppendFixed(str,3,0);
+        REQUIRE(str == "1.5 1.23457e+06 -2.35 3");
+
+        str.clear();
+        AppendFixed(str,1e100,1);
+        REQUIRE(str.size() == 103);
+
+        // the decimal point doesn't depend on the C locale
+        // (only checked where a locale with a comma exists)
+        std::string const prev_locale = std::setlocale(LC_NUMERIC,nullptr);
+        for(char const * name : {"de_DE.UTF-8","de_DE.utf8","de_DE","fr_FR.UTF-8"})   {
+            if(std::setlocale(LC_NUMERIC,name))   {
+                str.clear();
+                AppendDouble(str,1.5);
+                str.push_back(' ');
+                AppendFixed(str,-2.345,2);
+                std::setlocale(LC_NUMERIC,prev_locale.c_str());
+                REQUIRE(str == "1.5 -2.35");
+                break;
+            }
+        }
+
+        // ToString uses the same formatting; char types
+        // are still written as characters
+        REQUIRE(ToString(u16(65535)) == "65535");
+        REQUIRE(ToString(-0.25) == "-0.25");
+        REQUIRE(ToString('x') == "x");
+        REQUIRE(ToString(true) == "1");
+        REQUIRE(ToStringFormat(-12,0,5,'0') == "00-12");
+        REQUIRE(ToStringFormat(3.14159,2,6,' ') == "  3.14");
+    }
+
     SECTION("Prepend string")
     {
         std::string a = "World";
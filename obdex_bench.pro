@@ -0,0 +1,17 @@
+ TEMPLATE = app
+ TARGET = obdex_bench
+ CONFIG -= qt
+ CONFIG += release
+
+include(obdex.pri)
+
+# bench
+HEADERS += \
+    obdex/bench/ObdexDefinitionsGenerator.hpp
+
+SOURCES += \
+    obdex/bench/ObdexBench.cpp \
+    obdex/bench/ObdexDefinitionsGenerator.cpp
+
+
+QMAKE_CXXFLAGS += -std=c++11
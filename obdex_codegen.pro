@@ -0,0 +1,17 @@
+ TEMPLATE = app
+ TARGET = obdex_codegen
+ CONFIG -= qt
+ CONFIG += release
+
+include(obdex.pri)
+
+# codegen
+HEADERS += \
+    obdex/codegen/ObdexScriptTranslator.hpp
+
+SOURCES += \
+    obdex/codegen/ObdexCodegen.cpp \
+    obdex/codegen/ObdexScriptTranslator.cpp
+
+
+QMAKE_CXXFLAGS += -std=c++11
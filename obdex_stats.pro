@@ -0,0 +1,9 @@
+# the tests built with CONFIG += obdex_stats, so that
+# the parse stats are checked as well as the default
+# build without them; obdex.pri checks CONFIG when
+# it's included
+ CONFIG += obdex_stats
+
+include(obdex.pro)
+
+ TARGET = obdex_test_stats